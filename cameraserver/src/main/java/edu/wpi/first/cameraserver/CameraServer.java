@@ -19,6 +19,7 @@ import edu.wpi.first.cscore.VideoSink;
 import edu.wpi.first.cscore.VideoSource;
 import edu.wpi.first.networktables.BooleanEntry;
 import edu.wpi.first.networktables.BooleanPublisher;
+import edu.wpi.first.networktables.IntegerArrayPublisher;
 import edu.wpi.first.networktables.IntegerEntry;
 import edu.wpi.first.networktables.IntegerPublisher;
 import edu.wpi.first.networktables.NetworkTable;
@@ -187,6 +188,15 @@ public final class CameraServer {
       for (PropertyPublisher pp : m_properties.values()) {
         pp.close();
       }
+      if (m_captureLatencyPublisher != null) {
+        m_captureLatencyPublisher.close();
+      }
+      if (m_convertLatencyPublisher != null) {
+        m_convertLatencyPublisher.close();
+      }
+      for (IntegerArrayPublisher pub : m_streamLatencyPublishers.values()) {
+        pub.close();
+      }
     }
 
     final NetworkTable m_table;
@@ -197,6 +207,11 @@ public final class CameraServer {
     final StringEntry m_modeEntry;
     final StringArrayPublisher m_modesPublisher;
     final Map<Integer, PropertyPublisher> m_properties = new HashMap<>();
+    // only published once there is latency telemetry
+    IntegerArrayPublisher m_captureLatencyPublisher;
+    IntegerArrayPublisher m_convertLatencyPublisher;
+    // indexed by sink name
+    final Map<String, IntegerArrayPublisher> m_streamLatencyPublishers = new HashMap<>();
   }
 
   private static final AtomicInteger m_defaultUsbDevice = new AtomicInteger();
@@ -220,6 +235,10 @@ public final class CameraServer {
   // - "modes" (string array): Available video modes
   // - "Property/{Property}" - Property values
   // - "PropertyInfo/{Property}" - Property supporting information
+  // - "Latency/{capture,convert}" and "Latency/stream/{Sink.Name}" (integer
+  //   array): Median, 90th, and 99th percentile latency in microseconds, of
+  //   the source and of each sink streaming it; only published if telemetry
+  //   has been enabled with CameraServerJNI.setTelemetryPeriod()
 
   // Listener for video events
   @SuppressWarnings({"PMD.UnusedPrivateField", "PMD.AvoidCatchingGenericException"})
@@ -332,12 +351,15 @@ public final class CameraServer {
                     updateStreamValues();
                     break;
                   }
+                case kTelemetryUpdated:
+                  updateLatencyValues();
+                  break;
                 default:
                   break;
               }
             }
           },
-          0x4fff,
+          0xcfff,
           true);
 
   private static int m_nextPort = kBasePort;
@@ -497,6 +519,87 @@ public final class CameraServer {
     }
   }
 
+  // Gets the median, 90th, and 99th percentile latency (in microseconds) over the last telemetry
+  // period, or null if there are none
+  private static long[] getLatencyValues(int handle, CameraServerJNI.TelemetryKind kind) {
+    try {
+      return new long[] {
+        CameraServerJNI.getTelemetryLatency(handle, kind, 50.0),
+        CameraServerJNI.getTelemetryLatency(handle, kind, 90.0),
+        CameraServerJNI.getTelemetryLatency(handle, kind, 99.0)
+      };
+    } catch (VideoException ignored) {
+      return null;
+    }
+  }
+
+  private static IntegerArrayPublisher publishLatencyValues(
+      NetworkTable table,
+      String name,
+      IntegerArrayPublisher publisher,
+      int handle,
+      CameraServerJNI.TelemetryKind kind) {
+    long[] values = getLatencyValues(handle, kind);
+    if (values != null) {
+      if (publisher == null) {
+        publisher = table.getIntegerArrayTopic(name).publish();
+      }
+      publisher.set(values);
+    }
+    return publisher;
+  }
+
+  /** Update latency values from telemetry. */
+  private static synchronized void updateLatencyValues() {
+    // Over all the sources...
+    for (Map.Entry<Integer, SourcePublisher> entry : m_publishers.entrySet()) {
+      int source = entry.getKey();
+      SourcePublisher publisher = entry.getValue();
+      publisher.m_captureLatencyPublisher =
+          publishLatencyValues(
+              publisher.m_table,
+              "Latency/capture",
+              publisher.m_captureLatencyPublisher,
+              source,
+              CameraServerJNI.TelemetryKind.kSourceCaptureLatency);
+      publisher.m_convertLatencyPublisher =
+          publishLatencyValues(
+              publisher.m_table,
+              "Latency/convert",
+              publisher.m_convertLatencyPublisher,
+              source,
+              CameraServerJNI.TelemetryKind.kSourceConvertLatency);
+    }
+
+    // Over all the sinks...
+    for (Map.Entry<String, VideoSink> entry : m_sinks.entrySet()) {
+      String name = entry.getKey();
+      int sink = entry.getValue().getHandle();
+
+      // Get the source's subtable (if none exists, we're done)
+      int source =
+          Objects.requireNonNullElseGet(
+              m_fixedSources.get(sink), () -> CameraServerJNI.getSinkSource(sink));
+
+      if (source == 0) {
+        continue;
+      }
+      SourcePublisher publisher = m_publishers.get(source);
+      if (publisher != null) {
+        IntegerArrayPublisher streamPublisher =
+            publishLatencyValues(
+                publisher.m_table,
+                "Latency/stream/" + name,
+                publisher.m_streamLatencyPublishers.get(name),
+                sink,
+                CameraServerJNI.TelemetryKind.kSinkFrameLatency);
+        if (streamPublisher != null) {
+          publisher.m_streamLatencyPublishers.put(name, streamPublisher);
+        }
+      }
+    }
+  }
+
   /** Provide string description of pixel format. */
   private static String pixelFormatToString(PixelFormat pixelFormat) {
     switch (pixelFormat) {
@@ -510,6 +613,8 @@ public final class CameraServer {
         return "BGR";
       case kGray:
         return "Gray";
+      case kUYVY:
+        return "UYVY";
       default:
         return "Unknown";
     }
@@ -9,6 +9,7 @@
 
 #include <fmt/format.h>
 #include <networktables/BooleanTopic.h>
+#include <networktables/IntegerArrayTopic.h>
 #include <networktables/IntegerTopic.h>
 #include <networktables/NetworkTable.h>
 #include <networktables/NetworkTableInstance.h>
@@ -59,6 +60,11 @@ struct SourcePublisher {
   nt::StringEntry modeEntry;
   nt::StringArrayPublisher modesPublisher;
   wpi::DenseMap<CS_Property, PropertyPublisher> properties;
+  // only published once there is latency telemetry
+  nt::IntegerArrayPublisher captureLatencyPublisher;
+  nt::IntegerArrayPublisher convertLatencyPublisher;
+  // indexed by sink name
+  wpi::StringMap<nt::IntegerArrayPublisher> streamLatencyPublishers;
 };
 
 struct Instance {
@@ -67,6 +73,7 @@ struct Instance {
   std::vector<std::string> GetSinkStreamValues(CS_Sink sink);
   std::vector<std::string> GetSourceStreamValues(CS_Source source);
   void UpdateStreamValues();
+  void UpdateLatencyValues();
 
   wpi::mutex m_mutex;
   std::atomic<int> m_defaultUsbDevice{0};
@@ -242,6 +249,60 @@ void Instance::UpdateStreamValues() {
   }
 }
 
+// Publishes the median, 90th, and 99th percentile latency (in microseconds)
+// over the last telemetry period, if there is any
+static void PublishLatencyValues(nt::NetworkTable& table,
+                                 std::string_view name,
+                                 nt::IntegerArrayPublisher& publisher,
+                                 CS_Handle handle, CS_TelemetryKind kind) {
+  int64_t values[3];
+  int i = 0;
+  for (double percentile : {50.0, 90.0, 99.0}) {
+    CS_Status status = 0;
+    values[i++] = cs::GetTelemetryLatency(handle, kind, percentile, &status);
+    if (status != 0) {
+      return;
+    }
+  }
+  if (!publisher) {
+    publisher = table.GetIntegerArrayTopic(name).Publish();
+  }
+  publisher.Set(values);
+}
+
+void Instance::UpdateLatencyValues() {
+  // Over all the sources...
+  for (auto&& i : m_publishers) {
+    PublishLatencyValues(*i.second.table, "Latency/capture",
+                         i.second.captureLatencyPublisher, i.first,
+                         CS_SOURCE_CAPTURE_LATENCY);
+    PublishLatencyValues(*i.second.table, "Latency/convert",
+                         i.second.convertLatencyPublisher, i.first,
+                         CS_SOURCE_CONVERT_LATENCY);
+  }
+
+  // Over all the sinks...
+  for (const auto& i : m_sinks) {
+    CS_Status status = 0;
+    CS_Sink sink = i.second.GetHandle();
+
+    // Get the source's subtable (if none exists, we're done)
+    CS_Source source = m_fixedSources.lookup(sink);
+    if (source == 0) {
+      source = cs::GetSinkSource(sink, &status);
+    }
+    if (source == 0) {
+      continue;
+    }
+    if (auto publisher = GetPublisher(source)) {
+      PublishLatencyValues(
+          *publisher->table, fmt::format("Latency/stream/{}", i.first()),
+          publisher->streamLatencyPublishers[i.first()], sink,
+          CS_SINK_FRAME_LATENCY);
+    }
+  }
+}
+
 static std::string PixelFormatToString(int pixelFormat) {
   switch (pixelFormat) {
     case cs::VideoMode::PixelFormat::kMJPEG:
@@ -254,6 +315,8 @@ static std::string PixelFormatToString(int pixelFormat) {
       return "BGR";
     case cs::VideoMode::PixelFormat::kGray:
       return "Gray";
+    case cs::VideoMode::PixelFormat::kUYVY:
+      return "UYVY";
     default:
       return "Unknown";
   }
@@ -378,6 +441,10 @@ Instance::Instance() {
   // - "modes" (string array): Available video modes
   // - "Property/{Property}" - Property values
   // - "PropertyInfo/{Property}" - Property supporting information
+  // - "Latency/{capture,convert}" and "Latency/stream/{Sink.Name}" (integer
+  //   array): Median, 90th, and 99th percentile latency in microseconds, of
+  //   the source and of each sink streaming it; only published if telemetry
+  //   has been enabled with cs::SetTelemetryPeriod()
 
   // Listener for video events
   m_videoListener = cs::VideoListener{
@@ -458,11 +525,14 @@ Instance::Instance() {
             m_addresses = cs::GetNetworkInterfaces();
             UpdateStreamValues();
             break;
+          case cs::VideoEvent::kTelemetryUpdated:
+            UpdateLatencyValues();
+            break;
           default:
             break;
         }
       },
-      0x4fff, true};
+      0xcfff, true};
 }
 
 cs::UsbCamera CameraServer::StartAutomaticCapture() {
@@ -0,0 +1,165 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "vision/PipelinedVisionRunner.h"
+
+#include <thread>
+#include <utility>
+
+#include <opencv2/core/mat.hpp>
+
+#include "cameraserver/CameraServerShared.h"
+
+using namespace frc;
+
+struct PipelinedVisionRunnerBase::Worker {
+  explicit Worker(int index) : index{index} {}
+
+  int index;
+  std::thread thread;
+
+  // protected by m_mutex
+  bool busy = false;
+  cv::Mat image;
+  uint64_t frameTime = 0;
+  uint64_t sequence = 0;
+};
+
+PipelinedVisionRunnerBase::PipelinedVisionRunnerBase(
+    cs::VideoSource videoSource, int numWorkers)
+    : m_cvSink("PipelinedVisionRunner CvSink"),
+      m_enabled(true),
+      m_pending(std::make_unique<cv::Mat>()) {
+  m_cvSink.SetSource(videoSource);
+  for (int i = 0; i < numWorkers; ++i) {
+    m_workers.emplace_back(std::make_unique<Worker>(i));
+  }
+}
+
+// Located here and not in header due to cv::Mat forward declaration.
+PipelinedVisionRunnerBase::~PipelinedVisionRunnerBase() = default;
+
+void PipelinedVisionRunnerBase::RunForever() {
+  auto csShared = frc::GetCameraServerShared();
+  auto res = csShared->GetRobotMainThreadId();
+  if (res.second && (std::this_thread::get_id() == res.first)) {
+    csShared->SetVisionRunnerError(
+        "PipelinedVisionRunner::RunForever() cannot be called from the main "
+        "robot thread");
+    return;
+  }
+  if (m_workers.empty()) {
+    csShared->SetVisionRunnerError(
+        "PipelinedVisionRunner needs at least one pipeline");
+    return;
+  }
+  if (m_running.exchange(true)) {
+    csShared->SetVisionRunnerError(
+        "PipelinedVisionRunner::RunForever() is already running");
+    return;
+  }
+
+  {
+    std::scoped_lock lock(m_mutex);
+    m_active = true;
+    m_pendingTime = 0;
+    m_nextSequence = 0;
+    m_nextDeliver = 0;
+    for (auto&& worker : m_workers) {
+      worker->busy = false;
+      worker->thread = std::thread(&PipelinedVisionRunnerBase::WorkerMain,
+                                   this, std::ref(*worker));
+    }
+  }
+
+  cv::Mat image;
+  while (m_enabled) {
+    auto frameTime = m_cvSink.GrabFrame(image);
+    if (frameTime == 0) {
+      auto error = m_cvSink.GetError();
+      csShared->ReportDriverStationError(error.c_str());
+      continue;
+    }
+
+    std::scoped_lock lock(m_mutex);
+    Worker* idle = nullptr;
+    for (auto&& worker : m_workers) {
+      if (!worker->busy) {
+        idle = worker.get();
+        break;
+      }
+    }
+    if (idle) {
+      // swap rather than copy; the worker's old image becomes our grab buffer
+      std::swap(idle->image, image);
+      idle->frameTime = frameTime;
+      idle->sequence = m_nextSequence++;
+      idle->busy = true;
+      m_workerCv.notify_all();
+    } else {
+      // hold the newest frame for the first worker to finish
+      if (m_pendingTime != 0) {
+        ++m_droppedFrames;
+      }
+      std::swap(*m_pending, image);
+      m_pendingTime = frameTime;
+    }
+  }
+
+  {
+    std::scoped_lock lock(m_mutex);
+    m_active = false;
+    m_workerCv.notify_all();
+    m_deliverCv.notify_all();
+  }
+  for (auto&& worker : m_workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  m_running = false;
+}
+
+void PipelinedVisionRunnerBase::Stop() {
+  m_enabled = false;
+}
+
+void PipelinedVisionRunnerBase::WorkerMain(Worker& worker) {
+  std::unique_lock lock(m_mutex);
+  for (;;) {
+    m_workerCv.wait(lock, [&] { return !m_active || worker.busy; });
+    if (!m_active) {
+      return;
+    }
+
+    lock.unlock();
+    DoProcess(worker.index, worker.image);
+    lock.lock();
+
+    // deliver in frame order; sequence numbers are only assigned to frames
+    // handed to a worker, so there are no gaps to wait on
+    m_deliverCv.wait(
+        lock, [&] { return !m_active || m_nextDeliver == worker.sequence; });
+    if (!m_active) {
+      return;
+    }
+
+    lock.unlock();
+    DoDeliver(worker.index, worker.frameTime);
+    lock.lock();
+
+    ++m_nextDeliver;
+    m_deliverCv.notify_all();
+
+    // pick up the held frame, if any, without waiting for the next grab
+    if (m_pendingTime != 0) {
+      std::swap(worker.image, *m_pending);
+      worker.frameTime = m_pendingTime;
+      worker.sequence = m_nextSequence++;
+      m_pendingTime = 0;
+    } else {
+      worker.busy = false;
+    }
+  }
+}
@@ -0,0 +1,147 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <wpi/condition_variable.h>
+#include <wpi/mutex.h>
+
+#include "cscore.h"
+#include "cscore_cv.h"
+#include "vision/VisionPipeline.h"
+
+namespace frc {
+
+/**
+ * Non-template base class for PipelinedVisionRunner.
+ */
+class PipelinedVisionRunnerBase {
+ public:
+  /**
+   * Creates a new pipelined vision runner. It will take images from the
+   * {@code videoSource}, and call the virtual DoProcess() and DoDeliver()
+   * methods on {@code numWorkers} worker threads.
+   *
+   * @param videoSource the video source to use to supply images for the
+   *                    pipelines
+   * @param numWorkers  the number of worker threads
+   */
+  PipelinedVisionRunnerBase(cs::VideoSource videoSource, int numWorkers);
+
+  ~PipelinedVisionRunnerBase();
+
+  PipelinedVisionRunnerBase(const PipelinedVisionRunnerBase&) = delete;
+  PipelinedVisionRunnerBase& operator=(const PipelinedVisionRunnerBase&) =
+      delete;
+
+  /**
+   * Starts the worker threads and grabs frames from the video source until
+   * Stop() is called, handing each frame to an idle worker. If every worker
+   * is busy, the frame is held until one becomes idle; a newer frame replaces
+   * a held one, so the runner drops frames rather than falling behind. This
+   * must be run in a dedicated thread, and cannot be used in the main robot
+   * thread because it will freeze the robot program.
+   *
+   * <p>Only one RunForever() loop can run at a time; calls made while one
+   * is running return immediately.
+   *
+   * <strong>Do not call this method directly from the main thread.</strong>
+   */
+  void RunForever();
+
+  /**
+   * Stop a RunForever() loop. Frames still being processed are not
+   * delivered.
+   */
+  void Stop();
+
+  /**
+   * Gets the number of frames that were dropped because every worker was
+   * busy.
+   *
+   * @return Number of dropped frames
+   */
+  uint64_t GetDroppedFrames() const { return m_droppedFrames; }
+
+ protected:
+  /**
+   * Processes an image on a worker thread. Calls for different workers run
+   * concurrently.
+   *
+   * @param worker worker index
+   * @param image  image to process
+   */
+  virtual void DoProcess(int worker, cv::Mat& image) = 0;
+
+  /**
+   * Delivers the result of the worker's last DoProcess() call. Calls are
+   * made one at a time, in frame order.
+   *
+   * @param worker    worker index
+   * @param frameTime frame time of the processed image
+   */
+  virtual void DoDeliver(int worker, uint64_t frameTime) = 0;
+
+ private:
+  struct Worker;
+
+  void WorkerMain(Worker& worker);
+
+  cs::CvSink m_cvSink;
+  std::atomic_bool m_enabled;
+  // set while RunForever() is running
+  std::atomic_bool m_running{false};
+  std::atomic<uint64_t> m_droppedFrames{0};
+
+  wpi::mutex m_mutex;
+  wpi::condition_variable m_workerCv;
+  wpi::condition_variable m_deliverCv;
+  bool m_active = false;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  // newest frame not yet handed to a worker
+  std::unique_ptr<cv::Mat> m_pending;
+  uint64_t m_pendingTime = 0;
+  // sequence number of the next frame handed to a worker, and of the next
+  // frame to be delivered
+  uint64_t m_nextSequence = 0;
+  uint64_t m_nextDeliver = 0;
+};
+
+/**
+ * A pipelined vision runner processes frames from a video source on several
+ * worker threads, each with its own pipeline instance, so a pipeline that
+ * takes longer than the frame period can still keep up with the camera.
+ * Results are delivered to the listener in frame order, one at a time, along
+ * with the frame time; the listener is called on the worker thread that ran
+ * the pipeline, and the pipeline's outputs are only valid for the duration of
+ * the call.
+ *
+ * @see VisionRunner
+ * @see VisionPipeline
+ */
+template <typename T>
+class PipelinedVisionRunner : public PipelinedVisionRunnerBase {
+ public:
+  PipelinedVisionRunner(cs::VideoSource videoSource, std::vector<T*> pipelines,
+                        std::function<void(T&, uint64_t)> listener);
+  virtual ~PipelinedVisionRunner() = default;
+
+ protected:
+  void DoProcess(int worker, cv::Mat& image) override;
+  void DoDeliver(int worker, uint64_t frameTime) override;
+
+ private:
+  std::vector<T*> m_pipelines;
+  std::function<void(T&, uint64_t)> m_listener;
+};
+}  // namespace frc
+
+#include "PipelinedVisionRunner.inc"
@@ -0,0 +1,171 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "vision/PipelinedVisionRunner.h"  // NOLINT(build/include_order)
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <wpi/mutex.h>
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Records the number of the frame it processed (stored in the first pixel).
+// Odd frames take longer to process, so workers finish out of order.
+class TestPipeline : public frc::VisionPipeline {
+ public:
+  explicit TestPipeline(std::chrono::milliseconds oddDelay,
+                        std::chrono::milliseconds evenDelay = 1ms)
+      : m_oddDelay{oddDelay}, m_evenDelay{evenDelay} {}
+
+  void Process(cv::Mat& mat) override {
+    frame = mat.data[0];
+    std::this_thread::sleep_for(frame % 2 == 1 ? m_oddDelay : m_evenDelay);
+  }
+
+  int frame = 0;
+
+ private:
+  std::chrono::milliseconds m_oddDelay;
+  std::chrono::milliseconds m_evenDelay;
+};
+
+// Delivered frame numbers and times
+struct Deliveries {
+  void operator()(TestPipeline& pipeline, uint64_t time) {
+    std::scoped_lock lock{mutex};
+    frames.push_back(pipeline.frame);
+    times.push_back(time);
+  }
+
+  size_t size() {
+    std::scoped_lock lock{mutex};
+    return frames.size();
+  }
+
+  wpi::mutex mutex;
+  std::vector<int> frames;
+  std::vector<uint64_t> times;
+};
+
+}  // namespace
+
+class PipelinedVisionRunnerTest : public ::testing::Test {
+ protected:
+  static constexpr int kWidth = 32;
+  static constexpr int kHeight = 24;
+
+  ~PipelinedVisionRunnerTest() override { StopFeeding(); }
+
+  // Puts frames numbered 1 to numFrames (at most 255) into the source
+  void StartFeeding(int numFrames, std::chrono::milliseconds period) {
+    m_feeder = std::thread([=, this] {
+      for (int i = 1; i <= numFrames && m_feeding; ++i) {
+        cv::Mat image{kHeight, kWidth, CV_8UC3, cv::Scalar::all(i)};
+        m_source.PutFrame(image);
+        std::this_thread::sleep_for(period);
+      }
+    });
+  }
+
+  void StopFeeding() {
+    m_feeding = false;
+    if (m_feeder.joinable()) {
+      m_feeder.join();
+    }
+  }
+
+  // Waits up to 5 seconds for the predicate to become true
+  template <typename F>
+  static bool WaitFor(F&& pred) {
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!pred()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(1ms);
+    }
+    return true;
+  }
+
+  static void ExpectIncreasing(Deliveries& deliveries) {
+    std::scoped_lock lock{deliveries.mutex};
+    for (size_t i = 1; i < deliveries.frames.size(); ++i) {
+      EXPECT_GT(deliveries.frames[i], deliveries.frames[i - 1]) << i;
+      EXPECT_GT(deliveries.times[i], deliveries.times[i - 1]) << i;
+    }
+  }
+
+  cs::CvSource m_source{"source", cs::VideoMode::kBGR, kWidth, kHeight, 30};
+  std::atomic_bool m_feeding{true};
+  std::thread m_feeder;
+};
+
+TEST_F(PipelinedVisionRunnerTest, DeliversInFrameOrder) {
+  TestPipeline pipeline1{20ms}, pipeline2{20ms}, pipeline3{20ms};
+  Deliveries deliveries;
+  frc::PipelinedVisionRunner<TestPipeline> runner{
+      m_source, {&pipeline1, &pipeline2, &pipeline3}, std::ref(deliveries)};
+
+  StartFeeding(200, 5ms);
+  std::thread thread{[&] { runner.RunForever(); }};
+  EXPECT_TRUE(WaitFor([&] { return deliveries.size() >= 20; }));
+  runner.Stop();
+  thread.join();
+
+  ExpectIncreasing(deliveries);
+}
+
+TEST_F(PipelinedVisionRunnerTest, CountsDroppedFrames) {
+  // a single worker that can't keep up
+  TestPipeline pipeline{20ms, 20ms};
+  Deliveries deliveries;
+  frc::PipelinedVisionRunner<TestPipeline> runner{m_source, {&pipeline},
+                                                  std::ref(deliveries)};
+
+  StartFeeding(100, 2ms);
+  std::thread thread{[&] { runner.RunForever(); }};
+  EXPECT_TRUE(WaitFor([&] { return runner.GetDroppedFrames() >= 5; }));
+  StopFeeding();
+  runner.Stop();
+  thread.join();
+
+  EXPECT_GT(deliveries.size(), 0u);
+  EXPECT_LE(deliveries.size() + runner.GetDroppedFrames(), 100u);
+  ExpectIncreasing(deliveries);
+}
+
+TEST_F(PipelinedVisionRunnerTest, StopJoinsWorkers) {
+  TestPipeline pipeline1{5ms}, pipeline2{5ms};
+  std::atomic_int delivered{0};
+  frc::PipelinedVisionRunner<TestPipeline> runner{
+      m_source, {&pipeline1, &pipeline2},
+      [&](TestPipeline&, uint64_t) { ++delivered; }};
+
+  StartFeeding(255, 5ms);
+  std::thread thread{[&] { runner.RunForever(); }};
+  EXPECT_TRUE(WaitFor([&] { return delivered > 0; }));
+
+  // a second loop can't be started while one is running
+  runner.RunForever();
+
+  runner.Stop();
+  thread.join();
+
+  // nothing is delivered once RunForever() has returned
+  int count = delivered;
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(delivered, count);
+}
@@ -67,6 +67,9 @@ int main() {
         case cs::VideoMode::kRGB565:
           pixelFormat = "RGB565";
           break;
+        case cs::VideoMode::kUYVY:
+          pixelFormat = "UYVY";
+          break;
         default:
           pixelFormat = "Unknown";
           break;
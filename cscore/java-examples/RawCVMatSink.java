@@ -23,6 +23,7 @@ public class RawCVMatSink extends ImageSink {
     int type = 0;
     switch (pixelFormat) {
       case kYUYV:
+      case kUYVY:
       case kRGB565:
         type = CvType.CV_8UC2;
         break;
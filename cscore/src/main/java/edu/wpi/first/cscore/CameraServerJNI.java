@@ -170,6 +170,8 @@ public class CameraServerJNI {
 
   public static native UsbCameraInfo getUsbCameraInfo(int source);
 
+  public static native void setUsbCameraSharedCapture(boolean enabled);
+
   //
   // HttpCamera Source Functions
   //
@@ -258,6 +260,8 @@ public class CameraServerJNI {
 
   public static native int getMjpegServerPort(int sink);
 
+  public static native void setMjpegServerEventLoop(boolean enabled);
+
   //
   // Image Sink Functions
   //
@@ -335,7 +339,14 @@ public class CameraServerJNI {
   //
   public enum TelemetryKind {
     kSourceBytesReceived(1),
-    kSourceFramesReceived(2);
+    kSourceFramesReceived(2),
+    kSourceJpegCacheHits(3),
+    kSourceJpegCacheMisses(4),
+    kSourceImagePoolHits(5),
+    kSourceImagePoolMisses(6),
+    kSourceCaptureLatency(7),
+    kSourceConvertLatency(8),
+    kSinkFrameLatency(9);
 
     private final int value;
 
@@ -364,6 +375,12 @@ public class CameraServerJNI {
     return getTelemetryAverageValue(handle, kind.getValue());
   }
 
+  public static native long getTelemetryLatency(int handle, int kind, double percentile);
+
+  public static long getTelemetryLatency(int handle, TelemetryKind kind, double percentile) {
+    return getTelemetryLatency(handle, kind.getValue(), percentile);
+  }
+
   //
   // Logging Functions
   //
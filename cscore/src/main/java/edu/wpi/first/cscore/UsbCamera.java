@@ -71,4 +71,16 @@ public class UsbCamera extends VideoCamera {
     CameraServerJNI.setProperty(
         CameraServerJNI.getSourceProperty(m_handle, "connect_verbose"), level);
   }
+
+  /**
+   * Set whether frames are captured directly into frame buffers (zero-copy) rather than copied
+   * from the driver's buffers. This is only supported on Linux, and falls back to copying if the
+   * driver doesn't support it.
+   *
+   * @param enabled true to enable zero-copy capture
+   */
+  public void setZeroCopy(boolean enabled) {
+    CameraServerJNI.setProperty(
+        CameraServerJNI.getSourceProperty(m_handle, "zero_copy"), enabled ? 1 : 0);
+  }
 }
@@ -13,7 +13,8 @@ public class VideoMode {
     kYUYV(2),
     kRGB565(3),
     kBGR(4),
-    kGray(5);
+    kGray(5),
+    kUYVY(6);
 
     private final int value;
 
@@ -4,6 +4,10 @@
 
 #include "CvSinkImpl.h"
 
+#include <memory>
+#include <optional>
+#include <utility>
+
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
@@ -71,6 +75,7 @@ uint64_t CvSinkImpl::GrabFrame(cv::Mat& image) {
     return 0;
   }
 
+  RecordFrameLatency(frame);
   return frame.GetTime();
 }
 
@@ -97,9 +102,64 @@ uint64_t CvSinkImpl::GrabFrame(cv::Mat& image, double timeout) {
     return 0;
   }
 
+  RecordFrameLatency(frame);
   return frame.GetTime();
 }
 
+namespace {
+// Keeps a frame (and the source that owns its buffers) alive while a view of
+// one of its images is in use
+struct FrameLease {
+  FrameLease(std::shared_ptr<SourceImpl> source_, Frame frame_,
+             cv::Mat image_)
+      : source{std::move(source_)},
+        frame{std::move(frame_)},
+        image{std::move(image_)} {}
+
+  std::shared_ptr<SourceImpl> source;
+  Frame frame;
+  cv::Mat image;
+};
+}  // namespace
+
+uint64_t CvSinkImpl::GrabFrameNoCopy(std::shared_ptr<const cv::Mat>& image,
+                                     std::optional<double> timeout) {
+  SetEnabled(true);
+
+  // release the previous frame so the source can reuse its buffers
+  image.reset();
+
+  auto source = GetSource();
+  if (!source) {
+    // Source disconnected; sleep for one second
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    return 0;
+  }
+
+  auto frame = timeout ? source->GetNextFrame(*timeout)
+                       : source->GetNextFrame();  // blocks
+  if (!frame) {
+    // Bad frame; sleep for 20 ms so we don't consume all processor time.
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return 0;  // signal error
+  }
+
+  Image* rawImage = frame.GetImage(frame.GetOriginalWidth(),
+                                   frame.GetOriginalHeight(), VideoMode::kBGR);
+  if (!rawImage) {
+    // Shouldn't happen, but just in case...
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return 0;
+  }
+
+  RecordFrameLatency(frame);
+  uint64_t time = frame.GetTime();
+  auto lease = std::make_shared<FrameLease>(std::move(source), std::move(frame),
+                                            rawImage->AsMat());
+  image = std::shared_ptr<const cv::Mat>{lease, &lease->image};
+  return time;
+}
+
 // Send HTTP response and a stream of JPG-frames
 void CvSinkImpl::ThreadMain() {
   Enable();
@@ -174,6 +234,29 @@ uint64_t GrabSinkFrameTimeout(CS_Sink sink, cv::Mat& image, double timeout,
   return static_cast<CvSinkImpl&>(*data->sink).GrabFrame(image, timeout);
 }
 
+uint64_t GrabSinkFrameNoCopy(CS_Sink sink,
+                             std::shared_ptr<const cv::Mat>& image,
+                             CS_Status* status) {
+  auto data = Instance::GetInstance().GetSink(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<CvSinkImpl&>(*data->sink).GrabFrameNoCopy(image);
+}
+
+uint64_t GrabSinkFrameNoCopyTimeout(CS_Sink sink,
+                                    std::shared_ptr<const cv::Mat>& image,
+                                    double timeout, CS_Status* status) {
+  auto data = Instance::GetInstance().GetSink(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<CvSinkImpl&>(*data->sink).GrabFrameNoCopy(image,
+                                                                timeout);
+}
+
 std::string GetSinkError(CS_Sink sink, CS_Status* status) {
   auto data = Instance::GetInstance().GetSink(sink);
   if (!data || (data->kind & SinkMask) == 0) {
@@ -9,6 +9,8 @@
 
 #include <atomic>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <string_view>
 #include <thread>
 
@@ -35,6 +37,10 @@ class CvSinkImpl : public SinkImpl {
 
   uint64_t GrabFrame(cv::Mat& image);
   uint64_t GrabFrame(cv::Mat& image, double timeout);
+  // Waits (up to timeout seconds, if given) for the next frame and leases
+  // its BGR image; see CvSink::GrabFrameNoCopy()
+  uint64_t GrabFrameNoCopy(std::shared_ptr<const cv::Mat>& image,
+                           std::optional<double> timeout = {});
 
  private:
   void ThreadMain();
@@ -4,11 +4,18 @@
 
 #include "Frame.h"
 
+#include <stdint.h>
+
+#include <algorithm>
 #include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
+#include <wpi/timestamp.h>
 
 #include "Instance.h"
 #include "Log.h"
@@ -21,13 +28,16 @@ Frame::Frame(SourceImpl& source, std::string_view error, Time time)
   m_impl->refcount = 1;
   m_impl->error = error;
   m_impl->time = time;
+  m_impl->captureTime = 0;
 }
 
-Frame::Frame(SourceImpl& source, std::unique_ptr<Image> image, Time time)
+Frame::Frame(SourceImpl& source, std::unique_ptr<Image> image, Time time,
+             Time captureTime)
     : m_impl{source.AllocFrameImpl().release()} {
   m_impl->refcount = 1;
   m_impl->error.resize(0);
   m_impl->time = time;
+  m_impl->captureTime = captureTime;
   m_impl->images.push_back(image.release());
 }
 
@@ -103,6 +113,17 @@ Image* Frame::GetNearestImage(int width, int height,
     }
   }
 
+  // Upscaling a smaller image loses detail.  If there's a JPEG at least the
+  // requested size (e.g. the original, when only reduced-scale decodes of it
+  // exist), skip the smaller-image fallbacks below and decode it instead.
+  bool haveLargerJpeg = false;
+  for (auto i : m_impl->images) {
+    if (i->pixelFormat == VideoMode::kMJPEG && i->IsLarger(width, height)) {
+      haveLargerJpeg = true;
+      break;
+    }
+  }
+
   // 3) Different width, height, same pixelFormat (only if non-JPEG) (resample)
   if (pixelFormat != VideoMode::kMJPEG) {
     // 3a) Smallest image at least width/height in size
@@ -117,13 +138,16 @@ Image* Frame::GetNearestImage(int width, int height,
     }
 
     // 3b) Largest image (less than width/height)
-    for (auto i : m_impl->images) {
-      if (i->pixelFormat == pixelFormat && (!found || (i->IsLarger(*found)))) {
-        found = i;
+    if (!haveLargerJpeg) {
+      for (auto i : m_impl->images) {
+        if (i->pixelFormat == pixelFormat &&
+            (!found || (i->IsLarger(*found)))) {
+          found = i;
+        }
+      }
+      if (found) {
+        return found;
       }
-    }
-    if (found) {
-      return found;
     }
   }
 
@@ -141,14 +165,16 @@ Image* Frame::GetNearestImage(int width, int height,
   }
 
   // 4b) Largest image (less than width/height)
-  for (auto i : m_impl->images) {
-    if (i->pixelFormat != VideoMode::kMJPEG &&
-        (!found || (i->IsLarger(*found)))) {
-      found = i;
+  if (!haveLargerJpeg) {
+    for (auto i : m_impl->images) {
+      if (i->pixelFormat != VideoMode::kMJPEG &&
+          (!found || (i->IsLarger(*found)))) {
+        found = i;
+      }
+    }
+    if (found) {
+      return found;
     }
-  }
-  if (found) {
-    return found;
   }
 
   // 5) Same width, height, JPEG pixelFormat (decompression).  As there may be
@@ -195,164 +221,308 @@ Image* Frame::GetNearestImage(int width, int height,
   return m_impl->images.empty() ? nullptr : m_impl->images[0];
 }
 
+static constexpr int kNumPixelFormats = VideoMode::kUYVY + 1;
+
+// Approximate relative cost (per pixel) of each direct conversion, indexed by
+// [from][to] pixel format; 0 if there is no direct conversion.
+static constexpr int kConvertCost[kNumPixelFormats][kNumPixelFormats] = {
+    // to: Unknown, MJPEG, YUYV, RGB565, BGR, Gray, UYVY
+    {0, 0, 0, 0, 0, 0, 0},     // from Unknown
+    {0, 0, 0, 0, 100, 50, 0},  // from MJPEG
+    {0, 0, 0, 8, 10, 2, 0},    // from YUYV
+    {0, 0, 0, 0, 6, 0, 0},     // from RGB565
+    {0, 120, 0, 6, 0, 6, 0},   // from BGR
+    {0, 50, 0, 4, 4, 0, 0},    // from Gray
+    {0, 0, 0, 8, 10, 2, 0},    // from UYVY
+};
+
+// BT.601 (video range) YUV to RGB fixed-point coefficients, as used by
+// OpenCV's cvtColor(), so the direct conversions match the two-step ones
+static constexpr int kYuvShift = 20;
+static constexpr int kYuvRound = 1 << (kYuvShift - 1);
+static constexpr int kYuvCY = 1220542;
+static constexpr int kYuvCUB = 2116026;
+static constexpr int kYuvCUG = -409993;
+static constexpr int kYuvCVG = -852492;
+static constexpr int kYuvCVR = 1673527;
+
+// Compresses an image into a JPEG image.  cv::imencode() can only encode
+// into a std::vector, so the result keeps that rather than using pool storage
+// (see Image).
+static std::unique_ptr<Image> EncodeJpeg(Image* image, int quality) {
+  // We don't actually know what the resulting size will be; while the
+  // destination will automatically grow, doing so will cause an extra malloc,
+  // so we don't want to be too conservative here.  Per Wikipedia, Q=100 on a
+  // sample image results in 8.25 bits per pixel, this is a little bit more
+  // conservative in assuming 50% space savings over the source image.
+  std::vector<uchar> buf;
+  buf.reserve(image->size() / 2);
+  cv::imencode(".jpg", image->AsMat(), buf,
+               {cv::IMWRITE_JPEG_QUALITY, quality});
+  auto newImage = std::make_unique<Image>(std::move(buf));
+  newImage->pixelFormat = VideoMode::kMJPEG;
+  newImage->width = image->width;
+  newImage->height = image->height;
+  newImage->jpegQuality = quality;
+  return newImage;
+}
+
+static int GetConvertCost(int from, int to) {
+  if (from < 0 || from >= kNumPixelFormats || to < 0 ||
+      to >= kNumPixelFormats) {
+    return 0;
+  }
+  return kConvertCost[from][to];
+}
+
+static int GetBytesPerPixel(VideoMode::PixelFormat pixelFormat) {
+  switch (pixelFormat) {
+    case VideoMode::kYUYV:
+    case VideoMode::kUYVY:
+    case VideoMode::kRGB565:
+      return 2;
+    case VideoMode::kBGR:
+      return 3;
+    default:
+      return 1;
+  }
+}
+
+// Gets the largest JPEG decoder scale-down factor (1, 2, 4, or 8) that results
+// in an image at least the requested size
+static int GetJpegDecodeScale(int width, int height, int requestedWidth,
+                              int requestedHeight) {
+  for (int scale = 8; scale > 1; scale /= 2) {
+    if ((width + scale - 1) / scale >= requestedWidth &&
+        (height + scale - 1) / scale >= requestedHeight) {
+      return scale;
+    }
+  }
+  return 1;
+}
+
+static inline uint16_t ToRGB565(int y, int ruv, int guv, int buv) {
+  y = std::max(0, y - 16) * kYuvCY;
+  int r = std::clamp((y + ruv) >> kYuvShift, 0, 255);
+  int g = std::clamp((y + guv) >> kYuvShift, 0, 255);
+  int b = std::clamp((y + buv) >> kYuvShift, 0, 255);
+  // same channel order as ConvertBGRToRGB565()
+  return (r >> 3) | ((g >> 2) << 5) | ((b >> 3) << 11);
+}
+
+// Converts packed 4:2:2 YUV (YUYV if YIndex is 0, UYVY if YIndex is 1) to
+// RGB565 in a single pass.  This is a plain loop over pixel pairs so the
+// compiler can vectorize it.
+template <int YIndex>
+static void ConvertYUV422ToRGB565(const uint8_t* src, uint16_t* dst,
+                                  size_t numPairs) {
+  constexpr int kUIndex = 1 - YIndex;
+  constexpr int kVIndex = kUIndex + 2;
+  for (size_t i = 0; i < numPairs; ++i, src += 4, dst += 2) {
+    int u = src[kUIndex] - 128;
+    int v = src[kVIndex] - 128;
+    int ruv = kYuvRound + kYuvCVR * v;
+    int guv = kYuvRound + kYuvCVG * v + kYuvCUG * u;
+    int buv = kYuvRound + kYuvCUB * u;
+    dst[0] = ToRGB565(src[YIndex], ruv, guv, buv);
+    dst[1] = ToRGB565(src[YIndex + 2], ruv, guv, buv);
+  }
+}
+
 Image* Frame::ConvertImpl(Image* image, VideoMode::PixelFormat pixelFormat,
                           int requiredJpegQuality, int defaultJpegQuality) {
   if (!image || image->Is(image->width, image->height, pixelFormat,
                           requiredJpegQuality)) {
     return image;
   }
-  Image* cur = image;
+  if (!m_impl) {
+    return nullptr;
+  }
 
-  // If the source image is a JPEG, we need to decode it before we can do
-  // anything else with it.  Note that if the destination format is JPEG, we
-  // still need to do this (unless it was already a JPEG, in which case we
-  // would have returned above).
-  if (cur->pixelFormat == VideoMode::kMJPEG) {
-    cur = ConvertMJPEGToBGR(cur);
-    if (pixelFormat == VideoMode::kBGR) {
-      return cur;
+  // We may have already converted to this format (e.g. for another sink).
+  // The lock is only held for lookups and inserts (see AddImage()), so other
+  // threads can use the frame's existing images while this one converts.
+  Image* bgr;
+  {
+    std::scoped_lock lock(m_impl->mutex);
+    if (Image* existing = GetExistingImage(image->width, image->height,
+                                           pixelFormat, requiredJpegQuality)) {
+      return existing;
     }
+    bgr = image->pixelFormat == VideoMode::kBGR
+              ? image
+              : GetExistingImage(image->width, image->height, VideoMode::kBGR);
+  }
+
+  // Pick the cheapest chain of conversions.  Lossy formats are never used as
+  // intermediates, so the options are a direct conversion or a conversion
+  // through BGR.  A BGR version may already exist; if so, start from it.
+  // Note if the source image is a JPEG and the destination is a JPEG with a
+  // different quality, this decodes to BGR and re-encodes.
+  Image* source = nullptr;
+  bool viaBGR = false;
+  int bestCost = 0;
+  if (int cost = GetConvertCost(image->pixelFormat, pixelFormat); cost > 0) {
+    source = image;
+    bestCost = cost;
+  }
+  if (int fromBGR = GetConvertCost(VideoMode::kBGR, pixelFormat);
+      fromBGR > 0) {
+    if (bgr) {
+      if (!source || fromBGR < bestCost) {
+        source = bgr;
+        bestCost = fromBGR;
+      }
+    } else if (int toBGR = GetConvertCost(image->pixelFormat, VideoMode::kBGR);
+               toBGR > 0 && (!source || toBGR + fromBGR < bestCost)) {
+      source = image;
+      viaBGR = true;
+      bestCost = toBGR + fromBGR;
+    }
+  }
+  if (!source) {
+    return nullptr;  // Unsupported
   }
 
-  // Color convert
-  switch (pixelFormat) {
-    case VideoMode::kRGB565:
-      // If source is YUYV or Gray, need to convert to BGR first
-      if (cur->pixelFormat == VideoMode::kYUYV) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR)) {
-          cur = newImage;
-        } else {
-          cur = ConvertYUYVToBGR(cur);
-        }
-      } else if (cur->pixelFormat == VideoMode::kGray) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR)) {
-          cur = newImage;
-        } else {
-          cur = ConvertGrayToBGR(cur);
-        }
+  auto start = wpi::Now();
+  Image* cur = source;
+  if (viaBGR) {
+    cur = ConvertDirect(cur, VideoMode::kBGR, defaultJpegQuality);
+  }
+  cur = ConvertDirect(cur, pixelFormat, defaultJpegQuality);
+  if (cur) {
+    Instance::GetInstance().telemetry.RecordSourceConvertLatency(
+        m_impl->source, wpi::Now() - start);
+  }
+  return cur;
+}
+
+Image* Frame::ConvertDirect(Image* image, VideoMode::PixelFormat pixelFormat,
+                            int jpegQuality) {
+  if (!image) {
+    return nullptr;
+  }
+  switch (image->pixelFormat) {
+    case VideoMode::kMJPEG:
+      if (pixelFormat == VideoMode::kBGR) {
+        return ConvertMJPEGToBGR(image);
+      } else if (pixelFormat == VideoMode::kGray) {
+        return ConvertMJPEGToGray(image);
       }
-      return ConvertBGRToRGB565(cur);
-    case VideoMode::kGray:
-      // If source is YUYV or RGB565, need to convert to BGR first
-      if (cur->pixelFormat == VideoMode::kYUYV) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR)) {
-          cur = newImage;
-        } else {
-          cur = ConvertYUYVToBGR(cur);
-        }
-      } else if (cur->pixelFormat == VideoMode::kRGB565) {
-        // Check to see if BGR version already exists...
-        if (Image* newImage =
-                GetExistingImage(cur->width, cur->height, VideoMode::kBGR)) {
-          cur = newImage;
-        } else {
-          cur = ConvertRGB565ToBGR(cur);
-        }
+      break;
+    case VideoMode::kYUYV:
+      if (pixelFormat == VideoMode::kBGR) {
+        return ConvertYUYVToBGR(image);
+      } else if (pixelFormat == VideoMode::kGray) {
+        return ConvertYUYVToGray(image);
+      } else if (pixelFormat == VideoMode::kRGB565) {
+        return ConvertYUYVToRGB565(image);
       }
-      return ConvertBGRToGray(cur);
+      break;
+    case VideoMode::kUYVY:
+      if (pixelFormat == VideoMode::kBGR) {
+        return ConvertUYVYToBGR(image);
+      } else if (pixelFormat == VideoMode::kGray) {
+        return ConvertUYVYToGray(image);
+      } else if (pixelFormat == VideoMode::kRGB565) {
+        return ConvertUYVYToRGB565(image);
+      }
+      break;
+    case VideoMode::kRGB565:
+      if (pixelFormat == VideoMode::kBGR) {
+        return ConvertRGB565ToBGR(image);
+      }
+      break;
     case VideoMode::kBGR:
-    case VideoMode::kMJPEG:
-      if (cur->pixelFormat == VideoMode::kYUYV) {
-        cur = ConvertYUYVToBGR(cur);
-      } else if (cur->pixelFormat == VideoMode::kRGB565) {
-        cur = ConvertRGB565ToBGR(cur);
-      } else if (cur->pixelFormat == VideoMode::kGray) {
-        if (pixelFormat == VideoMode::kBGR) {
-          return ConvertGrayToBGR(cur);
-        } else {
-          return ConvertGrayToMJPEG(cur, defaultJpegQuality);
-        }
+      if (pixelFormat == VideoMode::kMJPEG) {
+        return ConvertBGRToMJPEG(image, jpegQuality);
+      } else if (pixelFormat == VideoMode::kGray) {
+        return ConvertBGRToGray(image);
+      } else if (pixelFormat == VideoMode::kRGB565) {
+        return ConvertBGRToRGB565(image);
+      }
+      break;
+    case VideoMode::kGray:
+      if (pixelFormat == VideoMode::kMJPEG) {
+        return ConvertGrayToMJPEG(image, jpegQuality);
+      } else if (pixelFormat == VideoMode::kBGR) {
+        return ConvertGrayToBGR(image);
+      } else if (pixelFormat == VideoMode::kRGB565) {
+        return ConvertGrayToRGB565(image);
       }
       break;
-    case VideoMode::kYUYV:
     default:
-      return nullptr;  // Unsupported
-  }
-
-  // Compress if destination is JPEG
-  if (pixelFormat == VideoMode::kMJPEG) {
-    cur = ConvertBGRToMJPEG(cur, defaultJpegQuality);
+      break;
   }
-
-  return cur;
+  return nullptr;
 }
 
-Image* Frame::ConvertMJPEGToBGR(Image* image) {
+Image* Frame::ConvertMJPEGToBGR(Image* image, int scale) {
   if (!image || image->pixelFormat != VideoMode::kMJPEG) {
     return nullptr;
   }
-
-  // Allocate an BGR image
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kBGR, image->width, image->height,
-                                image->width * image->height * 3);
-
-  // Decode
-  cv::Mat newMat = newImage->AsMat();
-  cv::imdecode(image->AsInputArray(), cv::IMREAD_COLOR, &newMat);
-
-  // Save the result
-  Image* rv = newImage.release();
-  if (m_impl) {
-    std::scoped_lock lock(m_impl->mutex);
-    m_impl->images.push_back(rv);
-  }
-  return rv;
+  return DecodeMJPEG(image, VideoMode::kBGR, scale);
 }
 
-Image* Frame::ConvertMJPEGToGray(Image* image) {
+Image* Frame::ConvertMJPEGToGray(Image* image, int scale) {
   if (!image || image->pixelFormat != VideoMode::kMJPEG) {
     return nullptr;
   }
+  // Only the luma channel is decoded
+  return DecodeMJPEG(image, VideoMode::kGray, scale);
+}
 
-  // Allocate an grayscale image
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kGray, image->width, image->height,
-                                image->width * image->height);
-
-  // Decode
-  cv::Mat newMat = newImage->AsMat();
-  cv::imdecode(image->AsInputArray(), cv::IMREAD_GRAYSCALE, &newMat);
+Image* Frame::ConvertYUYVToBGR(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kYUYV) {
+    return nullptr;
+  }
+  return ConvertCvtColor(image, VideoMode::kBGR, cv::COLOR_YUV2BGR_YUYV);
+}
 
-  // Save the result
-  Image* rv = newImage.release();
-  if (m_impl) {
-    std::scoped_lock lock(m_impl->mutex);
-    m_impl->images.push_back(rv);
+Image* Frame::ConvertYUYVToGray(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kYUYV) {
+    return nullptr;
   }
-  return rv;
+  // Extracts the Y channel
+  return ConvertCvtColor(image, VideoMode::kGray, cv::COLOR_YUV2GRAY_YUYV);
 }
 
-Image* Frame::ConvertYUYVToBGR(Image* image) {
+Image* Frame::ConvertYUYVToRGB565(Image* image) {
   if (!image || image->pixelFormat != VideoMode::kYUYV) {
     return nullptr;
   }
 
-  // Allocate a BGR image
+  // Allocate a RGB565 image
   auto newImage =
-      m_impl->source.AllocImage(VideoMode::kBGR, image->width, image->height,
-                                image->width * image->height * 3);
+      m_impl->source.AllocImage(VideoMode::kRGB565, image->width, image->height,
+                                image->width * image->height * 2);
 
   // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_YUV2BGR_YUYV);
+  ConvertYUV422ToRGB565<0>(reinterpret_cast<const uint8_t*>(image->data()),
+                           reinterpret_cast<uint16_t*>(newImage->data()),
+                           image->width * image->height / 2);
 
   // Save the result
-  Image* rv = newImage.release();
-  if (m_impl) {
-    std::scoped_lock lock(m_impl->mutex);
-    m_impl->images.push_back(rv);
+  return AddImage(std::move(newImage));
+}
+
+Image* Frame::ConvertUYVYToBGR(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kUYVY) {
+    return nullptr;
   }
-  return rv;
+  return ConvertCvtColor(image, VideoMode::kBGR, cv::COLOR_YUV2BGR_UYVY);
 }
 
-Image* Frame::ConvertBGRToRGB565(Image* image) {
-  if (!image || image->pixelFormat != VideoMode::kBGR) {
+Image* Frame::ConvertUYVYToGray(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kUYVY) {
+    return nullptr;
+  }
+  // Extracts the Y channel
+  return ConvertCvtColor(image, VideoMode::kGray, cv::COLOR_YUV2GRAY_UYVY);
+}
+
+Image* Frame::ConvertUYVYToRGB565(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kUYVY) {
     return nullptr;
   }
 
@@ -362,81 +532,47 @@ Image* Frame::ConvertBGRToRGB565(Image* image) {
                                 image->width * image->height * 2);
 
   // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_RGB2BGR565);
+  ConvertYUV422ToRGB565<1>(reinterpret_cast<const uint8_t*>(image->data()),
+                           reinterpret_cast<uint16_t*>(newImage->data()),
+                           image->width * image->height / 2);
 
   // Save the result
-  Image* rv = newImage.release();
-  if (m_impl) {
-    std::scoped_lock lock(m_impl->mutex);
-    m_impl->images.push_back(rv);
+  return AddImage(std::move(newImage));
+}
+
+Image* Frame::ConvertBGRToRGB565(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kBGR) {
+    return nullptr;
   }
-  return rv;
+  return ConvertCvtColor(image, VideoMode::kRGB565, cv::COLOR_RGB2BGR565);
 }
 
 Image* Frame::ConvertRGB565ToBGR(Image* image) {
   if (!image || image->pixelFormat != VideoMode::kRGB565) {
     return nullptr;
   }
-
-  // Allocate a BGR image
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kBGR, image->width, image->height,
-                                image->width * image->height * 3);
-
-  // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_BGR5652RGB);
-
-  // Save the result
-  Image* rv = newImage.release();
-  if (m_impl) {
-    std::scoped_lock lock(m_impl->mutex);
-    m_impl->images.push_back(rv);
-  }
-  return rv;
+  return ConvertCvtColor(image, VideoMode::kBGR, cv::COLOR_BGR5652RGB);
 }
 
 Image* Frame::ConvertBGRToGray(Image* image) {
   if (!image || image->pixelFormat != VideoMode::kBGR) {
     return nullptr;
   }
-
-  // Allocate a Grayscale image
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kGray, image->width, image->height,
-                                image->width * image->height);
-
-  // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_BGR2GRAY);
-
-  // Save the result
-  Image* rv = newImage.release();
-  if (m_impl) {
-    std::scoped_lock lock(m_impl->mutex);
-    m_impl->images.push_back(rv);
-  }
-  return rv;
+  return ConvertCvtColor(image, VideoMode::kGray, cv::COLOR_BGR2GRAY);
 }
 
 Image* Frame::ConvertGrayToBGR(Image* image) {
   if (!image || image->pixelFormat != VideoMode::kGray) {
     return nullptr;
   }
+  return ConvertCvtColor(image, VideoMode::kBGR, cv::COLOR_GRAY2BGR);
+}
 
-  // Allocate a BGR image
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kBGR, image->width, image->height,
-                                image->width * image->height * 3);
-
-  // Convert
-  cv::cvtColor(image->AsMat(), newImage->AsMat(), cv::COLOR_GRAY2BGR);
-
-  // Save the result
-  Image* rv = newImage.release();
-  if (m_impl) {
-    std::scoped_lock lock(m_impl->mutex);
-    m_impl->images.push_back(rv);
+Image* Frame::ConvertGrayToRGB565(Image* image) {
+  if (!image || image->pixelFormat != VideoMode::kGray) {
+    return nullptr;
   }
-  return rv;
+  return ConvertCvtColor(image, VideoMode::kRGB565, cv::COLOR_GRAY2BGR565);
 }
 
 Image* Frame::ConvertBGRToMJPEG(Image* image, int quality) {
@@ -446,32 +582,7 @@ Image* Frame::ConvertBGRToMJPEG(Image* image, int quality) {
   if (!m_impl) {
     return nullptr;
   }
-  std::scoped_lock lock(m_impl->mutex);
-
-  // Allocate a JPEG image.  We don't actually know what the resulting size
-  // will be; while the destination will automatically grow, doing so will
-  // cause an extra malloc, so we don't want to be too conservative here.
-  // Per Wikipedia, Q=100 on a sample image results in 8.25 bits per pixel,
-  // this is a little bit more conservative in assuming 50% space savings over
-  // the equivalent BGR image.
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kMJPEG, image->width, image->height,
-                                image->width * image->height * 1.5);
-
-  // Compress
-  if (m_impl->compressionParams.empty()) {
-    m_impl->compressionParams.push_back(cv::IMWRITE_JPEG_QUALITY);
-    m_impl->compressionParams.push_back(quality);
-  } else {
-    m_impl->compressionParams[1] = quality;
-  }
-  cv::imencode(".jpg", image->AsMat(), newImage->vec(),
-               m_impl->compressionParams);
-
-  // Save the result
-  Image* rv = newImage.release();
-  m_impl->images.push_back(rv);
-  return rv;
+  return AddImage(EncodeJpeg(image, quality));
 }
 
 Image* Frame::ConvertGrayToMJPEG(Image* image, int quality) {
@@ -481,30 +592,80 @@ Image* Frame::ConvertGrayToMJPEG(Image* image, int quality) {
   if (!m_impl) {
     return nullptr;
   }
-  std::scoped_lock lock(m_impl->mutex);
+  return AddImage(EncodeJpeg(image, quality));
+}
 
-  // Allocate a JPEG image.  We don't actually know what the resulting size
-  // will be; while the destination will automatically grow, doing so will
-  // cause an extra malloc, so we don't want to be too conservative here.
-  // Per Wikipedia, Q=100 on a sample image results in 8.25 bits per pixel,
-  // this is a little bit more conservative in assuming 25% space savings over
-  // the equivalent grayscale image.
-  auto newImage =
-      m_impl->source.AllocImage(VideoMode::kMJPEG, image->width, image->height,
-                                image->width * image->height * 0.75);
+Image* Frame::DecodeMJPEG(Image* image, VideoMode::PixelFormat pixelFormat,
+                          int scale) {
+  int flags;
+  switch (scale) {
+    case 2:
+      flags = cv::IMREAD_REDUCED_COLOR_2;
+      break;
+    case 4:
+      flags = cv::IMREAD_REDUCED_COLOR_4;
+      break;
+    case 8:
+      flags = cv::IMREAD_REDUCED_COLOR_8;
+      break;
+    default:
+      scale = 1;
+      flags = cv::IMREAD_COLOR;
+      break;
+  }
+  if (pixelFormat == VideoMode::kGray) {
+    flags &= ~cv::IMREAD_COLOR;  // IMREAD_REDUCED_GRAYSCALE_* or GRAYSCALE
+  }
+
+  // Allocate an image; the decoder rounds scaled dimensions up
+  int width = (image->width + scale - 1) / scale;
+  int height = (image->height + scale - 1) / scale;
+  auto newImage = m_impl->source.AllocImage(
+      pixelFormat, width, height,
+      width * height * GetBytesPerPixel(pixelFormat));
 
-  // Compress
-  if (m_impl->compressionParams.empty()) {
-    m_impl->compressionParams.push_back(cv::IMWRITE_JPEG_QUALITY);
-    m_impl->compressionParams.push_back(quality);
-  } else {
-    m_impl->compressionParams[1] = quality;
+  // Decode
+  cv::Mat newMat = newImage->AsMat();
+  cv::imdecode(image->AsInputArray(), flags, &newMat);
+
+  // If the decoded size didn't match (e.g. the JPEG header doesn't match the
+  // image size), the decoder will have allocated a new buffer; copy it
+  if (newMat.data != reinterpret_cast<uchar*>(newImage->data())) {
+    newImage->width = newMat.cols;
+    newImage->height = newMat.rows;
+    newImage->SetSize(newMat.total() * newMat.elemSize());
+    newMat.copyTo(newImage->AsMat());
   }
-  cv::imencode(".jpg", image->AsMat(), newImage->vec(),
-               m_impl->compressionParams);
 
   // Save the result
-  Image* rv = newImage.release();
+  return AddImage(std::move(newImage));
+}
+
+Image* Frame::ConvertCvtColor(Image* image, VideoMode::PixelFormat pixelFormat,
+                              int code) {
+  // Allocate an image
+  auto newImage = m_impl->source.AllocImage(
+      pixelFormat, image->width, image->height,
+      image->width * image->height * GetBytesPerPixel(pixelFormat));
+
+  // Convert
+  cv::cvtColor(image->AsMat(), newImage->AsMat(), code);
+
+  // Save the result
+  return AddImage(std::move(newImage));
+}
+
+Image* Frame::AddImage(std::unique_ptr<Image> image) {
+  std::scoped_lock lock(m_impl->mutex);
+  // Conversions run unlocked, so another thread may have just added the same
+  // image; if so, keep that one
+  if (Image* existing =
+          GetExistingImage(image->width, image->height, image->pixelFormat,
+                           image->jpegQuality)) {
+    m_impl->source.ReleaseImage(std::move(image));
+    return existing;
+  }
+  Image* rv = image.release();
   m_impl->images.push_back(rv);
   return rv;
 }
@@ -515,7 +676,7 @@ Image* Frame::GetImageImpl(int width, int height,
   if (!m_impl) {
     return nullptr;
   }
-  std::scoped_lock lock(m_impl->mutex);
+  // GetNearestImage() locks; like ConvertImpl(), the conversions don't
   Image* cur = GetNearestImage(width, height, pixelFormat, requiredJpegQuality);
   if (!cur || cur->Is(width, height, pixelFormat, requiredJpegQuality)) {
     return cur;
@@ -526,12 +687,25 @@ Image* Frame::GetImageImpl(int width, int height,
              cur->height, static_cast<int>(cur->pixelFormat), width, height,
              static_cast<int>(pixelFormat));
 
+  Image* nearest = cur;
+  auto start = wpi::Now();
+
   // If the source image is a JPEG, we need to decode it before we can do
   // anything else with it.  Note that if the destination format is JPEG, we
   // still need to do this (unless the width/height/compression were the same,
-  // in which case we already returned the existing JPEG above).
+  // in which case we already returned the existing JPEG above).  If a smaller
+  // image is wanted, have the decoder scale it down as far as possible, so
+  // only a small resize (if any) is left.
   if (cur->pixelFormat == VideoMode::kMJPEG) {
-    cur = ConvertMJPEGToBGR(cur);
+    int scale = GetJpegDecodeScale(cur->width, cur->height, width, height);
+    if (pixelFormat == VideoMode::kGray) {
+      cur = ConvertMJPEGToGray(cur, scale);
+    } else {
+      cur = ConvertMJPEGToBGR(cur, scale);
+    }
+    if (!cur) {
+      return nullptr;
+    }
   }
 
   // Resize
@@ -546,8 +720,13 @@ Image* Frame::GetImageImpl(int width, int height,
     cv::resize(cur->AsMat(), newMat, newMat.size(), 0, 0);
 
     // Save the result
-    cur = newImage.release();
-    m_impl->images.push_back(cur);
+    cur = AddImage(std::move(newImage));
+  }
+
+  // The format conversion (if any) is recorded separately
+  if (cur != nearest) {
+    Instance::GetInstance().telemetry.RecordSourceConvertLatency(
+        m_impl->source, wpi::Now() - start);
   }
 
   // Convert to output format
@@ -35,10 +35,10 @@ class Frame {
     wpi::recursive_mutex mutex;
     std::atomic_int refcount{0};
     Time time{0};
+    Time captureTime{0};
     SourceImpl& source;
     std::string error;
     wpi::SmallVector<Image*, 4> images;
-    std::vector<int> compressionParams;
   };
 
  public:
@@ -46,7 +46,8 @@ class Frame {
 
   Frame(SourceImpl& source, std::string_view error, Time time);
 
-  Frame(SourceImpl& source, std::unique_ptr<Image> image, Time time);
+  Frame(SourceImpl& source, std::unique_ptr<Image> image, Time time,
+        Time captureTime = 0);
 
   Frame(const Frame& frame) noexcept : m_impl{frame.m_impl} {
     if (m_impl) {
@@ -72,6 +73,15 @@ class Frame {
 
   Time GetTime() const { return m_impl ? m_impl->time : 0; }
 
+  // Time the frame was captured by the device, if known; otherwise the same
+  // as GetTime().  Used for end-to-end latency telemetry.
+  Time GetCaptureTime() const {
+    if (!m_impl) {
+      return 0;
+    }
+    return m_impl->captureTime != 0 ? m_impl->captureTime : m_impl->time;
+  }
+
   std::string_view GetError() const {
     if (!m_impl) {
       return {};
@@ -192,13 +202,19 @@ class Frame {
     return ConvertImpl(image, VideoMode::kMJPEG, requiredQuality,
                        defaultQuality);
   }
-  Image* ConvertMJPEGToBGR(Image* image);
-  Image* ConvertMJPEGToGray(Image* image);
+  Image* ConvertMJPEGToBGR(Image* image, int scale = 1);
+  Image* ConvertMJPEGToGray(Image* image, int scale = 1);
   Image* ConvertYUYVToBGR(Image* image);
+  Image* ConvertYUYVToGray(Image* image);
+  Image* ConvertYUYVToRGB565(Image* image);
+  Image* ConvertUYVYToBGR(Image* image);
+  Image* ConvertUYVYToGray(Image* image);
+  Image* ConvertUYVYToRGB565(Image* image);
   Image* ConvertBGRToRGB565(Image* image);
   Image* ConvertRGB565ToBGR(Image* image);
   Image* ConvertBGRToGray(Image* image);
   Image* ConvertGrayToBGR(Image* image);
+  Image* ConvertGrayToRGB565(Image* image);
   Image* ConvertBGRToMJPEG(Image* image, int quality);
   Image* ConvertGrayToMJPEG(Image* image, int quality);
 
@@ -222,6 +238,13 @@ class Frame {
  private:
   Image* ConvertImpl(Image* image, VideoMode::PixelFormat pixelFormat,
                      int requiredJpegQuality, int defaultJpegQuality);
+  Image* ConvertDirect(Image* image, VideoMode::PixelFormat pixelFormat,
+                       int jpegQuality);
+  Image* DecodeMJPEG(Image* image, VideoMode::PixelFormat pixelFormat,
+                     int scale);
+  Image* ConvertCvtColor(Image* image, VideoMode::PixelFormat pixelFormat,
+                         int code);
+  Image* AddImage(std::unique_ptr<Image> image);
   Image* GetImageImpl(int width, int height, VideoMode::PixelFormat pixelFormat,
                       int requiredJpegQuality, int defaultJpegQuality);
   void DecRef() {
@@ -6,12 +6,16 @@
 #define CSCORE_IMAGE_H_
 
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
 
 #include "cscore_cpp.h"
 #include "default_init_allocator.h"
+#ifdef __linux__
+#include "page_aligned_allocator.h"
+#endif
 
 namespace cs {
 
@@ -21,17 +25,32 @@ class Image {
   friend class Frame;
 
  public:
+  // Not value-initialized, as images are always written before being read.
+  // On Linux, page aligned so the USB camera can capture directly into images.
+#ifdef __linux__
+  using Storage =
+      std::vector<uchar,
+                  default_init_allocator<uchar, page_aligned_allocator<uchar>>>;
+#else
+  using Storage = std::vector<uchar, default_init_allocator<uchar>>;
+#endif
+
 #ifndef __linux__
   explicit Image(size_t capacity) {
     m_data.reserve(capacity);
   }
 #else
-  explicit Image(size_t capacity)
-      : m_data{capacity, default_init_allocator<uchar>{}} {
+  explicit Image(size_t capacity) : m_data(capacity) {
     m_data.resize(0);
   }
 #endif
 
+  // Takes the output of cv::imencode(), which can only encode into a
+  // std::vector<uchar>, rather than copying it into Storage.  These images
+  // aren't pooled.
+  explicit Image(std::vector<uchar>&& encoded)
+      : m_encoded{std::move(encoded)}, m_isEncoded{true} {}
+
   Image(const Image&) = delete;
   Image& operator=(const Image&) = delete;
 
@@ -43,36 +62,39 @@ class Image {
     return {data(), size()};
   }
   size_t capacity() const {
-    return m_data.capacity();
+    return m_isEncoded ? m_encoded.capacity() : m_data.capacity();
   }
   const char* data() const {
-    return reinterpret_cast<const char*>(m_data.data());
+    return reinterpret_cast<const char*>(m_isEncoded ? m_encoded.data()
+                                                     : m_data.data());
   }
   char* data() {
-    return reinterpret_cast<char*>(m_data.data());
+    return reinterpret_cast<char*>(m_isEncoded ? m_encoded.data()
+                                               : m_data.data());
   }
   size_t size() const {
-    return m_data.size();
-  }
-
-  const std::vector<uchar>& vec() const {
-    return m_data;
+    return m_isEncoded ? m_encoded.size() : m_data.size();
   }
-  std::vector<uchar>& vec() {
-    return m_data;
+  bool IsEncoded() const {
+    return m_isEncoded;
   }
 
   void resize(size_t size) {
-    m_data.resize(size);
+    if (m_isEncoded) {
+      m_encoded.resize(size);
+    } else {
+      m_data.resize(size);
+    }
   }
   void SetSize(size_t size) {
-    m_data.resize(size);
+    resize(size);
   }
 
   cv::Mat AsMat() {
     int type;
     switch (pixelFormat) {
       case VideoMode::kYUYV:
+      case VideoMode::kUYVY:
       case VideoMode::kRGB565:
         type = CV_8UC2;
         break;
@@ -85,11 +107,12 @@ class Image {
         type = CV_8UC1;
         break;
     }
-    return cv::Mat{height, width, type, m_data.data()};
+    return cv::Mat{height, width, type, data()};
   }
 
   cv::_InputArray AsInputArray() {
-    return cv::_InputArray{m_data};
+    return cv::_InputArray{reinterpret_cast<const uchar*>(data()),
+                           static_cast<int>(size())};
   }
 
   bool Is(int width_, int height_) {
@@ -120,7 +143,9 @@ class Image {
   }
 
  private:
-  std::vector<uchar> m_data;
+  Storage m_data;
+  std::vector<uchar> m_encoded;
+  bool m_isEncoded = false;
 
  public:
   VideoMode::PixelFormat pixelFormat{VideoMode::kUnknown};
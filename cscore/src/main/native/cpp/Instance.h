@@ -5,6 +5,7 @@
 #ifndef CSCORE_INSTANCE_H_
 #define CSCORE_INSTANCE_H_
 
+#include <atomic>
 #include <memory>
 #include <utility>
 
@@ -63,6 +64,8 @@ class Instance {
 
  public:
   wpi::EventLoopRunner eventLoop;
+  std::atomic_bool mjpegServerEventLoop{false};
+  std::atomic_bool usbCameraSharedCapture{false};
 
   std::pair<CS_Sink, std::shared_ptr<SinkData>> FindSink(const SinkImpl& sink);
   std::pair<CS_Source, std::shared_ptr<SourceData>> FindSource(
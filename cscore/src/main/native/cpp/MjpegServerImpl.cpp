@@ -4,16 +4,23 @@
 
 #include "MjpegServerImpl.h"
 
+#include <algorithm>
 #include <chrono>
 
 #include <fmt/format.h>
 #include <wpi/SmallString.h>
 #include <wpi/StringExtras.h>
 #include <wpi/fmt/raw_ostream.h>
+#include <wpinet/HttpServerConnection.h>
 #include <wpinet/HttpUtil.h>
 #include <wpinet/TCPAcceptor.h>
 #include <wpinet/raw_socket_istream.h>
 #include <wpinet/raw_socket_ostream.h>
+#include <wpinet/raw_uv_ostream.h>
+#include <wpinet/uv/Async.h>
+#include <wpinet/uv/Tcp.h>
+#include <wpinet/uv/Work.h>
+#include <wpinet/uv/util.h>
 
 #include "Handle.h"
 #include "Instance.h"
@@ -30,6 +37,9 @@ using namespace cs;
 // It separates the multipart stream of pictures
 #define BOUNDARY "boundarydonotcross"
 
+// Maximum number of simultaneous client streams per server
+static constexpr int kMaxStreams = 10;
+
 // A bare-bones HTML webpage for user friendliness.
 static const char* emptyRootPage =
     "</head><body>"
@@ -73,36 +83,60 @@ static const char* startRootPage =
     "<div class=\"settings\">\n";
 static const char* endRootPage = "</div></body></html>";
 
-class MjpegServerImpl::ConnThread : public wpi::SafeThread {
+enum RequestKind {
+  kCommand,
+  kStream,
+  kGetSettings,
+  kGetSourceConfig,
+  kRootPage,
+  kNotFound
+};
+
+// Request handling common to thread and event loop connections
+class MjpegServerImpl::ConnBase {
  public:
-  explicit ConnThread(std::string_view name, wpi::Logger& logger)
+  ConnBase(std::string_view name, wpi::Logger& logger)
       : m_name(name), m_logger(logger) {}
 
-  void Main() override;
-
   bool ProcessCommand(wpi::raw_ostream& os, SourceImpl& source,
                       std::string_view parameters, bool respond);
   void SendJSON(wpi::raw_ostream& os, SourceImpl& source, bool header);
   void SendHTMLHeadTitle(wpi::raw_ostream& os) const;
   void SendHTML(wpi::raw_ostream& os, SourceImpl& source, bool header);
-  void SendStream(wpi::raw_socket_ostream& os);
-  void ProcessRequest();
+  void SendPage(wpi::raw_ostream& os, RequestKind kind,
+                std::string_view parameters, SourceImpl* source);
 
-  std::unique_ptr<wpi::NetworkStream> m_stream;
-  std::shared_ptr<SourceImpl> m_source;
-  bool m_streaming = false;
-  bool m_noStreaming = false;
   int m_width = 0;
   int m_height = 0;
   int m_compression = -1;
   int m_defaultCompression = 80;
   int m_fps = 0;
 
- private:
+ protected:
   std::string m_name;
   wpi::Logger& m_logger;
 
   std::string_view GetName() { return m_name; }
+};
+
+class MjpegServerImpl::ConnThread : public wpi::SafeThread, public ConnBase {
+ public:
+  ConnThread(std::string_view name, wpi::Logger& logger,
+             MjpegServerImpl& server)
+      : ConnBase(name, logger), m_server(server) {}
+
+  void Main() override;
+
+  void SendStream(wpi::raw_socket_ostream& os);
+  void ProcessRequest();
+
+  std::unique_ptr<wpi::NetworkStream> m_stream;
+  std::shared_ptr<SourceImpl> m_source;
+  bool m_streaming = false;
+  bool m_noStreaming = false;
+
+ private:
+  MjpegServerImpl& m_server;
 
   std::shared_ptr<SourceImpl> GetSource() {
     std::scoped_lock lock(m_mutex);
@@ -126,6 +160,73 @@ class MjpegServerImpl::ConnThread : public wpi::SafeThread {
   }
 };
 
+// Event loop server state.  Only accessed from the event loop thread.
+struct MjpegServerImpl::LoopServer {
+  explicit LoopServer(MjpegServerImpl& server)
+      : server{&server}, m_logger{server.m_logger}, m_name{server.GetName()} {}
+
+  void Start(wpi::uv::Loop& loop);
+  void Stop();
+  void SetSource(std::shared_ptr<SourceImpl> newSource);
+  void SendFrame();
+  size_t GetNumStreams();
+
+  MjpegServerImpl* server;  // nullptr after Stop()
+  std::shared_ptr<wpi::uv::Tcp> listener;
+  std::shared_ptr<wpi::uv::Async<>> frameAsync;
+  std::shared_ptr<SourceImpl> source;
+  size_t frameListener = 0;  // only valid if source is set
+  std::vector<std::weak_ptr<LoopConn>> streams;
+  unsigned int port = 0;  // bound port (the requested one may be 0)
+
+  wpi::Logger& m_logger;
+  std::string m_name;
+
+  std::string_view GetName() { return m_name; }
+};
+
+// Event loop client connection.  Frames are written without blocking; if a
+// client is still receiving the previous frame, new frames are skipped for
+// that client.
+class MjpegServerImpl::LoopConn
+    : public wpi::HttpServerConnection,
+      public ConnBase,
+      public std::enable_shared_from_this<LoopConn> {
+ public:
+  LoopConn(std::shared_ptr<LoopServer> server,
+           std::shared_ptr<wpi::uv::Stream> stream)
+      : HttpServerConnection{stream},
+        ConnBase{server->m_name, server->m_logger},
+        m_server{std::move(server)} {}
+  ~LoopConn() override;
+
+  // Checks whether the frame should be sent (the client has received the
+  // previous one, and the frame rate limit allows it), and if so, marks the
+  // connection as writing and gets the JPEG variant it needs.  WriteFrame()
+  // must be called afterwards in that case.
+  bool StartFrame(const Frame& frame, int* width, int* height,
+                  int* requiredQuality, int* defaultQuality);
+  // Writes an encoded frame (nullptr if it could not be encoded).
+  void WriteFrame(std::shared_ptr<SourceImpl::EncodedJpeg> jpeg,
+                  const Frame& frame);
+  void Close() { m_stream.Close(); }
+
+  bool m_streaming = false;
+
+ protected:
+  void ProcessRequest() override;
+
+ private:
+  std::shared_ptr<LoopServer> m_server;
+  bool m_writing = false;
+
+  // frame rate limiting
+  Frame::Time m_lastFrameTime = 0;
+  Frame::Time m_timePerFrame = 0;
+  Frame::Time m_averageFrameTime = 0;
+  Frame::Time m_averagePeriod = 1000000;  // 1 second window
+};
+
 // Standard header to send along with other header information like mimetype.
 //
 // The parameters should ensure the browser does not cache our answer.
@@ -193,10 +294,10 @@ static void SendError(wpi::raw_ostream& os, int code,
 }
 
 // Perform a command specified by HTTP GET parameters.
-bool MjpegServerImpl::ConnThread::ProcessCommand(wpi::raw_ostream& os,
-                                                 SourceImpl& source,
-                                                 std::string_view parameters,
-                                                 bool respond) {
+bool MjpegServerImpl::ConnBase::ProcessCommand(wpi::raw_ostream& os,
+                                               SourceImpl& source,
+                                               std::string_view parameters,
+                                               bool respond) {
   wpi::SmallString<256> responseBuf;
   wpi::raw_svector_ostream response{responseBuf};
   // command format: param1=value1&param2=value2...
@@ -332,15 +433,14 @@ bool MjpegServerImpl::ConnThread::ProcessCommand(wpi::raw_ostream& os,
   return true;
 }
 
-void MjpegServerImpl::ConnThread::SendHTMLHeadTitle(
-    wpi::raw_ostream& os) const {
+void MjpegServerImpl::ConnBase::SendHTMLHeadTitle(wpi::raw_ostream& os) const {
   os << "<html><head><title>" << m_name << " CameraServer</title>"
      << "<meta charset=\"UTF-8\">";
 }
 
 // Send the root html file with controls for all the settable properties.
-void MjpegServerImpl::ConnThread::SendHTML(wpi::raw_ostream& os,
-                                           SourceImpl& source, bool header) {
+void MjpegServerImpl::ConnBase::SendHTML(wpi::raw_ostream& os,
+                                         SourceImpl& source, bool header) {
   if (header) {
     SendHeader(os, 200, "OK", "text/html");
   }
@@ -460,6 +560,9 @@ void MjpegServerImpl::ConnThread::SendHTML(wpi::raw_ostream& os,
       case VideoMode::kGray:
         os << "gray";
         break;
+      case VideoMode::kUYVY:
+        os << "UYVY";
+        break;
       default:
         os << "unknown";
         break;
@@ -473,8 +576,8 @@ void MjpegServerImpl::ConnThread::SendHTML(wpi::raw_ostream& os,
 }
 
 // Send a JSON file which is contains information about the source parameters.
-void MjpegServerImpl::ConnThread::SendJSON(wpi::raw_ostream& os,
-                                           SourceImpl& source, bool header) {
+void MjpegServerImpl::ConnBase::SendJSON(wpi::raw_ostream& os,
+                                         SourceImpl& source, bool header) {
   if (header) {
     SendHeader(os, 200, "OK", "application/json");
   }
@@ -569,6 +672,9 @@ void MjpegServerImpl::ConnThread::SendJSON(wpi::raw_ostream& os,
       case VideoMode::kGray:
         os << "gray";
         break;
+      case VideoMode::kUYVY:
+        os << "UYVY";
+        break;
       default:
         os << "unknown";
         break;
@@ -593,8 +699,45 @@ MjpegServerImpl::MjpegServerImpl(std::string_view name, wpi::Logger& logger,
   m_active = true;
 
   SetDescription(fmt::format("HTTP Server on port {}", port));
+  CreateProperties();
 
-  // Create properties
+  m_serverThread = std::thread(&MjpegServerImpl::ServerThreadMain, this);
+}
+
+MjpegServerImpl::MjpegServerImpl(std::string_view name, wpi::Logger& logger,
+                                 Notifier& notifier, Telemetry& telemetry,
+                                 std::string_view listenAddress, int port,
+                                 wpi::EventLoopRunner& eventLoop)
+    : SinkImpl{name, logger, notifier, telemetry},
+      m_listenAddress(listenAddress),
+      m_port(port),
+      m_eventLoop{&eventLoop} {
+  m_active = true;
+
+  SetDescription(fmt::format("HTTP Server on port {}", port));
+  CreateProperties();
+
+  m_loopServer = std::make_shared<LoopServer>(*this);
+  m_eventLoop->ExecAsync(
+      [server = m_loopServer](wpi::uv::Loop& loop) { server->Start(loop); });
+}
+
+MjpegServerImpl::~MjpegServerImpl() {
+  Stop();
+}
+
+int MjpegServerImpl::GetPort() {
+  if (m_port != 0 || !m_eventLoop) {
+    return m_port;
+  }
+  // Let the system pick the port; get the one the listener was bound to
+  unsigned int port = 0;
+  m_eventLoop->ExecSync(
+      [&, server = m_loopServer](wpi::uv::Loop&) { port = server->port; });
+  return port;
+}
+
+void MjpegServerImpl::CreateProperties() {
   m_widthProp = CreateProperty("width", [] {
     return std::make_unique<PropertyImpl>("width", CS_PROP_INTEGER, 1, 0, 0);
   });
@@ -612,17 +755,28 @@ MjpegServerImpl::MjpegServerImpl(std::string_view name, wpi::Logger& logger,
   m_fpsProp = CreateProperty("fps", [] {
     return std::make_unique<PropertyImpl>("fps", CS_PROP_INTEGER, 1, 0, 0);
   });
-
-  m_serverThread = std::thread(&MjpegServerImpl::ServerThreadMain, this);
 }
 
-MjpegServerImpl::~MjpegServerImpl() {
-  Stop();
+void MjpegServerImpl::InitConn(ConnBase& conn) {
+  conn.m_width = GetProperty(m_widthProp)->value;
+  conn.m_height = GetProperty(m_heightProp)->value;
+  conn.m_compression = GetProperty(m_compressionProp)->value;
+  conn.m_defaultCompression = GetProperty(m_defaultCompressionProp)->value;
+  conn.m_fps = GetProperty(m_fpsProp)->value;
 }
 
 void MjpegServerImpl::Stop() {
   m_active = false;
 
+  if (m_eventLoop) {
+    // closes the listener and all connections; this is a no-op if the event
+    // loop has already been stopped, in which case its handles are closed
+    // by the event loop
+    m_eventLoop->ExecSync(
+        [server = m_loopServer](wpi::uv::Loop&) { server->Stop(); });
+    return;
+  }
+
   // wake up server thread by shutting down the socket
   m_acceptor->shutdown();
 
@@ -721,34 +875,20 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
 
     int width = m_width != 0 ? m_width : frame.GetOriginalWidth();
     int height = m_height != 0 ? m_height : frame.GetOriginalHeight();
-    Image* image = frame.GetImageMJPEG(
-        width, height, m_compression,
+    // Shared with other connections streaming the same frame at the same
+    // size and quality, so it's only encoded once
+    auto jpeg = source->GetEncodedJpeg(
+        frame, width, height, m_compression,
         m_compression == -1 ? m_defaultCompression : m_compression);
-    if (!image) {
+    if (!jpeg) {
       // Shouldn't happen, but just in case...
       std::this_thread::sleep_for(std::chrono::milliseconds(20));
       continue;
     }
 
-    const char* data = image->data();
-    size_t size = image->size();
-    bool addDHT = false;
-    size_t locSOF = size;
-    switch (image->pixelFormat) {
-      case VideoMode::kMJPEG:
-        // Determine if we need to add DHT to it, and allocate enough space
-        // for adding it if required.
-        addDHT = JpegNeedsDHT(data, &size, &locSOF);
-        break;
-      case VideoMode::kYUYV:
-      case VideoMode::kRGB565:
-      default:
-        // Bad frame; sleep for 10 ms so we don't consume all processor time.
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        continue;
-    }
-
-    SDEBUG4("sending frame size={} addDHT={}", size, addDHT);
+    const char* data = jpeg->image->data();
+    size_t size = jpeg->size;
+    SDEBUG4("sending frame size={} addDHT={}", size, jpeg->addDHT);
 
     // print the individual mimetype and the length
     // sending the content-length fixes random stream disruption observed
@@ -762,11 +902,14 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
     fmt::print(oss, "X-Timestamp: {}\r\n", timestamp);
     oss << "\r\n";
     os << oss.str();
-    if (addDHT) {
+    // os is unbuffered, so the header has been sent
+    m_server.RecordFrameLatency(frame);
+    if (jpeg->addDHT) {
       // Insert DHT data immediately before SOF
+      size_t locSOF = jpeg->locSOF;
       os << std::string_view(data, locSOF);
       os << JpegGetDHT();
-      os << std::string_view(data + locSOF, image->size() - locSOF);
+      os << std::string_view(data + locSOF, jpeg->image->size() - locSOF);
     } else {
       os << std::string_view(data, size);
     }
@@ -775,36 +918,23 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
   StopStream();
 }
 
-void MjpegServerImpl::ConnThread::ProcessRequest() {
-  wpi::raw_socket_istream is{*m_stream};
-  wpi::raw_socket_ostream os{*m_stream, true};
-
-  // Read the request string from the stream
-  wpi::SmallString<128> reqBuf;
-  std::string_view req = is.getline(reqBuf, 4096);
-  if (is.has_error()) {
-    SDEBUG("error getting request string");
-    return;
-  }
-
-  enum { kCommand, kStream, kGetSettings, kGetSourceConfig, kRootPage } kind;
-  std::string_view parameters;
+// Determine request kind from the request line (e.g. "GET / HTTP/1.1").
+// Most of these are for mjpgstreamer compatibility, others are for Axis camera
+// compatibility.
+static RequestKind GetRequestKind(std::string_view req,
+                                  std::string_view* parameters) {
+  RequestKind kind;
   size_t pos;
-
-  SDEBUG("HTTP request: '{}'\n", req);
-
-  // Determine request kind.  Most of these are for mjpgstreamer
-  // compatibility, others are for Axis camera compatibility.
   if ((pos = req.find("POST /stream")) != std::string_view::npos) {
     kind = kStream;
-    parameters = wpi::substr(wpi::substr(req, req.find('?', pos + 12)), 1);
+    *parameters = wpi::substr(wpi::substr(req, req.find('?', pos + 12)), 1);
   } else if ((pos = req.find("GET /?action=stream")) !=
              std::string_view::npos) {
     kind = kStream;
-    parameters = wpi::substr(wpi::substr(req, req.find('&', pos + 19)), 1);
+    *parameters = wpi::substr(wpi::substr(req, req.find('&', pos + 19)), 1);
   } else if ((pos = req.find("GET /stream.mjpg")) != std::string_view::npos) {
     kind = kStream;
-    parameters = wpi::substr(wpi::substr(req, req.find('?', pos + 16)), 1);
+    *parameters = wpi::substr(wpi::substr(req, req.find('?', pos + 16)), 1);
   } else if (req.find("GET /settings") != std::string_view::npos &&
              req.find(".json") != std::string_view::npos) {
     kind = kGetSettings;
@@ -820,47 +950,29 @@ void MjpegServerImpl::ConnThread::ProcessRequest() {
   } else if ((pos = req.find("GET /?action=command")) !=
              std::string_view::npos) {
     kind = kCommand;
-    parameters = wpi::substr(wpi::substr(req, req.find('&', pos + 20)), 1);
+    *parameters = wpi::substr(wpi::substr(req, req.find('&', pos + 20)), 1);
   } else if (req.find("GET / ") != std::string_view::npos || req == "GET /\n") {
     kind = kRootPage;
   } else {
-    SDEBUG("HTTP request resource not found");
-    SendError(os, 404, "Resource not found");
-    return;
+    return kNotFound;
   }
 
   // Parameter can only be certain characters.  This also strips the EOL.
-  pos = parameters.find_first_not_of(
+  pos = parameters->find_first_not_of(
       "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_"
       "-=&1234567890%./");
-  parameters = wpi::substr(parameters, 0, pos);
-  SDEBUG("command parameters: \"{}\"", parameters);
-
-  // Read the rest of the HTTP request.
-  // The end of the request is marked by a single, empty line
-  wpi::SmallString<128> lineBuf;
-  for (;;) {
-    if (wpi::starts_with(is.getline(lineBuf, 4096), "\n")) {
-      break;
-    }
-    if (is.has_error()) {
-      return;
-    }
-  }
+  *parameters = wpi::substr(*parameters, 0, pos);
+  return kind;
+}
 
-  // Send response
+// Send the response to a non-stream request
+void MjpegServerImpl::ConnBase::SendPage(wpi::raw_ostream& os,
+                                         RequestKind kind,
+                                         std::string_view parameters,
+                                         SourceImpl* source) {
   switch (kind) {
-    case kStream:
-      if (auto source = GetSource()) {
-        SDEBUG("request for stream {}", source->GetName());
-        if (!ProcessCommand(os, *source, parameters, false)) {
-          return;
-        }
-      }
-      SendStream(os);
-      break;
     case kCommand:
-      if (auto source = GetSource()) {
+      if (source) {
         ProcessCommand(os, *source, parameters, true);
       } else {
         SendHeader(os, 200, "OK", "text/plain");
@@ -871,7 +983,7 @@ void MjpegServerImpl::ConnThread::ProcessRequest() {
       break;
     case kGetSettings:
       SDEBUG("request for JSON file");
-      if (auto source = GetSource()) {
+      if (source) {
         SendJSON(os, *source, true);
       } else {
         SendError(os, 404, "Resource not found");
@@ -879,7 +991,7 @@ void MjpegServerImpl::ConnThread::ProcessRequest() {
       break;
     case kGetSourceConfig:
       SDEBUG("request for JSON file");
-      if (auto source = GetSource()) {
+      if (source) {
         SendHeader(os, 200, "OK", "application/json");
         CS_Status status = CS_OK;
         os << source->GetConfigJson(&status);
@@ -891,13 +1003,66 @@ void MjpegServerImpl::ConnThread::ProcessRequest() {
     case kRootPage:
       SDEBUG("request for root page");
       SendHeader(os, 200, "OK", "text/html");
-      if (auto source = GetSource()) {
+      if (source) {
         SendHTML(os, *source, false);
       } else {
         SendHTMLHeadTitle(os);
         os << emptyRootPage << "\r\n";
       }
       break;
+    default:
+      SDEBUG("HTTP request resource not found");
+      SendError(os, 404, "Resource not found");
+      break;
+  }
+}
+
+void MjpegServerImpl::ConnThread::ProcessRequest() {
+  wpi::raw_socket_istream is{*m_stream};
+  wpi::raw_socket_ostream os{*m_stream, true};
+
+  // Read the request string from the stream
+  wpi::SmallString<128> reqBuf;
+  std::string_view req = is.getline(reqBuf, 4096);
+  if (is.has_error()) {
+    SDEBUG("error getting request string");
+    return;
+  }
+
+  SDEBUG("HTTP request: '{}'\n", req);
+
+  std::string_view parameters;
+  RequestKind kind = GetRequestKind(req, &parameters);
+  if (kind == kNotFound) {
+    SDEBUG("HTTP request resource not found");
+    SendError(os, 404, "Resource not found");
+    return;
+  }
+  SDEBUG("command parameters: \"{}\"", parameters);
+
+  // Read the rest of the HTTP request.
+  // The end of the request is marked by a single, empty line
+  wpi::SmallString<128> lineBuf;
+  for (;;) {
+    if (wpi::starts_with(is.getline(lineBuf, 4096), "\n")) {
+      break;
+    }
+    if (is.has_error()) {
+      return;
+    }
+  }
+
+  // Send response
+  if (kind == kStream) {
+    if (auto source = GetSource()) {
+      SDEBUG("request for stream {}", source->GetName());
+      if (!ProcessCommand(os, *source, parameters, false)) {
+        return;
+      }
+    }
+    SendStream(os);
+  } else {
+    SendPage(os, kind, parameters, GetSource().get());
   }
 
   SDEBUG("leaving HTTP client thread");
@@ -955,7 +1120,7 @@ void MjpegServerImpl::ServerThreadMain() {
     }
 
     // Start it if not already started
-    it->Start(GetName(), m_logger);
+    it->Start(GetName(), m_logger, *this);
 
     auto nstreams =
         std::count_if(m_connThreads.begin(), m_connThreads.end(),
@@ -968,12 +1133,8 @@ void MjpegServerImpl::ServerThreadMain() {
     auto thr = it->GetThread();
     thr->m_stream = std::move(stream);
     thr->m_source = source;
-    thr->m_noStreaming = nstreams >= 10;
-    thr->m_width = GetProperty(m_widthProp)->value;
-    thr->m_height = GetProperty(m_heightProp)->value;
-    thr->m_compression = GetProperty(m_compressionProp)->value;
-    thr->m_defaultCompression = GetProperty(m_defaultCompressionProp)->value;
-    thr->m_fps = GetProperty(m_fpsProp)->value;
+    thr->m_noStreaming = nstreams >= kMaxStreams;
+    InitConn(*thr);
     thr->m_cond.notify_one();
   }
 
@@ -981,6 +1142,14 @@ void MjpegServerImpl::ServerThreadMain() {
 }
 
 void MjpegServerImpl::SetSourceImpl(std::shared_ptr<SourceImpl> source) {
+  if (m_eventLoop) {
+    m_eventLoop->ExecAsync(
+        [server = m_loopServer, source = std::move(source)](wpi::uv::Loop&) {
+          server->SetSource(std::move(source));
+        });
+    return;
+  }
+
   std::scoped_lock lock(m_mutex);
   for (auto& connThread : m_connThreads) {
     if (auto thr = connThread.GetThread()) {
@@ -998,11 +1167,330 @@ void MjpegServerImpl::SetSourceImpl(std::shared_ptr<SourceImpl> source) {
   }
 }
 
+void MjpegServerImpl::LoopServer::Start(wpi::uv::Loop& loop) {
+  if (!server) {
+    return;
+  }
+
+  // new frames are signaled by the source threads
+  frameAsync = wpi::uv::Async<>::Create(loop);
+  if (!frameAsync) {
+    return;
+  }
+  frameAsync->wakeup.connect([this] { SendFrame(); });
+
+  listener = wpi::uv::Tcp::Create(loop);
+  if (!listener) {
+    return;
+  }
+  listener->error.connect(
+      [this](wpi::uv::Error err) { SERROR("server error: {}", err.str()); });
+  listener->connection.connect([this] {
+    auto tcp = listener->Accept();
+    if (!tcp) {
+      return;
+    }
+    SDEBUG("client connection");
+    tcp->SetNoDelay(true);
+    tcp->error.connect([h = tcp.get()](wpi::uv::Error) { h->Close(); });
+    tcp->SetData(std::make_shared<LoopConn>(server->m_loopServer, tcp));
+  });
+  listener->Bind(server->m_listenAddress, server->m_port);
+  SDEBUG("waiting for clients to connect");
+  listener->Listen();
+  std::string ip;
+  wpi::uv::AddrToName(listener->GetSock(), &ip, &port);
+}
+
+void MjpegServerImpl::LoopServer::Stop() {
+  if (!server) {
+    return;
+  }
+  SetSource(nullptr);
+  server = nullptr;
+  if (listener) {
+    listener->Close();
+  }
+  if (frameAsync) {
+    frameAsync->Close();
+  }
+  for (auto&& weakConn : streams) {
+    if (auto conn = weakConn.lock()) {
+      conn->Close();
+    }
+  }
+  streams.clear();
+}
+
+void MjpegServerImpl::LoopServer::SetSource(
+    std::shared_ptr<SourceImpl> newSource) {
+  if (!server || newSource == source) {
+    return;
+  }
+  if (source) {
+    source->RemoveFrameListener(frameListener);
+  }
+  size_t nstreams = GetNumStreams();
+  for (size_t i = 0; i < nstreams; ++i) {
+    if (source) {
+      source->DisableSink();
+    }
+    if (newSource) {
+      newSource->EnableSink();
+    }
+  }
+  source = std::move(newSource);
+  if (source) {
+    frameListener = source->AddFrameListener(
+        [weakAsync = std::weak_ptr<wpi::uv::Async<>>{frameAsync}] {
+          if (auto async = weakAsync.lock()) {
+            async->Send();
+          }
+        });
+  }
+}
+
+void MjpegServerImpl::LoopServer::SendFrame() {
+  if (!source) {
+    return;
+  }
+  Frame frame = source->GetCurFrame();
+  if (!frame) {
+    return;
+  }
+
+  // Group the connections that are ready for the frame by the JPEG variant
+  // they need.  Each variant is encoded on the libuv thread pool (so the
+  // loop thread is never blocked on an encode), and written to the
+  // connections back on the loop thread.
+  struct Variant {
+    int width;
+    int height;
+    int requiredQuality;
+    int defaultQuality;
+    std::vector<std::shared_ptr<LoopConn>> conns;
+  };
+  wpi::SmallVector<Variant, 4> variants;
+  for (auto&& weakConn : streams) {
+    auto conn = weakConn.lock();
+    int width, height, requiredQuality, defaultQuality;
+    if (!conn || !conn->StartFrame(frame, &width, &height, &requiredQuality,
+                                   &defaultQuality)) {
+      continue;
+    }
+    auto it = std::find_if(variants.begin(), variants.end(), [&](auto& v) {
+      return v.width == width && v.height == height &&
+             v.requiredQuality == requiredQuality &&
+             v.defaultQuality == defaultQuality;
+    });
+    if (it == variants.end()) {
+      it = &variants.emplace_back(
+          Variant{width, height, requiredQuality, defaultQuality, {}});
+    }
+    it->conns.emplace_back(std::move(conn));
+  }
+
+  for (auto&& variant : variants) {
+    auto jpeg = std::make_shared<std::shared_ptr<SourceImpl::EncodedJpeg>>();
+    wpi::uv::QueueWork(
+        frameAsync->GetLoopRef(),
+        [source = source, frame, jpeg, width = variant.width,
+         height = variant.height, requiredQuality = variant.requiredQuality,
+         defaultQuality = variant.defaultQuality] {
+          *jpeg = source->GetEncodedJpeg(frame, width, height,
+                                         requiredQuality, defaultQuality);
+        },
+        [conns = std::move(variant.conns), frame, jpeg] {
+          for (auto&& conn : conns) {
+            conn->WriteFrame(*jpeg, frame);
+          }
+        });
+  }
+}
+
+size_t MjpegServerImpl::LoopServer::GetNumStreams() {
+  // also removes closed connections
+  std::erase_if(streams, [](auto&& conn) { return conn.expired(); });
+  return streams.size();
+}
+
+MjpegServerImpl::LoopConn::~LoopConn() {
+  if (m_streaming && m_server->source) {
+    m_server->source->DisableSink();
+  }
+}
+
+void MjpegServerImpl::LoopConn::ProcessRequest() {
+  // once streaming, ignore any further requests
+  if (m_streaming) {
+    return;
+  }
+  if (!m_server->server) {
+    m_stream.Close();
+    return;
+  }
+
+  auto req = fmt::format("{} {} ", wpi::http_method_str(m_request.GetMethod()),
+                         m_request.GetUrl());
+  SDEBUG("HTTP request: '{}'\n", req);
+
+  std::string_view parameters;
+  RequestKind kind = GetRequestKind(req, &parameters);
+  SDEBUG("command parameters: \"{}\"", parameters);
+
+  {
+    std::scoped_lock lock(m_server->server->m_mutex);
+    m_server->server->InitConn(*this);
+  }
+
+  // responses are built in place and sent without blocking
+  wpi::SmallVector<wpi::uv::Buffer, 4> bufs;
+  wpi::raw_uv_ostream os{bufs, 4096};
+  SourceImpl* source = m_server->source.get();
+
+  if (kind != kStream) {
+    SendPage(os, kind, parameters, source);
+    SendData(os.bufs(), true);
+    return;
+  }
+
+  if (m_server->GetNumStreams() >= kMaxStreams) {
+    SERROR("Too many simultaneous client streams");
+    ::SendError(os, 503, "Too many simultaneous streams");
+    SendData(os.bufs(), true);
+    return;
+  }
+
+  if (source) {
+    SDEBUG("request for stream {}", source->GetName());
+    if (!ProcessCommand(os, *source, parameters, false)) {
+      SendData(os.bufs(), true);
+      return;
+    }
+  }
+
+  SendHeader(os, 200, "OK", "multipart/x-mixed-replace;boundary=" BOUNDARY);
+  SendData(os.bufs(), false);
+
+  SDEBUG("Headers send, sending stream now");
+
+  if (m_fps != 0) {
+    m_timePerFrame = 1000000.0 / m_fps;
+  }
+  if (m_averagePeriod < m_timePerFrame) {
+    m_averagePeriod = m_timePerFrame * 10;
+  }
+
+  m_streaming = true;
+  if (source) {
+    source->EnableSink();
+  }
+  m_server->streams.emplace_back(weak_from_this());
+}
+
+bool MjpegServerImpl::LoopConn::StartFrame(const Frame& frame, int* width,
+                                           int* height, int* requiredQuality,
+                                           int* defaultQuality) {
+  // skip the frame if the client hasn't received the previous one yet
+  if (m_writing || !frame) {
+    return false;
+  }
+
+  auto thisFrameTime = frame.GetTime();
+  if (thisFrameTime != 0 && m_timePerFrame != 0 && m_lastFrameTime != 0) {
+    Frame::Time deltaTime = thisFrameTime - m_lastFrameTime;
+
+    // drop frame if it is early compared to the desired frame rate AND
+    // the current average is higher than the desired average
+    if (deltaTime < m_timePerFrame && m_averageFrameTime < m_timePerFrame) {
+      return false;
+    }
+
+    // update average
+    if (m_averageFrameTime != 0) {
+      m_averageFrameTime = m_averageFrameTime *
+                               (m_averagePeriod - m_timePerFrame) /
+                               m_averagePeriod +
+                           deltaTime * m_timePerFrame / m_averagePeriod;
+    } else {
+      m_averageFrameTime = deltaTime;
+    }
+  }
+  m_lastFrameTime = thisFrameTime;
+
+  *width = m_width != 0 ? m_width : frame.GetOriginalWidth();
+  *height = m_height != 0 ? m_height : frame.GetOriginalHeight();
+  *requiredQuality = m_compression;
+  *defaultQuality = m_compression == -1 ? m_defaultCompression : m_compression;
+  m_writing = true;
+  return true;
+}
+
+void MjpegServerImpl::LoopConn::WriteFrame(
+    std::shared_ptr<SourceImpl::EncodedJpeg> jpeg, const Frame& frame) {
+  // the server may have been stopped (closing the connection) while the
+  // frame was being encoded
+  if (!jpeg || !m_server->server || m_stream.IsClosing()) {
+    m_writing = false;
+    return;
+  }
+
+  const char* data = jpeg->image->data();
+  size_t size = jpeg->size;
+  SDEBUG4("sending frame size={} addDHT={}", size, jpeg->addDHT);
+
+  // print the individual mimetype and the length
+  // sending the content-length fixes random stream disruption observed
+  // with firefox
+  double timestamp = frame.GetTime() / 1000000.0;
+  wpi::SmallString<128> header;
+  wpi::raw_svector_ostream oss{header};
+  oss << "\r\n--" BOUNDARY "\r\n"
+      << "Content-Type: image/jpeg\r\n";
+  fmt::print(oss, "Content-Length: {}\r\n", size);
+  fmt::print(oss, "X-Timestamp: {}\r\n", timestamp);
+  oss << "\r\n";
+
+  // the image data is written directly from the shared encoded image, which
+  // is kept alive until the write completes
+  wpi::SmallVector<wpi::uv::Buffer, 4> bufs;
+  bufs.emplace_back(wpi::uv::Buffer::Dup(oss.str()));
+  if (jpeg->addDHT) {
+    // Insert DHT data immediately before SOF
+    size_t locSOF = jpeg->locSOF;
+    bufs.emplace_back(data, locSOF);
+    bufs.emplace_back(JpegGetDHT());
+    bufs.emplace_back(data + locSOF, jpeg->image->size() - locSOF);
+  } else {
+    bufs.emplace_back(data, size);
+  }
+
+  m_stream.Write(bufs, [self = shared_from_this(), jpeg](
+                           auto bufs, wpi::uv::Error err) {
+    bufs[0].Deallocate();
+    self->m_writing = false;
+    if (err) {
+      self->m_stream.Close();
+    }
+  });
+  // No other write is pending, so libuv has already started sending this one
+  // (as for the threaded server, this is the time of the first byte sent)
+  if (m_server->server) {
+    m_server->server->RecordFrameLatency(frame);
+  }
+}
+
 namespace cs {
 
 CS_Sink CreateMjpegServer(std::string_view name, std::string_view listenAddress,
                           int port, CS_Status* status) {
   auto& inst = Instance::GetInstance();
+  if (inst.mjpegServerEventLoop) {
+    return inst.CreateSink(CS_SINK_MJPEG,
+                           std::make_shared<MjpegServerImpl>(
+                               name, inst.logger, inst.notifier, inst.telemetry,
+                               listenAddress, port, inst.eventLoop));
+  }
   return inst.CreateSink(
       CS_SINK_MJPEG,
       std::make_shared<MjpegServerImpl>(
@@ -1029,6 +1517,10 @@ int GetMjpegServerPort(CS_Sink sink, CS_Status* status) {
   return static_cast<MjpegServerImpl&>(*data->sink).GetPort();
 }
 
+void SetMjpegServerEventLoop(bool enabled) {
+  Instance::GetInstance().mjpegServerEventLoop = enabled;
+}
+
 }  // namespace cs
 
 extern "C" {
@@ -1046,4 +1538,8 @@ int CS_GetMjpegServerPort(CS_Sink sink, CS_Status* status) {
   return cs::GetMjpegServerPort(sink, status);
 }
 
+void CS_SetMjpegServerEventLoop(CS_Bool enabled) {
+  cs::SetMjpegServerEventLoop(enabled);
+}
+
 }  // extern "C"
@@ -16,6 +16,7 @@
 #include <wpi/SmallVector.h>
 #include <wpi/raw_istream.h>
 #include <wpi/raw_ostream.h>
+#include <wpinet/EventLoopRunner.h>
 #include <wpinet/NetworkAcceptor.h>
 #include <wpinet/NetworkStream.h>
 #include <wpinet/raw_socket_ostream.h>
@@ -32,18 +33,32 @@ class MjpegServerImpl : public SinkImpl {
                   Notifier& notifier, Telemetry& telemetry,
                   std::string_view listenAddress, int port,
                   std::unique_ptr<wpi::NetworkAcceptor> acceptor);
+  // Serves all clients from an event loop rather than a thread per client
+  MjpegServerImpl(std::string_view name, wpi::Logger& logger,
+                  Notifier& notifier, Telemetry& telemetry,
+                  std::string_view listenAddress, int port,
+                  wpi::EventLoopRunner& eventLoop);
   ~MjpegServerImpl() override;
 
   void Stop();
   std::string GetListenAddress() { return m_listenAddress; }
-  int GetPort() { return m_port; }
+  // If port 0 was requested, this is the port the system picked (event loop
+  // mode only)
+  int GetPort();
 
  private:
   void SetSourceImpl(std::shared_ptr<SourceImpl> source) override;
 
+  void CreateProperties();
   void ServerThreadMain();
 
+  class ConnBase;
   class ConnThread;
+  class LoopConn;
+  struct LoopServer;
+
+  // Sets a connection's stream settings from the properties
+  void InitConn(ConnBase& conn);
 
   // Never changed, so not protected by mutex
   std::string m_listenAddress;
@@ -55,6 +70,10 @@ class MjpegServerImpl : public SinkImpl {
 
   std::vector<wpi::SafeThreadOwner<ConnThread>> m_connThreads;
 
+  // Event loop mode (m_acceptor and threads are not used)
+  wpi::EventLoopRunner* m_eventLoop = nullptr;
+  std::shared_ptr<LoopServer> m_loopServer;
+
   // property indices
   int m_widthProp;
   int m_heightProp;
@@ -25,6 +25,7 @@ void RawSourceImpl::PutFrame(const CS_RawFrame& image) {
   int type;
   switch (image.pixelFormat) {
     case VideoMode::kYUYV:
+    case VideoMode::kUYVY:
     case VideoMode::kRGB565:
       type = CV_8UC2;
       break;
@@ -5,10 +5,12 @@
 #include "SinkImpl.h"
 
 #include <wpi/json.h>
+#include <wpi/timestamp.h>
 
 #include "Instance.h"
 #include "Notifier.h"
 #include "SourceImpl.h"
+#include "Telemetry.h"
 
 using namespace cs;
 
@@ -102,6 +104,14 @@ void SinkImpl::SetSource(std::shared_ptr<SourceImpl> source) {
   SetSourceImpl(source);
 }
 
+void SinkImpl::RecordFrameLatency(const Frame& frame) {
+  auto now = wpi::Now();
+  auto captureTime = frame.GetCaptureTime();
+  if (captureTime != 0 && captureTime <= now) {
+    m_telemetry.RecordSinkFrameLatency(*this, now - captureTime);
+  }
+}
+
 std::string SinkImpl::GetError() const {
   std::scoped_lock lock(m_mutex);
   if (!m_source) {
@@ -13,6 +13,7 @@
 #include <wpi/mutex.h>
 
 #include "SourceImpl.h"
+#include "Telemetry.h"
 
 namespace wpi {
 class json;
@@ -22,7 +23,6 @@ namespace cs {
 
 class Frame;
 class Notifier;
-class Telemetry;
 
 class SinkImpl : public PropertyContainer {
  public:
@@ -56,6 +56,9 @@ class SinkImpl : public PropertyContainer {
   std::string GetConfigJson(CS_Status* status);
   virtual wpi::json GetConfigJsonObject(CS_Status* status);
 
+  // Recorded by m_telemetry; gathered by its thread
+  TelemetryValues& GetTelemetryValues() const { return m_telemetryValues; }
+
  protected:
   // PropertyContainer implementation
   void NotifyPropertyCreated(int propIndex, PropertyImpl& prop) override;
@@ -64,6 +67,9 @@ class SinkImpl : public PropertyContainer {
 
   virtual void SetSourceImpl(std::shared_ptr<SourceImpl> source);
 
+  // Records the latency from capture to the frame being sent or handed off
+  void RecordFrameLatency(const Frame& frame);
+
  protected:
   wpi::Logger& m_logger;
   Notifier& m_notifier;
@@ -74,6 +80,7 @@ class SinkImpl : public PropertyContainer {
   std::string m_description;
   std::shared_ptr<SourceImpl> m_source;
   int m_enabledCount{0};
+  mutable TelemetryValues m_telemetryValues;
 };
 
 }  // namespace cs
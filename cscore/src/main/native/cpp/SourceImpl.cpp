@@ -5,6 +5,7 @@
 #include "SourceImpl.h"
 
 #include <algorithm>
+#include <bit>
 #include <cstring>
 #include <memory>
 
@@ -12,13 +13,39 @@
 #include <wpi/json.h>
 #include <wpi/timestamp.h>
 
+#include "JpegUtil.h"
 #include "Log.h"
 #include "Notifier.h"
 #include "Telemetry.h"
 
 using namespace cs;
 
-static constexpr size_t kMaxImagesAvail = 32;
+// Limit on the total capacity of pooled (available) images
+static constexpr size_t kMaxImagesAvailBytes = 64 * 1024 * 1024;
+
+// Gets the smallest image size class at least the given size.  Each power of
+// two is divided into four classes, so an image is never more than 25% larger
+// than requested.
+size_t SourceImpl::GetImageSizeClass(size_t size) {
+  constexpr int kMinBits = kImageSizeClassMinBits;
+  if (size <= (size_t{1} << kMinBits)) {
+    return 0;
+  }
+  // 2^(bits-1) < size <= 2^bits, so this rounds up to 5/8, 6/8, 7/8 or 8/8
+  // of 2^bits
+  int bits = std::bit_width(size - 1);
+  size_t eighths = (size + (size_t{1} << (bits - 3)) - 1) >> (bits - 3);
+  return 1 + 4 * (bits - kMinBits - 1) + (eighths - 5);
+}
+
+size_t SourceImpl::GetImageSizeClassSize(size_t sizeClass) {
+  constexpr int kMinBits = kImageSizeClassMinBits;
+  if (sizeClass == 0) {
+    return size_t{1} << kMinBits;
+  }
+  int bits = kMinBits + 1 + (sizeClass - 1) / 4;
+  return ((sizeClass - 1) % 4 + 5) << (bits - 3);
+}
 
 SourceImpl::SourceImpl(std::string_view name, wpi::Logger& logger,
                        Notifier& notifier, Telemetry& telemetry)
@@ -33,6 +60,10 @@ SourceImpl::~SourceImpl() {
   // Wake up anyone who is waiting.  This also clears the current frame,
   // which is good because its destructor will call back into the class.
   Wakeup();
+  {
+    std::scoped_lock lock{m_jpegCacheMutex};
+    m_jpegCache.clear();
+  }
   // Set a flag so ReleaseFrame() doesn't re-add them to m_framesAvail.
   // Put in a block so we destroy before the destructor ends.
   {
@@ -99,6 +130,23 @@ void SourceImpl::Wakeup() {
   m_frameCv.notify_all();
 }
 
+size_t SourceImpl::AddFrameListener(std::function<void()> callback) {
+  std::scoped_lock lock{m_frameListenerMutex};
+  return m_frameListeners.emplace_back(std::move(callback));
+}
+
+void SourceImpl::RemoveFrameListener(size_t listener) {
+  std::scoped_lock lock{m_frameListenerMutex};
+  m_frameListeners.erase(listener);
+}
+
+void SourceImpl::NotifyFrameListeners() {
+  std::scoped_lock lock{m_frameListenerMutex};
+  for (auto&& listener : m_frameListeners) {
+    listener();
+  }
+}
+
 void SourceImpl::SetBrightness(int brightness, CS_Status* status) {
   *status = CS_INVALID_HANDLE;
 }
@@ -198,6 +246,8 @@ bool SourceImpl::SetConfigJson(const wpi::json& config, CS_Status* status) {
         mode.pixelFormat = cs::VideoMode::kBGR;
       } else if (wpi::equals_lower(str, "gray")) {
         mode.pixelFormat = cs::VideoMode::kGray;
+      } else if (wpi::equals_lower(str, "uyvy")) {
+        mode.pixelFormat = cs::VideoMode::kUYVY;
       } else {
         SWARNING("SetConfigJson: could not understand pixel format value '{}'",
                  str);
@@ -360,6 +410,9 @@ wpi::json SourceImpl::GetConfigJsonObject(CS_Status* status) {
     case VideoMode::kGray:
       pixelFormat = "gray";
       break;
+    case VideoMode::kUYVY:
+      pixelFormat = "uyvy";
+      break;
     default:
       break;
   }
@@ -404,30 +457,50 @@ std::vector<VideoMode> SourceImpl::EnumerateVideoModes(
 
 std::unique_ptr<Image> SourceImpl::AllocImage(
     VideoMode::PixelFormat pixelFormat, int width, int height, size_t size) {
+  auto image = AllocPooledImage(pixelFormat, width, height, size);
+  if (image) {
+    return image;
+  }
+
+  size_t sizeClass = GetImageSizeClass(size);
+  if (sizeClass < kNumImageSizeClasses) {
+    image = std::make_unique<Image>(GetImageSizeClassSize(sizeClass));
+  } else {
+    // too large to pool
+    image = std::make_unique<Image>(size);
+  }
+  m_telemetry.RecordSourceImagePoolMisses(*this, 1);
+
+  // Initialize image
+  image->SetSize(size);
+  image->pixelFormat = pixelFormat;
+  image->width = width;
+  image->height = height;
+
+  return image;
+}
+
+std::unique_ptr<Image> SourceImpl::AllocPooledImage(
+    VideoMode::PixelFormat pixelFormat, int width, int height, size_t size) {
+  // Images are pooled by size class, so this is a constant time lookup and
+  // never returns an image much larger than requested.
+  size_t sizeClass = GetImageSizeClass(size);
+  if (sizeClass >= kNumImageSizeClasses) {
+    return nullptr;
+  }
   std::unique_ptr<Image> image;
   {
     std::scoped_lock lock{m_poolMutex};
-    // find the smallest existing frame that is at least big enough.
-    int found = -1;
-    for (size_t i = 0; i < m_imagesAvail.size(); ++i) {
-      // is it big enough?
-      if (m_imagesAvail[i] && m_imagesAvail[i]->capacity() >= size) {
-        // is it smaller than the last found?
-        if (found < 0 ||
-            m_imagesAvail[i]->capacity() < m_imagesAvail[found]->capacity()) {
-          // yes, update
-          found = i;
-        }
-      }
-    }
-
-    // if nothing found, allocate a new buffer
-    if (found < 0) {
-      image = std::make_unique<Image>(size);
-    } else {
-      image = std::move(m_imagesAvail[found]);
+    m_imageSizeClassLastUse[sizeClass] = ++m_imageSizeClassUses;
+    auto& avail = m_imagesAvail[sizeClass];
+    if (avail.empty()) {
+      return nullptr;
     }
+    image = std::move(avail.back());
+    avail.pop_back();
+    m_imagesAvailBytes -= image->capacity();
   }
+  m_telemetry.RecordSourceImagePoolHits(*this, 1);
 
   // Initialize image
   image->SetSize(size);
@@ -438,8 +511,63 @@ std::unique_ptr<Image> SourceImpl::AllocImage(
   return image;
 }
 
+std::shared_ptr<SourceImpl::EncodedJpeg> SourceImpl::GetEncodedJpeg(
+    const Frame& frame, int width, int height, int requiredQuality,
+    int defaultQuality) {
+  Frame::Time time = frame.GetTime();
+  int effectiveQuality =
+      requiredQuality == -1 ? defaultQuality : requiredQuality;
+  std::unique_lock lock{m_jpegCacheMutex};
+  for (auto&& jpeg : m_jpegCache) {
+    if (jpeg->frame.GetTime() == time && jpeg->width == width &&
+        jpeg->height == height && jpeg->quality == requiredQuality &&
+        jpeg->effectiveQuality == effectiveQuality) {
+      m_telemetry.RecordSourceJpegCacheHits(*this, 1);
+      // Another caller may still be encoding it; wait for that rather than
+      // duplicating the encode
+      auto rv = jpeg;
+      m_jpegCacheCv.wait(lock, [&] { return rv->ready; });
+      return rv->image ? rv : nullptr;
+    }
+  }
+  m_telemetry.RecordSourceJpegCacheMisses(*this, 1);
+
+  // Only keep encodings of the newest frame
+  std::erase_if(m_jpegCache,
+                [&](const auto& jpeg) { return jpeg->frame.GetTime() < time; });
+
+  // Add the in-flight entry and encode it without holding the lock, so
+  // other variants (and other frames) can be encoded concurrently
+  auto jpeg = std::make_shared<EncodedJpeg>();
+  jpeg->frame = frame;
+  jpeg->width = width;
+  jpeg->height = height;
+  jpeg->quality = requiredQuality;
+  jpeg->effectiveQuality = effectiveQuality;
+  m_jpegCache.emplace_back(jpeg);
+  lock.unlock();
+
+  Image* image = jpeg->frame.GetImageMJPEG(width, height, requiredQuality,
+                                           defaultQuality);
+  if (image && image->pixelFormat == VideoMode::kMJPEG) {
+    // Determine if we need to add DHT to it
+    jpeg->size = image->size();
+    jpeg->locSOF = jpeg->size;
+    jpeg->addDHT = JpegNeedsDHT(image->data(), &jpeg->size, &jpeg->locSOF);
+  } else {
+    image = nullptr;
+  }
+
+  lock.lock();
+  jpeg->image = image;
+  jpeg->ready = true;
+  m_jpegCacheCv.notify_all();
+  return image ? jpeg : nullptr;
+}
+
 void SourceImpl::PutFrame(VideoMode::PixelFormat pixelFormat, int width,
-                          int height, std::string_view data, Frame::Time time) {
+                          int height, std::string_view data, Frame::Time time,
+                          Frame::Time captureTime) {
   auto image = AllocImage(pixelFormat, width, height, data.size());
 
   // Copy in image data
@@ -447,22 +575,27 @@ void SourceImpl::PutFrame(VideoMode::PixelFormat pixelFormat, int width,
           fmt::ptr(data.data()), data.size());
   std::memcpy(image->data(), data.data(), data.size());
 
-  PutFrame(std::move(image), time);
+  PutFrame(std::move(image), time, captureTime);
 }
 
-void SourceImpl::PutFrame(std::unique_ptr<Image> image, Frame::Time time) {
+void SourceImpl::PutFrame(std::unique_ptr<Image> image, Frame::Time time,
+                          Frame::Time captureTime) {
   // Update telemetry
   m_telemetry.RecordSourceFrames(*this, 1);
   m_telemetry.RecordSourceBytes(*this, static_cast<int>(image->size()));
+  if (captureTime != 0 && captureTime <= time) {
+    m_telemetry.RecordSourceCaptureLatency(*this, time - captureTime);
+  }
 
   // Update frame
   {
     std::scoped_lock lock{m_frameMutex};
-    m_frame = Frame{*this, std::move(image), time};
+    m_frame = Frame{*this, std::move(image), time, captureTime};
   }
 
   // Signal listeners
   m_frameCv.notify_all();
+  NotifyFrameListeners();
 }
 
 void SourceImpl::PutError(std::string_view msg, Frame::Time time) {
@@ -474,6 +607,7 @@ void SourceImpl::PutError(std::string_view msg, Frame::Time time) {
 
   // Signal listeners
   m_frameCv.notify_all();
+  NotifyFrameListeners();
 }
 
 void SourceImpl::NotifyPropertyCreated(int propIndex, PropertyImpl& prop) {
@@ -510,29 +644,48 @@ void SourceImpl::UpdatePropertyValue(int property, bool setString, int value,
 }
 
 void SourceImpl::ReleaseImage(std::unique_ptr<Image> image) {
+  if (image->IsEncoded()) {
+    return;  // not pool storage
+  }
   std::scoped_lock lock{m_poolMutex};
   if (m_destroyFrames) {
     return;
   }
-  // Return the frame to the pool.  First try to find an empty slot, otherwise
-  // add it to the end.
-  auto it = std::find(m_imagesAvail.begin(), m_imagesAvail.end(), nullptr);
-  if (it != m_imagesAvail.end()) {
-    *it = std::move(image);
-  } else if (m_imagesAvail.size() > kMaxImagesAvail) {
-    // Replace smallest buffer; don't need to check for null because the above
-    // find would have found it.
-    auto it2 = std::min_element(
-        m_imagesAvail.begin(), m_imagesAvail.end(),
-        [](const std::unique_ptr<Image>& a, const std::unique_ptr<Image>& b) {
-          return a->capacity() < b->capacity();
-        });
-    if ((*it2)->capacity() < image->capacity()) {
-      *it2 = std::move(image);
+
+  // Return the image to the pool of the largest size class it can hold (the
+  // capacity may have grown past its original size class).
+  size_t capacity = image->capacity();
+  size_t sizeClass = GetImageSizeClass(capacity);
+  if (GetImageSizeClassSize(sizeClass) > capacity) {
+    if (sizeClass == 0) {
+      return;  // too small to pool
     }
-  } else {
-    m_imagesAvail.emplace_back(std::move(image));
+    --sizeClass;
+  }
+  if (sizeClass >= kNumImageSizeClasses) {
+    return;  // too large to pool
   }
+
+  // Stay within the pool size limit by freeing images of the least recently
+  // used size classes; if there are none, free this image instead.
+  while (m_imagesAvailBytes + capacity > kMaxImagesAvailBytes) {
+    size_t lru = kNumImageSizeClasses;
+    for (size_t i = 0; i < kNumImageSizeClasses; ++i) {
+      if (i != sizeClass && !m_imagesAvail[i].empty() &&
+          (lru == kNumImageSizeClasses ||
+           m_imageSizeClassLastUse[i] < m_imageSizeClassLastUse[lru])) {
+        lru = i;
+      }
+    }
+    if (lru == kNumImageSizeClasses) {
+      return;
+    }
+    m_imagesAvailBytes -= m_imagesAvail[lru].back()->capacity();
+    m_imagesAvail[lru].pop_back();
+  }
+
+  m_imagesAvailBytes += capacity;
+  m_imagesAvail[sizeClass].emplace_back(std::move(image));
 }
 
 std::unique_ptr<Frame::Impl> SourceImpl::AllocFrameImpl() {
@@ -5,14 +5,19 @@
 #ifndef CSCORE_SOURCEIMPL_H_
 #define CSCORE_SOURCEIMPL_H_
 
+#include <stdint.h>
+
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include <wpi/Logger.h>
+#include <wpi/UidVector.h>
 #include <wpi/condition_variable.h>
 #include <wpi/mutex.h>
 
@@ -20,6 +25,7 @@
 #include "Handle.h"
 #include "Image.h"
 #include "PropertyContainer.h"
+#include "Telemetry.h"
 #include "cscore_cpp.h"
 
 namespace wpi {
@@ -29,7 +35,6 @@ class json;
 namespace cs {
 
 class Notifier;
-class Telemetry;
 
 class SourceImpl : public PropertyContainer {
   friend class Frame;
@@ -105,6 +110,12 @@ class SourceImpl : public PropertyContainer {
   // Force a wakeup of all GetNextFrame() callers by sending an empty frame.
   void Wakeup();
 
+  // Adds a function to be called whenever a new frame (or error) is put.
+  // This is called from the thread putting the frame, so it should only
+  // signal another thread to call GetCurFrame().  Returns a listener ID.
+  size_t AddFrameListener(std::function<void()> callback);
+  void RemoveFrameListener(size_t listener);
+
   // Standard common camera properties
   virtual void SetBrightness(int brightness, CS_Status* status);
   virtual int GetBrightness(CS_Status* status) const;
@@ -135,15 +146,56 @@ class SourceImpl : public PropertyContainer {
 
   std::unique_ptr<Image> AllocImage(VideoMode::PixelFormat pixelFormat,
                                     int width, int height, size_t size);
+  // Like AllocImage(), but only returns an image from the pool; returns
+  // nullptr rather than allocating a new image if none is available.
+  std::unique_ptr<Image> AllocPooledImage(VideoMode::PixelFormat pixelFormat,
+                                          int width, int height, size_t size);
+
+  // A frame encoded as a JPEG image for streaming.  These are shared by all
+  // MJPEG server connections streaming the same frame at the same size and
+  // quality, so each variant is only encoded once.
+  struct EncodedJpeg {
+    // Keeps the image alive
+    Frame frame;
+    Image* image = nullptr;
+    int width = 0;
+    int height = 0;
+    // Required quality (-1 if any), and the quality used if it needs to be
+    // encoded
+    int quality = -1;
+    int effectiveQuality = -1;
+    // Set (under m_jpegCacheMutex) when the encode has finished; the other
+    // fields are only valid after this is set
+    bool ready = false;
+    // Size to send (including the DHT if it needs to be added), and where to
+    // insert the DHT
+    size_t size = 0;
+    size_t locSOF = 0;
+    bool addDHT = false;
+  };
+
+  // Gets a frame as a JPEG image with the given size and quality, encoding
+  // it only if no other caller has already done so.  Returns nullptr if the
+  // frame could not be converted.
+  std::shared_ptr<EncodedJpeg> GetEncodedJpeg(const Frame& frame, int width,
+                                              int height, int requiredQuality,
+                                              int defaultQuality);
+
+  // Recorded by m_telemetry; gathered by its thread
+  TelemetryValues& GetTelemetryValues() const { return m_telemetryValues; }
 
  protected:
   void NotifyPropertyCreated(int propIndex, PropertyImpl& prop) override;
   void UpdatePropertyValue(int property, bool setString, int value,
                            std::string_view valueStr) override;
 
+  // captureTime is the time the device captured the frame, if known (0 if
+  // not); it's used for latency telemetry
   void PutFrame(VideoMode::PixelFormat pixelFormat, int width, int height,
-                std::string_view data, Frame::Time time);
-  void PutFrame(std::unique_ptr<Image> image, Frame::Time time);
+                std::string_view data, Frame::Time time,
+                Frame::Time captureTime = 0);
+  void PutFrame(std::unique_ptr<Image> image, Frame::Time time,
+                Frame::Time captureTime = 0);
   void PutError(std::string_view msg, Frame::Time time);
 
   // Notification functions for corresponding atomics
@@ -163,6 +215,7 @@ class SourceImpl : public PropertyContainer {
   Telemetry& m_telemetry;
 
  private:
+  void NotifyFrameListeners();
   void ReleaseImage(std::unique_ptr<Image> image);
   std::unique_ptr<Frame::Impl> AllocFrameImpl();
   void ReleaseFrameImpl(std::unique_ptr<Frame::Impl> data);
@@ -176,20 +229,48 @@ class SourceImpl : public PropertyContainer {
   wpi::mutex m_frameMutex;
   wpi::condition_variable m_frameCv;
 
+  wpi::mutex m_frameListenerMutex;
+  wpi::UidVector<std::function<void()>, 4> m_frameListeners;
+
   bool m_destroyFrames{false};
 
+  // Image pool size classes: up to 4 KiB, then four classes per power of two
+  // up to 1 GiB (see AllocImage())
+  static constexpr int kImageSizeClassMinBits = 12;
+  static constexpr int kImageSizeClassMaxBits = 30;
+  static constexpr size_t kNumImageSizeClasses =
+      1 + 4 * (kImageSizeClassMaxBits - kImageSizeClassMinBits);
+  static size_t GetImageSizeClass(size_t size);
+  static size_t GetImageSizeClassSize(size_t sizeClass);
+
   // Pool of frames/images to reduce malloc traffic.
   wpi::mutex m_poolMutex;
   std::vector<std::unique_ptr<Frame::Impl>> m_framesAvail;
-  std::vector<std::unique_ptr<Image>> m_imagesAvail;
+  // Available images, by size class
+  std::array<std::vector<std::unique_ptr<Image>>, kNumImageSizeClasses>
+      m_imagesAvail;
+  // Total capacity of available images
+  size_t m_imagesAvailBytes{0};
+  // Last use of each size class (for eviction), and use counter
+  std::array<uint64_t, kNumImageSizeClasses> m_imageSizeClassLastUse{};
+  uint64_t m_imageSizeClassUses{0};
 
   std::atomic_bool m_connected{false};
 
+  mutable TelemetryValues m_telemetryValues;
+
   // Most recent frame (returned to callers of GetNextFrame)
   // Access protected by m_frameMutex.
   // MUST be located below m_poolMutex as the Frame destructor calls back
   // into SourceImpl::ReleaseImage, which locks m_poolMutex.
   Frame m_frame;
+
+  // JPEG images of the most recent frame(s) (see GetEncodedJpeg()),
+  // including ones still being encoded.  Also MUST be located below
+  // m_poolMutex.
+  wpi::mutex m_jpegCacheMutex;
+  wpi::condition_variable m_jpegCacheCv;
+  std::vector<std::shared_ptr<EncodedJpeg>> m_jpegCache;
 };
 
 }  // namespace cs
@@ -4,37 +4,114 @@
 
 #include "Telemetry.h"
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
+#include <cmath>
 #include <limits>
 
 #include <wpi/DenseMap.h>
+#include <wpi/SmallVector.h>
 #include <wpi/timestamp.h>
 
-#include "Handle.h"
 #include "Instance.h"
 #include "Notifier.h"
+#include "SinkImpl.h"
 #include "SourceImpl.h"
 #include "cscore_cpp.h"
 
 using namespace cs;
 
+static bool IsLatencyKind(CS_TelemetryKind kind) {
+  return kind == CS_SOURCE_CAPTURE_LATENCY ||
+         kind == CS_SOURCE_CONVERT_LATENCY || kind == CS_SINK_FRAME_LATENCY;
+}
+
+int LatencyHistogram::GetBucket(uint64_t value) {
+  if (value < kNumExactBuckets) {
+    return static_cast<int>(value);
+  }
+  if (value > UINT32_MAX) {
+    return kNumBuckets - 1;
+  }
+  // the top two bits below the leading one select one of four buckets
+  int exp = std::bit_width(value) - 1;
+  int sub = (value >> (exp - 2)) & 3;
+  return kNumExactBuckets + (exp - 3) * 4 + sub;
+}
+
+uint64_t LatencyHistogram::GetBucketLimit(int bucket) {
+  if (bucket < kNumExactBuckets) {
+    return bucket + 1;
+  }
+  int exp = 3 + (bucket - kNumExactBuckets) / 4;
+  int sub = (bucket - kNumExactBuckets) % 4;
+  return static_cast<uint64_t>(5 + sub) << (exp - 2);
+}
+
+void LatencyHistogram::Record(uint64_t value) {
+  ++m_buckets[GetBucket(value)];
+  ++m_count;
+  m_sum += value;
+  m_max = (std::max)(m_max, value);
+}
+
+double LatencyHistogram::GetMean() const {
+  if (m_count == 0) {
+    return 0.0;
+  }
+  return static_cast<double>(m_sum) / m_count;
+}
+
+int64_t LatencyHistogram::GetPercentile(double percentile) const {
+  if (m_count == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(
+      std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * m_count));
+  rank = (std::max<uint64_t>)(rank, 1);
+  uint64_t total = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    total += m_buckets[i];
+    if (total >= rank) {
+      return (std::min)(GetBucketLimit(i) - 1, m_max);
+    }
+  }
+  return m_max;
+}
+
 class Telemetry::Thread : public wpi::SafeThread {
  public:
+  using ValueMap = wpi::DenseMap<std::pair<CS_Handle, int>, int64_t>;
+  using LatencyMap =
+      wpi::DenseMap<std::pair<CS_Handle, int>, LatencyHistogram>;
+
   explicit Thread(Notifier& notifier) : m_notifier(notifier) {}
 
   void Main() override;
 
+  // Gathers (and resets) the values recorded by all sources and sinks
+  static void GatherAll(ValueMap& values, LatencyMap& latency);
+  static void Gather(CS_Handle handle, TelemetryValues& from,
+                     ValueMap& values, LatencyMap& latency);
+
   Notifier& m_notifier;
-  wpi::DenseMap<std::pair<CS_Handle, int>, int64_t> m_user;
-  wpi::DenseMap<std::pair<CS_Handle, int>, int64_t> m_current;
+  ValueMap m_user;
+  LatencyMap m_userLatency;
   double m_period = 0.0;
   double m_elapsed = 0.0;
   bool m_updated = false;
   int64_t GetValue(CS_Handle handle, CS_TelemetryKind kind, CS_Status* status);
+  const LatencyHistogram* GetLatency(CS_Handle handle, CS_TelemetryKind kind,
+                                     CS_Status* status);
 };
 
 int64_t Telemetry::Thread::GetValue(CS_Handle handle, CS_TelemetryKind kind,
                                     CS_Status* status) {
+  if (IsLatencyKind(kind)) {
+    auto hist = GetLatency(handle, kind, status);
+    return hist ? hist->GetPercentile(50) : 0;
+  }
   auto it = m_user.find(std::make_pair(handle, static_cast<int>(kind)));
   if (it == m_user.end()) {
     *status = CS_EMPTY_VALUE;
@@ -43,17 +120,72 @@ int64_t Telemetry::Thread::GetValue(CS_Handle handle, CS_TelemetryKind kind,
   return it->getSecond();
 }
 
+const LatencyHistogram* Telemetry::Thread::GetLatency(CS_Handle handle,
+                                                      CS_TelemetryKind kind,
+                                                      CS_Status* status) {
+  auto it = m_userLatency.find(std::make_pair(handle, static_cast<int>(kind)));
+  if (it == m_userLatency.end()) {
+    *status = CS_EMPTY_VALUE;
+    return nullptr;
+  }
+  return &it->getSecond();
+}
+
+void Telemetry::Thread::GatherAll(ValueMap& values, LatencyMap& latency) {
+  auto& inst = Instance::GetInstance();
+  wpi::SmallVector<CS_Handle, 16> handles;
+  for (auto handle : inst.EnumerateSourceHandles(handles)) {
+    if (auto data = inst.GetSource(handle)) {
+      Gather(handle, data->source->GetTelemetryValues(), values, latency);
+    }
+  }
+  handles.clear();
+  for (auto handle : inst.EnumerateSinkHandles(handles)) {
+    if (auto data = inst.GetSink(handle)) {
+      Gather(handle, data->sink->GetTelemetryValues(), values, latency);
+    }
+  }
+}
+
+void Telemetry::Thread::Gather(CS_Handle handle, TelemetryValues& from,
+                               ValueMap& values, LatencyMap& latency) {
+  uint32_t recorded = from.m_recorded.exchange(0, std::memory_order_relaxed);
+  for (int kind = 0; kind < TelemetryValues::kFirstLatencyKind; ++kind) {
+    if ((recorded & (1u << kind)) != 0) {
+      values[std::make_pair(handle, kind)] =
+          from.m_values[kind].exchange(0, std::memory_order_relaxed);
+    }
+  }
+
+  std::scoped_lock lock{from.m_latencyMutex};
+  for (int kind = TelemetryValues::kFirstLatencyKind;
+       kind < TelemetryValues::kNumKinds; ++kind) {
+    auto& hist = from.m_latency[kind - TelemetryValues::kFirstLatencyKind];
+    if (hist.GetCount() != 0) {
+      latency[std::make_pair(handle, kind)] = hist;
+      hist = LatencyHistogram{};
+    }
+  }
+}
+
 Telemetry::~Telemetry() = default;
 
 void Telemetry::Start() {
   m_owner.Start(m_notifier);
+  m_enabled = true;
 }
 
 void Telemetry::Stop() {
+  m_enabled = false;
   m_owner.Stop();
 }
 
 void Telemetry::Thread::Main() {
+  // Discard anything left over from the last time telemetry was enabled
+  ValueMap values;
+  LatencyMap latency;
+  GatherAll(values, latency);
+
   std::unique_lock lock(m_mutex);
   auto prevTime = std::chrono::steady_clock::now();
   while (m_active) {
@@ -75,9 +207,15 @@ void Telemetry::Thread::Main() {
       continue;
     }
 
-    // move to user and clear current, as we don't keep around old values
-    m_user = std::move(m_current);
-    m_current.clear();
+    // gather to user, resetting the sources and sinks, as we don't keep
+    // around old values
+    lock.unlock();
+    values.clear();
+    latency.clear();
+    GatherAll(values, latency);
+    lock.lock();
+    m_user = std::move(values);
+    m_userLatency = std::move(latency);
     auto curTime = std::chrono::steady_clock::now();
     m_elapsed = std::chrono::duration<double>(curTime - prevTime).count();
     prevTime = curTime;
@@ -125,30 +263,86 @@ double Telemetry::GetAverageValue(CS_Handle handle, CS_TelemetryKind kind,
     *status = CS_TELEMETRY_NOT_ENABLED;
     return 0;
   }
+  if (IsLatencyKind(kind)) {
+    auto hist = thr->GetLatency(handle, kind, status);
+    return hist ? hist->GetMean() : 0.0;
+  }
   if (thr->m_elapsed == 0) {
     return 0.0;
   }
   return thr->GetValue(handle, kind, status) / thr->m_elapsed;
 }
 
-void Telemetry::RecordSourceBytes(const SourceImpl& source, int quantity) {
+int64_t Telemetry::GetLatency(CS_Handle handle, CS_TelemetryKind kind,
+                              double percentile, CS_Status* status) {
   auto thr = m_owner.GetThread();
   if (!thr) {
-    return;
+    *status = CS_TELEMETRY_NOT_ENABLED;
+    return 0;
+  }
+  auto hist = thr->GetLatency(handle, kind, status);
+  return hist ? hist->GetPercentile(percentile) : 0;
+}
+
+void Telemetry::RecordSourceBytes(const SourceImpl& source, int quantity) {
+  if (m_enabled) {
+    source.GetTelemetryValues().Add(CS_SOURCE_BYTES_RECEIVED, quantity);
   }
-  auto handleData = Instance::GetInstance().FindSource(source);
-  thr->m_current[std::make_pair(Handle{handleData.first, Handle::kSource},
-                                static_cast<int>(CS_SOURCE_BYTES_RECEIVED))] +=
-      quantity;
 }
 
 void Telemetry::RecordSourceFrames(const SourceImpl& source, int quantity) {
-  auto thr = m_owner.GetThread();
-  if (!thr) {
-    return;
+  if (m_enabled) {
+    source.GetTelemetryValues().Add(CS_SOURCE_FRAMES_RECEIVED, quantity);
+  }
+}
+
+void Telemetry::RecordSourceJpegCacheHits(const SourceImpl& source,
+                                          int quantity) {
+  if (m_enabled) {
+    source.GetTelemetryValues().Add(CS_SOURCE_JPEG_CACHE_HITS, quantity);
+  }
+}
+
+void Telemetry::RecordSourceJpegCacheMisses(const SourceImpl& source,
+                                            int quantity) {
+  if (m_enabled) {
+    source.GetTelemetryValues().Add(CS_SOURCE_JPEG_CACHE_MISSES, quantity);
+  }
+}
+
+void Telemetry::RecordSourceImagePoolHits(const SourceImpl& source,
+                                          int quantity) {
+  if (m_enabled) {
+    source.GetTelemetryValues().Add(CS_SOURCE_IMAGE_POOL_HITS, quantity);
+  }
+}
+
+void Telemetry::RecordSourceImagePoolMisses(const SourceImpl& source,
+                                            int quantity) {
+  if (m_enabled) {
+    source.GetTelemetryValues().Add(CS_SOURCE_IMAGE_POOL_MISSES, quantity);
+  }
+}
+
+void Telemetry::RecordSourceCaptureLatency(const SourceImpl& source,
+                                           uint64_t latency) {
+  if (m_enabled) {
+    source.GetTelemetryValues().RecordLatency(CS_SOURCE_CAPTURE_LATENCY,
+                                              latency);
+  }
+}
+
+void Telemetry::RecordSourceConvertLatency(const SourceImpl& source,
+                                           uint64_t latency) {
+  if (m_enabled) {
+    source.GetTelemetryValues().RecordLatency(CS_SOURCE_CONVERT_LATENCY,
+                                              latency);
+  }
+}
+
+void Telemetry::RecordSinkFrameLatency(const SinkImpl& sink,
+                                       uint64_t latency) {
+  if (m_enabled) {
+    sink.GetTelemetryValues().RecordLatency(CS_SINK_FRAME_LATENCY, latency);
   }
-  auto handleData = Instance::GetInstance().FindSource(source);
-  thr->m_current[std::make_pair(Handle{handleData.first, Handle::kSource},
-                                static_cast<int>(CS_SOURCE_FRAMES_RECEIVED))] +=
-      quantity;
 }
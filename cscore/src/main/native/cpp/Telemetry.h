@@ -5,15 +5,81 @@
 #ifndef CSCORE_TELEMETRY_H_
 #define CSCORE_TELEMETRY_H_
 
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+
 #include <wpi/SafeThread.h>
+#include <wpi/mutex.h>
 
 #include "cscore_cpp.h"
 
 namespace cs {
 
 class Notifier;
+class SinkImpl;
 class SourceImpl;
 
+// Latency histogram with logarithmic buckets (four per power of two), so
+// recording is a single increment and percentiles are within 25%.  Values
+// are in microseconds.
+class LatencyHistogram {
+ public:
+  void Record(uint64_t value);
+
+  uint64_t GetCount() const { return m_count; }
+  double GetMean() const;
+  // Returns the upper end of the bucket containing the given percentile
+  // (limited to the maximum value recorded), or 0 if empty.
+  int64_t GetPercentile(double percentile) const;
+
+  static int GetBucket(uint64_t value);
+  // Exclusive upper limit of a bucket
+  static uint64_t GetBucketLimit(int bucket);
+
+ private:
+  // Values below kNumExactBuckets get their own bucket; values of 2^32 us
+  // (over an hour) or more all go in the last bucket.
+  static constexpr int kNumExactBuckets = 8;
+  static constexpr int kNumBuckets = kNumExactBuckets + (32 - 3) * 4;
+
+  std::array<uint32_t, kNumBuckets> m_buckets{};
+  uint64_t m_count = 0;
+  uint64_t m_sum = 0;
+  uint64_t m_max = 0;
+};
+
+// Telemetry recorded by a single source or sink.  This is kept on the source
+// or sink, so recording is an atomic increment (or a histogram update under
+// a per-source/sink lock) rather than a handle lookup under the telemetry
+// lock.  The telemetry thread gathers and resets it once per period.
+class TelemetryValues {
+  friend class Telemetry;
+
+ public:
+  void Add(CS_TelemetryKind kind, int64_t quantity) {
+    m_values[kind].fetch_add(quantity, std::memory_order_relaxed);
+    m_recorded.fetch_or(1u << kind, std::memory_order_relaxed);
+  }
+
+  void RecordLatency(CS_TelemetryKind kind, uint64_t latency) {
+    std::scoped_lock lock{m_latencyMutex};
+    m_latency[kind - kFirstLatencyKind].Record(latency);
+  }
+
+ private:
+  // The latency kinds are the last kinds
+  static constexpr int kFirstLatencyKind = CS_SOURCE_CAPTURE_LATENCY;
+  static constexpr int kNumKinds = CS_SINK_FRAME_LATENCY + 1;
+
+  std::array<std::atomic<int64_t>, kFirstLatencyKind> m_values{};
+  // Bit per kind, set if the kind has been recorded this period
+  std::atomic<uint32_t> m_recorded{0};
+  wpi::mutex m_latencyMutex;
+  std::array<LatencyHistogram, kNumKinds - kFirstLatencyKind> m_latency;
+};
+
 class Telemetry {
   friend class TelemetryTest;
 
@@ -30,14 +96,26 @@ class Telemetry {
   int64_t GetValue(CS_Handle handle, CS_TelemetryKind kind, CS_Status* status);
   double GetAverageValue(CS_Handle handle, CS_TelemetryKind kind,
                          CS_Status* status);
+  int64_t GetLatency(CS_Handle handle, CS_TelemetryKind kind, double percentile,
+                     CS_Status* status);
 
   // Telemetry events
   void RecordSourceBytes(const SourceImpl& source, int quantity);
   void RecordSourceFrames(const SourceImpl& source, int quantity);
+  void RecordSourceJpegCacheHits(const SourceImpl& source, int quantity);
+  void RecordSourceJpegCacheMisses(const SourceImpl& source, int quantity);
+  void RecordSourceImagePoolHits(const SourceImpl& source, int quantity);
+  void RecordSourceImagePoolMisses(const SourceImpl& source, int quantity);
+  void RecordSourceCaptureLatency(const SourceImpl& source, uint64_t latency);
+  void RecordSourceConvertLatency(const SourceImpl& source, uint64_t latency);
+  void RecordSinkFrameLatency(const SinkImpl& sink, uint64_t latency);
 
  private:
   Notifier& m_notifier;
 
+  // Set while the thread is running; nothing is recorded otherwise
+  std::atomic_bool m_enabled{false};
+
   class Thread;
   wpi::SafeThreadOwner<Thread> m_owner;
 };
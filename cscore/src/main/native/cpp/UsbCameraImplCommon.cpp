@@ -4,11 +4,20 @@
 
 #include "cscore_c.h"  // NOLINT(build/include_order)
 
+#include "Instance.h"
 #include "c_util.h"
 #include "cscore_cpp.h"
 
 using namespace cs;
 
+namespace cs {
+
+void SetUsbCameraSharedCapture(bool enabled) {
+  Instance::GetInstance().usbCameraSharedCapture = enabled;
+}
+
+}  // namespace cs
+
 static void ConvertToC(CS_UsbCameraInfo* out, const UsbCameraInfo& in) {
   out->dev = in.dev;
   out->path = ConvertToC(in.path);
@@ -52,6 +61,10 @@ char* CS_GetUsbCameraPath(CS_Source source, CS_Status* status) {
   return ConvertToC(cs::GetUsbCameraPath(source, status));
 }
 
+void CS_SetUsbCameraSharedCapture(CS_Bool enabled) {
+  cs::SetUsbCameraSharedCapture(enabled);
+}
+
 CS_UsbCameraInfo* CS_GetUsbCameraInfo(CS_Source source, CS_Status* status) {
   auto info = cs::GetUsbCameraInfo(source, status);
   if (*status != CS_OK) {
@@ -436,6 +436,11 @@ double CS_GetTelemetryAverageValue(CS_Handle handle, CS_TelemetryKind kind,
   return cs::GetTelemetryAverageValue(handle, kind, status);
 }
 
+int64_t CS_GetTelemetryLatency(CS_Handle handle, CS_TelemetryKind kind,
+                               double percentile, CS_Status* status) {
+  return cs::GetTelemetryLatency(handle, kind, percentile, status);
+}
+
 void CS_SetLogger(CS_LogFunc func, unsigned int min_level) {
   cs::SetLogger(func, min_level);
 }
@@ -839,6 +839,12 @@ double GetTelemetryAverageValue(CS_Handle handle, CS_TelemetryKind kind,
                                                            status);
 }
 
+int64_t GetTelemetryLatency(CS_Handle handle, CS_TelemetryKind kind,
+                            double percentile, CS_Status* status) {
+  return Instance::GetInstance().telemetry.GetLatency(handle, kind, percentile,
+                                                      status);
+}
+
 //
 // Logging Functions
 //
@@ -1135,6 +1135,18 @@ Java_edu_wpi_first_cscore_CameraServerJNI_getUsbCameraInfo
   return MakeJObject(env, info);
 }
 
+/*
+ * Class:     edu_wpi_first_cscore_CameraServerJNI
+ * Method:    setUsbCameraSharedCapture
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL
+Java_edu_wpi_first_cscore_CameraServerJNI_setUsbCameraSharedCapture
+  (JNIEnv* env, jclass, jboolean enabled)
+{
+  cs::SetUsbCameraSharedCapture(enabled);
+}
+
 /*
  * Class:     edu_wpi_first_cscore_CameraServerJNI
  * Method:    getHttpCameraKind
@@ -1654,6 +1666,18 @@ Java_edu_wpi_first_cscore_CameraServerJNI_getMjpegServerPort
   return val;
 }
 
+/*
+ * Class:     edu_wpi_first_cscore_CameraServerJNI
+ * Method:    setMjpegServerEventLoop
+ * Signature: (Z)V
+ */
+JNIEXPORT void JNICALL
+Java_edu_wpi_first_cscore_CameraServerJNI_setMjpegServerEventLoop
+  (JNIEnv* env, jclass, jboolean enabled)
+{
+  cs::SetMjpegServerEventLoop(enabled);
+}
+
 /*
  * Class:     edu_wpi_first_cscore_CameraServerJNI
  * Method:    setSinkDescription
@@ -2041,6 +2065,22 @@ Java_edu_wpi_first_cscore_CameraServerJNI_getTelemetryAverageValue
   return val;
 }
 
+/*
+ * Class:     edu_wpi_first_cscore_CameraServerJNI
+ * Method:    getTelemetryLatency
+ * Signature: (IID)J
+ */
+JNIEXPORT jlong JNICALL
+Java_edu_wpi_first_cscore_CameraServerJNI_getTelemetryLatency
+  (JNIEnv* env, jclass, jint handle, jint kind, jdouble percentile)
+{
+  CS_Status status = 0;
+  auto val = cs::GetTelemetryLatency(
+      handle, static_cast<CS_TelemetryKind>(kind), percentile, &status);
+  CheckStatus(env, status);
+  return val;
+}
+
 /*
  * Class:     edu_wpi_first_cscore_CameraServerJNI
  * Method:    enumerateUsbCameras
@@ -0,0 +1,66 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef CSCORE_PAGE_ALIGNED_ALLOCATOR_H_
+#define CSCORE_PAGE_ALIGNED_ALLOCATOR_H_
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <new>
+
+namespace cs {
+
+// Allocator that aligns allocations to the system page size, e.g. so they
+// can be used as V4L2 user pointer buffers.  Allocations of at least a huge
+// page are aligned to the huge page size and advised to use transparent huge
+// pages (if enabled by the system), to reduce TLB misses on large images.
+template <typename T>
+class page_aligned_allocator {
+ public:
+  using value_type = T;
+
+  page_aligned_allocator() noexcept = default;
+  template <typename U>
+  page_aligned_allocator(  // NOLINT(runtime/explicit)
+      const page_aligned_allocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    size_t size = n * sizeof(T);
+    auto ptr = ::operator new(size, GetAlignment(size));
+#ifdef MADV_HUGEPAGE
+    if (size >= kHugePageSize) {
+      // only advisory, so errors are ignored
+      madvise(ptr, size, MADV_HUGEPAGE);
+    }
+#endif
+    return static_cast<T*>(ptr);
+  }
+  void deallocate(T* ptr, size_t n) noexcept {
+    ::operator delete(ptr, GetAlignment(n * sizeof(T)));
+  }
+
+  template <typename U>
+  bool operator==(const page_aligned_allocator<U>&) const noexcept {
+    return true;
+  }
+
+ private:
+  // PMD size with 4 KiB pages (e.g. x86-64 and ARM64)
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+  static std::align_val_t GetAlignment(size_t size) {
+    static const std::align_val_t alignment{
+        static_cast<size_t>(sysconf(_SC_PAGESIZE))};
+    if (size >= kHugePageSize) {
+      return std::align_val_t{kHugePageSize};
+    }
+    return alignment;
+  }
+};
+
+}  // namespace cs
+
+#endif  // CSCORE_PAGE_ALIGNED_ALLOCATOR_H_
@@ -93,7 +93,8 @@ enum CS_PixelFormat {
   CS_PIXFMT_YUYV,
   CS_PIXFMT_RGB565,
   CS_PIXFMT_BGR,
-  CS_PIXFMT_GRAY
+  CS_PIXFMT_GRAY,
+  CS_PIXFMT_UYVY
 };
 
 /**
@@ -176,10 +177,32 @@ enum CS_EventKind {
 
 /**
  * Telemetry kinds
+ *
+ * The *_LATENCY kinds are histograms in microseconds.  For these, the
+ * telemetry value is the median, the average value is the mean, and other
+ * percentiles are available from CS_GetTelemetryLatency().
  */
 enum CS_TelemetryKind {
   CS_SOURCE_BYTES_RECEIVED = 1,
-  CS_SOURCE_FRAMES_RECEIVED = 2
+  CS_SOURCE_FRAMES_RECEIVED = 2,
+  CS_SOURCE_JPEG_CACHE_HITS = 3,
+  CS_SOURCE_JPEG_CACHE_MISSES = 4,
+  CS_SOURCE_IMAGE_POOL_HITS = 5,
+  CS_SOURCE_IMAGE_POOL_MISSES = 6,
+  /**
+   * Capture (device timestamp) to the frame being put by the source.  Only
+   * recorded for sources that report capture times.
+   */
+  CS_SOURCE_CAPTURE_LATENCY = 7,
+  /**
+   * Time taken by each image conversion or encode.
+   */
+  CS_SOURCE_CONVERT_LATENCY = 8,
+  /**
+   * Capture to the first byte of the frame being sent (MJPEG server) or the
+   * frame being handed to the caller (CV sink).
+   */
+  CS_SINK_FRAME_LATENCY = 9
 };
 
 /** Connection strategy */
@@ -343,6 +366,7 @@ void CS_SetCameraExposureManual(CS_Source source, int value, CS_Status* status);
 void CS_SetUsbCameraPath(CS_Source source, const char* path, CS_Status* status);
 char* CS_GetUsbCameraPath(CS_Source source, CS_Status* status);
 CS_UsbCameraInfo* CS_GetUsbCameraInfo(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraSharedCapture(CS_Bool enabled);
 /** @} */
 
 /**
@@ -414,6 +438,7 @@ void CS_ReleaseSink(CS_Sink sink, CS_Status* status);
  */
 char* CS_GetMjpegServerListenAddress(CS_Sink sink, CS_Status* status);
 int CS_GetMjpegServerPort(CS_Sink sink, CS_Status* status);
+void CS_SetMjpegServerEventLoop(CS_Bool enabled);
 /** @} */
 
 /**
@@ -461,6 +486,8 @@ int64_t CS_GetTelemetryValue(CS_Handle handle, enum CS_TelemetryKind kind,
                              CS_Status* status);
 double CS_GetTelemetryAverageValue(CS_Handle handle, enum CS_TelemetryKind kind,
                                    CS_Status* status);
+int64_t CS_GetTelemetryLatency(CS_Handle handle, enum CS_TelemetryKind kind,
+                               double percentile, CS_Status* status);
 /** @} */
 
 /**
@@ -68,7 +68,8 @@ struct VideoMode : public CS_VideoMode {
     kYUYV = CS_PIXFMT_YUYV,
     kRGB565 = CS_PIXFMT_RGB565,
     kBGR = CS_PIXFMT_BGR,
-    kGray = CS_PIXFMT_GRAY
+    kGray = CS_PIXFMT_GRAY,
+    kUYVY = CS_PIXFMT_UYVY
   };
   VideoMode() {
     pixelFormat = 0;
@@ -278,6 +279,9 @@ void SetCameraExposureManual(CS_Source source, int value, CS_Status* status);
 void SetUsbCameraPath(CS_Source, std::string_view path, CS_Status* status);
 std::string GetUsbCameraPath(CS_Source source, CS_Status* status);
 UsbCameraInfo GetUsbCameraInfo(CS_Source source, CS_Status* status);
+// Capture from subsequently created USB cameras using a single shared thread
+// and a small worker pool, rather than a thread per camera (Linux only).
+void SetUsbCameraSharedCapture(bool enabled);
 /** @} */
 
 /**
@@ -357,6 +361,9 @@ void ReleaseSink(CS_Sink sink, CS_Status* status);
  */
 std::string GetMjpegServerListenAddress(CS_Sink sink, CS_Status* status);
 int GetMjpegServerPort(CS_Sink sink, CS_Status* status);
+// Serve clients of subsequently created MJPEG servers from a single shared
+// event loop thread instead of a thread per client.
+void SetMjpegServerEventLoop(bool enabled);
 /** @} */
 
 /**
@@ -405,6 +412,8 @@ int64_t GetTelemetryValue(CS_Handle handle, CS_TelemetryKind kind,
                           CS_Status* status);
 double GetTelemetryAverageValue(CS_Handle handle, CS_TelemetryKind kind,
                                 CS_Status* status);
+int64_t GetTelemetryLatency(CS_Handle handle, CS_TelemetryKind kind,
+                            double percentile, CS_Status* status);
 /** @} */
 
 /**
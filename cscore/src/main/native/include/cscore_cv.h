@@ -39,6 +39,8 @@ uint64_t CS_GrabSinkFrameTimeout(CS_Sink sink, struct CvMat* image,
 
 #ifdef __cplusplus
 
+#include <memory>
+
 #include "cscore_oo.h"
 
 namespace cv {
@@ -65,6 +67,12 @@ void PutSourceFrame(CS_Source source, cv::Mat& image, CS_Status* status);
 uint64_t GrabSinkFrame(CS_Sink sink, cv::Mat& image, CS_Status* status);
 uint64_t GrabSinkFrameTimeout(CS_Sink sink, cv::Mat& image, double timeout,
                               CS_Status* status);
+uint64_t GrabSinkFrameNoCopy(CS_Sink sink,
+                             std::shared_ptr<const cv::Mat>& image,
+                             CS_Status* status);
+uint64_t GrabSinkFrameNoCopyTimeout(CS_Sink sink,
+                                    std::shared_ptr<const cv::Mat>& image,
+                                    double timeout, CS_Status* status);
 
 /**
  * A source for user code to provide OpenCV images as video frames.
@@ -164,6 +172,42 @@ class CvSink : public ImageSink {
    *         and is in 1 us increments.
    */
   [[nodiscard]] uint64_t GrabFrameNoTimeout(cv::Mat& image) const;
+
+  /**
+   * Wait for the next frame and get a read-only view of the image, without
+   * copying it.  Times out (returning 0) after timeout seconds.
+   * The image will have three 8-bit channels stored in BGR order.
+   *
+   * <p>The view refers to the frame buffer owned by the source; the buffer
+   * is not reused until the last copy of the returned pointer is released.
+   * The previous image in the pointer is released before waiting, so
+   * reusing the same pointer for each call lets the source recycle buffers.
+   * The image is only converted (into a new buffer) if the source frame is
+   * not already BGR.
+   *
+   * <p>The buffer is shared with every other sink using the same frame (e.g.
+   * an MjpegServer streaming it), and const only applies to the cv::Mat
+   * header: copies of the Mat (or Mats constructed from it) alias the same
+   * pixel data and can write to it.  The pixel data must not be modified;
+   * use clone() to get a modifiable copy.
+   *
+   * @return Frame time, or 0 on error (call GetError() to obtain the error
+   *         message); the frame time is in the same time base as wpi::Now(),
+   *         and is in 1 us increments.
+   */
+  [[nodiscard]] uint64_t GrabFrameNoCopy(std::shared_ptr<const cv::Mat>& image,
+                                         double timeout = 0.225) const;
+
+  /**
+   * Wait for the next frame and get a read-only view of the image, without
+   * copying it.  May block forever.  See GrabFrameNoCopy() for details.
+   *
+   * @return Frame time, or 0 on error (call GetError() to obtain the error
+   *         message); the frame time is in the same time base as wpi::Now(),
+   *         and is in 1 us increments.
+   */
+  [[nodiscard]] uint64_t GrabFrameNoCopyNoTimeout(
+      std::shared_ptr<const cv::Mat>& image) const;
 };
 
 inline CvSource::CvSource(std::string_view name, const VideoMode& mode) {
@@ -200,6 +244,18 @@ inline uint64_t CvSink::GrabFrameNoTimeout(cv::Mat& image) const {
   return GrabSinkFrame(m_handle, image, &m_status);
 }
 
+inline uint64_t CvSink::GrabFrameNoCopy(std::shared_ptr<const cv::Mat>& image,
+                                        double timeout) const {
+  m_status = 0;
+  return GrabSinkFrameNoCopyTimeout(m_handle, image, timeout, &m_status);
+}
+
+inline uint64_t CvSink::GrabFrameNoCopyNoTimeout(
+    std::shared_ptr<const cv::Mat>& image) const {
+  m_status = 0;
+  return GrabSinkFrameNoCopy(m_handle, image, &m_status);
+}
+
 }  // namespace cs
 
 #endif
@@ -464,6 +464,15 @@ class UsbCamera : public VideoCamera {
    * @param level 0=don't display Connecting message, 1=do display message
    */
   void SetConnectVerbose(int level);
+
+  /**
+   * Set whether frames are captured directly into frame buffers (zero-copy)
+   * rather than copied from the driver's buffers.  This is only supported on
+   * Linux, and falls back to copying if the driver doesn't support it.
+   *
+   * @param enabled true to enable zero-copy capture
+   */
+  void SetZeroCopy(bool enabled);
 };
 
 /**
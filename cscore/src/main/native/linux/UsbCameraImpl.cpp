@@ -17,6 +17,7 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <algorithm>
@@ -56,6 +57,8 @@ static constexpr char const* kPropExValue = "exposure_absolute";
 static constexpr char const* kPropBrValue = "brightness";
 static constexpr char const* kPropConnectVerbose = "connect_verbose";
 static constexpr unsigned kPropConnectVerboseId = 0;
+static constexpr char const* kPropZeroCopy = "zero_copy";
+static constexpr unsigned kPropZeroCopyId = 1;
 
 // Conversions v4l2_fract time per frame from/to frames per second (fps)
 static inline int FractToFPS(const struct v4l2_fract& timeperframe) {
@@ -82,6 +85,8 @@ static VideoMode::PixelFormat ToPixelFormat(__u32 pixelFormat) {
       return VideoMode::kBGR;
     case V4L2_PIX_FMT_GREY:
       return VideoMode::kGray;
+    case V4L2_PIX_FMT_UYVY:
+      return VideoMode::kUYVY;
     default:
       return VideoMode::kUnknown;
   }
@@ -100,6 +105,8 @@ static __u32 FromPixelFormat(VideoMode::PixelFormat pixelFormat) {
       return V4L2_PIX_FMT_BGR24;
     case VideoMode::kGray:
       return V4L2_PIX_FMT_GREY;
+    case VideoMode::kUYVY:
+      return V4L2_PIX_FMT_UYVY;
     default:
       return 0;
   }
@@ -324,6 +331,10 @@ UsbCameraImpl::UsbCameraImpl(std::string_view name, wpi::Logger& logger,
                                                kPropConnectVerboseId,
                                                CS_PROP_INTEGER, 0, 1, 1, 1, 1);
   });
+  CreateProperty(kPropZeroCopy, [] {
+    return std::make_unique<UsbCameraProperty>(
+        kPropZeroCopy, kPropZeroCopyId, CS_PROP_BOOLEAN, 0, 1, 1, 0, 0);
+  });
 }
 
 UsbCameraImpl::~UsbCameraImpl() {
@@ -332,13 +343,21 @@ UsbCameraImpl::~UsbCameraImpl() {
   // Just in case anyone is waiting...
   m_responseCv.notify_all();
 
-  // Send message to wake up thread; select timeout will wake us up anyway,
-  // but this speeds shutdown.
-  Send(Message{Message::kNone});
+  if (m_useReactor) {
+    UsbCameraReactor::GetInstance().Remove(*this);
+
+    // close camera connection
+    DeviceStreamOff();
+    DeviceDisconnect();
+  } else {
+    // Send message to wake up thread; select timeout will wake us up anyway,
+    // but this speeds shutdown.
+    Send(Message{Message::kNone});
 
-  // join camera thread
-  if (m_cameraThread.joinable()) {
-    m_cameraThread.join();
+    // join camera thread
+    if (m_cameraThread.joinable()) {
+      m_cameraThread.join();
+    }
   }
 
   // close command fd
@@ -358,6 +377,23 @@ static inline void DoFdSet(int fd, fd_set* set, int* nfds) {
 }
 
 void UsbCameraImpl::Start() {
+  if (Instance::GetInstance().usbCameraSharedCapture) {
+    // Watch the device directory for disconnects and reconnects
+    wpi::SmallString<64> pathCopy{m_path};
+    pathCopy.push_back('\0');
+    m_notifyBase = basename(pathCopy.data());
+    std::string dir = dirname(pathCopy.data());
+
+    m_streaming = false;
+    m_wasStreaming = false;
+    m_notified = false;
+    m_useReactor = true;
+    if (UsbCameraReactor::GetInstance().Add(*this, dir)) {
+      return;
+    }
+    m_useReactor = false;
+  }
+
   // Kick off the camera thread
   m_cameraThread = std::thread(&UsbCameraImpl::CameraThreadMain, this);
 }
@@ -380,24 +416,22 @@ void UsbCameraImpl::CameraThreadMain() {
           notify_fd, true, sizeof(struct inotify_event) + NAME_MAX + 1);
     }
   }
-  bool notified = (notify_fd < 0);  // treat as always notified if cannot notify
+  m_canNotify = (notify_fd >= 0);
+  m_notified = !m_canNotify;  // treat as always notified if cannot notify
 
   // Get the basename for later notify use
   wpi::SmallString<64> pathCopy{m_path};
   pathCopy.push_back('\0');
-  wpi::SmallString<64> base{basename(pathCopy.data())};
+  m_notifyBase = basename(pathCopy.data());
 
   // Used to restart streaming on reconnect
-  bool wasStreaming = false;
+  m_wasStreaming = false;
 
   // Default to not streaming
   m_streaming = false;
 
   while (m_active) {
-    // If not connected, try to reconnect
-    if (m_fd < 0) {
-      DeviceConnect();
-    }
+    int timeout = DevicePrepare();
 
     // Make copies of fd's in case they go away
     int command_fd = m_command_fd.load();
@@ -406,31 +440,9 @@ void UsbCameraImpl::CameraThreadMain() {
       break;
     }
 
-    // Reset notified flag and restart streaming if necessary
-    if (fd >= 0) {
-      notified = (notify_fd < 0);
-      if (wasStreaming && !m_streaming) {
-        DeviceStreamOn();
-        wasStreaming = false;
-      }
-    }
-
-    // Turn off streaming if not enabled, and turn it on if enabled
-    if (m_streaming && !IsEnabled()) {
-      DeviceStreamOff();
-    } else if (!m_streaming && IsEnabled()) {
-      DeviceStreamOn();
-    }
-
-    // The select timeout can be long unless we're trying to reconnect
     struct timeval tv;
-    if (fd < 0 && notified) {
-      tv.tv_sec = 0;
-      tv.tv_usec = 300000;
-    } else {
-      tv.tv_sec = 2;
-      tv.tv_usec = 0;
-    }
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
 
     // select on applicable read descriptors
     int nfds = 0;
@@ -463,19 +475,7 @@ void UsbCameraImpl::CameraThreadMain() {
         wpi::SmallString<64> raw_name;
         raw_name.resize(event.len);
         notify_is->read(raw_name.data(), event.len);
-        // If the name is what we expect...
-        std::string_view name{raw_name.c_str()};
-        SDEBUG4("got event on '{}' ({}) compare to '{}' ({}) mask {}", name,
-                name.size(), base, base.size(), event.mask);
-        if (name == base) {
-          if ((event.mask & IN_DELETE) != 0) {
-            wasStreaming = m_streaming;
-            DeviceStreamOff();
-            DeviceDisconnect();
-          } else if ((event.mask & IN_CREATE) != 0) {
-            notified = true;
-          }
-        }
+        DeviceNotifyEvent(raw_name.c_str(), event.mask);
       } while (!notify_is->has_error() &&
                notify_is->in_avail() >= sizeof(event));
       continue;
@@ -493,62 +493,220 @@ void UsbCameraImpl::CameraThreadMain() {
 
     // Handle frames
     if (m_streaming && fd >= 0 && FD_ISSET(fd, &readfds)) {
-      SDEBUG4("grabbing image");
-
-      // Dequeue buffer
-      struct v4l2_buffer buf;
-      std::memset(&buf, 0, sizeof(buf));
-      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-      buf.memory = V4L2_MEMORY_MMAP;
-      if (DoIoctl(fd, VIDIOC_DQBUF, &buf) != 0) {
-        SWARNING("could not dequeue buffer");
-        wasStreaming = m_streaming;
-        DeviceStreamOff();
-        DeviceDisconnect();
-        notified = true;  // device wasn't deleted, just error'ed
-        continue;         // will reconnect
-      }
+      DeviceProcessFrame(fd);
+    }
+  }
+
+  // close camera connection
+  DeviceStreamOff();
+  DeviceDisconnect();
+}
 
-      if ((buf.flags & V4L2_BUF_FLAG_ERROR) == 0) {
-        SDEBUG4("got image size={} index={}", buf.bytesused, buf.index);
+UsbCameraReactor::Wait UsbCameraImpl::ReactorProcess(
+    const UsbCameraReactor::Events& events) {
+  UsbCameraReactor::Wait wait;
+  if (!m_active) {
+    return wait;
+  }
 
-        if (buf.index >= kNumBuffers || !m_buffers[buf.index].m_data) {
-          SWARNING("invalid buffer {}", buf.index);
-          continue;
-        }
+  m_canNotify = ReactorIsWatching();
+  if (!m_canNotify) {
+    m_notified = true;  // treat as always notified if cannot notify
+  }
 
-        std::string_view image{
-            static_cast<const char*>(m_buffers[buf.index].m_data),
-            static_cast<size_t>(buf.bytesused)};
-        int width = m_mode.width;
-        int height = m_mode.height;
-        bool good = true;
-        if (m_mode.pixelFormat == VideoMode::kMJPEG &&
-            !GetJpegSize(image, &width, &height)) {
-          SWARNING("invalid JPEG image received from camera");
-          good = false;
-        }
-        if (good) {
-          PutFrame(static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat),
-                   width, height, image, wpi::Now());  // TODO: time
+  int command_fd = m_command_fd.load();
+  int fd = m_fd.load();
+  auto isReadable = [&](int checkFd) {
+    return checkFd >= 0 && std::find(events.readable.begin(),
+                                     events.readable.end(),
+                                     checkFd) != events.readable.end();
+  };
+
+  // Handle events in the same order as the camera thread
+  for (auto&& [name, mask] : events.notify) {
+    DeviceNotifyEvent(name, mask);
+  }
+  if (isReadable(command_fd)) {
+    SDEBUG4("got command");
+    // Read it to clear
+    eventfd_t val;
+    eventfd_read(command_fd, &val);
+    DeviceProcessCommands();
+  }
+  if (m_streaming && fd >= 0 && fd == m_fd && isReadable(fd)) {
+    DeviceProcessFrame(fd);
+  }
+
+  wait.timeout = DevicePrepare();
+  if (command_fd >= 0) {
+    wait.fds.emplace_back(command_fd);
+  }
+  fd = m_fd.load();
+  if (m_streaming && fd >= 0) {
+    wait.fds.emplace_back(fd);
+  }
+  return wait;
+}
+
+int UsbCameraImpl::DevicePrepare() {
+  // If not connected, try to reconnect
+  if (m_fd < 0) {
+    DeviceConnect();
+  }
+  int fd = m_fd.load();
+
+  // Reset notified flag and restart streaming if necessary
+  if (fd >= 0) {
+    m_notified = !m_canNotify;
+    if (m_wasStreaming && !m_streaming) {
+      DeviceStreamOn();
+      m_wasStreaming = false;
+    }
+  }
+
+  // Turn off streaming if not enabled, and turn it on if enabled
+  if (m_streaming && !IsEnabled()) {
+    DeviceStreamOff();
+  } else if (!m_streaming && IsEnabled()) {
+    DeviceStreamOn();
+  }
+
+  // The wait timeout can be long unless we're trying to reconnect
+  if (fd < 0 && m_notified) {
+    return 300;
+  } else {
+    return 2000;
+  }
+}
+
+void UsbCameraImpl::DeviceNotifyEvent(std::string_view name, uint32_t mask) {
+  // If the name is what we expect...
+  SDEBUG4("got event on '{}' ({}) compare to '{}' ({}) mask {}", name,
+          name.size(), m_notifyBase, m_notifyBase.size(), mask);
+  if (name == m_notifyBase) {
+    if ((mask & IN_DELETE) != 0) {
+      m_wasStreaming = m_streaming;
+      DeviceStreamOff();
+      DeviceDisconnect();
+    } else if ((mask & IN_CREATE) != 0) {
+      m_notified = true;
+    }
+  }
+}
+
+// Converts a V4L2 buffer timestamp to the wpi::Now() timebase, given the
+// current wpi::Now() time.  Returns 0 if the driver doesn't provide monotonic
+// timestamps.
+static Frame::Time GetCaptureTime(const struct v4l2_buffer& buf,
+                                  Frame::Time now) {
+  if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) !=
+      V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+    return 0;
+  }
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+    return 0;
+  }
+  int64_t monoNow = static_cast<int64_t>(ts.tv_sec) * 1000000 +
+                    ts.tv_nsec / 1000;
+  int64_t captured = static_cast<int64_t>(buf.timestamp.tv_sec) * 1000000 +
+                     buf.timestamp.tv_usec;
+  int64_t age = monoNow - captured;
+  if (age < 0 || static_cast<uint64_t>(age) >= now) {
+    return 0;  // bogus timestamp
+  }
+  return now - age;
+}
+
+void UsbCameraImpl::DeviceProcessFrame(int fd) {
+  SDEBUG4("grabbing image");
+
+  // Dequeue buffer
+  struct v4l2_buffer buf;
+  std::memset(&buf, 0, sizeof(buf));
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = m_userPtr ? V4L2_MEMORY_USERPTR : V4L2_MEMORY_MMAP;
+  if (DoIoctl(fd, VIDIOC_DQBUF, &buf) != 0) {
+    SWARNING("could not dequeue buffer");
+    m_wasStreaming = m_streaming;
+    DeviceStreamOff();
+    DeviceDisconnect();
+    m_notified = true;  // device wasn't deleted, just error'ed
+    return;             // will reconnect
+  }
+
+  if ((buf.flags & V4L2_BUF_FLAG_ERROR) == 0) {
+    SDEBUG4("got image size={} index={}", buf.bytesused, buf.index);
+
+    const char* data = nullptr;
+    if (buf.index < kNumBuffers) {
+      if (m_userPtr) {
+        if (m_userBuffers[buf.index]) {
+          data = m_userBuffers[buf.index]->data();
         }
+      } else {
+        data = static_cast<const char*>(m_buffers[buf.index].m_data);
       }
+    }
+    if (!data) {
+      SWARNING("invalid buffer {}", buf.index);
+      return;
+    }
 
-      // Requeue buffer
-      if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
-        SWARNING("could not requeue buffer");
-        wasStreaming = m_streaming;
-        DeviceStreamOff();
-        DeviceDisconnect();
-        notified = true;  // device wasn't deleted, just error'ed
-        continue;         // will reconnect
-      }
+    std::string_view image{data, static_cast<size_t>(buf.bytesused)};
+    int width = m_mode.width;
+    int height = m_mode.height;
+    bool good = true;
+    if (m_mode.pixelFormat == VideoMode::kMJPEG &&
+        !GetJpegSize(image, &width, &height)) {
+      SWARNING("invalid JPEG image received from camera");
+      good = false;
+    }
+    auto now = wpi::Now();
+    auto captureTime = GetCaptureTime(buf, now);
+    // In zero-copy mode, hand off the image the device wrote into and queue
+    // one recycled from a released frame in its place.  If there isn't one
+    // (e.g. sinks are holding on to frames), copy like the mmap path does and
+    // requeue the same image, so the number of capture buffers stays fixed.
+    std::unique_ptr<Image> replacement;
+    if (good && m_userPtr) {
+      replacement = AllocPooledImage(
+          static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat),
+          m_mode.width, m_mode.height, m_userBufferSize);
+    }
+    if (replacement) {
+      auto& userBuffer = m_userBuffers[buf.index];
+      auto frameImage = std::move(userBuffer);
+      frameImage->SetSize(image.size());
+      frameImage->width = width;
+      frameImage->height = height;
+      PutFrame(std::move(frameImage), now, captureTime);
+      userBuffer = std::move(replacement);
+      buf.m.userptr = reinterpret_cast<uintptr_t>(userBuffer->data());
+      buf.length = userBuffer->size();
+    } else if (good && m_userPtr) {
+      // copy into a full size image, so it can be recycled as a capture
+      // buffer once it's released
+      auto frameImage = AllocImage(
+          static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat), width,
+          height, m_userBufferSize);
+      std::memcpy(frameImage->data(), image.data(), image.size());
+      frameImage->SetSize(image.size());
+      PutFrame(std::move(frameImage), now, captureTime);
+    } else if (good) {
+      PutFrame(static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat), width,
+               height, image, now, captureTime);
     }
   }
 
-  // close camera connection
-  DeviceStreamOff();
-  DeviceDisconnect();
+  // Requeue buffer
+  if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
+    SWARNING("could not requeue buffer");
+    m_wasStreaming = m_streaming;
+    DeviceStreamOff();
+    DeviceDisconnect();
+    m_notified = true;  // device wasn't deleted, just error'ed
+  }
 }
 
 void UsbCameraImpl::DeviceDisconnect() {
@@ -565,6 +723,11 @@ void UsbCameraImpl::DeviceDisconnect() {
   // Close device
   close(fd);
 
+  // Release user buffers (only safe once the device can't write to them)
+  for (int i = 0; i < kNumBuffers; ++i) {
+    m_userBuffers[i].reset();
+  }
+
   // Notify
   SetConnected(false);
 }
@@ -625,6 +788,50 @@ void UsbCameraImpl::DeviceConnect() {
   }
 
   // Request buffers
+  m_userPtr = m_zeroCopy && DeviceRequestUserBuffers(fd);
+  if (m_userPtr) {
+    SDEBUG3("using zero-copy buffers of size {}", m_userBufferSize);
+  }
+  if (!m_userPtr && !DeviceRequestMmapBuffers(fd)) {
+    close(fd);
+    m_fd = -1;
+    return;
+  }
+
+  // Update description (as it may have changed)
+  SetDescription(GetDescriptionImpl(m_path.c_str()));
+
+  // Update quirks settings
+  SetQuirks();
+
+  // Notify
+  SetConnected(true);
+}
+
+bool UsbCameraImpl::DeviceRequestUserBuffers(int fd) {
+  // The buffer size depends on the current format
+  struct v4l2_format vfmt;
+  std::memset(&vfmt, 0, sizeof(vfmt));
+  vfmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  if (DoIoctl(fd, VIDIOC_G_FMT, &vfmt) != 0 || vfmt.fmt.pix.sizeimage == 0) {
+    return false;
+  }
+
+  struct v4l2_requestbuffers rb;
+  std::memset(&rb, 0, sizeof(rb));
+  rb.count = kNumBuffers;
+  rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  rb.memory = V4L2_MEMORY_USERPTR;
+  if (TryIoctl(fd, VIDIOC_REQBUFS, &rb) != 0) {
+    SDEBUG("zero-copy capture not supported, falling back to mmap");
+    return false;
+  }
+
+  m_userBufferSize = vfmt.fmt.pix.sizeimage;
+  return true;
+}
+
+bool UsbCameraImpl::DeviceRequestMmapBuffers(int fd) {
   SDEBUG3("allocating buffers");
   struct v4l2_requestbuffers rb;
   std::memset(&rb, 0, sizeof(rb));
@@ -633,9 +840,7 @@ void UsbCameraImpl::DeviceConnect() {
   rb.memory = V4L2_MEMORY_MMAP;
   if (DoIoctl(fd, VIDIOC_REQBUFS, &rb) != 0) {
     SWARNING("could not allocate buffers");
-    close(fd);
-    m_fd = -1;
-    return;
+    return false;
   }
 
   // Map buffers
@@ -648,9 +853,7 @@ void UsbCameraImpl::DeviceConnect() {
     buf.memory = V4L2_MEMORY_MMAP;
     if (DoIoctl(fd, VIDIOC_QUERYBUF, &buf) != 0) {
       SWARNING("could not query buffer {}", i);
-      close(fd);
-      m_fd = -1;
-      return;
+      return false;
     }
     SDEBUG4("buf {} length={} offset={}", i, buf.length, buf.m.offset);
 
@@ -661,22 +864,31 @@ void UsbCameraImpl::DeviceConnect() {
       for (int j = 0; j < i; ++j) {
         m_buffers[j] = UsbCameraBuffer{};
       }
-      close(fd);
-      m_fd = -1;
-      return;
+      return false;
     }
 
     SDEBUG4("buf {} address={}", i, m_buffers[i].m_data);
   }
+  return true;
+}
 
-  // Update description (as it may have changed)
-  SetDescription(GetDescriptionImpl(m_path.c_str()));
+bool UsbCameraImpl::DeviceFallBackToMmap(int fd) {
+  SWARNING("could not queue zero-copy buffers, falling back to mmap");
+  m_userPtr = false;
 
-  // Update quirks settings
-  SetQuirks();
+  // Free the user pointer buffers; the device no longer references the
+  // images after this
+  struct v4l2_requestbuffers rb;
+  std::memset(&rb, 0, sizeof(rb));
+  rb.count = 0;
+  rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  rb.memory = V4L2_MEMORY_USERPTR;
+  TryIoctl(fd, VIDIOC_REQBUFS, &rb);
+  for (int i = 0; i < kNumBuffers; ++i) {
+    m_userBuffers[i].reset();
+  }
 
-  // Notify
-  SetConnected(true);
+  return DeviceRequestMmapBuffers(fd);
 }
 
 bool UsbCameraImpl::DeviceStreamOn() {
@@ -696,7 +908,27 @@ bool UsbCameraImpl::DeviceStreamOn() {
     buf.index = i;
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
     buf.memory = V4L2_MEMORY_MMAP;
-    if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
+    if (m_userPtr) {
+      auto& userBuffer = m_userBuffers[i];
+      if (!userBuffer) {
+        userBuffer = AllocImage(
+            static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat),
+            m_mode.width, m_mode.height, m_userBufferSize);
+      }
+      buf.memory = V4L2_MEMORY_USERPTR;
+      buf.m.userptr = reinterpret_cast<uintptr_t>(userBuffer->data());
+      buf.length = userBuffer->size();
+    }
+    if (m_userPtr && i == 0) {
+      // Some drivers accept user pointer buffers in REQBUFS but reject the
+      // memory at QBUF time (e.g. if they need physically contiguous memory)
+      if (TryIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
+        if (!DeviceFallBackToMmap(fd)) {
+          return false;
+        }
+        return DeviceStreamOn();
+      }
+    } else if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
       SWARNING("could not queue buffer {}", i);
       return false;
     }
@@ -846,9 +1078,14 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetProperty(
   }
 
   // Actually set the new value on the device (if possible)
+  bool reconnect = false;
   if (!prop->device) {
     if (prop->id == kPropConnectVerboseId) {
       m_connectVerbose = value;
+    } else if (prop->id == kPropZeroCopyId) {
+      // buffers are allocated on connect
+      reconnect = m_zeroCopy != (value != 0);
+      m_zeroCopy = value != 0;
     }
   } else {
     if (!prop->DeviceSet(lock, m_fd, value, valueStr)) {
@@ -863,6 +1100,12 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetProperty(
                         valueStr);
   }
 
+  if (reconnect) {
+    lock.unlock();
+    DeviceReconnect();
+    lock.lock();
+  }
+
   return CS_OK;
 }
 
@@ -870,6 +1113,12 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetPath(
     std::unique_lock<wpi::mutex>& lock, const Message& msg) {
   m_path = msg.dataStr;
   lock.unlock();
+  DeviceReconnect();
+  lock.lock();
+  return CS_OK;
+}
+
+void UsbCameraImpl::DeviceReconnect() {
   // disconnect and reconnect
   bool wasStreaming = m_streaming;
   if (wasStreaming) {
@@ -882,8 +1131,6 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetPath(
   if (wasStreaming) {
     DeviceStreamOn();
   }
-  lock.lock();
-  return CS_OK;
 }
 
 CS_StatusValue UsbCameraImpl::DeviceProcessCommand(
@@ -24,13 +24,14 @@
 #include "SourceImpl.h"
 #include "UsbCameraBuffer.h"
 #include "UsbCameraProperty.h"
+#include "UsbCameraReactor.h"
 
 namespace cs {
 
 class Notifier;
 class Telemetry;
 
-class UsbCameraImpl : public SourceImpl {
+class UsbCameraImpl : public SourceImpl, private UsbCameraReactor::Client {
  public:
   UsbCameraImpl(std::string_view name, wpi::Logger& logger, Notifier& notifier,
                 Telemetry& telemetry, std::string_view path);
@@ -110,7 +111,14 @@ class UsbCameraImpl : public SourceImpl {
   // The camera processing thread
   void CameraThreadMain();
 
-  // Functions used by CameraThreadMain()
+  // Camera processing when using the shared capture reactor instead
+  UsbCameraReactor::Wait ReactorProcess(
+      const UsbCameraReactor::Events& events) override;
+
+  // Functions used by CameraThreadMain() and ReactorProcess()
+  int DevicePrepare();
+  void DeviceNotifyEvent(std::string_view name, uint32_t mask);
+  void DeviceProcessFrame(int fd);
   void DeviceDisconnect();
   void DeviceConnect();
   bool DeviceStreamOn();
@@ -122,6 +130,10 @@ class UsbCameraImpl : public SourceImpl {
   void DeviceCacheProperty(std::unique_ptr<UsbCameraProperty> rawProp);
   void DeviceCacheProperties();
   void DeviceCacheVideoModes();
+  bool DeviceRequestUserBuffers(int fd);
+  bool DeviceRequestMmapBuffers(int fd);
+  bool DeviceFallBackToMmap(int fd);
+  void DeviceReconnect();
 
   // Command helper functions
   CS_StatusValue DeviceProcessCommand(std::unique_lock<wpi::mutex>& lock,
@@ -142,7 +154,16 @@ class UsbCameraImpl : public SourceImpl {
   //
   // Variables only used within camera thread
   //
+  bool m_useReactor{false};
   bool m_streaming;
+  // Used to restart streaming on reconnect
+  bool m_wasStreaming{false};
+  // Whether the device may have been reconnected; always set if device
+  // directory changes can't be watched
+  bool m_notified{false};
+  bool m_canNotify{false};
+  // Device basename, for directory change events
+  std::string m_notifyBase;
   bool m_modeSetPixelFormat{false};
   bool m_modeSetResolution{false};
   bool m_modeSetFPS{false};
@@ -151,6 +172,15 @@ class UsbCameraImpl : public SourceImpl {
   // Number of buffers to ask OS for
   static constexpr int kNumBuffers = 4;
   std::array<UsbCameraBuffer, kNumBuffers> m_buffers;
+  // Zero-copy capture: the device writes directly into (page aligned) images
+  // from the frame pool (V4L2_MEMORY_USERPTR), which are handed off as frames
+  // and replaced with images recycled from released frames, rather than
+  // copying out of the mmap'ed buffers.  Falls back to mmap if the driver
+  // doesn't support it or rejects the first buffer.
+  bool m_zeroCopy{false};
+  bool m_userPtr{false};
+  size_t m_userBufferSize{0};
+  std::array<std::unique_ptr<Image>, kNumBuffers> m_userBuffers;
 
   std::atomic_int m_fd;
   std::atomic_int m_command_fd;  // for command eventfd
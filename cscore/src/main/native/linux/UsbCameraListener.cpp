@@ -9,47 +9,85 @@
 #include <wpinet/uv/FsEvent.h>
 #include <wpinet/uv/Timer.h>
 
+#include "Instance.h"
 #include "Notifier.h"
+#include "UsbCameraReactor.h"
 
 using namespace cs;
 
-class UsbCameraListener::Impl {
+class UsbCameraListener::Impl : public UsbCameraReactor::Client {
  public:
   explicit Impl(Notifier& notifier) : m_notifier(notifier) {}
 
+  // Used when sharing the USB camera capture reactor
+  UsbCameraReactor::Wait ReactorProcess(
+      const UsbCameraReactor::Events& events) override;
+
   Notifier& m_notifier;
 
   std::unique_ptr<wpi::EventLoopRunner> m_runner;
+  bool m_reactor = false;
+  bool m_refreshPending = false;
 };
 
+UsbCameraReactor::Wait UsbCameraListener::Impl::ReactorProcess(
+    const UsbCameraReactor::Events& events) {
+  UsbCameraReactor::Wait wait;
+  for (auto&& event : events.notify) {
+    if (wpi::starts_with(event.first, "video")) {
+      m_refreshPending = true;
+    }
+  }
+  if (m_refreshPending) {
+    if (events.notify.empty() && events.timedOut) {
+      m_refreshPending = false;
+      m_notifier.NotifyUsbCamerasChanged();
+    } else {
+      // wait for changes to settle
+      wait.timeout = 200;
+    }
+  }
+  return wait;
+}
+
 UsbCameraListener::UsbCameraListener(wpi::Logger& logger, Notifier& notifier)
     : m_impl(std::make_unique<Impl>(notifier)) {}
 
 UsbCameraListener::~UsbCameraListener() = default;
 
 void UsbCameraListener::Start() {
-  if (!m_impl->m_runner) {
-    m_impl->m_runner = std::make_unique<wpi::EventLoopRunner>();
-    m_impl->m_runner->ExecAsync([impl = m_impl.get()](wpi::uv::Loop& loop) {
-      auto refreshTimer = wpi::uv::Timer::Create(loop);
-      refreshTimer->timeout.connect([notifier = &impl->m_notifier] {
-        notifier->NotifyUsbCamerasChanged();
-      });
-      refreshTimer->Unreference();
-
-      auto devEvents = wpi::uv::FsEvent::Create(loop);
-      devEvents->fsEvent.connect([refreshTimer](const char* fn, int flags) {
-        if (wpi::starts_with(fn, "video")) {
-          refreshTimer->Start(wpi::uv::Timer::Time(200));
-        }
-      });
-      devEvents->Start("/dev");
-      devEvents->Unreference();
-    });
+  if (m_impl->m_runner || m_impl->m_reactor) {
+    return;
   }
+  if (Instance::GetInstance().usbCameraSharedCapture &&
+      UsbCameraReactor::GetInstance().Add(*m_impl, "/dev")) {
+    m_impl->m_reactor = true;
+    return;
+  }
+  m_impl->m_runner = std::make_unique<wpi::EventLoopRunner>();
+  m_impl->m_runner->ExecAsync([impl = m_impl.get()](wpi::uv::Loop& loop) {
+    auto refreshTimer = wpi::uv::Timer::Create(loop);
+    refreshTimer->timeout.connect([notifier = &impl->m_notifier] {
+      notifier->NotifyUsbCamerasChanged();
+    });
+    refreshTimer->Unreference();
+
+    auto devEvents = wpi::uv::FsEvent::Create(loop);
+    devEvents->fsEvent.connect([refreshTimer](const char* fn, int flags) {
+      if (wpi::starts_with(fn, "video")) {
+        refreshTimer->Start(wpi::uv::Timer::Time(200));
+      }
+    });
+    devEvents->Start("/dev");
+    devEvents->Unreference();
+  });
 }
 
 void UsbCameraListener::Stop() {
+  if (m_impl->m_reactor) {
+    UsbCameraReactor::GetInstance().Remove(*m_impl);
+    m_impl->m_reactor = false;
+  }
   if (m_impl->m_runner) {
     m_impl->m_runner.reset();
   }
@@ -0,0 +1,335 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "UsbCameraReactor.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "Instance.h"
+#include "Log.h"
+
+using namespace cs;
+
+static constexpr int kMaxEvents = 16;
+// Retry delays if epoll_wait() fails
+static constexpr std::chrono::milliseconds kMinErrorBackoff{10};
+static constexpr std::chrono::milliseconds kMaxErrorBackoff{1000};
+
+UsbCameraReactor& UsbCameraReactor::GetInstance() {
+  // intentionally leaked, like Instance
+  static UsbCameraReactor* reactor =
+      new UsbCameraReactor{Instance::GetInstance().logger};
+  return *reactor;
+}
+
+bool UsbCameraReactor::Init() {
+  if (m_epollFd >= 0) {
+    return true;
+  }
+
+  m_wakeFd = ::eventfd(0, EFD_NONBLOCK);
+  if (m_wakeFd < 0) {
+    ERROR("UsbCameraReactor: could not create eventfd: {}",
+          std::strerror(errno));
+    return false;
+  }
+
+  int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) {
+    ERROR("UsbCameraReactor: could not create epoll: {}",
+          std::strerror(errno));
+    ::close(m_wakeFd);
+    m_wakeFd = -1;
+    return false;
+  }
+
+  struct epoll_event ev;
+  std::memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = m_wakeFd;
+  ::epoll_ctl(epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+
+  // directory watching is optional; clients fall back to polling
+  m_notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_notifyFd >= 0) {
+    ev.data.fd = m_notifyFd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, m_notifyFd, &ev);
+  }
+
+  m_epollFd = epollFd;
+  return true;
+}
+
+bool UsbCameraReactor::Add(Client& client, std::string_view watchDir) {
+  std::scoped_lock clientsLock(m_clientsMutex);
+  std::scoped_lock lock(m_mutex);
+  if (!Init()) {
+    return false;
+  }
+
+  // start threads if necessary
+  if (!m_active) {
+    m_active = true;
+    m_thread = std::thread(&UsbCameraReactor::ReactorMain, this);
+    unsigned int numWorkers =
+        std::clamp(std::thread::hardware_concurrency(), 2u, 4u);
+    for (unsigned int i = 0; i < numWorkers; ++i) {
+      m_workers.emplace_back(&UsbCameraReactor::WorkerMain, this);
+    }
+  }
+
+  client.m_watch = -1;
+  if (!watchDir.empty() && m_notifyFd >= 0) {
+    std::string dir{watchDir};
+    int wd =
+        ::inotify_add_watch(m_notifyFd, dir.c_str(), IN_CREATE | IN_DELETE);
+    if (wd >= 0) {
+      ++m_watchRefs[wd];
+      client.m_watch = wd;
+    }
+  }
+
+  m_clients.emplace_back(&client);
+  client.m_pending.timedOut = true;
+  Schedule(client);
+  return true;
+}
+
+void UsbCameraReactor::Remove(Client& client) {
+  std::vector<std::thread> threads;
+  std::scoped_lock clientsLock(m_clientsMutex);
+  {
+    std::unique_lock lock(m_mutex);
+    auto it = std::find(m_clients.begin(), m_clients.end(), &client);
+    if (it == m_clients.end()) {
+      return;
+    }
+    m_clients.erase(it);
+
+    // wait for processing to finish, and drop any queued work
+    m_idleCv.wait(lock, [&] { return !client.m_running; });
+    if (client.m_queued) {
+      m_work.erase(std::find(m_work.begin(), m_work.end(), &client));
+      client.m_queued = false;
+    }
+    client.m_pending = Events{};
+    client.m_hasPending = false;
+    client.m_hasDeadline = false;
+
+    UpdateFds(client, wpi::SmallVector<int, 2>{});
+    if (client.m_watch >= 0) {
+      if (--m_watchRefs[client.m_watch] == 0) {
+        m_watchRefs.erase(client.m_watch);
+        ::inotify_rm_watch(m_notifyFd, client.m_watch);
+      }
+      client.m_watch = -1;
+    }
+
+    // stop threads when there are no more clients
+    if (m_clients.empty()) {
+      m_active = false;
+      threads = std::move(m_workers);
+      m_workers.clear();
+      threads.emplace_back(std::move(m_thread));
+      m_workCv.notify_all();
+      m_stopCv.notify_all();
+      Wake();
+    }
+  }
+
+  for (auto&& thread : threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
+
+void UsbCameraReactor::ReactorMain() {
+  struct epoll_event events[kMaxEvents];
+  std::chrono::milliseconds backoff{0};
+  std::unique_lock lock(m_mutex);
+  while (m_active) {
+    // wait until the earliest client deadline
+    auto now = std::chrono::steady_clock::now();
+    m_waitDeadline = std::chrono::steady_clock::time_point::max();
+    for (auto client : m_clients) {
+      if (client->m_hasDeadline && client->m_deadline < m_waitDeadline) {
+        m_waitDeadline = client->m_deadline;
+      }
+    }
+    int timeout = -1;
+    if (m_waitDeadline != std::chrono::steady_clock::time_point::max()) {
+      timeout = std::max<int64_t>(
+          std::chrono::ceil<std::chrono::milliseconds>(m_waitDeadline - now)
+              .count(),
+          0);
+    }
+
+    lock.unlock();
+    int n = ::epoll_wait(m_epollFd, events, kMaxEvents, timeout);
+    lock.lock();
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Exiting would leave every client without events, so back off and
+      // retry (still handling timeouts in the meantime).  Only the first
+      // error of a run is logged.
+      if (backoff.count() == 0) {
+        ERROR("UsbCameraReactor: epoll_wait(): {}; retrying",
+              std::strerror(errno));
+        backoff = kMinErrorBackoff;
+      } else {
+        backoff = std::min(backoff * 2, kMaxErrorBackoff);
+      }
+      m_stopCv.wait_for(lock, backoff, [&] { return !m_active; });
+      n = 0;
+    } else if (backoff.count() != 0) {
+      INFO("UsbCameraReactor: epoll_wait() recovered");
+      backoff = std::chrono::milliseconds{0};
+    }
+    if (!m_active) {
+      break;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      int fd = events[i].data.fd;
+      if (fd == m_wakeFd) {
+        eventfd_t val;
+        eventfd_read(m_wakeFd, &val);
+      } else if (fd == m_notifyFd) {
+        ReadNotify();
+      } else if (auto it = m_fdClients.find(fd); it != m_fdClients.end()) {
+        it->second->m_pending.readable.emplace_back(fd);
+        Schedule(*it->second);
+      }
+    }
+
+    // handle expired timeouts
+    now = std::chrono::steady_clock::now();
+    for (auto client : m_clients) {
+      if (client->m_hasDeadline && client->m_deadline <= now) {
+        client->m_hasDeadline = false;
+        client->m_pending.timedOut = true;
+        Schedule(*client);
+      }
+    }
+  }
+}
+
+void UsbCameraReactor::WorkerMain() {
+  std::unique_lock lock(m_mutex);
+  for (;;) {
+    m_workCv.wait(lock, [&] { return !m_active || !m_work.empty(); });
+    if (!m_active) {
+      return;
+    }
+    Client* client = m_work.front();
+    m_work.pop_front();
+    client->m_queued = false;
+    client->m_running = true;
+    Events events = std::move(client->m_pending);
+    client->m_pending = Events{};
+    client->m_hasPending = false;
+
+    lock.unlock();
+    Wait wait = client->ReactorProcess(events);
+    lock.lock();
+
+    client->m_running = false;
+    if (wait.timeout >= 0) {
+      client->m_hasDeadline = true;
+      client->m_deadline = std::chrono::steady_clock::now() +
+                           std::chrono::milliseconds{wait.timeout};
+      // only need to wake the reactor if it would otherwise wait too long
+      if (client->m_deadline < m_waitDeadline) {
+        Wake();
+      }
+    } else {
+      client->m_hasDeadline = false;
+    }
+    UpdateFds(*client, wait.fds);
+    if (client->m_hasPending) {
+      client->m_queued = true;
+      m_work.emplace_back(client);
+    }
+    m_idleCv.notify_all();
+  }
+}
+
+void UsbCameraReactor::ReadNotify() {
+  alignas(struct inotify_event) char buf[4096];
+  for (;;) {
+    ssize_t len = ::read(m_notifyFd, buf, sizeof(buf));
+    if (len <= 0) {
+      return;
+    }
+    for (ssize_t pos = 0; pos < len;) {
+      auto event = reinterpret_cast<const struct inotify_event*>(buf + pos);
+      std::string_view name;
+      if (event->len > 0) {
+        name = event->name;  // null padded
+      }
+      for (auto client : m_clients) {
+        if (client->m_watch == event->wd) {
+          client->m_pending.notify.emplace_back(name, event->mask);
+          Schedule(*client);
+        }
+      }
+      pos += sizeof(struct inotify_event) + event->len;
+    }
+  }
+}
+
+void UsbCameraReactor::Schedule(Client& client) {
+  client.m_hasPending = true;
+  if (!client.m_queued && !client.m_running) {
+    client.m_queued = true;
+    m_work.emplace_back(&client);
+    m_workCv.notify_one();
+  }
+}
+
+void UsbCameraReactor::UpdateFds(Client& client,
+                                 const wpi::SmallVectorImpl<int>& fds) {
+  // stop waiting on removed fds (these may already be closed, in which case
+  // the kernel has already removed them)
+  for (int fd : client.m_fds) {
+    if (std::find(fds.begin(), fds.end(), fd) != fds.end()) {
+      continue;
+    }
+    auto it = m_fdClients.find(fd);
+    if (it != m_fdClients.end() && it->second == &client) {
+      m_fdClients.erase(it);
+      ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+  }
+
+  // (re-)arm the rest; one-shot so the fd isn't reported again until the
+  // client has processed it
+  for (int fd : fds) {
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.fd = fd;
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, fd, &ev) != 0 &&
+        errno == ENOENT) {
+      ::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    m_fdClients[fd] = &client;
+  }
+  client.m_fds.assign(fds.begin(), fds.end());
+}
+
+void UsbCameraReactor::Wake() {
+  eventfd_write(m_wakeFd, 1);
+}
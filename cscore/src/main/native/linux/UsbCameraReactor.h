@@ -0,0 +1,129 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifndef CSCORE_USBCAMERAREACTOR_H_
+#define CSCORE_USBCAMERAREACTOR_H_
+
+#include <stdint.h>
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <wpi/DenseMap.h>
+#include <wpi/Logger.h>
+#include <wpi/SmallVector.h>
+#include <wpi/condition_variable.h>
+#include <wpi/mutex.h>
+
+namespace cs {
+
+// Shared capture reactor for USB cameras (and the USB camera listener).
+// Rather than each camera running its own select() thread, a single thread
+// waits on the file descriptors of all clients with one epoll instance (and
+// on device directory changes with one inotify instance), and dispatches
+// the resulting work to a small pool of worker threads.  Work for a single
+// client is never run on more than one worker at a time.
+class UsbCameraReactor {
+ public:
+  // Events passed to a client
+  struct Events {
+    // Set on the first call and when the client's timeout expires
+    bool timedOut = false;
+    // File descriptors that are readable
+    wpi::SmallVector<int, 2> readable;
+    // (name, inotify mask) of changes in the client's watched directory
+    std::vector<std::pair<std::string, uint32_t>> notify;
+  };
+
+  // What a client waits for next
+  struct Wait {
+    wpi::SmallVector<int, 2> fds;
+    int timeout = -1;  // in milliseconds; -1 for no timeout
+  };
+
+  class Client {
+   public:
+    virtual ~Client() = default;
+
+    // Processes events on a worker thread.  Returns what to wait for next;
+    // file descriptors are only waited on again after this returns.
+    virtual Wait ReactorProcess(const Events& events) = 0;
+
+   protected:
+    // True if directory changes are reported in Events::notify
+    bool ReactorIsWatching() const { return m_watch >= 0; }
+
+   private:
+    friend class UsbCameraReactor;
+
+    // protected by reactor mutex
+    Events m_pending;
+    bool m_hasPending = false;
+    bool m_queued = false;
+    bool m_running = false;
+    wpi::SmallVector<int, 2> m_fds;
+    bool m_hasDeadline = false;
+    std::chrono::steady_clock::time_point m_deadline;
+    int m_watch = -1;
+  };
+
+  static UsbCameraReactor& GetInstance();
+
+  explicit UsbCameraReactor(wpi::Logger& logger) : m_logger(logger) {}
+  UsbCameraReactor(const UsbCameraReactor&) = delete;
+  UsbCameraReactor& operator=(const UsbCameraReactor&) = delete;
+
+  // Adds a client, watching the given directory for changes if not empty.
+  // The client is immediately processed (with timedOut set).  Returns false
+  // if the reactor could not be started.
+  bool Add(Client& client, std::string_view watchDir);
+
+  // Removes a client, waiting for any in-progress processing to complete.
+  // Must not be called from the client's ReactorProcess().
+  void Remove(Client& client);
+
+ private:
+  bool Init();
+  void ReactorMain();
+  void WorkerMain();
+  void ReadNotify();
+  void Schedule(Client& client);
+  void UpdateFds(Client& client, const wpi::SmallVectorImpl<int>& fds);
+  void Wake();
+
+  wpi::Logger& m_logger;
+
+  // serializes Add() and Remove(), as Remove() stops the threads
+  wpi::mutex m_clientsMutex;
+
+  wpi::mutex m_mutex;
+  wpi::condition_variable m_workCv;
+  wpi::condition_variable m_idleCv;
+  // notified when the threads are stopped (for the reactor's error backoff)
+  wpi::condition_variable m_stopCv;
+  bool m_active = false;
+  std::vector<Client*> m_clients;
+  std::deque<Client*> m_work;
+  wpi::DenseMap<int, Client*> m_fdClients;
+  wpi::DenseMap<int, int> m_watchRefs;
+  // time the reactor thread is waiting until
+  std::chrono::steady_clock::time_point m_waitDeadline;
+
+  // created once and never closed
+  int m_epollFd = -1;
+  int m_notifyFd = -1;
+  int m_wakeFd = -1;
+
+  std::thread m_thread;
+  std::vector<std::thread> m_workers;
+};
+
+}  // namespace cs
+
+#endif  // CSCORE_USBCAMERAREACTOR_H_
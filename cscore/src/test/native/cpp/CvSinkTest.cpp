@@ -0,0 +1,80 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include <opencv2/core/core.hpp>
+
+#include "Instance.h"
+#include "SourceImpl.h"
+#include "cscore_cv.h"
+#include "gtest/gtest.h"
+
+namespace cs {
+
+class CvSinkTest : public ::testing::Test {
+ protected:
+  static constexpr int kWidth = 160;
+  static constexpr int kHeight = 120;
+
+  CvSinkTest() {
+    m_cvSink.SetSource(m_cvSource);
+    m_source =
+        Instance::GetInstance().GetSource(m_cvSource.GetHandle())->source;
+
+    // feed frames, each a different solid color, until stopped
+    m_thread = std::thread([this] {
+      for (int i = 1; m_active; ++i) {
+        cv::Mat image{kHeight, kWidth, CV_8UC3, cv::Scalar::all(i % 256)};
+        m_cvSource.PutFrame(image);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    });
+  }
+
+  ~CvSinkTest() override { StopFeeding(); }
+
+  void StopFeeding() {
+    m_active = false;
+    if (m_thread.joinable()) {
+      m_thread.join();
+    }
+  }
+
+  CvSource m_cvSource{"source", VideoMode::kBGR, kWidth, kHeight, 30};
+  CvSink m_cvSink{"sink"};
+  std::shared_ptr<SourceImpl> m_source;
+  std::atomic_bool m_active{true};
+  std::thread m_thread;
+};
+
+TEST_F(CvSinkTest, GrabFrameNoCopy) {
+  std::shared_ptr<const cv::Mat> image;
+  ASSERT_NE(m_cvSink.GrabFrameNoCopy(image, 1.0), 0u) << m_cvSink.GetError();
+  ASSERT_TRUE(image);
+  ASSERT_EQ(image->cols, kWidth);
+  ASSERT_EQ(image->rows, kHeight);
+  const uchar* data = image->data;
+  uchar value = data[0];
+
+  // the lease keeps the image alive (and unmodified) while the source moves
+  // on to newer frames
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  StopFeeding();
+  for (size_t i = 0; i < image->total() * image->elemSize(); ++i) {
+    ASSERT_EQ(data[i], value) << i;
+  }
+
+  // once released, its buffer goes back to the source's pool
+  image.reset();
+  auto pooled = m_source->AllocPooledImage(VideoMode::kBGR, kWidth, kHeight,
+                                           kWidth * kHeight * 3);
+  ASSERT_TRUE(pooled);
+  EXPECT_EQ(reinterpret_cast<const uchar*>(pooled->data()), data);
+}
+
+}  // namespace cs
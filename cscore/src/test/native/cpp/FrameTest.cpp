@@ -0,0 +1,310 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "Frame.h"  // NOLINT(build/include_order)
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "Instance.h"
+#include "SourceImpl.h"
+#include "cscore_raw.h"
+#include "gtest/gtest.h"
+
+namespace cs {
+
+class FrameTest : public ::testing::Test {
+ protected:
+  static constexpr int kWidth = 640;
+  static constexpr int kHeight = 480;
+
+  FrameTest() {
+    CS_Status status = 0;
+    m_handle = CreateRawSource(
+        "frametest", VideoMode{VideoMode::kYUYV, kWidth, kHeight, 30},
+        &status);
+    m_source = Instance::GetInstance().GetSource(m_handle)->source;
+  }
+
+  ~FrameTest() override {
+    CS_Status status = 0;
+    m_source.reset();
+    ReleaseSource(m_handle, &status);
+  }
+
+  // Makes a frame with a packed 4:2:2 gradient (YUYV or UYVY)
+  Frame MakeYUV422Frame(VideoMode::PixelFormat pixelFormat,
+                        Frame::Time time = 0) {
+    auto image = m_source->AllocImage(pixelFormat, kWidth, kHeight,
+                                      kWidth * kHeight * 2);
+    int yIndex = pixelFormat == VideoMode::kYUYV ? 0 : 1;
+    auto data = reinterpret_cast<uint8_t*>(image->data());
+    for (int i = 0; i < kWidth * kHeight / 2; ++i) {
+      data[i * 4 + yIndex] = i % 256;
+      data[i * 4 + 2 + yIndex] = (i * 3) % 256;
+      data[i * 4 + 1 - yIndex] = (i / kWidth) % 256;
+      data[i * 4 + 3 - yIndex] = (i * 7) % 256;
+    }
+    return Frame{*m_source, std::move(image), time};
+  }
+
+  // Gets the frame as a JPEG image from several threads at once, as the
+  // connections of an MJPEG server streaming it would
+  std::vector<std::shared_ptr<SourceImpl::EncodedJpeg>> GetEncodedJpegs(
+      const Frame& frame, int width, int height) {
+    constexpr int kThreads = 8;
+    std::vector<std::shared_ptr<SourceImpl::EncodedJpeg>> jpegs(kThreads);
+    std::atomic_bool start{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+      threads.emplace_back([&, i] {
+        while (!start) {
+          std::this_thread::yield();
+        }
+        jpegs[i] = m_source->GetEncodedJpeg(frame, width, height, -1, 80);
+      });
+    }
+    start = true;
+    for (auto&& thread : threads) {
+      thread.join();
+    }
+    return jpegs;
+  }
+
+  CS_Source m_handle;
+  std::shared_ptr<SourceImpl> m_source;
+};
+
+TEST_F(FrameTest, YUYVToGray) {
+  auto frame = MakeYUV422Frame(VideoMode::kYUYV);
+  Image* yuyv = frame.GetExistingImage();
+  Image* gray = frame.Convert(yuyv, VideoMode::kGray);
+  ASSERT_NE(gray, nullptr);
+  ASSERT_EQ(gray->pixelFormat, VideoMode::kGray);
+  // single pass; no BGR intermediate
+  EXPECT_EQ(frame.GetExistingImage(kWidth, kHeight, VideoMode::kBGR), nullptr);
+  for (int i = 0; i < kWidth * kHeight; ++i) {
+    ASSERT_EQ(gray->data()[i], yuyv->data()[i * 2]);
+  }
+}
+
+TEST_F(FrameTest, YUYVToRGB565) {
+  auto frame = MakeYUV422Frame(VideoMode::kYUYV);
+  Image* yuyv = frame.GetExistingImage();
+  Image* rgb565 = frame.Convert(yuyv, VideoMode::kRGB565);
+  ASSERT_NE(rgb565, nullptr);
+  EXPECT_EQ(frame.GetExistingImage(kWidth, kHeight, VideoMode::kBGR), nullptr);
+
+  // compare to converting through BGR
+  cv::Mat bgr, expected;
+  cv::cvtColor(yuyv->AsMat(), bgr, cv::COLOR_YUV2BGR_YUYV);
+  cv::cvtColor(bgr, expected, cv::COLOR_RGB2BGR565);
+  auto actual = reinterpret_cast<const uint16_t*>(rgb565->data());
+  auto expectedData = expected.ptr<uint16_t>();
+  for (int i = 0; i < kWidth * kHeight; ++i) {
+    uint16_t a = actual[i];
+    uint16_t e = expectedData[i];
+    ASSERT_LE(std::abs((a & 0x1f) - (e & 0x1f)), 1) << i;
+    ASSERT_LE(std::abs(((a >> 5) & 0x3f) - ((e >> 5) & 0x3f)), 1) << i;
+    ASSERT_LE(std::abs((a >> 11) - (e >> 11)), 1) << i;
+  }
+}
+
+TEST_F(FrameTest, UYVYMatchesYUYV) {
+  auto yuyvFrame = MakeYUV422Frame(VideoMode::kYUYV);
+  auto uyvyFrame = MakeYUV422Frame(VideoMode::kUYVY);
+  for (auto pixelFormat :
+       {VideoMode::kBGR, VideoMode::kGray, VideoMode::kRGB565}) {
+    Image* a = yuyvFrame.Convert(yuyvFrame.GetExistingImage(), pixelFormat);
+    Image* b = uyvyFrame.Convert(uyvyFrame.GetExistingImage(), pixelFormat);
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(a->str(), b->str()) << pixelFormat;
+  }
+}
+
+TEST_F(FrameTest, ReusesExistingBGR) {
+  auto frame = MakeYUV422Frame(VideoMode::kYUYV);
+  Image* bgr = frame.Convert(frame.GetExistingImage(), VideoMode::kBGR);
+  ASSERT_NE(bgr, nullptr);
+  Image* jpeg = frame.ConvertToMJPEG(frame.GetExistingImage(), 50, 50);
+  ASSERT_NE(jpeg, nullptr);
+  EXPECT_EQ(jpeg->pixelFormat, VideoMode::kMJPEG);
+  // YUYV, BGR, MJPEG
+  EXPECT_EQ(frame.GetExistingImage(3), nullptr);
+  EXPECT_EQ(frame.ConvertToMJPEG(bgr, 52), jpeg);
+  // Gray is converted from the existing BGR image rather than decoded
+  Image* gray = frame.Convert(jpeg, VideoMode::kGray);
+  ASSERT_NE(gray, nullptr);
+  EXPECT_EQ(frame.GetExistingImage(4), nullptr);
+}
+
+TEST_F(FrameTest, ReducedJpegDecode) {
+  std::string jpeg;
+  {
+    auto frame = MakeYUV422Frame(VideoMode::kYUYV);
+    jpeg = frame.ConvertToMJPEG(frame.GetExistingImage(), 80)->str();
+  }
+  auto image =
+      m_source->AllocImage(VideoMode::kMJPEG, kWidth, kHeight, jpeg.size());
+  std::copy(jpeg.begin(), jpeg.end(), image->data());
+  Frame frame{*m_source, std::move(image), 0};
+
+  // 1/4 scale decode, no resize
+  Image* small = frame.GetImage(160, 120, VideoMode::kBGR);
+  ASSERT_NE(small, nullptr);
+  EXPECT_TRUE(small->Is(160, 120, VideoMode::kBGR));
+  EXPECT_EQ(frame.GetExistingImage(2), nullptr);
+
+  // 1/2 scale grayscale decode, then resize
+  Image* gray = frame.GetImage(200, 150, VideoMode::kGray);
+  ASSERT_NE(gray, nullptr);
+  EXPECT_TRUE(gray->Is(200, 150, VideoMode::kGray));
+  EXPECT_NE(frame.GetExistingImage(320, 240, VideoMode::kGray), nullptr);
+
+  // full size is decoded from the JPEG rather than upscaled
+  Image* full = frame.GetImage(kWidth, kHeight, VideoMode::kBGR);
+  ASSERT_NE(full, nullptr);
+  EXPECT_TRUE(full->Is(kWidth, kHeight, VideoMode::kBGR));
+  EXPECT_EQ(frame.GetExistingImage(5), nullptr);
+}
+
+TEST_F(FrameTest, ImagePoolSizeClasses) {
+  constexpr size_t kLargeSize = 1920 * 1080 * 3;
+  const char* largeData;
+  {
+    auto image = m_source->AllocImage(VideoMode::kBGR, 1920, 1080, kLargeSize);
+    EXPECT_GE(image->capacity(), kLargeSize);
+    EXPECT_LE(image->capacity(), kLargeSize * 5 / 4);
+    largeData = image->data();
+    Frame frame{*m_source, std::move(image), 0};
+  }
+
+  // a small image doesn't get the large buffer
+  auto small = m_source->AllocImage(VideoMode::kBGR, 160, 120, 160 * 120 * 3);
+  EXPECT_NE(small->data(), largeData);
+  EXPECT_LE(small->capacity(), 160 * 120 * 3 * 5 / 4);
+
+  // but one of the same size does
+  auto large = m_source->AllocImage(VideoMode::kBGR, 1920, 1080, kLargeSize);
+  EXPECT_EQ(large->data(), largeData);
+}
+
+TEST_F(FrameTest, EncodedJpegNotPooled) {
+  size_t size;
+  {
+    auto frame = MakeYUV422Frame(VideoMode::kYUYV);
+    Image* jpeg = frame.ConvertToMJPEG(frame.GetExistingImage(), 80);
+    ASSERT_NE(jpeg, nullptr);
+    EXPECT_TRUE(jpeg->IsEncoded());
+    size = jpeg->size();
+  }
+  // pooled images are always pool storage (e.g. page aligned on Linux)
+  auto image = m_source->AllocImage(VideoMode::kMJPEG, kWidth, kHeight, size);
+  EXPECT_FALSE(image->IsEncoded());
+}
+
+TEST_F(FrameTest, EncodedJpegShared) {
+  for (Frame::Time time = 1; time <= 5; ++time) {
+    auto frame = MakeYUV422Frame(VideoMode::kYUYV, time);
+    auto jpegs = GetEncodedJpegs(frame, kWidth, kHeight);
+    ASSERT_NE(jpegs[0], nullptr);
+    ASSERT_NE(jpegs[0]->image, nullptr);
+    EXPECT_EQ(jpegs[0]->image->pixelFormat, VideoMode::kMJPEG);
+    for (auto&& jpeg : jpegs) {
+      EXPECT_EQ(jpeg, jpegs[0]);
+    }
+    // encoded once: YUYV, BGR, MJPEG
+    EXPECT_NE(frame.GetExistingImage(2), nullptr);
+    EXPECT_EQ(frame.GetExistingImage(3), nullptr);
+  }
+}
+
+TEST_F(FrameTest, EncodedJpegFailureWakesWaiters) {
+  // No conversion from an unknown pixel format; the resize before the failed
+  // conversion keeps the encode in flight long enough for the other threads
+  // to wait on it
+  constexpr int kLargeWidth = 3840;
+  constexpr int kLargeHeight = 2160;
+  for (Frame::Time time = 1; time <= 5; ++time) {
+    auto image = m_source->AllocImage(VideoMode::kUnknown, kLargeWidth,
+                                      kLargeHeight, kLargeWidth * kLargeHeight);
+    Frame frame{*m_source, std::move(image), time};
+    for (auto&& jpeg : GetEncodedJpegs(frame, kLargeWidth / 2,
+                                       kLargeHeight / 2)) {
+      EXPECT_EQ(jpeg, nullptr);
+    }
+  }
+}
+
+// Conversion timings, recorded as test properties (e.g. in the --gtest_output
+// XML/JSON).  Disabled by default; run with --gtest_also_run_disabled_tests.
+TEST_F(FrameTest, DISABLED_Benchmark) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  using std::chrono::steady_clock;
+  constexpr int kIterations = 100;
+
+  struct Conversion {
+    const char* name;
+    VideoMode::PixelFormat from;
+    VideoMode::PixelFormat to;
+  };
+  static const Conversion conversions[] = {
+      {"YUYV->Gray", VideoMode::kYUYV, VideoMode::kGray},
+      {"YUYV->RGB565", VideoMode::kYUYV, VideoMode::kRGB565},
+      {"YUYV->BGR", VideoMode::kYUYV, VideoMode::kBGR},
+      {"YUYV->MJPEG", VideoMode::kYUYV, VideoMode::kMJPEG},
+      {"UYVY->Gray", VideoMode::kUYVY, VideoMode::kGray},
+      {"UYVY->RGB565", VideoMode::kUYVY, VideoMode::kRGB565},
+      {"MJPEG->Gray", VideoMode::kMJPEG, VideoMode::kGray},
+      {"MJPEG->BGR", VideoMode::kMJPEG, VideoMode::kBGR},
+      {"MJPEG->RGB565", VideoMode::kMJPEG, VideoMode::kRGB565},
+  };
+
+  // JPEG input for the MJPEG conversions
+  std::string jpeg;
+  {
+    auto frame = MakeYUV422Frame(VideoMode::kYUYV);
+    jpeg = frame.ConvertToMJPEG(frame.GetExistingImage(), 80)->str();
+  }
+
+  for (auto&& conversion : conversions) {
+    steady_clock::duration total{0};
+    for (int i = 0; i < kIterations; ++i) {
+      Frame frame;
+      if (conversion.from == VideoMode::kMJPEG) {
+        auto image = m_source->AllocImage(VideoMode::kMJPEG, kWidth, kHeight,
+                                          jpeg.size());
+        std::copy(jpeg.begin(), jpeg.end(), image->data());
+        frame = Frame{*m_source, std::move(image), 0};
+      } else {
+        frame = MakeYUV422Frame(conversion.from);
+      }
+      auto start = steady_clock::now();
+      Image* source = frame.GetExistingImage();
+      Image* image = conversion.to == VideoMode::kMJPEG
+                         ? frame.ConvertToMJPEG(source, 80)
+                         : frame.Convert(source, conversion.to);
+      total += steady_clock::now() - start;
+      ASSERT_NE(image, nullptr) << conversion.name;
+    }
+    RecordProperty(fmt::format("{} us/frame", conversion.name),
+                   duration_cast<microseconds>(total).count() / kIterations);
+  }
+}
+
+}  // namespace cs
@@ -0,0 +1,132 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "MjpegServerImpl.h"  // NOLINT(build/include_order)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <wpinet/EventLoopRunner.h>
+#include <wpinet/NetworkStream.h>
+#include <wpinet/TCPConnector.h>
+#include <wpinet/raw_socket_istream.h>
+
+#include "Instance.h"
+#include "SourceImpl.h"
+#include "cscore_raw.h"
+#include "gtest/gtest.h"
+
+namespace cs {
+
+// Event loop mode, with the server running on its own loop (rather than the
+// instance's, which other tests shut down)
+class MjpegServerLoopTest : public ::testing::Test {
+ protected:
+  static constexpr int kWidth = 160;
+  static constexpr int kHeight = 120;
+
+  MjpegServerLoopTest() {
+    CS_Status status = 0;
+    m_source = CreateRawSource(
+        "source", VideoMode{VideoMode::kBGR, kWidth, kHeight, 30}, &status);
+    auto& inst = Instance::GetInstance();
+    m_server = std::make_shared<MjpegServerImpl>(
+        "server", inst.logger, inst.notifier, inst.telemetry, "", 0, m_loop);
+    m_server->SetSource(inst.GetSource(m_source)->source);
+    m_port = m_server->GetPort();
+
+    // feed frames until the test is done
+    m_thread = std::thread([this] {
+      RawFrame frame;
+      CS_AllocateRawFrameData(&frame, kWidth * kHeight * 3);
+      frame.pixelFormat = VideoMode::kBGR;
+      frame.width = kWidth;
+      frame.height = kHeight;
+      frame.totalData = kWidth * kHeight * 3;
+      for (int i = 0; m_active; ++i) {
+        std::fill_n(frame.data, frame.totalData, static_cast<char>(i));
+        CS_Status status = 0;
+        PutSourceFrame(m_source, frame, &status);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    });
+  }
+
+  ~MjpegServerLoopTest() override {
+    m_active = false;
+    m_thread.join();
+    m_server.reset();
+    CS_Status status = 0;
+    ReleaseSource(m_source, &status);
+  }
+
+  std::unique_ptr<wpi::NetworkStream> Connect(std::string_view path) {
+    auto stream = wpi::TCPConnector::connect(
+        "127.0.0.1", m_port, Instance::GetInstance().logger, 1);
+    if (stream) {
+      std::string request = fmt::format("GET {} HTTP/1.0\r\n\r\n", path);
+      wpi::NetworkStream::Error err;
+      stream->send(request.data(), request.size(), &err);
+    }
+    return stream;
+  }
+
+  // Reads until the string has been received; returns false on error
+  static bool ReadUntil(wpi::NetworkStream& stream, std::string_view str) {
+    wpi::raw_socket_istream is{stream, 5};
+    std::string window;
+    while (!window.ends_with(str)) {
+      char ch;
+      is.read(ch);
+      if (is.has_error()) {
+        return false;
+      }
+      window.push_back(ch);
+      if (window.size() > str.size()) {
+        window.erase(0, 1);
+      }
+    }
+    return true;
+  }
+
+  wpi::EventLoopRunner m_loop;
+  CS_Source m_source;
+  std::shared_ptr<MjpegServerImpl> m_server;
+  int m_port;
+  std::atomic_bool m_active{true};
+  std::thread m_thread;
+};
+
+TEST_F(MjpegServerLoopTest, Streams) {
+  // the server is limited to 10 simultaneous streams
+  std::vector<std::unique_ptr<wpi::NetworkStream>> clients;
+  for (int i = 0; i < 10; ++i) {
+    auto client = Connect("/stream.mjpg");
+    ASSERT_TRUE(client);
+    ASSERT_TRUE(ReadUntil(*client, "HTTP/1.0 200 OK\r\n")) << i;
+    ASSERT_TRUE(ReadUntil(*client, "\r\n\r\n")) << i;
+    clients.emplace_back(std::move(client));
+  }
+
+  auto rejected = Connect("/stream.mjpg");
+  ASSERT_TRUE(rejected);
+  EXPECT_TRUE(ReadUntil(*rejected, "HTTP/1.0 503"));
+
+  // every client receives frames, not just the first one
+  for (auto&& client : {clients.front().get(), clients.back().get()}) {
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(ReadUntil(*client, "Content-Type: image/jpeg\r\n"));
+      ASSERT_TRUE(ReadUntil(*client, "\xff\xd8"));  // JPEG SOI marker
+    }
+  }
+}
+
+}  // namespace cs
@@ -0,0 +1,48 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "Telemetry.h"  // NOLINT(build/include_order)
+
+#include <stdint.h>
+
+#include "gtest/gtest.h"
+
+namespace cs {
+
+TEST(LatencyHistogramTest, Buckets) {
+  int prev = 0;
+  for (uint64_t value = 0; value < (1u << 20); ++value) {
+    int bucket = LatencyHistogram::GetBucket(value);
+    // buckets are contiguous and contain the value
+    ASSERT_TRUE(bucket == prev || bucket == prev + 1) << value;
+    ASSERT_LT(value, LatencyHistogram::GetBucketLimit(bucket)) << value;
+    if (bucket > 0) {
+      ASSERT_GE(value, LatencyHistogram::GetBucketLimit(bucket - 1)) << value;
+    }
+    // and are at most 25% wide
+    if (value >= 8) {
+      ASSERT_LE(LatencyHistogram::GetBucketLimit(bucket), value * 5 / 4 + 1)
+          << value;
+    }
+    prev = bucket;
+  }
+  EXPECT_EQ(LatencyHistogram::GetBucket(UINT64_MAX),
+            LatencyHistogram::GetBucket(UINT32_MAX));
+}
+
+TEST(LatencyHistogramTest, Percentiles) {
+  LatencyHistogram hist;
+  EXPECT_EQ(hist.GetPercentile(50), 0);
+  for (int i = 1; i <= 1000; ++i) {
+    hist.Record(i * 10);
+  }
+  EXPECT_EQ(hist.GetCount(), 1000u);
+  EXPECT_DOUBLE_EQ(hist.GetMean(), 5005.0);
+  EXPECT_GE(hist.GetPercentile(50), 5000);
+  EXPECT_LE(hist.GetPercentile(50), 5000 * 5 / 4);
+  EXPECT_GE(hist.GetPercentile(90), 9000);
+  EXPECT_EQ(hist.GetPercentile(100), 10000);
+}
+
+}  // namespace cs
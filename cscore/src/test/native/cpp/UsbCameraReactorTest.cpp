@@ -0,0 +1,277 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#ifdef __linux__
+
+#include "../../../main/native/linux/UsbCameraReactor.h"  // NOLINT
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <wpi/Logger.h>
+
+#include "gtest/gtest.h"
+
+using namespace std::chrono_literals;
+
+namespace cs {
+
+namespace {
+
+// Client that processes events with a callback, and counts the calls
+class TestClient : public UsbCameraReactor::Client {
+ public:
+  using Process = std::function<UsbCameraReactor::Wait(
+      const UsbCameraReactor::Events& events)>;
+
+  explicit TestClient(Process process) : m_process{std::move(process)} {}
+
+  UsbCameraReactor::Wait ReactorProcess(
+      const UsbCameraReactor::Events& events) override {
+    int running = ++m_running;
+    int maxRunning = m_maxRunning;
+    while (running > maxRunning &&
+           !m_maxRunning.compare_exchange_weak(maxRunning, running)) {
+    }
+    auto wait = m_process(events);
+    --m_running;
+    {
+      std::scoped_lock lock{m_mutex};
+      ++m_calls;
+    }
+    m_cv.notify_all();
+    return wait;
+  }
+
+  // Waits until there have been at least the given number of calls
+  bool WaitForCalls(int count) {
+    std::unique_lock lock{m_mutex};
+    return m_cv.wait_for(lock, 5s, [&] { return m_calls >= count; });
+  }
+
+  int GetCalls() {
+    std::scoped_lock lock{m_mutex};
+    return m_calls;
+  }
+
+  int GetMaxRunning() const { return m_maxRunning; }
+
+ private:
+  Process m_process;
+  std::atomic_int m_running{0};
+  std::atomic_int m_maxRunning{0};
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  int m_calls = 0;
+};
+
+int CountThreads() {
+  int count = 0;
+  for ([[maybe_unused]] auto&& entry :
+       std::filesystem::directory_iterator{"/proc/self/task"}) {
+    ++count;
+  }
+  return count;
+}
+
+// Joined threads may take a moment to be reaped
+bool WaitForThreadCount(int count) {
+  for (int i = 0; i < 100; ++i) {
+    if (CountThreads() == count) {
+      return true;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+  return false;
+}
+
+}  // namespace
+
+class UsbCameraReactorTest : public ::testing::Test {
+ protected:
+  ~UsbCameraReactorTest() override {
+    for (int fd : m_fds) {
+      ::close(fd);
+    }
+  }
+
+  // Creates an event fd; this is readable once signaled, until consumed
+  int CreateEventFd() {
+    int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    m_fds.emplace_back(fd);
+    return fd;
+  }
+
+  static void Signal(int fd) { eventfd_write(fd, 1); }
+
+  static void Consume(int fd) {
+    eventfd_t val;
+    eventfd_read(fd, &val);
+  }
+
+  wpi::Logger m_logger;
+  UsbCameraReactor m_reactor{m_logger};
+  std::vector<int> m_fds;
+};
+
+TEST_F(UsbCameraReactorTest, OneShotRearm) {
+  int fd = CreateEventFd();
+  int step = 0;
+  TestClient client{[&](const UsbCameraReactor::Events& events) {
+    UsbCameraReactor::Wait wait;
+    wait.fds.emplace_back(fd);
+    switch (step++) {
+      case 0:
+        // added
+        EXPECT_TRUE(events.timedOut);
+        break;
+      case 1:
+        // not consumed, and still readable while this runs; as the fd is
+        // one-shot, it's only reported again after this re-arms it
+        EXPECT_EQ(events.readable.size(), 1u);
+        std::this_thread::sleep_for(50ms);
+        break;
+      case 2:
+        EXPECT_FALSE(events.timedOut);
+        EXPECT_EQ(events.readable.size(), 1u);
+        EXPECT_TRUE(events.readable.size() == 1 && events.readable[0] == fd);
+        Consume(fd);
+        break;
+      default:
+        Consume(fd);
+        break;
+    }
+    return wait;
+  }};
+  ASSERT_TRUE(m_reactor.Add(client, ""));
+  ASSERT_TRUE(client.WaitForCalls(1));
+
+  Signal(fd);
+  ASSERT_TRUE(client.WaitForCalls(3));
+
+  // consumed, so not reported again until it's signaled again
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(client.GetCalls(), 3);
+  Signal(fd);
+  ASSERT_TRUE(client.WaitForCalls(4));
+
+  m_reactor.Remove(client);
+}
+
+TEST_F(UsbCameraReactorTest, ClientSerialized) {
+  int fd1 = CreateEventFd();
+  int fd2 = CreateEventFd();
+  TestClient client{[&](const UsbCameraReactor::Events& events) {
+    for (int fd : events.readable) {
+      Consume(fd);
+    }
+    // long enough for more events to arrive while this runs
+    std::this_thread::sleep_for(2ms);
+    UsbCameraReactor::Wait wait;
+    wait.fds.emplace_back(fd1);
+    wait.fds.emplace_back(fd2);
+    wait.timeout = 1;
+    return wait;
+  }};
+  ASSERT_TRUE(m_reactor.Add(client, ""));
+
+  for (int i = 0; i < 100; ++i) {
+    Signal(fd1);
+    Signal(fd2);
+    std::this_thread::sleep_for(1ms);
+  }
+  ASSERT_TRUE(client.WaitForCalls(20));
+  m_reactor.Remove(client);
+  EXPECT_EQ(client.GetMaxRunning(), 1);
+}
+
+TEST_F(UsbCameraReactorTest, RemoveDuringDispatch) {
+  int fd = CreateEventFd();
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool entered = false;
+  bool release = false;
+  TestClient client{[&](const UsbCameraReactor::Events& events) {
+    if (!events.readable.empty()) {
+      Consume(fd);
+      std::unique_lock lock{mutex};
+      entered = true;
+      cv.notify_all();
+      cv.wait(lock, [&] { return release; });
+    }
+    UsbCameraReactor::Wait wait;
+    wait.fds.emplace_back(fd);
+    return wait;
+  }};
+  ASSERT_TRUE(m_reactor.Add(client, ""));
+  ASSERT_TRUE(client.WaitForCalls(1));
+
+  Signal(fd);
+  {
+    std::unique_lock lock{mutex};
+    ASSERT_TRUE(cv.wait_for(lock, 5s, [&] { return entered; }));
+  }
+
+  // Remove() waits for the dispatch to finish
+  std::atomic_bool removed{false};
+  std::thread remover{[&] {
+    m_reactor.Remove(client);
+    removed = true;
+  }};
+  std::this_thread::sleep_for(50ms);
+  EXPECT_FALSE(removed);
+  {
+    std::scoped_lock lock{mutex};
+    release = true;
+  }
+  cv.notify_all();
+  remover.join();
+  EXPECT_TRUE(removed);
+
+  // and nothing is dispatched afterwards
+  Signal(fd);
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(client.GetCalls(), 2);
+}
+
+TEST_F(UsbCameraReactorTest, ThreadsStopWithLastClient) {
+  auto process = [](const UsbCameraReactor::Events&) {
+    return UsbCameraReactor::Wait{};
+  };
+  TestClient client1{process};
+  TestClient client2{process};
+  int threads = CountThreads();
+
+  ASSERT_TRUE(m_reactor.Add(client1, ""));
+  ASSERT_TRUE(m_reactor.Add(client2, ""));
+  ASSERT_TRUE(client1.WaitForCalls(1));
+  ASSERT_TRUE(client2.WaitForCalls(1));
+  int running = CountThreads();
+  EXPECT_GT(running, threads);
+
+  m_reactor.Remove(client1);
+  EXPECT_EQ(CountThreads(), running);
+  m_reactor.Remove(client2);
+  EXPECT_TRUE(WaitForThreadCount(threads));
+
+  // and are restarted for the next client
+  ASSERT_TRUE(m_reactor.Add(client1, ""));
+  ASSERT_TRUE(client1.WaitForCalls(2));
+  m_reactor.Remove(client1);
+  EXPECT_TRUE(WaitForThreadCount(threads));
+}
+
+}  // namespace cs
+
+#endif  // __linux__
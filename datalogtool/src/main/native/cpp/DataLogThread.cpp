@@ -5,6 +5,50 @@
 #include "DataLogThread.h"
 
 #include <fmt/format.h>
+#include <wpi/MappedFileRegion.h>
+#include <wpi/MemoryBuffer.h>
+#include <wpi/fs.h>
+
+namespace {
+class MappedLogBuffer : public wpi::MemoryBuffer {
+ public:
+  MappedLogBuffer(std::string_view filename, wpi::MappedFileRegion mapping)
+      : m_filename{filename}, m_mapping{std::move(mapping)} {
+    Init(m_mapping.const_data(), m_mapping.const_data() + m_mapping.size());
+  }
+
+  std::string_view GetBufferIdentifier() const override { return m_filename; }
+  BufferKind GetBufferKind() const override { return MemoryBuffer_MMap; }
+
+ private:
+  std::string m_filename;
+  wpi::MappedFileRegion m_mapping;
+};
+}  // namespace
+
+std::unique_ptr<wpi::MemoryBuffer> OpenMappedLog(std::string_view filename,
+                                                 std::error_code& ec) {
+  auto size = fs::file_size(fs::path{filename}, ec);
+  if (ec) {
+    return nullptr;
+  }
+  if (size == 0) {
+    // can't map an empty file
+    return wpi::MemoryBuffer::GetMemBufferCopy({}, filename);
+  }
+  fs::file_t f = fs::OpenFileForRead(filename, ec, fs::OF_None);
+  if (ec) {
+    return nullptr;
+  }
+  wpi::MappedFileRegion mapping{f, size, 0, wpi::MappedFileRegion::kReadOnly,
+                                ec};
+  fs::CloseFile(f);
+  if (ec) {
+    return nullptr;
+  }
+  mapping.Advise(wpi::MappedFileRegion::kSequential);
+  return std::make_unique<MappedLogBuffer>(filename, std::move(mapping));
+}
 
 DataLogThread::~DataLogThread() {
   if (m_thread.joinable()) {
@@ -14,6 +58,21 @@ DataLogThread::~DataLogThread() {
 }
 
 void DataLogThread::ReadMain() {
+  // if the log has a summary, the entries are known without reading the
+  // whole log
+  std::vector<wpi::log::SummaryRecordData> summary;
+  if (m_reader.GetSummary(&summary)) {
+    std::scoped_lock lock{m_mutex};
+    for (auto&& data : summary) {
+      wpi::log::StartRecordData start{data.entry, data.name, data.type,
+                                      data.metadata};
+      if (m_entryNames.try_emplace(std::string{data.name}, start).second) {
+        m_summaryNames.emplace(data.name);
+        sigEntryAdded(start);
+      }
+    }
+  }
+
   for (auto record : m_reader) {
     if (!m_active) {
       break;
@@ -26,9 +85,11 @@ void DataLogThread::ReadMain() {
         if (m_entries.find(data.entry) != m_entries.end()) {
           fmt::print("...DUPLICATE entry ID, overriding\n");
         }
-        m_entries[data.entry] = data;
-        m_entryNames.emplace(data.name, data);
-        sigEntryAdded(data);
+        m_entries[data.entry] = data.name;
+        m_entryNames.try_emplace(std::string{data.name}, data);
+        if (!m_summaryNames.contains(data.name)) {
+          sigEntryAdded(data);
+        }
       } else {
         fmt::print("Start(INVALID)\n");
       }
@@ -53,8 +114,7 @@ void DataLogThread::ReadMain() {
         if (it == m_entries.end()) {
           fmt::print("...ID not found\n");
         } else {
-          it->second.metadata = data.metadata;
-          auto nameIt = m_entryNames.find(it->second.name);
+          auto nameIt = m_entryNames.find(it->second);
           if (nameIt != m_entryNames.end()) {
             nameIt->second.metadata = data.metadata;
           }
@@ -62,11 +122,24 @@ void DataLogThread::ReadMain() {
       } else {
         fmt::print("SetMetadata(INVALID)\n");
       }
-    } else if (record.IsControl()) {
+    } else if (record.IsControl() && !record.IsSync() &&
+               !record.IsSummary() && !record.IsSummaryEnd()) {
       fmt::print("Unrecognized control record\n");
     }
   }
 
+  // release the log; it's opened again when needed
+  m_reader = wpi::log::DataLogReader{nullptr};
+  {
+    std::scoped_lock lock{m_mutex};
+    m_summaryNames.clear();
+    m_entries.clear();
+  }
+
   sigDone();
   m_done = true;
 }
+
+wpi::log::DataLogReader DataLogThread::OpenReader(std::error_code& ec) const {
+  return wpi::log::DataLogReader{OpenMappedLog(m_filename, ec)};
+}
@@ -7,33 +7,65 @@
 #include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include <wpi/DataLogReader.h>
 #include <wpi/DenseMap.h>
 #include <wpi/Signal.h>
 #include <wpi/mutex.h>
 
+namespace wpi {
+class MemoryBuffer;
+}  // namespace wpi
+
+// Memory maps a log file for reading it once from start to end.  The pages
+// of the mapping aren't kept resident after they have been read.
+std::unique_ptr<wpi::MemoryBuffer> OpenMappedLog(std::string_view filename,
+                                                 std::error_code& ec);
+
+// Scans a log in the background to find its entries.  Only the entry
+// information is kept after the scan; the log is opened again with
+// OpenReader() to read its records (e.g. when exporting), so memory use
+// doesn't depend on the size of the log.
 class DataLogThread {
  public:
+  // Copy of the start record data (which refers to the log)
+  struct EntryInfo {
+    explicit EntryInfo(const wpi::log::StartRecordData& data)
+        : entry{data.entry},
+          name{data.name},
+          type{data.type},
+          metadata{data.metadata} {}
+    EntryInfo() = default;
+
+    int entry = 0;
+    std::string name;
+    std::string type;
+    std::string metadata;
+  };
+
   explicit DataLogThread(wpi::log::DataLogReader reader)
-      : m_reader{std::move(reader)}, m_thread{[=, this] { ReadMain(); }} {}
+      : m_filename{reader.GetBufferIdentifier()},
+        m_reader{std::move(reader)},
+        m_thread{[=, this] { ReadMain(); }} {}
   ~DataLogThread();
 
   bool IsDone() const { return m_done; }
-  std::string_view GetBufferIdentifier() const {
-    return m_reader.GetBufferIdentifier();
-  }
+  std::string_view GetBufferIdentifier() const { return m_filename; }
   unsigned int GetNumRecords() const { return m_numRecords; }
   unsigned int GetNumEntries() const {
     std::scoped_lock lock{m_mutex};
     return m_entryNames.size();
   }
 
-  // Passes wpi::log::StartRecordData to func
+  // Passes const EntryInfo& to func
   template <typename T>
   void ForEachEntryName(T&& func) {
     std::scoped_lock lock{m_mutex};
@@ -42,7 +74,7 @@ class DataLogThread {
     }
   }
 
-  wpi::log::StartRecordData GetEntry(std::string_view name) const {
+  EntryInfo GetEntry(std::string_view name) const {
     std::scoped_lock lock{m_mutex};
     auto it = m_entryNames.find(name);
     if (it == m_entryNames.end()) {
@@ -51,21 +83,28 @@ class DataLogThread {
     return it->second;
   }
 
-  const wpi::log::DataLogReader& GetReader() const { return m_reader; }
+  // Opens the log again for reading its records
+  wpi::log::DataLogReader OpenReader(std::error_code& ec) const;
 
-  // note: these are called on separate thread
+  // note: these are called on separate thread; the data passed to
+  // sigEntryAdded is only valid during the call
   wpi::sig::Signal_mt<const wpi::log::StartRecordData&> sigEntryAdded;
   wpi::sig::Signal_mt<> sigDone;
 
  private:
   void ReadMain();
 
+  std::string m_filename;
+  // only used during the scan
   wpi::log::DataLogReader m_reader;
   mutable wpi::mutex m_mutex;
   std::atomic_bool m_active{true};
   std::atomic_bool m_done{false};
   std::atomic<unsigned int> m_numRecords{0};
-  std::map<std::string, wpi::log::StartRecordData, std::less<>> m_entryNames;
-  wpi::DenseMap<int, wpi::log::StartRecordData> m_entries;
+  std::map<std::string, EntryInfo, std::less<>> m_entryNames;
+  // only used during the scan: entries already signaled from the log
+  // summary, and the names of active entries
+  std::set<std::string, std::less<>> m_summaryNames;
+  wpi::DenseMap<int, std::string> m_entries;
   std::thread m_thread;
 };
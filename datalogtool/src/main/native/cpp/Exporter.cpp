@@ -4,32 +4,44 @@
 
 #include "Exporter.h"
 
+#include <algorithm>
 #include <atomic>
 #include <ctime>
+#include <deque>
+#include <functional>
 #include <future>
 #include <map>
 #include <memory>
+#include <queue>
 #include <set>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <fmt/chrono.h>
+#include <fmt/compile.h>
 #include <fmt/format.h>
 #include <glass/Storage.h>
 #include <imgui.h>
 #include <imgui_internal.h>
 #include <imgui_stdlib.h>
 #include <portable-file-dialogs.h>
+#include <wpi/DataLogMerger.h>
 #include <wpi/DenseMap.h>
-#include <wpi/MemoryBuffer.h>
+#include <wpi/Endian.h>
+#include <wpi/MappedFileRegion.h>
 #include <wpi/SmallVector.h>
 #include <wpi/SpanExtras.h>
 #include <wpi/StringExtras.h>
+#include <wpi/json.h>
 #include <wpi/fmt/raw_ostream.h>
 #include <wpi/fs.h>
 #include <wpi/mutex.h>
 #include <wpi/raw_ostream.h>
+#include <wpi/scope>
 
 #include "App.h"
 #include "DataLogThread.h"
@@ -63,9 +75,6 @@ struct Entry {
   bool typeConflict = false;
   bool metadataConflict = false;
   bool selected = true;
-
-  // used only during export
-  int column = -1;
 };
 
 struct EntryTreeNode {
@@ -179,7 +188,7 @@ InputFile::~InputFile() {
 
 static std::unique_ptr<InputFile> LoadDataLog(std::string_view filename) {
   std::error_code ec;
-  auto buf = wpi::MemoryBuffer::GetFile(filename, ec);
+  auto buf = OpenMappedLog(filename, ec);
   std::string fn{filename};
   if (ec) {
     return std::make_unique<InputFile>(
@@ -284,9 +293,8 @@ static bool EmitEntry(const std::string& name, Entry& entry) {
     if (ImGui::IsItemHovered()) {
       ImGui::BeginTooltip();
       for (auto inputFile : entry.inputFiles) {
-        ImGui::Text(
-            "%s: %s", inputFile->stem.c_str(),
-            std::string{inputFile->datalog->GetEntry(entry.name).type}.c_str());
+        ImGui::Text("%s: %s", inputFile->stem.c_str(),
+                    inputFile->datalog->GetEntry(entry.name).type.c_str());
       }
       ImGui::EndTooltip();
     }
@@ -300,10 +308,8 @@ static bool EmitEntry(const std::string& name, Entry& entry) {
     if (ImGui::IsItemHovered()) {
       ImGui::BeginTooltip();
       for (auto inputFile : entry.inputFiles) {
-        ImGui::Text(
-            "%s: %s", inputFile->stem.c_str(),
-            std::string{inputFile->datalog->GetEntry(entry.name).metadata}
-                .c_str());
+        ImGui::Text("%s: %s", inputFile->stem.c_str(),
+                    inputFile->datalog->GetEntry(entry.name).metadata.c_str());
       }
       ImGui::EndTooltip();
     }
@@ -434,130 +440,464 @@ void DisplayEntries() {
 static wpi::mutex gExportMutex;
 static std::vector<std::string> gExportErrors;
 
-static void PrintEscapedCsvString(wpi::raw_ostream& os, std::string_view str) {
+namespace {
+// Entry information used during export.  This is copied from gEntries when
+// the export is started so files can be exported concurrently.
+struct ExportEntry {
+  explicit ExportEntry(const Entry& entry)
+      : name{entry.name}, type{entry.type}, metadata{entry.metadata} {}
+
+  std::string name;
+  std::string type;
+  std::string metadata;
+  int column = -1;
+};
+
+struct ExportOptions {
+  int style = 0;  // 0 = list, 1 = table, 2 = resampled table
+  // resampled style: one row per driver entry record if driver is set,
+  // otherwise one row per period (in seconds)
+  std::string driver;
+  double period = 0.02;
+  // resampled style: interpolate numeric values (zero-order hold otherwise)
+  bool linear = false;
+  // export columnar binary files instead of CSV
+  bool columnar = false;
+};
+
+struct ExportFile {
+  std::string stem;
+  const DataLogThread* datalog = nullptr;
+  // selected entries in this file
+  std::map<std::string, ExportEntry, std::less<>> entries;
+};
+}  // namespace
+
+// output is accumulated in memory and written in large chunks
+static constexpr size_t kWriteBufferSize = 1024 * 1024;
+
+static void PrintEscapedCsvString(fmt::memory_buffer& out,
+                                  std::string_view str) {
   auto s = str;
   while (!s.empty()) {
     std::string_view fragment;
     std::tie(fragment, s) = wpi::split(s, '"');
-    os << fragment;
+    out.append(fragment);
     if (!s.empty()) {
-      os << '"' << '"';
+      out.append(std::string_view{"\"\""});
     }
   }
   if (wpi::ends_with(str, '"')) {
-    os << '"' << '"';
+    out.append(std::string_view{"\"\""});
+  }
+}
+
+// these produce the same output as fmt::print("{}"), but avoid parsing the
+// format string for every value
+static void PrintValue(fmt::memory_buffer& out, int64_t val) {
+  fmt::format_int str{val};
+  out.append(str.data(), str.data() + str.size());
+}
+
+static void PrintValue(fmt::memory_buffer& out, int val) {
+  PrintValue(out, static_cast<int64_t>(val));
+}
+
+static void PrintValue(fmt::memory_buffer& out, double val) {
+  fmt::format_to(std::back_inserter(out), FMT_COMPILE("{}"), val);
+}
+
+static void PrintValue(fmt::memory_buffer& out, float val) {
+  fmt::format_to(std::back_inserter(out), FMT_COMPILE("{}"), val);
+}
+
+template <typename T>
+static void PrintArray(fmt::memory_buffer& out, const std::vector<T>& arr) {
+  bool first = true;
+  for (auto&& val : arr) {
+    if (!first) {
+      out.push_back(';');
+    }
+    first = false;
+    PrintValue(out, val);
   }
 }
 
-static void ValueToCsv(wpi::raw_ostream& os, const Entry& entry,
+static void ValueToCsv(fmt::memory_buffer& out, const ExportEntry& entry,
                        const wpi::log::DataLogRecord& record) {
   // handle systemTime specially
   if (entry.name == "systemTime" && entry.type == "int64") {
     int64_t val;
     if (record.GetInteger(&val)) {
       std::time_t timeval = val / 1000000;
-      fmt::print(os, "{:%Y-%m-%d %H:%M:%S}.{:06}", *std::localtime(&timeval),
-                 val % 1000000);
+      fmt::format_to(std::back_inserter(out), "{:%Y-%m-%d %H:%M:%S}.{:06}",
+                     fmt::localtime(timeval), val % 1000000);
       return;
     }
   } else if (entry.type == "double") {
     double val;
     if (record.GetDouble(&val)) {
-      fmt::print(os, "{}", val);
+      PrintValue(out, val);
       return;
     }
   } else if (entry.type == "int64") {
     int64_t val;
     if (record.GetInteger(&val)) {
-      fmt::print(os, "{}", val);
+      PrintValue(out, val);
       return;
     }
   } else if (entry.type == "string" || entry.type == "json") {
     std::string_view val;
     record.GetString(&val);
-    os << '"';
-    PrintEscapedCsvString(os, val);
-    os << '"';
+    out.push_back('"');
+    PrintEscapedCsvString(out, val);
+    out.push_back('"');
     return;
   } else if (entry.type == "boolean") {
     bool val;
     if (record.GetBoolean(&val)) {
-      fmt::print(os, "{}", val);
+      out.append(std::string_view{val ? "true" : "false"});
       return;
     }
   } else if (entry.type == "boolean[]") {
     std::vector<int> val;
     if (record.GetBooleanArray(&val)) {
-      fmt::print(os, "{}", fmt::join(val, ";"));
+      PrintArray(out, val);
       return;
     }
   } else if (entry.type == "double[]") {
     std::vector<double> val;
     if (record.GetDoubleArray(&val)) {
-      fmt::print(os, "{}", fmt::join(val, ";"));
+      PrintArray(out, val);
       return;
     }
   } else if (entry.type == "float[]") {
     std::vector<float> val;
     if (record.GetFloatArray(&val)) {
-      fmt::print(os, "{}", fmt::join(val, ";"));
+      PrintArray(out, val);
       return;
     }
   } else if (entry.type == "int64[]") {
     std::vector<int64_t> val;
     if (record.GetIntegerArray(&val)) {
-      fmt::print(os, "{}", fmt::join(val, ";"));
+      PrintArray(out, val);
       return;
     }
   } else if (entry.type == "string[]") {
     std::vector<std::string_view> val;
     if (record.GetStringArray(&val)) {
-      os << '"';
+      out.push_back('"');
       bool first = true;
       for (auto&& v : val) {
         if (!first) {
-          os << ';';
+          out.push_back(';');
         }
         first = false;
-        PrintEscapedCsvString(os, v);
+        PrintEscapedCsvString(out, v);
       }
-      os << '"';
+      out.push_back('"');
       return;
     }
   }
-  fmt::print(os, "<invalid>");
+  out.append(std::string_view{"<invalid>"});
+}
+
+static bool GetNumericValue(const ExportEntry& entry,
+                            const wpi::log::DataLogRecord& record,
+                            double* value) {
+  if (entry.type == "double") {
+    return record.GetDouble(value);
+  } else if (entry.type == "float") {
+    float val;
+    if (record.GetFloat(&val)) {
+      *value = val;
+      return true;
+    }
+  } else if (entry.type == "int64" && entry.name != "systemTime") {
+    int64_t val;
+    if (record.GetInteger(&val)) {
+      *value = val;
+      return true;
+    }
+  }
+  return false;
 }
 
-static void ExportCsvFile(InputFile& f, wpi::raw_ostream& os, int style) {
+namespace {
+// State of one column of the resampled export
+struct ResampleColumn {
+  explicit ResampleColumn(const ExportEntry* entry) : entry{entry} {}
+
+  const ExportEntry* entry;
+  // most recent value
+  bool hasValue = false;
+  int64_t time = 0;
+  std::string text;  // formatted for the CSV
+  bool numeric = false;
+  double value = 0;
+  // sequence numbers of pending rows with a hole for this column
+  std::vector<uint64_t> holes;
+};
+
+// A row waiting for the next value of one or more interpolated columns
+struct ResampleRow {
+  struct Hole {
+    size_t pos;  // in text
+    size_t column;
+    std::string value;
+  };
+
+  int64_t time;
+  std::string text;
+  std::vector<Hole> holes;
+  size_t unfilled = 0;
+};
+}  // namespace
+
+// Writes one row per output time, with the value of every column at that
+// time, in a single pass over the log.  Each column keeps only its most
+// recent value; a row is written once a record of a selected entry (or the
+// driver) later than the row time has been read, so records are expected to
+// be in timestamp order in the file (as DataLog writes them).  A record
+// earlier than its column's previous record is treated as having the
+// previous record's timestamp.
+//
+// With linear interpolation, a row can't be completed until each numeric
+// column's next value has been read; rows are held (in order) until then, so
+// memory use only grows with the longest gap between values of an
+// interpolated column.
+static void ExportResampled(const wpi::log::DataLogReader& reader,
+                            const ExportOptions& options,
+                            std::span<const ExportEntry* const> entries,
+                            fmt::memory_buffer& out, wpi::raw_ostream& os) {
+  std::vector<ResampleColumn> columns;
+  columns.reserve(entries.size());
+  std::map<std::string_view, size_t, std::less<>> columnNames;
+  for (auto entry : entries) {
+    columnNames.emplace(entry->name, columns.size());
+    columns.emplace_back(entry);
+  }
+  // active entry IDs
+  wpi::DenseMap<int, size_t> entryColumns;
+  std::vector<int> driverEntries;
+
+  bool driver = !options.driver.empty();
+  int64_t period = (std::max)(static_cast<int64_t>(options.period * 1000000),
+                              int64_t{1});
+  // output times not yet written: driver record times, or the next period
+  std::queue<int64_t> driverTimes;
+  bool hasDriverTime = false;
+  int64_t lastDriverTime = 0;
+  bool started = false;
+  int64_t nextTime = 0;
+  int64_t lastTime = 0;
+
+  std::deque<ResampleRow> rows;
+  uint64_t firstRow = 0;  // sequence number of rows.front()
+  fmt::memory_buffer value;
+
+  auto flushRows = [&] {
+    while (!rows.empty() && rows.front().unfilled == 0) {
+      auto& row = rows.front();
+      size_t pos = 0;
+      for (auto&& hole : row.holes) {
+        out.append(std::string_view{row.text}.substr(pos, hole.pos - pos));
+        out.append(hole.value);
+        pos = hole.pos;
+      }
+      out.append(std::string_view{row.text}.substr(pos));
+      rows.pop_front();
+      ++firstRow;
+      if (out.size() >= kWriteBufferSize) {
+        os.write(out.data(), out.size());
+        out.clear();
+      }
+    }
+  };
+
+  auto addRow = [&](int64_t time) {
+    auto& row = rows.emplace_back();
+    row.time = time;
+    value.clear();
+    PrintValue(value, time / 1000000.0);
+    row.text.assign(value.data(), value.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+      row.text.push_back(',');
+      auto& column = columns[i];
+      if (!column.hasValue) {
+        continue;  // no value yet
+      }
+      if (options.linear && column.numeric && column.time < time) {
+        // filled in when the column's next value is read
+        row.holes.emplace_back(
+            ResampleRow::Hole{row.text.size(), i, column.text});
+        ++row.unfilled;
+        column.holes.emplace_back(firstRow + rows.size() - 1);
+      } else {
+        row.text.append(column.text);
+      }
+    }
+    row.text.push_back('\n');
+    flushRows();
+  };
+
+  // writes the rows before time (or up to and including it if inclusive)
+  auto addRows = [&](int64_t time, bool inclusive) {
+    if (driver) {
+      while (!driverTimes.empty() &&
+             (driverTimes.front() < time ||
+              (inclusive && driverTimes.front() == time))) {
+        addRow(driverTimes.front());
+        driverTimes.pop();
+      }
+    } else if (started) {
+      while (nextTime < time || (inclusive && nextTime == time)) {
+        addRow(nextTime);
+        nextTime += period;
+      }
+    }
+  };
+
+  // fills the holes of a column with its next value (or its previous value if
+  // the next one isn't numeric or there isn't one)
+  auto fillHoles = [&](size_t i, bool hasNext, int64_t t1, double v1) {
+    auto& column = columns[i];
+    for (uint64_t seq : column.holes) {
+      auto& row = rows[seq - firstRow];
+      auto hole = std::find_if(row.holes.begin(), row.holes.end(),
+                               [&](auto& h) { return h.column == i; });
+      if (hasNext && t1 > row.time) {
+        int64_t t0 = column.time;
+        double v0 = column.value;
+        value.clear();
+        PrintValue(value,
+                   v0 + (v1 - v0) * static_cast<double>(row.time - t0) /
+                            (t1 - t0));
+        hole->value.assign(value.data(), value.size());
+      }
+      --row.unfilled;
+    }
+    column.holes.clear();
+  };
+
+  for (auto&& record : reader) {
+    if (record.IsStart()) {
+      wpi::log::StartRecordData data;
+      if (record.GetStartData(&data)) {
+        auto it = columnNames.find(data.name);
+        if (it != columnNames.end()) {
+          entryColumns[data.entry] = it->second;
+        }
+        if (driver && data.name == options.driver) {
+          driverEntries.emplace_back(data.entry);
+        }
+      }
+      continue;
+    } else if (record.IsFinish()) {
+      int entry;
+      if (record.GetFinishEntry(&entry)) {
+        entryColumns.erase(entry);
+        std::erase(driverEntries, entry);
+      }
+      continue;
+    } else if (record.IsControl()) {
+      continue;
+    }
+
+    int entry = record.GetEntry();
+    auto columnIt = entryColumns.find(entry);
+    bool isDriver = driver && std::find(driverEntries.begin(),
+                                        driverEntries.end(),
+                                        entry) != driverEntries.end();
+    if (columnIt == entryColumns.end() && !isDriver) {
+      continue;
+    }
+
+    int64_t time = record.GetTimestamp();
+    if (isDriver && hasDriverTime) {
+      time = (std::max)(time, lastDriverTime);
+    }
+    if (columnIt != entryColumns.end()) {
+      auto& column = columns[columnIt->second];
+      if (column.hasValue) {
+        time = (std::max)(time, column.time);
+      }
+      // rows before this record are complete
+      if (!driver && !started) {
+        started = true;
+        nextTime = time;
+      }
+      addRows(time, false);
+
+      double val;
+      bool numeric = GetNumericValue(*column.entry, record, &val);
+      fillHoles(columnIt->second, numeric, time, val);
+      column.hasValue = true;
+      column.time = time;
+      value.clear();
+      ValueToCsv(value, *column.entry, record);
+      column.text.assign(value.data(), value.size());
+      column.numeric = numeric;
+      column.value = val;
+      flushRows();
+    } else {
+      addRows(time, false);
+    }
+    // skip duplicate driver timestamps
+    if (isDriver && (!hasDriverTime || time != lastDriverTime)) {
+      driverTimes.push(time);
+      hasDriverTime = true;
+      lastDriverTime = time;
+    }
+    lastTime = (std::max)(lastTime, time);
+  }
+
+  // the remaining rows have no later values
+  addRows(lastTime, true);
+  for (size_t i = 0; i < columns.size(); ++i) {
+    fillHoles(i, false, 0, 0);
+  }
+  flushRows();
+  os.write(out.data(), out.size());
+}
+
+static void ExportCsvFile(ExportFile& f, const wpi::log::DataLogReader& reader,
+                          wpi::raw_ostream& os, const ExportOptions& options) {
+  int style = options.style;
+  fmt::memory_buffer out;
+  out.reserve(kWriteBufferSize + 4096);
+
   // header
+  std::vector<const ExportEntry*> entries;
   if (style == 0) {
-    os << "Timestamp,Name,Value\n";
-  } else if (style == 1) {
-    // scan for exported fields for this file to print header and assign columns
-    os << "Timestamp";
+    out.append(std::string_view{"Timestamp,Name,Value\n"});
+  } else if (style == 1 || style == 2) {
+    // assign columns for the exported fields of this file
+    out.append(std::string_view{"Timestamp"});
     int columnNum = 0;
-    for (auto&& entry : gEntries) {
-      if (entry.second->selected &&
-          entry.second->inputFiles.find(&f) != entry.second->inputFiles.end()) {
-        os << ',' << '"';
-        PrintEscapedCsvString(os, entry.first);
-        os << '"';
-        entry.second->column = columnNum++;
-      } else {
-        entry.second->column = -1;
-      }
+    for (auto&& entry : f.entries) {
+      out.append(std::string_view{",\""});
+      PrintEscapedCsvString(out, entry.first);
+      out.push_back('"');
+      entry.second.column = columnNum++;
+      entries.emplace_back(&entry.second);
     }
-    os << '\n';
+    out.push_back('\n');
+  }
+
+  if (style == 2) {
+    ExportResampled(reader, options, entries, out, os);
+    return;
   }
 
-  wpi::DenseMap<int, Entry*> nameMap;
-  for (auto&& record : f.datalog->GetReader()) {
+  wpi::DenseMap<int, ExportEntry*> nameMap;
+  for (auto&& record : reader) {
     if (record.IsStart()) {
       wpi::log::StartRecordData data;
       if (record.GetStartData(&data)) {
-        auto it = gEntries.find(data.name);
-        if (it != gEntries.end() && it->second->selected) {
-          nameMap[data.entry] = it->second.get();
+        auto it = f.entries.find(data.name);
+        if (it != f.entries.end()) {
+          nameMap[data.entry] = &it->second;
         }
       }
     } else if (record.IsFinish()) {
@@ -570,46 +910,506 @@ static void ExportCsvFile(InputFile& f, wpi::raw_ostream& os, int style) {
       if (entryIt == nameMap.end()) {
         continue;
       }
-      Entry* entry = entryIt->second;
+      ExportEntry* entry = entryIt->second;
 
       if (style == 0) {
-        fmt::print(os, "{},\"", record.GetTimestamp() / 1000000.0);
-        PrintEscapedCsvString(os, entry->name);
-        os << '"' << ',';
-        ValueToCsv(os, *entry, record);
-        os << '\n';
+        PrintValue(out, record.GetTimestamp() / 1000000.0);
+        out.append(std::string_view{",\""});
+        PrintEscapedCsvString(out, entry->name);
+        out.append(std::string_view{"\","});
+        ValueToCsv(out, *entry, record);
+        out.push_back('\n');
       } else if (style == 1 && entry->column != -1) {
-        fmt::print(os, "{},", record.GetTimestamp() / 1000000.0);
-        for (int i = 0; i < entry->column; ++i) {
-          os << ',';
+        PrintValue(out, record.GetTimestamp() / 1000000.0);
+        out.resize(out.size() + entry->column + 1);
+        std::fill(out.end() - entry->column - 1, out.end(), ',');
+        ValueToCsv(out, *entry, record);
+        out.push_back('\n');
+      }
+
+      if (out.size() >= kWriteBufferSize) {
+        os.write(out.data(), out.size());
+        out.clear();
+      }
+    }
+  }
+  os.write(out.data(), out.size());
+}
+
+static void AddExportError(std::string_view stem, std::string_view msg) {
+  std::scoped_lock lock{gExportMutex};
+  gExportErrors.emplace_back(fmt::format("{}: {}", stem, msg));
+}
+
+// Columnar export.  Each input file is exported as a little-endian binary
+// data file (<stem>.bin) and a JSON schema (<stem>.json) that describes it.
+// The schema has an "entries" array with an object for each entry, with the
+// entry's name, type, metadata, and number of values ("count"), plus a
+// description of each of the entry's buffers in the data file: its element
+// type ("dtype"), byte offset ("offset"), and byte length ("length").  Each
+// buffer starts at a multiple of 64 bytes, so the data file can be memory
+// mapped and the buffers used directly as arrays.
+//
+// Every entry has a "timestamps" buffer (int64, microseconds).  Values are
+// stored depending on the entry type:
+// - boolean, int64, float, double: a "values" buffer of bool (1 byte),
+//   int64, float32, or float64
+// - boolean[], int64[], float[], double[]: an "offsets" buffer (int64,
+//   count + 1 elements); the elements of value i are values[offsets[i]] to
+//   values[offsets[i + 1]] in the "values" buffer
+// - string[]: "offsets" (int64, count + 1 elements) into the list of strings,
+//   "stringOffsets" (int64, number of strings + 1 elements) into the "values"
+//   buffer (utf8)
+// - everything else: "offsets" (int64, count + 1 elements) into the "values"
+//   buffer (utf8 for string and json, binary for everything else)
+//
+// The buffers are accumulated in memory while reading the log; when they
+// reach kMaxStagedSize in total, they are appended to a temporary spill file
+// (<stem>.bin.tmp), and the pieces are put back together when the data file
+// is written.  Memory use thus doesn't depend on the size of the log.
+namespace {
+struct ColumnarBuffer {
+  uint64_t size() const { return spilledSize + data.size(); }
+
+  void Append(std::span<const uint8_t> bytes) {
+    data.insert(data.end(), bytes.begin(), bytes.end());
+  }
+  void AppendInt64(int64_t val) {
+    size_t pos = data.size();
+    data.resize(pos + 8);
+    wpi::support::endian::write64le(&data[pos], val);
+  }
+
+  std::vector<uint8_t> data;  // not yet spilled
+  // pieces in the spill file (offset, length)
+  std::vector<std::pair<uint64_t, uint64_t>> spilled;
+  uint64_t spilledSize = 0;
+};
+
+struct ColumnarEntry {
+  size_t GetStagedSize() const {
+    return timestamps.data.size() + offsets.data.size() +
+           stringOffsets.data.size() + values.data.size();
+  }
+
+  std::string_view dtype;  // element type of values
+  size_t elementSize = 0;  // 0 for byte strings
+  bool variable = false;   // has offsets
+  uint64_t count = 0;
+  ColumnarBuffer timestamps;
+  ColumnarBuffer offsets;
+  ColumnarBuffer stringOffsets;
+  ColumnarBuffer values;
+};
+}  // namespace
+
+static constexpr size_t kColumnAlignment = 64;
+static constexpr size_t kMaxStagedSize = 32 * 1024 * 1024;
+
+static ColumnarEntry MakeColumnarEntry(std::string_view type) {
+  ColumnarEntry col;
+  if (type == "double") {
+    col.dtype = "float64";
+    col.elementSize = 8;
+  } else if (type == "float") {
+    col.dtype = "float32";
+    col.elementSize = 4;
+  } else if (type == "int64") {
+    col.dtype = "int64";
+    col.elementSize = 8;
+  } else if (type == "boolean") {
+    col.dtype = "bool";
+    col.elementSize = 1;
+  } else if (type == "double[]") {
+    col.dtype = "float64";
+    col.elementSize = 8;
+    col.variable = true;
+  } else if (type == "float[]") {
+    col.dtype = "float32";
+    col.elementSize = 4;
+    col.variable = true;
+  } else if (type == "int64[]") {
+    col.dtype = "int64";
+    col.elementSize = 8;
+    col.variable = true;
+  } else if (type == "boolean[]") {
+    col.dtype = "bool";
+    col.elementSize = 1;
+    col.variable = true;
+  } else if (type == "string" || type == "json" || type == "string[]") {
+    col.dtype = "utf8";
+    col.variable = true;
+  } else {
+    col.dtype = "binary";
+    col.variable = true;
+  }
+  if (col.variable) {
+    col.offsets.AppendInt64(0);
+    if (type == "string[]") {
+      col.stringOffsets.AppendInt64(0);
+    }
+  }
+  return col;
+}
+
+static void AddColumnarValue(ColumnarEntry& col, const ExportEntry& entry,
+                             const wpi::log::DataLogRecord& record) {
+  // payloads are already little endian, so most can be copied directly
+  auto data = record.GetRaw();
+  if (entry.type == "string[]") {
+    std::vector<std::string_view> arr;
+    if (!record.GetStringArray(&arr)) {
+      return;
+    }
+    for (auto&& str : arr) {
+      col.values.Append(
+          {reinterpret_cast<const uint8_t*>(str.data()), str.size()});
+      col.stringOffsets.AppendInt64(col.values.size());
+    }
+    col.offsets.AppendInt64(col.stringOffsets.size() / 8 - 1);
+  } else if (col.elementSize == 0) {
+    col.values.Append(data);
+    col.offsets.AppendInt64(col.values.size());
+  } else if (col.variable) {
+    if ((data.size() % col.elementSize) != 0) {
+      return;
+    }
+    col.values.Append(data);
+    col.offsets.AppendInt64(col.values.size() / col.elementSize);
+  } else {
+    if (data.size() != col.elementSize) {
+      return;
+    }
+    col.values.Append(data);
+  }
+  col.timestamps.AppendInt64(record.GetTimestamp());
+  ++col.count;
+}
+
+static void ExportColumnarFile(const fs::path& outPath, ExportFile& f,
+                               const wpi::log::DataLogReader& reader) {
+  std::vector<ColumnarEntry> columns;
+  columns.reserve(f.entries.size());
+  for (auto&& entry : f.entries) {
+    entry.second.column = columns.size();
+    columns.emplace_back(MakeColumnarEntry(entry.second.type));
+  }
+
+  // spill file, created when first needed and removed when done
+  auto spillPath = outPath / fs::path{f.stem}.replace_extension("bin.tmp");
+  std::unique_ptr<wpi::raw_fd_ostream> spill;
+  wpi::MappedFileRegion spillMap;
+  bool spilled = false;
+  uint64_t spillSize = 0;
+  size_t stagedSize = 0;
+  wpi::scope_exit removeSpill{[&] {
+    if (spilled) {
+      if (spill) {
+        spill->close();
+        spill->clear_error();
+        spill.reset();
+      }
+      spillMap.Unmap();
+      std::error_code ec;
+      fs::remove(spillPath, ec);
+    }
+  }};
+  auto spillBuffers = [&]() -> bool {
+    if (!spill) {
+      std::error_code ec;
+      auto sf = fs::OpenFileForWrite(spillPath, ec, fs::CD_CreateAlways,
+                                     fs::OF_None);
+      if (ec) {
+        AddExportError(f.stem, ec.message());
+        return false;
+      }
+      spill = std::make_unique<wpi::raw_fd_ostream>(
+          fs::FileToFd(sf, ec, fs::OF_None), true, /*unbuffered=*/false);
+      spill->SetBufferSize(kWriteBufferSize);
+      spilled = true;
+    }
+    for (auto&& col : columns) {
+      for (auto buf :
+           {&col.timestamps, &col.offsets, &col.stringOffsets, &col.values}) {
+        if (buf->data.empty()) {
+          continue;
+        }
+        spill->write(buf->data.data(), buf->data.size());
+        buf->spilled.emplace_back(spillSize, buf->data.size());
+        buf->spilledSize += buf->data.size();
+        spillSize += buf->data.size();
+        // keep the capacity for the next round
+        buf->data.clear();
+      }
+    }
+    stagedSize = 0;
+    if (spill->has_error()) {
+      AddExportError(f.stem, spill->error().message());
+      spill->clear_error();
+      return false;
+    }
+    return true;
+  };
+
+  wpi::DenseMap<int, ExportEntry*> nameMap;
+  for (auto&& record : reader) {
+    if (record.IsStart()) {
+      wpi::log::StartRecordData data;
+      if (record.GetStartData(&data)) {
+        auto it = f.entries.find(data.name);
+        if (it != f.entries.end()) {
+          nameMap[data.entry] = &it->second;
+        }
+      }
+    } else if (record.IsFinish()) {
+      int entry;
+      if (record.GetFinishEntry(&entry)) {
+        nameMap.erase(entry);
+      }
+    } else if (!record.IsControl()) {
+      auto entryIt = nameMap.find(record.GetEntry());
+      if (entryIt != nameMap.end()) {
+        auto& col = columns[entryIt->second->column];
+        size_t prevSize = col.GetStagedSize();
+        AddColumnarValue(col, *entryIt->second, record);
+        stagedSize += col.GetStagedSize() - prevSize;
+        if (stagedSize >= kMaxStagedSize && !spillBuffers()) {
+          return;
         }
-        ValueToCsv(os, *entry, record);
-        os << '\n';
       }
     }
   }
+
+  // map the spilled pieces for copying into the data file
+  if (spilled) {
+    spill->close();
+    if (spill->has_error()) {
+      AddExportError(f.stem, spill->error().message());
+      return;
+    }
+    spill.reset();
+    std::error_code ec;
+    fs::file_t sf = fs::OpenFileForRead(spillPath, ec, fs::OF_None);
+    if (!ec) {
+      spillMap = wpi::MappedFileRegion{
+          sf, spillSize, 0, wpi::MappedFileRegion::kReadOnly, ec};
+      fs::CloseFile(sf);
+    }
+    if (ec) {
+      AddExportError(f.stem, ec.message());
+      return;
+    }
+  }
+
+  // data file
+  auto dataFilename = fs::path{f.stem}.replace_extension("bin");
+  std::error_code ec;
+  auto of = fs::OpenFileForWrite(outPath / dataFilename, ec, fs::CD_CreateNew,
+                                 fs::OF_None);
+  if (ec) {
+    AddExportError(f.stem, ec.message());
+    return;
+  }
+  wpi::json schema{{"format", "wpilog-columnar"},
+                   {"version", 1},
+                   {"byteOrder", "little"},
+                   {"source", reader.GetBufferIdentifier()},
+                   {"dataFile", dataFilename.string()},
+                   {"entries", wpi::json::array()}};
+  {
+    wpi::raw_fd_ostream os{fs::FileToFd(of, ec, fs::OF_None), true,
+                           /*unbuffered=*/false};
+    // large buffers are written directly
+    os.SetBufferSize(kWriteBufferSize);
+    uint64_t offset = 0;
+    auto writeBuffer = [&](std::string_view dtype,
+                           const ColumnarBuffer& buf) {
+      wpi::json desc{
+          {"dtype", dtype}, {"offset", offset}, {"length", buf.size()}};
+      for (auto&& [pieceOffset, pieceSize] : buf.spilled) {
+        os.write(spillMap.const_data() + pieceOffset, pieceSize);
+      }
+      os.write(buf.data.data(), buf.data.size());
+      offset += buf.size();
+      size_t padding = (kColumnAlignment - offset % kColumnAlignment) %
+                       kColumnAlignment;
+      os.write_zeros(padding);
+      offset += padding;
+      return desc;
+    };
+
+    for (auto&& [name, entry] : f.entries) {
+      auto& col = columns[entry.column];
+      wpi::json desc{{"name", name},
+                     {"type", entry.type},
+                     {"metadata", entry.metadata},
+                     {"count", col.count}};
+      desc["timestamps"] = writeBuffer("int64", col.timestamps);
+      if (col.variable) {
+        desc["offsets"] = writeBuffer("int64", col.offsets);
+      }
+      if (col.stringOffsets.size() != 0) {
+        desc["stringOffsets"] = writeBuffer("int64", col.stringOffsets);
+      }
+      desc["values"] = writeBuffer(col.dtype, col.values);
+      schema["entries"].push_back(std::move(desc));
+      // free memory as we go
+      col = ColumnarEntry{};
+    }
+    if (os.has_error()) {
+      AddExportError(f.stem, os.error().message());
+      os.clear_error();
+      return;
+    }
+  }
+
+  // schema
+  of = fs::OpenFileForWrite(
+      outPath / fs::path{f.stem}.replace_extension("json"), ec,
+      fs::CD_CreateNew, fs::OF_Text);
+  if (ec) {
+    AddExportError(f.stem, ec.message());
+    return;
+  }
+  wpi::raw_fd_ostream os{fs::FileToFd(of, ec, fs::OF_Text), true};
+  schema.dump(os, 2);
+  os << '\n';
 }
 
-static void ExportCsv(std::string_view outputFolder, int style) {
+static void ExportFiles(std::string outputFolder, std::vector<ExportFile> files,
+                        ExportOptions options) {
   fs::path outPath{outputFolder};
+  auto exportFile = [&](ExportFile& f) {
+    if (!f.datalog) {
+      return;
+    }
+    // the records are read from the file again; only the entries are kept
+    // in memory after loading
+    std::error_code ec;
+    auto reader = f.datalog->OpenReader(ec);
+    if (ec) {
+      AddExportError(f.stem, ec.message());
+      return;
+    }
+    if (options.columnar) {
+      ExportColumnarFile(outPath, f, reader);
+      return;
+    }
+    if (options.style == 2 && !options.driver.empty() &&
+        !f.entries.contains(options.driver)) {
+      AddExportError(f.stem,
+                     fmt::format("driver entry '{}' is not selected or not "
+                                 "in file",
+                                 options.driver));
+      return;
+    }
+    auto of = fs::OpenFileForWrite(
+        outPath / fs::path{f.stem}.replace_extension("csv"), ec,
+        fs::CD_CreateNew, fs::OF_Text);
+    if (ec) {
+      AddExportError(f.stem, ec.message());
+      return;
+    }
+    wpi::raw_fd_ostream os{fs::FileToFd(of, ec, fs::OF_Text), true};
+    // ExportCsvFile does its own buffering
+    os.SetUnbuffered();
+    ExportCsvFile(f, reader, os, options);
+  };
+
+  // export files concurrently; each worker takes the next file in turn
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i; (i = next++) < files.size();) {
+      exportFile(files[i]);
+      ++gExportCount;
+    }
+  };
+  size_t numThreads = (std::min<size_t>)(
+      (std::max)(std::thread::hardware_concurrency(), 1u), files.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto&& thread : threads) {
+    thread.join();
+  }
+}
+
+// merges the selected entries of all input files into a single log
+static void MergeFiles(std::string outputFolder, std::string filename,
+                       std::vector<ExportFile> files, bool trim,
+                       double startTime, double endTime) {
+  wpi::log::DataLogMerger merger;
+  std::vector<wpi::log::DataLogReader> readers;
+  readers.reserve(files.size());
+  bool anySelected = false;
+  for (auto&& f : files) {
+    if (!f.datalog || f.entries.empty()) {
+      continue;
+    }
+    std::error_code ec;
+    auto& reader = readers.emplace_back(f.datalog->OpenReader(ec));
+    if (ec) {
+      AddExportError(f.stem, ec.message());
+      readers.pop_back();
+      continue;
+    }
+    merger.AddInput(reader);
+    for (auto&& entry : f.entries) {
+      merger.IncludeEntry(entry.first);
+    }
+    anySelected = true;
+  }
+  if (!anySelected) {
+    AddExportError(filename, "no entries selected");
+    gExportCount = files.size();
+    return;
+  }
+  if (trim) {
+    merger.SetTimeRange(static_cast<int64_t>(startTime * 1000000),
+                        static_cast<int64_t>(endTime * 1000000));
+  }
+
+  std::error_code ec;
+  auto of = fs::OpenFileForWrite(fs::path{outputFolder} / filename, ec,
+                                 fs::CD_CreateNew, fs::OF_None);
+  if (ec) {
+    AddExportError(filename, ec.message());
+    gExportCount = files.size();
+    return;
+  }
+  wpi::raw_fd_ostream os{fs::FileToFd(of, ec, fs::OF_None), true};
+  if (!merger.Merge(os)) {
+    AddExportError(filename, "invalid input log");
+  }
+  os.close();
+  if (os.has_error()) {
+    AddExportError(filename, os.error().message());
+  }
+  gExportCount = files.size();
+}
+
+// gets the selected entries for each input file
+static std::vector<ExportFile> GetExportFiles() {
+  std::vector<ExportFile> files;
+  files.reserve(gInputFiles.size());
+  std::scoped_lock lock{gEntriesMutex};
   for (auto&& f : gInputFiles) {
-    if (f.second->datalog) {
-      std::error_code ec;
-      auto of = fs::OpenFileForWrite(
-          outPath / fs::path{f.first}.replace_extension("csv"), ec,
-          fs::CD_CreateNew, fs::OF_Text);
-      if (ec) {
-        std::scoped_lock lock{gExportMutex};
-        gExportErrors.emplace_back(
-            fmt::format("{}: {}", f.first, ec.message()));
-        ++gExportCount;
-        continue;
+    auto& file = files.emplace_back();
+    file.stem = f.first;
+    file.datalog = f.second->datalog.get();
+    if (!file.datalog) {
+      continue;
+    }
+    for (auto&& entry : gEntries) {
+      if (entry.second->selected &&
+          entry.second->inputFiles.count(f.second.get()) != 0) {
+        file.entries.try_emplace(entry.first, *entry.second);
       }
-      wpi::raw_fd_ostream os{fs::FileToFd(of, ec, fs::OF_Text), true};
-      ExportCsvFile(*f.second, os, style);
     }
-    ++gExportCount;
   }
+  return files;
 }
 
 void DisplayOutput(glass::Storage& storage) {
@@ -625,20 +1425,92 @@ void DisplayOutput(glass::Storage& storage) {
     }
     ImGui::TextUnformatted(outputFolder.c_str());
 
-    static const char* const options[] = {"List", "Table"};
-    static int style = 0;
+    static const char* const styles[] = {"List", "Table", "Resampled"};
+    static ExportOptions options;
     ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
-    ImGui::Combo("Style", &style, options,
-                 sizeof(options) / sizeof(const char*));
+    ImGui::Combo("Style", &options.style, styles,
+                 sizeof(styles) / sizeof(const char*));
+    if (options.style == 2) {
+      static const char* const rowModes[] = {"Fixed Period", "Driver Entry"};
+      static int rowMode = 0;
+      ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+      ImGui::Combo("Rows", &rowMode, rowModes,
+                   sizeof(rowModes) / sizeof(const char*));
+      ImGui::SameLine();
+      static std::string driver;
+      ImGui::SetNextItemWidth(ImGui::GetFontSize() * 12);
+      if (rowMode == 0) {
+        ImGui::InputDouble("Period (s)", &options.period, 0, 0, "%.6f");
+        if (options.period < 0.000001) {
+          options.period = 0.000001;
+        }
+        options.driver.clear();
+      } else {
+        ImGui::InputText("Driver", &driver);
+        options.driver = driver;
+      }
+      static const char* const interpolations[] = {"Zero-Order Hold",
+                                                   "Linear"};
+      int interpolation = options.linear ? 1 : 0;
+      ImGui::SetNextItemWidth(ImGui::GetFontSize() * 8);
+      if (ImGui::Combo("Interpolation", &interpolation, interpolations,
+                       sizeof(interpolations) / sizeof(const char*))) {
+        options.linear = interpolation == 1;
+      }
+    }
 
     static std::future<void> exporter;
-    if (!gInputFiles.empty() && !outputFolder.empty() &&
-        ImGui::Button("Export CSV") &&
-        (gExportCount == 0 ||
-         gExportCount == static_cast<int>(gInputFiles.size()))) {
-      gExportCount = 0;
-      gExportErrors.clear();
-      exporter = std::async(std::launch::async, ExportCsv, outputFolder, style);
+    if (!gInputFiles.empty() && !outputFolder.empty()) {
+      bool exportCsv = ImGui::Button("Export CSV");
+      ImGui::SameLine();
+      bool exportColumnar = ImGui::Button("Export Columnar");
+      if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip(
+            "Binary file with one typed column per entry, plus a JSON schema");
+      }
+      if ((exportCsv || exportColumnar) &&
+          (gExportCount == 0 ||
+           gExportCount == static_cast<int>(gInputFiles.size()))) {
+        gExportCount = 0;
+        gExportErrors.clear();
+        options.columnar = exportColumnar;
+        exporter = std::async(std::launch::async, ExportFiles, outputFolder,
+                              GetExportFiles(), options);
+      }
+
+      static std::string& mergeFilename =
+          storage.GetString("mergeFilename", "merged.wpilog");
+      static bool trim = false;
+      static double trimStart = 0;
+      static double trimEnd = 0;
+      bool merge = ImGui::Button("Merge");
+      if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip(
+            "Merge the selected entries of all input files into a single "
+            "data log");
+      }
+      ImGui::SameLine();
+      ImGui::SetNextItemWidth(ImGui::GetFontSize() * 12);
+      ImGui::InputText("##mergeFilename", &mergeFilename);
+      ImGui::SameLine();
+      ImGui::Checkbox("Trim", &trim);
+      if (trim) {
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(ImGui::GetFontSize() * 6);
+        ImGui::InputDouble("Start (s)", &trimStart, 0, 0, "%.3f");
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(ImGui::GetFontSize() * 6);
+        ImGui::InputDouble("End (s)", &trimEnd, 0, 0, "%.3f");
+      }
+      if (merge && !mergeFilename.empty() &&
+          (gExportCount == 0 ||
+           gExportCount == static_cast<int>(gInputFiles.size()))) {
+        gExportCount = 0;
+        gExportErrors.clear();
+        exporter = std::async(std::launch::async, MergeFiles, outputFolder,
+                              mergeFilename, GetExportFiles(), trim, trimStart,
+                              trimEnd);
+      }
     }
     if (exporter.valid()) {
       ImGui::SameLine();
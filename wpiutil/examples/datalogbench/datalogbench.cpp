@@ -0,0 +1,465 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+// DataLog microbenchmarks.  Measures the append path (single and multiple
+// threads), the writer thread (to tmpfs and to disk), and DataLogReader
+// decoding.  Results are printed as a table, and optionally saved as JSON
+// (--json) so they can be compared between runs.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+#include "wpi/DataLog.h"
+#include "wpi/DataLogParallelReader.h"
+#include "wpi/DataLogReader.h"
+#include "wpi/MemoryBuffer.h"
+#include "wpi/StringExtras.h"
+#include "wpi/fs.h"
+#include "wpi/json.h"
+#include "wpi/raw_ostream.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+  uint64_t ops = 1000000;
+  int runs = 5;
+  unsigned int maxThreads = 4;
+  uint64_t writeBytes = 256 * 1024 * 1024;
+  std::string tmpfsDir = "/dev/shm";
+  std::string diskDir;
+  std::string filter;
+  std::string jsonFile;
+};
+
+struct Result {
+  explicit Result(std::string name, unsigned int threads = 1)
+      : name{std::move(name)}, threads{threads} {}
+
+  std::string name;
+  unsigned int threads;
+  // operations and bytes per run
+  uint64_t ops = 0;
+  uint64_t bytes = 0;
+  // elapsed time of each run
+  std::vector<double> seconds;
+  // per-operation latencies of all runs, in nanoseconds (if measured)
+  std::vector<int64_t> latencies;
+  uint64_t dropped = 0;
+};
+
+struct AppendBench {
+  std::string_view name;
+  std::string_view type;
+  size_t payloadSize;
+  void (*append)(wpi::log::DataLog& log, int entry, int64_t timestamp);
+};
+
+constexpr std::array<double, 16> kDoubleArray{1, 2,  3,  4,  5,  6,  7,  8,
+                                              9, 10, 11, 12, 13, 14, 15, 16};
+constexpr std::string_view kString = "the quick brown fox jumps over it";
+constexpr std::array<uint8_t, 8> kRawHeader{};
+constexpr std::array<uint8_t, 56> kRawBody{};
+
+const AppendBench kAppendBenches[] = {
+    {"AppendDouble", "double", 8,
+     [](auto& log, int entry, int64_t timestamp) {
+       log.AppendDouble(entry, timestamp * 0.5, timestamp);
+     }},
+    {"AppendDoubleArray", "double[]", kDoubleArray.size() * 8,
+     [](auto& log, int entry, int64_t timestamp) {
+       log.AppendDoubleArray(entry, kDoubleArray, timestamp);
+     }},
+    {"AppendString", "string", kString.size(),
+     [](auto& log, int entry, int64_t timestamp) {
+       log.AppendString(entry, kString, timestamp);
+     }},
+    {"AppendRaw2", "raw", kRawHeader.size() + kRawBody.size(),
+     [](auto& log, int entry, int64_t timestamp) {
+       std::span<const uint8_t> parts[] = {kRawHeader, kRawBody};
+       log.AppendRaw2(entry, parts, timestamp);
+     }},
+};
+
+double Seconds(Clock::duration d) {
+  return std::chrono::duration<double>(d).count();
+}
+
+int64_t Percentile(std::span<const int64_t> sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[(std::min)(i, sorted.size() - 1)];
+}
+
+double Median(std::vector<double> vals) {
+  if (vals.empty()) {
+    return 0;
+  }
+  std::sort(vals.begin(), vals.end());
+  return vals[vals.size() / 2];
+}
+
+// Runs func(thread) on the given number of threads, starting them all at
+// once; returns the time from the start until all threads finished.
+template <typename F>
+Clock::duration RunThreads(unsigned int threads, F&& func) {
+  std::atomic<bool> go{false};
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (unsigned int t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+      }
+      func(t);
+    });
+  }
+  auto start = Clock::now();
+  go.store(true, std::memory_order_release);
+  for (auto&& worker : workers) {
+    worker.join();
+  }
+  return Clock::now() - start;
+}
+
+// Each run appends opts.ops records split evenly between the threads, to a
+// log that discards its output, so only the append path is measured.  A
+// first pass measures throughput; a second pass times each call to get the
+// latency distribution.  Timestamps are provided explicitly so the time
+// source isn't part of the measurement.
+Result RunAppend(const AppendBench& bench, unsigned int threads,
+                 const Options& opts) {
+  Result result{fmt::format("{}/threads:{}", bench.name, threads), threads};
+  uint64_t perThread = opts.ops / threads;
+  result.ops = perThread * threads;
+  result.bytes = result.ops * bench.payloadSize;
+
+  for (int run = -1; run < opts.runs; ++run) {
+    wpi::log::DataLog log{[](auto) {}, 0.005};
+    std::vector<int> entries;
+    for (unsigned int t = 0; t < threads; ++t) {
+      entries.emplace_back(
+          log.Start(fmt::format("bench/{}", t), bench.type, "", 1));
+    }
+
+    // the first run is a warmup
+    uint64_t count = run < 0 ? perThread / 10 : perThread;
+    auto elapsed = RunThreads(threads, [&](unsigned int t) {
+      for (uint64_t i = 1; i <= count; ++i) {
+        bench.append(log, entries[t], i);
+      }
+    });
+    if (run < 0) {
+      continue;
+    }
+    result.seconds.emplace_back(Seconds(elapsed));
+
+    std::vector<std::vector<int64_t>> latencies(threads);
+    RunThreads(threads, [&](unsigned int t) {
+      auto& out = latencies[t];
+      out.reserve(count);
+      for (uint64_t i = count + 1; i <= 2 * count; ++i) {
+        auto start = Clock::now();
+        bench.append(log, entries[t], i);
+        out.emplace_back(
+            std::chrono::nanoseconds(Clock::now() - start).count());
+      }
+    });
+    for (auto&& lat : latencies) {
+      result.latencies.insert(result.latencies.end(), lat.begin(), lat.end());
+    }
+    result.dropped += log.GetDroppedRecords();
+  }
+  return result;
+}
+
+// Each run appends opts.writeBytes of raw records to a log file in dir and
+// measures the time until the log is closed (so all data is written).  The
+// buffer limit makes the appending thread wait for the writer thread, so
+// this measures the writer thread throughput.
+std::optional<Result> RunWrite(std::string_view label, const std::string& dir,
+                               const Options& opts) {
+  std::error_code ec;
+  if (dir.empty() || !fs::is_directory(dir, ec)) {
+    return std::nullopt;
+  }
+  static constexpr size_t kRecordSize = 1024;
+  static const std::vector<uint8_t> payload(kRecordSize, 0x5a);
+
+  Result result{fmt::format("Write/{}", label)};
+  result.ops = opts.writeBytes / kRecordSize;
+  for (int run = 0; run < opts.runs; ++run) {
+    auto filename = fmt::format("datalogbench_{}.wpilog",
+                                Clock::now().time_since_epoch().count());
+    auto path = fs::path{dir} / filename;
+    auto start = Clock::now();
+    {
+      wpi::log::DataLog log{dir, filename, 0.05};
+      log.SetBufferLimit(16 * 1024 * 1024,
+                         wpi::log::DataLog::OverflowPolicy::kBlock);
+      int entry = log.Start("raw", "raw", "", 1);
+      for (uint64_t i = 1; i <= result.ops; ++i) {
+        log.AppendRaw(entry, payload, i);
+      }
+      result.dropped += log.GetDroppedRecords();
+    }
+    result.seconds.emplace_back(Seconds(Clock::now() - start));
+    result.bytes = fs::file_size(path, ec);
+    fs::remove(path, ec);
+  }
+  return result;
+}
+
+// Generates an in-memory log with a mix of record types for the decode
+// benchmarks.
+std::vector<uint8_t> MakeDecodeLog(const Options& opts) {
+  std::vector<uint8_t> data;
+  wpi::log::DataLog log{[&](auto out) {
+    data.insert(data.end(), out.begin(), out.end());
+  }};
+  int doubleEntry = log.Start("double", "double", "", 1);
+  int arrayEntry = log.Start("double[]", "double[]", "", 1);
+  int stringEntry = log.Start("string", "string", "", 1);
+  for (uint64_t i = 1; i <= opts.ops; ++i) {
+    switch (i % 4) {
+      case 0:
+        log.AppendDoubleArray(arrayEntry, kDoubleArray, i);
+        break;
+      case 1:
+        log.AppendString(stringEntry, kString, i);
+        break;
+      default:
+        log.AppendDouble(doubleEntry, i * 0.5, i);
+        break;
+    }
+  }
+  return data;
+}
+
+// Decodes each record's value, as a log viewer would.
+void DecodeValue(const wpi::log::DataLogRecord& record, double* sum) {
+  double val;
+  std::vector<double> arr;
+  std::string_view str;
+  if (record.GetDouble(&val)) {
+    *sum += val;
+  } else if (record.GetString(&str)) {
+    *sum += str.size();
+  } else if (record.GetDoubleArray(&arr)) {
+    *sum += arr.size();
+  }
+}
+
+std::vector<Result> RunDecode(const Options& opts) {
+  auto data = MakeDecodeLog(opts);
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+
+  Result sequential{"Decode/DataLogReader"};
+  Result parallel{"Decode/DataLogParallelReader",
+                  (std::max)(std::thread::hardware_concurrency(), 1u)};
+  for (auto result : {&sequential, &parallel}) {
+    result->bytes = data.size();
+  }
+
+  double sum = 0;
+  for (int run = 0; run < opts.runs; ++run) {
+    uint64_t count = 0;
+    auto start = Clock::now();
+    for (auto&& record : reader) {
+      DecodeValue(record, &sum);
+      ++count;
+    }
+    sequential.seconds.emplace_back(Seconds(Clock::now() - start));
+    sequential.ops = count;
+
+    count = 0;
+    start = Clock::now();
+    wpi::log::DataLogParallelReader preader{reader};
+    preader.ForEachChunk([&](size_t, auto records) {
+      double chunkSum = 0;
+      for (auto&& record : records) {
+        DecodeValue(record, &chunkSum);
+      }
+      (void)chunkSum;
+    });
+    parallel.seconds.emplace_back(Seconds(Clock::now() - start));
+    preader.ForEach([&](auto&) { ++count; });
+    parallel.ops = count;
+  }
+  // keep the decoding from being optimized out
+  if (sum == -1) {
+    fmt::print("\n");
+  }
+  return {std::move(sequential), std::move(parallel)};
+}
+
+wpi::json ToJson(const Result& result) {
+  double seconds = Median(result.seconds);
+  wpi::json j{{"name", result.name},
+              {"threads", result.threads},
+              {"runs", result.seconds.size()},
+              {"ops", result.ops},
+              {"bytes", result.bytes},
+              {"seconds", result.seconds},
+              {"median_seconds", seconds},
+              {"ops_per_second", seconds > 0 ? result.ops / seconds : 0.0},
+              {"bytes_per_second", seconds > 0 ? result.bytes / seconds : 0.0},
+              {"dropped", result.dropped}};
+  if (!result.latencies.empty()) {
+    j["latency_ns"] = {{"p50", Percentile(result.latencies, 0.5)},
+                       {"p90", Percentile(result.latencies, 0.9)},
+                       {"p99", Percentile(result.latencies, 0.99)},
+                       {"p999", Percentile(result.latencies, 0.999)},
+                       {"max", result.latencies.back()}};
+  }
+  return j;
+}
+
+void Print(Result& result) {
+  std::sort(result.latencies.begin(), result.latencies.end());
+  double seconds = Median(result.seconds);
+  fmt::print("{:<36} {:>12.0f} ops/s {:>10.1f} MB/s", result.name,
+             seconds > 0 ? result.ops / seconds : 0,
+             seconds > 0 ? result.bytes / seconds / 1e6 : 0);
+  if (!result.latencies.empty()) {
+    fmt::print("  p50 {} p99 {} p99.9 {} max {} ns",
+               Percentile(result.latencies, 0.5),
+               Percentile(result.latencies, 0.99),
+               Percentile(result.latencies, 0.999), result.latencies.back());
+  }
+  if (result.dropped != 0) {
+    fmt::print("  ({} dropped)", result.dropped);
+  }
+  fmt::print("\n");
+}
+
+void Usage() {
+  fmt::print(stderr,
+             "Usage: datalogbench [options]\n"
+             "  --ops N          records per append/decode run (default "
+             "1000000)\n"
+             "  --runs N         runs per benchmark (default 5)\n"
+             "  --threads N      maximum number of appending threads "
+             "(default 4)\n"
+             "  --write-mb N     megabytes per write run (default 256)\n"
+             "  --tmpfs-dir DIR  tmpfs directory for write runs (default "
+             "/dev/shm)\n"
+             "  --disk-dir DIR   disk directory for write runs (default: "
+             "skip)\n"
+             "  --filter STR     only run benchmarks containing STR\n"
+             "  --json FILE      save results as JSON\n");
+}
+
+std::optional<Options> ParseArgs(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (i + 1 >= argc) {
+      return std::nullopt;
+    }
+    std::string_view val = argv[++i];
+    auto num = wpi::parse_integer<uint64_t>(val, 10);
+    if (arg == "--ops" && num && *num > 0) {
+      opts.ops = *num;
+    } else if (arg == "--runs" && num && *num > 0) {
+      opts.runs = *num;
+    } else if (arg == "--threads" && num && *num > 0) {
+      opts.maxThreads = *num;
+    } else if (arg == "--write-mb" && num && *num > 0) {
+      opts.writeBytes = *num * 1024 * 1024;
+    } else if (arg == "--tmpfs-dir") {
+      opts.tmpfsDir = val;
+    } else if (arg == "--disk-dir") {
+      opts.diskDir = val;
+    } else if (arg == "--filter") {
+      opts.filter = val;
+    } else if (arg == "--json") {
+      opts.jsonFile = val;
+    } else {
+      return std::nullopt;
+    }
+  }
+  return opts;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  auto opts = ParseArgs(argc, argv);
+  if (!opts) {
+    Usage();
+    return EXIT_FAILURE;
+  }
+
+  auto selected = [&](std::string_view name) {
+    return opts->filter.empty() ||
+           name.find(opts->filter) != std::string_view::npos;
+  };
+  std::vector<Result> results;
+  auto add = [&](Result&& result) {
+    Print(result);
+    results.emplace_back(std::move(result));
+  };
+
+  for (auto&& bench : kAppendBenches) {
+    for (unsigned int threads = 1; threads <= opts->maxThreads;
+         threads *= 2) {
+      if (selected(fmt::format("{}/threads:{}", bench.name, threads))) {
+        add(RunAppend(bench, threads, *opts));
+      }
+    }
+  }
+  if (selected("Write/tmpfs")) {
+    if (auto result = RunWrite("tmpfs", opts->tmpfsDir, *opts)) {
+      add(std::move(*result));
+    }
+  }
+  if (selected("Write/disk")) {
+    if (auto result = RunWrite("disk", opts->diskDir, *opts)) {
+      add(std::move(*result));
+    }
+  }
+  if (selected("Decode/")) {
+    for (auto&& result : RunDecode(*opts)) {
+      if (selected(result.name)) {
+        add(std::move(result));
+      }
+    }
+  }
+
+  if (!opts->jsonFile.empty()) {
+    wpi::json j{{"benchmark", "datalog"},
+                {"hardware_threads", std::thread::hardware_concurrency()},
+                {"results", wpi::json::array()}};
+    for (auto&& result : results) {
+      j["results"].push_back(ToJson(result));
+    }
+    std::error_code ec;
+    wpi::raw_fd_ostream os{opts->jsonFile, ec};
+    if (ec) {
+      fmt::print(stderr, "could not open '{}': {}\n", opts->jsonFile,
+                 ec.message());
+      return EXIT_FAILURE;
+    }
+    j.dump(os, 2);
+    os << '\n';
+  }
+
+  return EXIT_SUCCESS;
+}
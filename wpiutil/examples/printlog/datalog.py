@@ -15,6 +15,10 @@ doubleStruct = struct.Struct("<d")
 kControlStart = 0
 kControlFinish = 1
 kControlSetMetadata = 2
+kControlSync = 3
+kControlBlock = 4
+kControlSummary = 5
+kControlSummaryEnd = 6
 
 
 class StartRecordData:
@@ -84,6 +88,20 @@ class DataLogRecord:
             and self._getControlType() == kControlSetMetadata
         )
 
+    def isSync(self) -> bool:
+        return (
+            self.entry == 0
+            and len(self.data) == 17
+            and self._getControlType() == kControlSync
+        )
+
+    def isBlock(self) -> bool:
+        return (
+            self.entry == 0
+            and len(self.data) >= 8
+            and self._getControlType() == kControlBlock
+        )
+
     def getStartData(self) -> StartRecordData:
         if not self.isStart():
             raise TypeError("not a start record")
@@ -303,6 +321,19 @@ if __name__ == "__main__":
                         print("...ID not found")
                 except TypeError as e:
                     print("SetMetadata(INVALID)")
+            elif record.isSync():
+                print(f"Sync [{timestamp}]")
+            elif record.isControl() and record._getControlType() == kControlSummary:
+                entry = int.from_bytes(record.data[1:5], byteorder="little")
+                print(f"Summary({entry}) [{timestamp}]")
+            elif (
+                record.isControl()
+                and record._getControlType() == kControlSummaryEnd
+            ):
+                print(f"SummaryEnd [{timestamp}]")
+            elif record.isBlock():
+                entry = int.from_bytes(record.data[1:5], byteorder="little")
+                print(f"Block({entry}) [{timestamp}]")
             elif record.isControl():
                 print("Unrecognized control record")
             else:
@@ -69,6 +69,24 @@ int main(int argc, const char** argv) {
       } else {
         fmt::print("SetMetadata(INVALID)\n");
       }
+    } else if (record.IsSync()) {
+      fmt::print("Sync [{}]\n", record.GetTimestamp() / 1000000.0);
+    } else if (record.IsSummary()) {
+      wpi::log::SummaryRecordData data;
+      if (record.GetSummaryData(&data)) {
+        fmt::print("Summary({}, '{}', '{}', count={}, time={}-{}", data.entry,
+                   data.name, data.type, data.count,
+                   data.firstTimestamp / 1000000.0,
+                   data.lastTimestamp / 1000000.0);
+        if (data.hasValues) {
+          fmt::print(", min={}, max={}, sum={}", data.min, data.max, data.sum);
+        }
+        fmt::print(") [{}]\n", record.GetTimestamp() / 1000000.0);
+      } else {
+        fmt::print("Summary(INVALID)\n");
+      }
+    } else if (record.IsSummaryEnd()) {
+      fmt::print("SummaryEnd [{}]\n", record.GetTimestamp() / 1000000.0);
     } else if (record.IsControl()) {
       fmt::print("Unrecognized control record\n");
     } else {
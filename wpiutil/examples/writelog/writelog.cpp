@@ -6,6 +6,7 @@
 #include <chrono>
 #include <numeric>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "fmt/format.h"
@@ -42,6 +43,22 @@ int main(int argc, char** argv) {
                        }
                      }});
 #endif
+  testVec.push_back({"4 thread 50k double append", [](auto& log) {
+                       std::vector<std::thread> threads;
+                       for (int t = 0; t < 4; ++t) {
+                         threads.emplace_back([&log, t] {
+                           wpi::log::DoubleLogEntry entry{
+                               log, fmt::format("thread{}", t), 1};
+                           for (int i = 0; i < 50000; ++i) {
+                             entry.Append(1.3 * i, 20000 * i);
+                           }
+                         });
+                       }
+                       for (auto&& thr : threads) {
+                         thr.join();
+                       }
+                     }});
+
   testVec.push_back({"50 string append", [](auto& log) {
                        wpi::log::StringLogEntry entry{log, "string", 1};
                        for (int i = 0; i < 50; ++i) {
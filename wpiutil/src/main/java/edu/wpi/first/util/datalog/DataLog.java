@@ -17,10 +17,12 @@ package edu.wpi.first.util.datalog;
  * being made. In fact, finish() does not need to be called at all.
  *
  * <p>DataLog calls are thread safe. DataLog uses a typical multiple-supplier, single-consumer
- * setup. Writes to the log are atomic, but there is no guaranteed order in the log when multiple
- * threads are writing to it; whichever thread grabs the write mutex first will get written first.
- * For this reason (as well as the fact that timestamps can be set to arbitrary values), records in
- * the log are not guaranteed to be sorted by timestamp.
+ * setup. Each thread appends data records to its own buffer, and these buffers are handed to the
+ * writer thread in batches. Writes to the log are atomic, and records appended by a single thread
+ * appear in the log in the order they were appended, but there is no guaranteed order between
+ * records appended concurrently by different threads. For this reason (as well as the fact that
+ * timestamps can be set to arbitrary values), records in the log are not guaranteed to be sorted by
+ * timestamp.
  */
 public final class DataLog implements AutoCloseable {
   /**
@@ -10,6 +10,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <fcntl.h>
+#endif
+
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
@@ -19,52 +23,37 @@
 
 #endif
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <random>
 #include <vector>
 
+#include "DataLogInternal.h"
 #include "fmt/format.h"
+#include "wpi/DataLogReader.h"
 #include "wpi/Endian.h"
 #include "wpi/Logger.h"
 #include "wpi/MathExtras.h"
 #include "wpi/fs.h"
+#include "wpi/spinlock.h"
 #include "wpi/timestamp.h"
 
 using namespace wpi::log;
 
 static constexpr size_t kBlockSize = 16 * 1024;
-static constexpr size_t kRecordMaxHeaderSize = 17;
-
-template <typename T>
-static unsigned int WriteVarInt(uint8_t* buf, T val) {
-  unsigned int len = 0;
-  do {
-    *buf++ = static_cast<unsigned int>(val) & 0xff;
-    ++len;
-    val >>= 8;
-  } while (val != 0);
-  return len;
-}
+using impl::kRecordMaxHeaderSize;
 
-// min size: 4, max size: 17
+// a zero timestamp is replaced with the current time
 static unsigned int WriteRecordHeader(uint8_t* buf, uint32_t entry,
                                       uint64_t timestamp,
                                       uint32_t payloadSize) {
-  uint8_t* origbuf = buf++;
-
-  unsigned int entryLen = WriteVarInt(buf, entry);
-  buf += entryLen;
-  unsigned int payloadLen = WriteVarInt(buf, payloadSize);
-  buf += payloadLen;
-  unsigned int timestampLen =
-      WriteVarInt(buf, timestamp == 0 ? wpi::Now() : timestamp);
-  buf += timestampLen;
-  *origbuf =
-      ((timestampLen - 1) << 4) | ((payloadLen - 1) << 2) | (entryLen - 1);
-  return buf - origbuf;
+  return impl::WriteRecordHeader(
+      buf, entry, timestamp == 0 ? wpi::Now() : timestamp, payloadSize);
 }
 
 class DataLog::Buffer {
@@ -77,10 +66,16 @@ class DataLog::Buffer {
   Buffer& operator=(const Buffer&) = delete;
 
   Buffer(Buffer&& oth)
-      : m_buf{oth.m_buf}, m_len{oth.m_len}, m_maxLen{oth.m_maxLen} {
+      : m_buf{oth.m_buf},
+        m_len{oth.m_len},
+        m_maxLen{oth.m_maxLen},
+        m_recordStart{oth.m_recordStart},
+        m_threadRecords{oth.m_threadRecords} {
     oth.m_buf = nullptr;
     oth.m_len = 0;
     oth.m_maxLen = 0;
+    oth.m_recordStart = false;
+    oth.m_threadRecords = false;
   }
 
   Buffer& operator=(Buffer&& oth) {
@@ -90,9 +85,13 @@ class DataLog::Buffer {
     m_buf = oth.m_buf;
     m_len = oth.m_len;
     m_maxLen = oth.m_maxLen;
+    m_recordStart = oth.m_recordStart;
+    m_threadRecords = oth.m_threadRecords;
     oth.m_buf = nullptr;
     oth.m_len = 0;
     oth.m_maxLen = 0;
+    oth.m_recordStart = false;
+    oth.m_threadRecords = false;
     return *this;
   }
 
@@ -105,7 +104,33 @@ class DataLog::Buffer {
 
   void Unreserve(size_t size) { m_len -= size; }
 
-  void Clear() { m_len = 0; }
+  // reserves space for a complete record; returns pointer to payload
+  uint8_t* ReserveRecord(uint32_t entry, uint64_t timestamp,
+                         uint32_t payloadSize) {
+    if (m_len == 0) {
+      m_recordStart = true;
+    }
+    uint8_t* buf = Reserve(kRecordMaxHeaderSize + payloadSize);
+    auto headerLen = WriteRecordHeader(buf, entry, timestamp, payloadSize);
+    Unreserve(kRecordMaxHeaderSize - headerLen);
+    return buf + headerLen;
+  }
+
+  void Clear() {
+    m_len = 0;
+    m_recordStart = false;
+    m_threadRecords = false;
+  }
+
+  // true if the buffer starts with the start of a record (rather than the
+  // continuation of a record from the previous buffer)
+  bool IsRecordStart() const { return m_recordStart; }
+  void SetRecordStart(bool recordStart = true) { m_recordStart = recordStart; }
+
+  // true if the buffer was filled by a thread (and so only contains complete
+  // data records, which the writer thread may reorder)
+  bool IsThreadRecords() const { return m_threadRecords; }
+  void SetThreadRecords() { m_threadRecords = true; }
 
   size_t GetRemaining() const { return m_maxLen - m_len; }
 
@@ -116,8 +141,174 @@ class DataLog::Buffer {
   uint8_t* m_buf;
   size_t m_len = 0;
   size_t m_maxLen;
+  bool m_recordStart = false;
+  bool m_threadRecords = false;
+};
+
+namespace {
+// Set by the owning thread when it exits, so the writer thread can discard
+// the buffer once it has been sealed
+struct ThreadBufferState {
+  std::atomic_bool exited{false};
+};
+}  // namespace
+
+// Data records are appended to a per-thread buffer.  The spinlock is only
+// contended when the writer thread seals the buffer (takes it for writing).
+class DataLog::ThreadBuffer : public ThreadBufferState {
+ public:
+  explicit ThreadBuffer(std::thread::id id) : id{id} {}
+
+  std::thread::id id;
+  wpi::spinlock mutex;
+  Buffer buf{0};
+};
+
+// Values for block encoded entries are accumulated here until the block is
+// full or the writer thread flushes.  Block record payload format:
+// 1-byte type (kControlBlock)
+// 4-byte entry
+// 1-byte value encoding (impl::BlockEncoding)
+// LEB128 sample count
+// for each sample:
+//   zigzag LEB128 timestamp delta-of-delta (the record timestamp is the first
+//   sample's timestamp, and the initial delta is 0)
+//   value (depending on encoding)
+class DataLog::BlockEncoder {
+ public:
+  static constexpr uint32_t kMaxSamples = 1024;
+  static constexpr size_t kMaxDataSize = 4096;
+  // type, entry, encoding, count, data
+  static constexpr size_t kMaxPayloadSize = 1 + 4 + 1 + 5 + kMaxDataSize + 32;
+
+  explicit BlockEncoder(impl::BlockEncoding encoding) : m_encoding{encoding} {}
+
+  void Add(uint64_t timestamp, uint64_t bits) {
+    if (m_count == 0) {
+      m_firstTimestamp = timestamp;
+      m_prevTimestamp = timestamp;
+      m_prevDelta = 0;
+      m_prevBits = 0;
+    }
+    uint64_t delta = timestamp - m_prevTimestamp;
+    WriteUleb128(ZigZag(delta - m_prevDelta));
+    m_prevTimestamp = timestamp;
+    m_prevDelta = delta;
+
+    if (m_encoding == impl::kBlockInt64) {
+      WriteUleb128(ZigZag(bits - m_prevBits));
+    } else {
+      uint64_t x = bits ^ m_prevBits;
+      if (x == 0) {
+        m_data.push_back(0x80);
+      } else {
+        // high nibble: number of leading zero bytes, low nibble: number of
+        // trailing zero bytes; followed by the remaining bytes, little endian
+        unsigned int lead = std::countl_zero(x) / 8;
+        unsigned int trail = std::countr_zero(x) / 8;
+        m_data.push_back((lead << 4) | trail);
+        x >>= trail * 8;
+        for (unsigned int i = lead + trail; i < 8; ++i) {
+          m_data.push_back(x & 0xff);
+          x >>= 8;
+        }
+      }
+    }
+    m_prevBits = bits;
+    ++m_count;
+  }
+
+  bool IsEmpty() const { return m_count == 0; }
+  bool IsFull() const {
+    return m_count >= kMaxSamples || m_data.size() >= kMaxDataSize;
+  }
+  uint64_t GetFirstTimestamp() const { return m_firstTimestamp; }
+
+  // returns payload size; buf must be at least kMaxPayloadSize
+  size_t GetPayload(int entry, uint8_t* buf) const {
+    uint8_t* origbuf = buf;
+    *buf++ = impl::kControlBlock;
+    wpi::support::endian::write32le(buf, entry);
+    buf += 4;
+    *buf++ = m_encoding;
+    uint32_t count = m_count;
+    do {
+      uint8_t byte = count & 0x7f;
+      count >>= 7;
+      *buf++ = count != 0 ? (byte | 0x80) : byte;
+    } while (count != 0);
+    std::memcpy(buf, m_data.data(), m_data.size());
+    return buf + m_data.size() - origbuf;
+  }
+
+  void Clear() {
+    m_data.clear();
+    m_count = 0;
+  }
+
+ private:
+  static uint64_t ZigZag(uint64_t val) {
+    return (val << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(val) >> 63);
+  }
+
+  void WriteUleb128(uint64_t val) {
+    do {
+      uint8_t byte = val & 0x7f;
+      val >>= 7;
+      m_data.push_back(val != 0 ? (byte | 0x80) : byte);
+    } while (val != 0);
+  }
+
+  impl::BlockEncoding m_encoding;
+  std::vector<uint8_t> m_data;
+  uint32_t m_count = 0;
+  uint64_t m_firstTimestamp = 0;
+  uint64_t m_prevTimestamp = 0;
+  uint64_t m_prevDelta = 0;
+  uint64_t m_prevBits = 0;
 };
 
+static std::atomic<uint64_t> gInstanceCount{0};
+
+namespace {
+struct ThreadBufferCache {
+  static constexpr size_t kSize = 4;
+
+  ~ThreadBufferCache() {
+    for (auto&& state : owned) {
+      state->exited.store(true, std::memory_order_release);
+    }
+  }
+
+  void* Find(uint64_t instance) const {
+    for (auto&& cached : entries) {
+      if (cached.instance == instance) {
+        return cached.tb;
+      }
+    }
+    return nullptr;
+  }
+
+  void Insert(uint64_t instance, void* tb) {
+    entries[next] = {instance, tb};
+    next = (next + 1) % kSize;
+  }
+
+  // the buffers of the most recently used instances (instance numbers start
+  // at 1, so empty slots never match)
+  struct Entry {
+    uint64_t instance = 0;
+    void* tb = nullptr;
+  };
+  Entry entries[kSize];
+  size_t next = 0;
+  // buffers created by this thread (for any instance)
+  std::vector<std::shared_ptr<ThreadBufferState>> owned;
+};
+}  // namespace
+
+static thread_local ThreadBufferCache gThreadBufferCache;
+
 static void DefaultLog(unsigned int level, const char* file, unsigned int line,
                        const char* msg) {
   if (level > wpi::WPI_LOG_INFO) {
@@ -140,6 +331,7 @@ DataLog::DataLog(wpi::Logger& msglog, std::string_view dir,
       m_period{period},
       m_extraHeader{extraHeader},
       m_newFilename{filename},
+      m_instance{++gInstanceCount},
       m_thread{[this, dir = std::string{dir}] { WriterThreadMain(dir); }} {}
 
 DataLog::DataLog(std::function<void(std::span<const uint8_t> data)> write,
@@ -152,6 +344,7 @@ DataLog::DataLog(wpi::Logger& msglog,
     : m_msglog{msglog},
       m_period{period},
       m_extraHeader{extraHeader},
+      m_instance{++gInstanceCount},
       m_thread{[this, write = std::move(write)] {
         WriterThreadMain(std::move(write));
       }} {}
@@ -163,6 +356,7 @@ DataLog::~DataLog() {
     m_doFlush = true;
   }
   m_cond.notify_all();
+  m_bufferCond.notify_all();
   m_thread.join();
 }
 
@@ -174,6 +368,15 @@ void DataLog::SetFilename(std::string_view filename) {
   m_cond.notify_all();
 }
 
+void DataLog::SetRotation(uint64_t maxBytes, double maxTime) {
+  {
+    std::scoped_lock lock{m_mutex};
+    m_rotateBytes = maxBytes;
+    m_rotateTime = maxTime;
+  }
+  m_cond.notify_all();
+}
+
 void DataLog::Flush() {
   {
     std::scoped_lock lock{m_mutex};
@@ -183,15 +386,114 @@ void DataLog::Flush() {
 }
 
 void DataLog::Pause() {
-  std::scoped_lock lock{m_mutex};
   m_paused = true;
 }
 
 void DataLog::Resume() {
-  std::scoped_lock lock{m_mutex};
   m_paused = false;
 }
 
+void DataLog::SetBufferLimit(size_t maxBytes, OverflowPolicy policy) {
+  std::scoped_lock lock{m_mutex};
+  m_maxBuffers =
+      maxBytes == 0 ? 0 : std::max<size_t>(maxBytes / kBlockSize, 1);
+  m_overflowPolicy = policy;
+  if (m_maxBuffers != 0 && policy == OverflowPolicy::kDropLowPriority) {
+    m_priorityThreshold = m_maxBuffers / 2;
+  } else {
+    m_priorityThreshold = SIZE_MAX;
+  }
+  m_bufferCond.notify_all();
+}
+
+void DataLog::SetPriority(int entry, int priority) {
+  if (entry <= 0) {
+    return;
+  }
+  std::scoped_lock lock{m_mutex};
+  m_entryPriorities[entry] = priority;
+}
+
+uint64_t DataLog::GetDroppedRecords() const {
+  std::scoped_lock lock{m_mutex};
+  return m_droppedRecords;
+}
+
+uint64_t DataLog::GetDroppedBytes() const {
+  std::scoped_lock lock{m_mutex};
+  return m_droppedBytes;
+}
+
+void DataLog::SetWritePolicy(int entry, const WritePolicy& policy) {
+  if (entry <= 0) {
+    return;
+  }
+  std::scoped_lock lock{m_mutex};
+  auto it = m_writePolicies.find(entry);
+  if (it != m_writePolicies.end() && it->second.held) {
+    WriteHeld(entry, it->second);
+  }
+  if (policy.minPeriod <= 0 && policy.deadband < 0) {
+    if (it != m_writePolicies.end()) {
+      m_writePolicies.erase(it);
+      m_writePolicyEntries.Erase(entry);
+    }
+    return;
+  }
+  if (it == m_writePolicies.end()) {
+    it = m_writePolicies.try_emplace(entry).first;
+    m_writePolicyEntries.Insert(entry);
+  }
+  auto& state = it->second;
+  state.minPeriod = static_cast<int64_t>(policy.minPeriod * 1000000);
+  state.deadband = policy.deadband;
+  state.latest = policy.latest;
+}
+
+uint64_t DataLog::GetSuppressedCount(int entry) const {
+  std::scoped_lock lock{m_mutex};
+  auto it = m_writePolicies.find(entry);
+  return it != m_writePolicies.end() ? it->second.suppressed : 0;
+}
+
+void DataLog::SetBlockEncoding(int entry, bool enable) {
+  if (entry <= 0) {
+    return;
+  }
+  std::scoped_lock lock{m_mutex};
+  auto it = m_blockEncoders.find(entry);
+  if (!enable) {
+    if (it == m_blockEncoders.end()) {
+      return;
+    }
+    WriteBlock(entry, *it->second);
+    m_blockEncoders.erase(it);
+    m_blockEntries.Erase(entry);
+    return;
+  }
+  if (it != m_blockEncoders.end()) {
+    return;
+  }
+
+  impl::BlockEncoding encoding;
+  auto entryInfo = std::find_if(m_entries.begin(), m_entries.end(),
+                                [&](auto& e) { return e.second.id == entry; });
+  if (entryInfo == m_entries.end()) {
+    return;
+  }
+  if (entryInfo->second.type == "int64") {
+    encoding = impl::kBlockInt64;
+  } else if (entryInfo->second.type == "double") {
+    encoding = impl::kBlockDouble;
+  } else {
+    WPI_WARNING(m_msglog, "cannot block encode '{}' of type '{}'",
+                entryInfo->first(), entryInfo->second.type);
+    return;
+  }
+  m_blockEncoders[entry] = std::make_unique<BlockEncoder>(encoding);
+  m_blockEntries.Insert(entry);
+}
+
 static void WriteToFile(fs::file_t f, std::span<const uint8_t> data,
                         std::string_view filename, wpi::Logger& msglog) {
   do {
@@ -222,6 +524,385 @@ static void WriteToFile(fs::file_t f, std::span<const uint8_t> data,
   } while (data.size() > 0);
 }
 
+namespace {
+// Sync records are inserted by the writer thread at most once per interval,
+// at the start of a buffer that begins with a record (so they always land on
+// a record boundary).  Readers use them to split the log into chunks.
+struct SyncState {
+  explicit SyncState(uint64_t offset) : offset{offset}, lastSync{offset} {}
+
+  template <typename Buffers, typename F>
+  void WriteBuffers(Buffers& bufs, F&& write);
+
+  uint64_t offset;
+  uint64_t lastSync;
+};
+}  // namespace
+
+template <typename Buffers, typename F>
+void SyncState::WriteBuffers(Buffers& bufs, F&& write) {
+  bool first = true;
+  for (auto&& buf : bufs) {
+    auto data = buf.GetData();
+    if (data.empty()) {
+      continue;
+    }
+    // the first buffer in a batch always starts with a record
+    if ((first || buf.IsRecordStart()) &&
+        (offset - lastSync) >= impl::kSyncInterval) {
+      uint8_t sync[impl::kSyncRecordMaxSize];
+      size_t len = impl::WriteSyncRecord(sync, wpi::Now(), offset);
+      write(std::span<const uint8_t>{sync, len});
+      lastSync = offset;
+      offset += len;
+    }
+    first = false;
+    write(std::span<const uint8_t>{data});
+    offset += data.size();
+  }
+}
+
+namespace {
+// Records appended by different threads land in different buffers, so the
+// writer thread merges each run of consecutive thread buffers by timestamp
+// before writing it.  Other records (e.g. control records) seal all of the
+// thread buffers first, so they act as barriers and are never reordered.
+class ThreadRecordMerger {
+ public:
+  template <typename Buffers>
+  void Merge(Buffers& bufs);
+
+ private:
+  struct Record {
+    uint64_t timestamp;
+    const uint8_t* data;
+    size_t size;
+  };
+
+  template <typename It>
+  void MergeRun(It begin, It end);
+
+  static uint64_t ReadVarInt(const uint8_t* buf, unsigned int len) {
+    uint64_t val = 0;
+    for (unsigned int i = 0; i < len; ++i) {
+      val |= static_cast<uint64_t>(buf[i]) << (i * 8);
+    }
+    return val;
+  }
+
+  std::vector<Record> m_records;
+  std::vector<uint8_t> m_merged;
+};
+}  // namespace
+
+template <typename Buffers>
+void ThreadRecordMerger::Merge(Buffers& bufs) {
+  auto it = bufs.begin();
+  while (it != bufs.end()) {
+    if (!it->IsThreadRecords()) {
+      ++it;
+      continue;
+    }
+    auto end = std::find_if(it, bufs.end(),
+                            [](auto&& buf) { return !buf.IsThreadRecords(); });
+    MergeRun(it, end);
+    it = end;
+  }
+}
+
+template <typename It>
+void ThreadRecordMerger::MergeRun(It begin, It end) {
+  m_records.clear();
+  bool sorted = true;
+  for (auto it = begin; it != end; ++it) {
+    auto data = it->GetData();
+    size_t pos = 0;
+    while (pos < data.size()) {
+      const uint8_t* buf = data.data() + pos;
+      unsigned int entryLen = (buf[0] & 0x3) + 1;
+      unsigned int sizeLen = ((buf[0] >> 2) & 0x3) + 1;
+      unsigned int timestampLen = ((buf[0] >> 4) & 0x7) + 1;
+      size_t headerLen = 1 + entryLen + sizeLen + timestampLen;
+      size_t size = headerLen + ReadVarInt(buf + 1 + entryLen, sizeLen);
+      uint64_t timestamp =
+          ReadVarInt(buf + 1 + entryLen + sizeLen, timestampLen);
+      if (!m_records.empty() && timestamp < m_records.back().timestamp) {
+        sorted = false;
+      }
+      m_records.emplace_back(Record{timestamp, buf, size});
+      pos += size;
+    }
+  }
+  // the common case (a single appending thread)
+  if (sorted) {
+    return;
+  }
+
+  // records with equal timestamps keep their append order
+  std::stable_sort(
+      m_records.begin(), m_records.end(),
+      [](const auto& a, const auto& b) { return a.timestamp < b.timestamp; });
+  m_merged.clear();
+  for (auto&& record : m_records) {
+    m_merged.insert(m_merged.end(), record.data, record.data + record.size);
+  }
+
+  // copy back, keeping the buffer sizes; records may now span buffers
+  size_t offset = 0;
+  auto record = m_records.begin();
+  size_t recordOffset = 0;
+  for (auto it = begin; it != end; ++it) {
+    auto data = it->GetData();
+    while (recordOffset < offset) {
+      recordOffset += record->size;
+      ++record;
+    }
+    it->SetRecordStart(recordOffset == offset);
+    std::memcpy(data.data(), m_merged.data() + offset, data.size());
+    offset += data.size();
+  }
+}
+
+namespace {
+// Keeps per-entry statistics for the summary records.  The writer thread
+// feeds this all of the data it writes (in order), so appenders don't pay
+// anything for it; records may be split across multiple calls to Add().
+class SummaryCollector {
+ public:
+  void Add(std::span<const uint8_t> data);
+
+  // forgets finished entries and resets statistics (e.g. for a new file)
+  void Reset();
+
+  // summary records for all entries, followed by a summary end record;
+  // offset is the file offset at which the data will be written
+  std::vector<uint8_t> MakeSummary(uint64_t offset) const;
+
+ private:
+  struct EntryStats {
+    std::string name;
+    std::string type;
+    std::string metadata;
+    bool active = true;
+    uint64_t count = 0;
+    int64_t firstTimestamp = 0;
+    int64_t lastTimestamp = 0;
+    bool hasValues = false;
+    double min = 0;
+    double max = 0;
+    double sum = 0;
+  };
+
+  void AddRecord(int entry, int64_t timestamp, std::span<const uint8_t> data);
+  void AddValue(EntryStats& stats, int64_t timestamp,
+                std::span<const uint8_t> data);
+
+  wpi::DenseMap<int, EntryStats> m_entries;
+  // the summary records use the latest timestamp seen so they don't extend
+  // the time range of the log
+  int64_t m_maxTimestamp = 0;
+
+  // partial record state
+  uint8_t m_header[kRecordMaxHeaderSize];
+  size_t m_headerLen = 0;
+  size_t m_headerSize = 0;
+  int m_entry = 0;
+  int64_t m_timestamp = 0;
+  uint32_t m_remaining = 0;
+  bool m_collect = false;
+  std::vector<uint8_t> m_payload;
+};
+}  // namespace
+
+static uint64_t ReadVarInt(const uint8_t* buf, unsigned int len) {
+  uint64_t val = 0;
+  for (unsigned int i = 0; i < len; ++i) {
+    val |= static_cast<uint64_t>(buf[i]) << (8 * i);
+  }
+  return val;
+}
+
+void SummaryCollector::Add(std::span<const uint8_t> data) {
+  while (!data.empty()) {
+    if (m_headerSize == 0 || m_headerLen < m_headerSize) {
+      // header
+      if (m_headerLen == 0) {
+        m_headerSize = 1 + (data[0] & 0x3) + 1 + ((data[0] >> 2) & 0x3) + 1 +
+                       ((data[0] >> 4) & 0x7) + 1;
+      }
+      size_t len = (std::min)(m_headerSize - m_headerLen, data.size());
+      std::memcpy(m_header + m_headerLen, data.data(), len);
+      m_headerLen += len;
+      data = data.subspan(len);
+      if (m_headerLen < m_headerSize) {
+        return;
+      }
+      unsigned int entryLen = (m_header[0] & 0x3) + 1;
+      unsigned int sizeLen = ((m_header[0] >> 2) & 0x3) + 1;
+      unsigned int timestampLen = ((m_header[0] >> 4) & 0x7) + 1;
+      m_entry = ReadVarInt(m_header + 1, entryLen);
+      m_remaining = ReadVarInt(m_header + 1 + entryLen, sizeLen);
+      m_timestamp = ReadVarInt(m_header + 1 + entryLen + sizeLen, timestampLen);
+      m_maxTimestamp = (std::max)(m_maxTimestamp, m_timestamp);
+      // only the payload of control records and scalar values is needed
+      m_collect = m_entry == 0 || m_remaining <= 8;
+      m_payload.clear();
+    }
+
+    size_t len = (std::min<size_t>)(m_remaining, data.size());
+    if (m_collect) {
+      m_payload.insert(m_payload.end(), data.begin(), data.begin() + len);
+    }
+    m_remaining -= len;
+    data = data.subspan(len);
+    if (m_remaining == 0) {
+      AddRecord(m_entry, m_timestamp, m_payload);
+      m_headerLen = 0;
+      m_headerSize = 0;
+    }
+  }
+}
+
+void SummaryCollector::AddRecord(int entry, int64_t timestamp,
+                                 std::span<const uint8_t> data) {
+  if (entry != 0) {
+    auto it = m_entries.find(entry);
+    if (it != m_entries.end()) {
+      // data is empty if the payload was not collected
+      AddValue(it->second, timestamp, data);
+    }
+    return;
+  }
+
+  DataLogRecord record{0, timestamp, data};
+  StartRecordData start;
+  MetadataRecordData metadata;
+  int finishEntry;
+  impl::DecodedBlock block;
+  if (record.GetStartData(&start)) {
+    auto& stats = m_entries[start.entry];
+    stats.name = start.name;
+    stats.type = start.type;
+    stats.metadata = start.metadata;
+    stats.active = true;
+  } else if (record.GetFinishEntry(&finishEntry)) {
+    if (auto it = m_entries.find(finishEntry); it != m_entries.end()) {
+      it->second.active = false;
+    }
+  } else if (record.GetSetMetadataData(&metadata)) {
+    if (auto it = m_entries.find(metadata.entry); it != m_entries.end()) {
+      it->second.metadata = metadata.metadata;
+    }
+  } else if (record.IsBlock() && impl::DecodeBlock(record, &block)) {
+    if (auto it = m_entries.find(block.entry); it != m_entries.end()) {
+      for (size_t i = 0; i < block.timestamps.size(); ++i) {
+        AddValue(it->second, block.timestamps[i],
+                 std::span{block.values}.subspan(i * 8, 8));
+      }
+    }
+  }
+}
+
+void SummaryCollector::AddValue(EntryStats& stats, int64_t timestamp,
+                                std::span<const uint8_t> data) {
+  if (stats.count == 0) {
+    stats.firstTimestamp = timestamp;
+    stats.lastTimestamp = timestamp;
+  } else {
+    stats.firstTimestamp = (std::min)(stats.firstTimestamp, timestamp);
+    stats.lastTimestamp = (std::max)(stats.lastTimestamp, timestamp);
+  }
+  ++stats.count;
+
+  double value;
+  if (stats.type == "double" && data.size() == 8) {
+    value = wpi::BitsToDouble(wpi::support::endian::read64le(data.data()));
+  } else if (stats.type == "int64" && data.size() == 8) {
+    value = static_cast<int64_t>(wpi::support::endian::read64le(data.data()));
+  } else if (stats.type == "float" && data.size() == 4) {
+    value = wpi::BitsToFloat(wpi::support::endian::read32le(data.data()));
+  } else if (stats.type == "boolean" && data.size() == 1) {
+    value = data[0] != 0 ? 1 : 0;
+  } else {
+    return;
+  }
+  if (!stats.hasValues) {
+    stats.hasValues = true;
+    stats.min = value;
+    stats.max = value;
+  } else {
+    stats.min = (std::min)(stats.min, value);
+    stats.max = (std::max)(stats.max, value);
+  }
+  stats.sum += value;
+}
+
+void SummaryCollector::Reset() {
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    if (!it->second.active) {
+      m_entries.erase(it++);
+    } else {
+      it->second = EntryStats{std::move(it->second.name),
+                              std::move(it->second.type),
+                              std::move(it->second.metadata)};
+      ++it;
+    }
+  }
+}
+
+std::vector<uint8_t> SummaryCollector::MakeSummary(uint64_t offset) const {
+  // sort by entry ID
+  std::vector<std::pair<int, const EntryStats*>> entries;
+  entries.reserve(m_entries.size());
+  for (auto&& [entry, stats] : m_entries) {
+    entries.emplace_back(entry, &stats);
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](auto& a, auto& b) { return a.first < b.first; });
+
+  std::vector<uint8_t> out;
+  for (auto&& [entry, stats] : entries) {
+    uint32_t payloadSize = 1 + 4 + 8 + 8 + 8 + 1 + 8 + 8 + 8 + 12 +
+                           stats->name.size() + stats->type.size() +
+                           stats->metadata.size();
+    size_t pos = out.size();
+    out.resize(pos + kRecordMaxHeaderSize + payloadSize);
+    uint8_t* buf = out.data() + pos;
+    buf += WriteRecordHeader(buf, 0, m_maxTimestamp, payloadSize);
+    *buf++ = impl::kControlSummary;
+    wpi::support::endian::write32le(buf, entry);
+    wpi::support::endian::write64le(buf + 4, stats->count);
+    wpi::support::endian::write64le(buf + 12, stats->firstTimestamp);
+    wpi::support::endian::write64le(buf + 20, stats->lastTimestamp);
+    buf[28] = stats->hasValues ? impl::kSummaryHasValues : 0;
+    wpi::support::endian::write64le(buf + 29, wpi::DoubleToBits(stats->min));
+    wpi::support::endian::write64le(buf + 37, wpi::DoubleToBits(stats->max));
+    wpi::support::endian::write64le(buf + 45, wpi::DoubleToBits(stats->sum));
+    buf += 53;
+    for (std::string_view str : {stats->name, stats->type, stats->metadata}) {
+      wpi::support::endian::write32le(buf, str.size());
+      buf += 4;
+      std::memcpy(buf, str.data(), str.size());
+      buf += str.size();
+    }
+    out.resize(buf - out.data());
+  }
+
+  // summary end record, pointing to the first summary record
+  size_t pos = out.size();
+  out.resize(pos + kRecordMaxHeaderSize + impl::kSummaryEndPayloadSize);
+  uint8_t* buf = out.data() + pos;
+  buf += WriteRecordHeader(buf, 0, m_maxTimestamp,
+                           impl::kSummaryEndPayloadSize);
+  *buf++ = impl::kControlSummaryEnd;
+  std::memcpy(buf, impl::kSummaryMagic.data(), impl::kSummaryMagic.size());
+  buf += impl::kSummaryMagic.size();
+  wpi::support::endian::write64le(buf, offset);
+  buf += 8;
+  out.resize(buf - out.data());
+  return out;
+}
+
 static std::string MakeRandomFilename() {
   // build random filename
   static std::random_device dev;
@@ -236,45 +917,78 @@ static std::string MakeRandomFilename() {
   return filename;
 }
 
-void DataLog::WriterThreadMain(std::string_view dir) {
-  std::chrono::duration<double> periodTime{m_period};
-
-  std::error_code ec;
-  fs::path dirPath{dir};
-  std::string filename;
-
-  {
-    std::scoped_lock lock{m_mutex};
-    filename = std::move(m_newFilename);
-    m_newFilename.clear();
-  }
-
-  if (filename.empty()) {
-    filename = MakeRandomFilename();
-  }
+static std::string MakeRotatedFilename(std::string_view base,
+                                       unsigned int index) {
+  fs::path path{base};
+  return fmt::format("{}_{}{}", path.stem().string(), index,
+                     path.extension().string());
+}
 
+static fs::file_t OpenLogFile(const fs::path& dirPath, std::string* filename,
+                              wpi::Logger& msglog) {
   // try preferred filename, or randomize it a few times, before giving up
-  fs::file_t f;
+  std::error_code ec;
+  fs::file_t f = fs::kInvalidFile;
   for (int i = 0; i < 5; ++i) {
     // open file for append
 #ifdef _WIN32
     // WIN32 doesn't allow combination of CreateNew and Append
-    f = fs::OpenFileForWrite(dirPath / filename, ec, fs::CD_CreateNew,
+    f = fs::OpenFileForWrite(dirPath / *filename, ec, fs::CD_CreateNew,
                              fs::OF_None);
 #else
-    f = fs::OpenFileForWrite(dirPath / filename, ec, fs::CD_CreateNew,
+    f = fs::OpenFileForWrite(dirPath / *filename, ec, fs::CD_CreateNew,
                              fs::OF_Append);
 #endif
     if (ec) {
-      WPI_ERROR(m_msglog, "Could not open log file '{}': {}",
-                (dirPath / filename).string(), ec.message());
+      WPI_ERROR(msglog, "Could not open log file '{}': {}",
+                (dirPath / *filename).string(), ec.message());
       // try again with random filename
-      filename = MakeRandomFilename();
+      *filename = MakeRandomFilename();
     } else {
       break;
     }
   }
+  return f;
+}
+
+// Allocates space for the file without changing its size, so later appends
+// don't need to allocate blocks.  Returns false if not supported.
+static bool PreallocateFile(fs::file_t f, uint64_t size) {
+#ifdef __linux__
+  return size != 0 && ::fallocate(f, FALLOC_FL_KEEP_SIZE, 0, size) == 0;
+#else
+  return false;
+#endif
+}
+
+static void CloseLogFile(fs::file_t f, uint64_t size, bool preallocated) {
+#ifndef _WIN32
+  if (preallocated) {
+    // release any preallocated space past the end of the data
+    [[maybe_unused]] int rv = ::ftruncate(f, size);
+  }
+#endif
+  fs::CloseFile(f);
+}
+
+void DataLog::WriterThreadMain(std::string_view dir) {
+  std::chrono::duration<double> periodTime{m_period};
+
+  std::error_code ec;
+  fs::path dirPath{dir};
+  std::string filename;
+
+  {
+    std::scoped_lock lock{m_mutex};
+    filename = std::move(m_newFilename);
+    m_newFilename.clear();
+  }
 
+  if (filename.empty()) {
+    filename = MakeRandomFilename();
+  }
+
+  fs::file_t f = OpenLogFile(dirPath, &filename, m_msglog);
   if (f == fs::kInvalidFile) {
     WPI_ERROR(m_msglog, "Could not open log file, no log being saved");
   } else {
@@ -282,7 +996,7 @@ void DataLog::WriterThreadMain(std::string_view dir) {
   }
 
   // write header (version 1.0)
-  if (f != fs::kInvalidFile) {
+  auto writeHeader = [&](fs::file_t f, std::string_view filename) {
     const uint8_t header[] = {'W', 'P', 'I', 'L', 'O', 'G', 0, 1};
     WriteToFile(f, header, filename, m_msglog);
     uint8_t extraLen[4];
@@ -294,16 +1008,46 @@ void DataLog::WriterThreadMain(std::string_view dir) {
                    m_extraHeader.size()},
                   filename, m_msglog);
     }
+  };
+  SyncState sync{12 + m_extraHeader.size()};
+  if (f != fs::kInvalidFile) {
+    writeHeader(f, filename);
   }
 
+  // log rotation state; the next file is opened ahead of time (when the
+  // current file is half full or half its maximum age)
+  std::string baseFilename = filename;
+  unsigned int rotateIndex = 1;
+  auto fileStart = std::chrono::steady_clock::now();
+  bool preallocated = false;
+  fs::file_t nextFile = fs::kInvalidFile;
+  std::string nextFilename;
+  bool nextPreallocated = false;
+  std::vector<uint8_t> startRecords;
+
+  SummaryCollector summary;
+  ThreadRecordMerger merger;
+  auto writeSummary = [&] {
+    auto data = summary.MakeSummary(sync.offset);
+    WriteToFile(f, data, filename, m_msglog);
+    sync.offset += data.size();
+  };
+
   std::vector<Buffer> toWrite;
 
   std::unique_lock lock{m_mutex};
-  while (m_active) {
+  bool active = true;
+  while (active) {
     bool doFlush = false;
-    auto timeoutTime = std::chrono::steady_clock::now() + periodTime;
-    if (m_cond.wait_until(lock, timeoutTime) == std::cv_status::timeout) {
+    if (!m_active) {
+      // do a final flush before exiting
+      active = false;
       doFlush = true;
+    } else {
+      auto timeoutTime = std::chrono::steady_clock::now() + periodTime;
+      if (m_cond.wait_until(lock, timeoutTime) == std::cv_status::timeout) {
+        doFlush = true;
+      }
     }
 
     if (!m_newFilename.empty()) {
@@ -322,23 +1066,64 @@ void DataLog::WriterThreadMain(std::string_view dir) {
                  newFilename);
       }
       filename = std::move(newFilename);
+      baseFilename = filename;
+      // the next file (if already open) follows the new name
+      if (nextFile != fs::kInvalidFile) {
+        auto name = MakeRotatedFilename(baseFilename, rotateIndex);
+        fs::rename(dirPath / nextFilename, dirPath / name, ec);
+        if (!ec) {
+          nextFilename = std::move(name);
+        }
+      }
       lock.lock();
     }
 
     if (doFlush || m_doFlush) {
       // flush to file
       m_doFlush = false;
-      if (m_outgoing.empty()) {
+      LogDropped(lock);
+      WriteHeldValues(!active);
+      WriteBlocks();
+      SealThreadBuffers();
+      // an idle log still rotates when it reaches its age limit
+      if (m_outgoing.empty() &&
+          (f == fs::kInvalidFile || m_rotateTime == 0 ||
+           (std::chrono::steady_clock::now() - fileStart) <
+               std::chrono::duration<double>{m_rotateTime})) {
         continue;
       }
       // swap outgoing with empty vector
       toWrite.swap(m_outgoing);
 
+      // check for rotation after this batch; the start records must reflect
+      // the state at the end of the batch, so generate them now
+      uint64_t rotateBytes = m_rotateBytes;
+      std::chrono::duration<double> rotateTime{m_rotateTime};
+      bool rotating = f != fs::kInvalidFile &&
+                      (rotateBytes != 0 || rotateTime.count() != 0);
+      bool rotate = false;
+      auto now = std::chrono::steady_clock::now();
+      if (rotating) {
+        uint64_t size = sync.offset;
+        for (auto&& buf : toWrite) {
+          size += buf.GetData().size();
+        }
+        rotate = (rotateBytes != 0 && size >= rotateBytes) ||
+                 (rotateTime.count() != 0 && (now - fileStart) >= rotateTime);
+        if (rotate) {
+          startRecords = MakeActiveStartRecords();
+        }
+      }
+
       if (f != fs::kInvalidFile) {
         lock.unlock();
+        merger.Merge(toWrite);
         // write buffers to file
+        sync.WriteBuffers(toWrite, [&](std::span<const uint8_t> data) {
+          WriteToFile(f, data, filename, m_msglog);
+        });
         for (auto&& buf : toWrite) {
-          WriteToFile(f, buf.GetData(), filename, m_msglog);
+          summary.Add(buf.GetData());
         }
 
         // sync to storage
@@ -347,20 +1132,56 @@ void DataLog::WriterThreadMain(std::string_view dir) {
 #elif defined(__APPLE__)
         ::fsync(f);
 #endif
+
+        // open the next file ahead of time
+        if (rotating && nextFile == fs::kInvalidFile &&
+            (rotate || (rotateBytes != 0 && sync.offset >= rotateBytes / 2) ||
+             (rotateTime.count() != 0 &&
+              (now - fileStart) >= rotateTime / 2))) {
+          nextFilename = MakeRotatedFilename(baseFilename, rotateIndex);
+          nextFile = OpenLogFile(dirPath, &nextFilename, m_msglog);
+          if (nextFile != fs::kInvalidFile) {
+            // without a size limit, expect the file to end up about twice
+            // as large as at half its maximum age
+            nextPreallocated = PreallocateFile(
+                nextFile, rotateBytes != 0 ? rotateBytes : sync.offset * 2);
+          }
+        }
+
+        if (rotate && nextFile != fs::kInvalidFile) {
+          writeSummary();
+          CloseLogFile(f, sync.offset, preallocated);
+          WPI_INFO(m_msglog, "Rotated log file from '{}' to '{}'", filename,
+                   nextFilename);
+          f = nextFile;
+          filename = std::move(nextFilename);
+          preallocated = nextPreallocated;
+          nextFile = fs::kInvalidFile;
+          ++rotateIndex;
+          fileStart = now;
+
+          sync = SyncState{12 + m_extraHeader.size()};
+          writeHeader(f, filename);
+          WriteToFile(f, startRecords, filename, m_msglog);
+          sync.offset += startRecords.size();
+          summary.Reset();
+          summary.Add(startRecords);
+        }
         lock.lock();
       }
 
-      // release buffers back to free list
-      for (auto&& buf : toWrite) {
-        buf.Clear();
-        m_free.emplace_back(std::move(buf));
-      }
-      toWrite.resize(0);
+      ReleaseBuffers(toWrite);
     }
   }
 
   if (f != fs::kInvalidFile) {
-    fs::CloseFile(f);
+    writeSummary();
+    CloseLogFile(f, sync.offset, preallocated);
+  }
+  // remove unused next file
+  if (nextFile != fs::kInvalidFile) {
+    fs::CloseFile(nextFile);
+    fs::remove(dirPath / nextFilename, ec);
   }
 }
 
@@ -369,6 +1190,7 @@ void DataLog::WriterThreadMain(
   std::chrono::duration<double> periodTime{m_period};
 
   // write header (version 1.0)
+  SyncState sync{12 + m_extraHeader.size()};
   {
     const uint8_t header[] = {'W', 'P', 'I', 'L', 'O', 'G', 0, 1};
     write(header);
@@ -381,19 +1203,32 @@ void DataLog::WriterThreadMain(
     }
   }
 
+  SummaryCollector summary;
+  ThreadRecordMerger merger;
   std::vector<Buffer> toWrite;
 
   std::unique_lock lock{m_mutex};
-  while (m_active) {
+  bool active = true;
+  while (active) {
     bool doFlush = false;
-    auto timeoutTime = std::chrono::steady_clock::now() + periodTime;
-    if (m_cond.wait_until(lock, timeoutTime) == std::cv_status::timeout) {
+    if (!m_active) {
+      // do a final flush before exiting
+      active = false;
       doFlush = true;
+    } else {
+      auto timeoutTime = std::chrono::steady_clock::now() + periodTime;
+      if (m_cond.wait_until(lock, timeoutTime) == std::cv_status::timeout) {
+        doFlush = true;
+      }
     }
 
     if (doFlush || m_doFlush) {
       // flush to file
       m_doFlush = false;
+      LogDropped(lock);
+      WriteHeldValues(!active);
+      WriteBlocks();
+      SealThreadBuffers();
       if (m_outgoing.empty()) {
         continue;
       }
@@ -401,23 +1236,19 @@ void DataLog::WriterThreadMain(
       toWrite.swap(m_outgoing);
 
       lock.unlock();
+      merger.Merge(toWrite);
       // write buffers
+      sync.WriteBuffers(toWrite, write);
       for (auto&& buf : toWrite) {
-        if (!buf.GetData().empty()) {
-          write(buf.GetData());
-        }
+        summary.Add(buf.GetData());
       }
       lock.lock();
 
-      // release buffers back to free list
-      for (auto&& buf : toWrite) {
-        buf.Clear();
-        m_free.emplace_back(std::move(buf));
-      }
-      toWrite.resize(0);
+      ReleaseBuffers(toWrite);
     }
   }
 
+  write(summary.MakeSummary(sync.offset));
   write({});  // indicate EOF
 }
 
@@ -445,6 +1276,7 @@ int DataLog::Start(std::string_view name, std::string_view type,
     return entryInfo.id;
   }
   entryInfo.type = type;
+  m_entryMetadata[entryInfo.id] = metadata;
   size_t strsize = name.size() + type.size() + metadata.size();
   uint8_t* buf = StartRecord(0, timestamp, 5 + 12 + strsize, 5);
   *buf++ = impl::kControlStart;
@@ -470,6 +1302,20 @@ void DataLog::Finish(int entry, int64_t timestamp) {
     return;
   }
   m_entryCounts.erase(entry);
+  m_entryPriorities.erase(entry);
+  m_entryMetadata.erase(entry);
+  if (auto it = m_writePolicies.find(entry); it != m_writePolicies.end()) {
+    if (it->second.held) {
+      WriteHeld(entry, it->second);
+    }
+    m_writePolicies.erase(it);
+    m_writePolicyEntries.Erase(entry);
+  }
+  if (auto it = m_blockEncoders.find(entry); it != m_blockEncoders.end()) {
+    WriteBlock(entry, *it->second);
+    m_blockEncoders.erase(it);
+    m_blockEntries.Erase(entry);
+  }
   uint8_t* buf = StartRecord(0, timestamp, 5, 5);
   *buf++ = impl::kControlFinish;
   wpi::support::endian::write32le(buf, entry);
@@ -481,28 +1327,358 @@ void DataLog::SetMetadata(int entry, std::string_view metadata,
     return;
   }
   std::scoped_lock lock{m_mutex};
+  if (auto it = m_entryMetadata.find(entry); it != m_entryMetadata.end()) {
+    it->second = metadata;
+  }
   uint8_t* buf = StartRecord(0, timestamp, 5 + 4 + metadata.size(), 5);
   *buf++ = impl::kControlSetMetadata;
   wpi::support::endian::write32le(buf, entry);
   AppendStringImpl(metadata);
 }
 
-uint8_t* DataLog::Reserve(size_t size) {
-  assert(size <= kBlockSize);
-  if (m_outgoing.empty() || size > m_outgoing.back().GetRemaining()) {
-    if (m_free.empty()) {
-      m_outgoing.emplace_back();
+std::vector<uint8_t> DataLog::MakeActiveStartRecords() const {
+  std::vector<uint8_t> out;
+  for (auto&& entry : m_entries) {
+    int id = entry.second.id;
+    auto countIt = m_entryCounts.find(id);
+    if (countIt == m_entryCounts.end() || countIt->second == 0) {
+      continue;
+    }
+    std::string_view metadata;
+    if (auto it = m_entryMetadata.find(id); it != m_entryMetadata.end()) {
+      metadata = it->second;
+    }
+    std::string_view strs[] = {entry.first(), entry.second.type, metadata};
+    uint32_t payloadSize = 5;
+    for (auto str : strs) {
+      payloadSize += 4 + str.size();
+    }
+
+    size_t pos = out.size();
+    out.resize(pos + kRecordMaxHeaderSize + payloadSize);
+    uint8_t* buf = out.data() + pos;
+    buf += WriteRecordHeader(buf, 0, 0, payloadSize);
+    *buf++ = impl::kControlStart;
+    wpi::support::endian::write32le(buf, id);
+    buf += 4;
+    for (auto str : strs) {
+      wpi::support::endian::write32le(buf, str.size());
+      buf += 4;
+      std::memcpy(buf, str.data(), str.size());
+      buf += str.size();
+    }
+    out.resize(buf - out.data());
+  }
+  return out;
+}
+
+static constexpr bool FitsInBlock(size_t payloadSize) {
+  return payloadSize <= (kBlockSize - kRecordMaxHeaderSize);
+}
+
+DataLog::Buffer DataLog::AllocBuffer() {
+  ++m_buffersInUse;
+  if (m_free.empty()) {
+    return Buffer{};
+  }
+  Buffer buf = std::move(m_free.back());
+  m_free.pop_back();
+  return buf;
+}
+
+void DataLog::ReleaseBuffers(std::vector<Buffer>& bufs) {
+  m_buffersInUse -= bufs.size();
+  for (auto&& buf : bufs) {
+    // only keep as many as the limit allows (it may have been reduced)
+    if (m_maxBuffers == 0 || (m_buffersInUse + m_free.size()) < m_maxBuffers) {
+      buf.Clear();
+      m_free.emplace_back(std::move(buf));
+    }
+  }
+  bufs.resize(0);
+  m_bufferCond.notify_all();
+}
+
+bool DataLog::CheckBufferLimit(std::unique_lock<wpi::mutex>& lock, int entry,
+                               size_t count, size_t payloadSize) {
+  for (;;) {
+    if (m_maxBuffers == 0) {
+      return true;
+    }
+    size_t limit = m_maxBuffers;
+    if (m_overflowPolicy == OverflowPolicy::kDropLowPriority) {
+      auto it = m_entryPriorities.find(entry);
+      int priority = it == m_entryPriorities.end() ? 0 : it->second;
+      if (priority < 0) {
+        limit = m_maxBuffers / 2;
+      } else if (priority == 0) {
+        limit = m_maxBuffers * 3 / 4;
+      }
+    }
+    if ((m_buffersInUse + count) <= limit) {
+      return true;
+    }
+    if (m_overflowPolicy != OverflowPolicy::kBlock || count > m_maxBuffers ||
+        !m_active) {
+      ++m_droppedRecords;
+      m_droppedBytes += payloadSize;
+      return false;
+    }
+    // wake up the writer thread to free up space
+    m_doFlush = true;
+    m_cond.notify_all();
+    m_bufferCond.wait(lock);
+  }
+}
+
+std::unique_lock<wpi::mutex> DataLog::LockLargeRecord(int entry,
+                                                      size_t payloadSize) {
+  std::unique_lock lock{m_mutex};
+  // worst case is a partially used buffer plus the full record
+  size_t count = (kRecordMaxHeaderSize + payloadSize) / kBlockSize + 1;
+  if (!CheckBufferLimit(lock, entry, count, payloadSize)) {
+    lock.unlock();
+  }
+  return lock;
+}
+
+void DataLog::LogDropped(std::unique_lock<wpi::mutex>& lock) {
+  if (m_droppedRecords == m_loggedDroppedRecords) {
+    return;
+  }
+  if (m_loggedDroppedRecords == 0) {
+    WPI_WARNING(m_msglog, "buffer limit reached, dropping records");
+  }
+  if (m_droppedRecordsEntry == 0) {
+    lock.unlock();
+    int recordsEntry = Start("DataLog/droppedRecords", "int64");
+    int bytesEntry = Start("DataLog/droppedBytes", "int64");
+    lock.lock();
+    m_droppedRecordsEntry = recordsEntry;
+    m_droppedBytesEntry = bytesEntry;
+  }
+  uint8_t* buf = StartRecord(m_droppedRecordsEntry, 0, 8, 8);
+  wpi::support::endian::write64le(buf, m_droppedRecords);
+  buf = StartRecord(m_droppedBytesEntry, 0, 8, 8);
+  wpi::support::endian::write64le(buf, m_droppedBytes);
+  m_loggedDroppedRecords = m_droppedRecords;
+}
+
+bool DataLog::CheckWritePolicy(int entry, int64_t* timestamp,
+                               std::span<const uint8_t> scalar, double value) {
+  if (*timestamp == 0) {
+    *timestamp = wpi::Now();
+  }
+  std::scoped_lock lock{m_mutex};
+  auto it = m_writePolicies.find(entry);
+  if (it == m_writePolicies.end()) {
+    return true;
+  }
+  auto& state = it->second;
+
+  // end of interval for a held value
+  if (state.held && *timestamp >= state.windowEnd) {
+    WriteHeld(entry, state);
+  }
+
+  if (!scalar.empty() && state.deadband >= 0 && state.hasLast &&
+      std::abs(value - state.lastValue) <= state.deadband) {
+    ++state.suppressed;
+    return false;
+  }
+
+  if (state.minPeriod <= 0) {
+    state.hasLast = true;
+    state.lastTimestamp = *timestamp;
+    state.lastValue = value;
+    return true;
+  }
+
+  if (state.latest && !scalar.empty()) {
+    if (state.held) {
+      // replaces the held value
+      ++state.suppressed;
     } else {
-      m_outgoing.emplace_back(std::move(m_free.back()));
-      m_free.pop_back();
+      state.held = true;
+      state.windowEnd = *timestamp + state.minPeriod;
+    }
+    state.heldTimestamp = *timestamp;
+    state.heldValue = value;
+    std::memcpy(state.heldData, scalar.data(), scalar.size());
+    state.heldSize = scalar.size();
+    return false;
+  }
+
+  if (state.hasLast && (*timestamp - state.lastTimestamp) < state.minPeriod) {
+    ++state.suppressed;
+    return false;
+  }
+  state.hasLast = true;
+  state.lastTimestamp = *timestamp;
+  state.lastValue = value;
+  return true;
+}
+
+void DataLog::WriteHeld(int entry, WritePolicyState& state) {
+  state.held = false;
+  state.hasLast = true;
+  state.lastTimestamp = state.heldTimestamp;
+  state.lastValue = state.heldValue;
+  if (state.heldSize == 8) {
+    if (auto it = m_blockEncoders.find(entry); it != m_blockEncoders.end()) {
+      it->second->Add(state.heldTimestamp,
+                      wpi::support::endian::read64le(state.heldData));
+      if (it->second->IsFull()) {
+        WriteBlock(entry, *it->second);
+      }
+      return;
+    }
+  }
+  uint8_t* buf =
+      StartRecord(entry, state.heldTimestamp, state.heldSize, state.heldSize);
+  std::memcpy(buf, state.heldData, state.heldSize);
+}
+
+void DataLog::WriteHeldValues(bool all) {
+  int64_t now = wpi::Now();
+  for (auto&& [entry, state] : m_writePolicies) {
+    if (state.held && (all || now >= state.windowEnd)) {
+      WriteHeld(entry, state);
+    }
+  }
+}
+
+bool DataLog::AppendBlockSample(int entry, int64_t timestamp, uint64_t bits) {
+  if (timestamp == 0) {
+    timestamp = wpi::Now();
+  }
+  std::scoped_lock lock{m_mutex};
+  auto it = m_blockEncoders.find(entry);
+  if (it == m_blockEncoders.end()) {
+    return false;
+  }
+  it->second->Add(timestamp, bits);
+  if (it->second->IsFull()) {
+    WriteBlock(entry, *it->second);
+  }
+  return true;
+}
+
+void DataLog::WriteBlock(int entry, BlockEncoder& encoder) {
+  if (encoder.IsEmpty()) {
+    return;
+  }
+  uint8_t payload[BlockEncoder::kMaxPayloadSize];
+  size_t size = encoder.GetPayload(entry, payload);
+  uint8_t* buf = StartRecord(0, encoder.GetFirstTimestamp(), size, size);
+  std::memcpy(buf, payload, size);
+  encoder.Clear();
+}
+
+void DataLog::WriteBlocks() {
+  for (auto&& [entry, encoder] : m_blockEncoders) {
+    WriteBlock(entry, *encoder);
+  }
+}
+
+DataLog::ThreadBuffer& DataLog::GetThreadBuffer() {
+  if (void* tb = gThreadBufferCache.Find(m_instance)) {
+    return *static_cast<ThreadBuffer*>(tb);
+  }
+  std::scoped_lock lock{m_mutex};
+  // thread IDs may be reused after a thread exits; in that case the new
+  // thread simply takes over the old thread's buffer
+  auto id = std::this_thread::get_id();
+  ThreadBuffer* tb = nullptr;
+  for (auto&& buf : m_threadBuffers) {
+    if (buf->id == id && !buf->exited.load(std::memory_order_acquire)) {
+      tb = buf.get();
+      break;
+    }
+  }
+  if (!tb) {
+    auto& buf =
+        m_threadBuffers.emplace_back(std::make_shared<ThreadBuffer>(id));
+    gThreadBufferCache.owned.emplace_back(buf);
+    tb = buf.get();
+  }
+  gThreadBufferCache.Insert(m_instance, tb);
+  return *tb;
+}
+
+void DataLog::SealThreadBuffers() {
+  // lock all of the buffers before sealing any of them, so that every append
+  // lands either before or after the seal of every buffer; the writer thread
+  // can then restore timestamp order by merging the sealed buffers
+  for (auto&& tb : m_threadBuffers) {
+    tb->mutex.lock();
+  }
+  // buffers of exited threads are discarded after their last seal; check the
+  // flag first so nothing appended before the thread exited is lost
+  std::erase_if(m_threadBuffers, [&](auto&& tb) {
+    bool exited = tb->exited.load(std::memory_order_acquire);
+    if (!tb->buf.GetData().empty()) {
+      m_outgoing.emplace_back(std::move(tb->buf));
+    }
+    tb->mutex.unlock();
+    return exited;
+  });
+}
+
+template <typename F>
+void DataLog::AppendThreadRecord(int entry, int64_t timestamp,
+                                 size_t payloadSize, F&& fill) {
+  // only look up the priority when enough buffers are in use to matter
+  if (m_buffersInUse.load(std::memory_order_relaxed) >=
+      m_priorityThreshold.load(std::memory_order_relaxed)) {
+    std::unique_lock lock{m_mutex};
+    if (!CheckBufferLimit(lock, entry, 0, payloadSize)) {
+      return;
     }
   }
+
+  ThreadBuffer& tb = GetThreadBuffer();
+  {
+    std::scoped_lock lock{tb.mutex};
+    if ((kRecordMaxHeaderSize + payloadSize) <= tb.buf.GetRemaining()) {
+      fill(tb.buf.ReserveRecord(entry, timestamp, payloadSize));
+      return;
+    }
+  }
+
+  // out of space (or sealed by the writer thread); hand off the current
+  // buffer and start a new one
+  std::unique_lock lock{m_mutex};
+  if (!CheckBufferLimit(lock, entry, 1, payloadSize)) {
+    return;
+  }
+  std::scoped_lock tlock{tb.mutex};
+  if (!tb.buf.GetData().empty()) {
+    m_outgoing.emplace_back(std::move(tb.buf));
+  }
+  tb.buf = AllocBuffer();
+  tb.buf.SetThreadRecords();
+  fill(tb.buf.ReserveRecord(entry, timestamp, payloadSize));
+}
+
+uint8_t* DataLog::Reserve(size_t size) {
+  assert(size <= kBlockSize);
+  if (m_outgoing.empty() || m_outgoing.back().IsThreadRecords() ||
+      size > m_outgoing.back().GetRemaining()) {
+    m_outgoing.emplace_back(AllocBuffer());
+  }
   return m_outgoing.back().Reserve(size);
 }
 
 uint8_t* DataLog::StartRecord(uint32_t entry, uint64_t timestamp,
                               uint32_t payloadSize, size_t reserveSize) {
+  // keep ordering with records already appended to per-thread buffers (of
+  // any thread, as they may be for the same entry)
+  SealThreadBuffers();
   uint8_t* buf = Reserve(kRecordMaxHeaderSize + reserveSize);
+  if (buf == m_outgoing.back().GetData().data()) {
+    m_outgoing.back().SetRecordStart();
+  }
   auto headerLen = WriteRecordHeader(buf, entry, timestamp, payloadSize);
   m_outgoing.back().Unreserve(kRecordMaxHeaderSize - headerLen);
   buf += headerLen;
@@ -527,11 +1703,21 @@ void DataLog::AppendStringImpl(std::string_view str) {
 
 void DataLog::AppendRaw(int entry, std::span<const uint8_t> data,
                         int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (m_writePolicyEntries.MaybeContains(entry) &&
+      !CheckWritePolicy(entry, &timestamp)) {
+    return;
+  }
+  if (FitsInBlock(data.size())) {
+    AppendThreadRecord(entry, timestamp, data.size(), [&](uint8_t* buf) {
+      std::memcpy(buf, data.data(), data.size());
+    });
+    return;
+  }
+  auto lock = LockLargeRecord(entry, data.size());
+  if (!lock) {
     return;
   }
   StartRecord(entry, timestamp, data.size(), 0);
@@ -541,17 +1727,30 @@ void DataLog::AppendRaw(int entry, std::span<const uint8_t> data,
 void DataLog::AppendRaw2(int entry,
                          std::span<const std::span<const uint8_t>> data,
                          int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (m_writePolicyEntries.MaybeContains(entry) &&
+      !CheckWritePolicy(entry, &timestamp)) {
     return;
   }
   size_t size = 0;
   for (auto&& chunk : data) {
     size += chunk.size();
   }
+  if (FitsInBlock(size)) {
+    AppendThreadRecord(entry, timestamp, size, [&](uint8_t* buf) {
+      for (auto chunk : data) {
+        std::memcpy(buf, chunk.data(), chunk.size());
+        buf += chunk.size();
+      }
+    });
+    return;
+  }
+  auto lock = LockLargeRecord(entry, size);
+  if (!lock) {
+    return;
+  }
   StartRecord(entry, timestamp, size, 0);
   for (auto chunk : data) {
     AppendImpl(chunk);
@@ -559,61 +1758,83 @@ void DataLog::AppendRaw2(int entry,
 }
 
 void DataLog::AppendBoolean(int entry, bool value, int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
-    return;
+  if (m_writePolicyEntries.MaybeContains(entry)) {
+    uint8_t data[1] = {static_cast<uint8_t>(value ? 1 : 0)};
+    if (!CheckWritePolicy(entry, &timestamp, data, value ? 1 : 0)) {
+      return;
+    }
   }
-  uint8_t* buf = StartRecord(entry, timestamp, 1, 1);
-  buf[0] = value ? 1 : 0;
+  AppendThreadRecord(entry, timestamp, 1,
+                     [&](uint8_t* buf) { buf[0] = value ? 1 : 0; });
 }
 
 void DataLog::AppendInteger(int entry, int64_t value, int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (m_writePolicyEntries.MaybeContains(entry)) {
+    uint8_t data[8];
+    wpi::support::endian::write64le(data, value);
+    if (!CheckWritePolicy(entry, &timestamp, data, value)) {
+      return;
+    }
+  }
+  if (m_blockEntries.MaybeContains(entry) &&
+      AppendBlockSample(entry, timestamp, value)) {
     return;
   }
-  uint8_t* buf = StartRecord(entry, timestamp, 8, 8);
-  wpi::support::endian::write64le(buf, value);
+  AppendThreadRecord(entry, timestamp, 8, [&](uint8_t* buf) {
+    wpi::support::endian::write64le(buf, value);
+  });
 }
 
 void DataLog::AppendFloat(int entry, float value, int64_t timestamp) {
-  if (entry <= 0) {
-    return;
-  }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  uint8_t* buf = StartRecord(entry, timestamp, 4, 4);
-  if constexpr (wpi::support::endian::system_endianness() ==
-                wpi::support::little) {
-    std::memcpy(buf, &value, 4);
-  } else {
-    wpi::support::endian::write32le(buf, wpi::FloatToBits(value));
+  if (m_writePolicyEntries.MaybeContains(entry)) {
+    uint8_t data[4];
+    wpi::support::endian::write32le(data, wpi::FloatToBits(value));
+    if (!CheckWritePolicy(entry, &timestamp, data, value)) {
+      return;
+    }
   }
+  AppendThreadRecord(entry, timestamp, 4, [&](uint8_t* buf) {
+    if constexpr (wpi::support::endian::system_endianness() ==
+                  wpi::support::little) {
+      std::memcpy(buf, &value, 4);
+    } else {
+      wpi::support::endian::write32le(buf, wpi::FloatToBits(value));
+    }
+  });
 }
 
 void DataLog::AppendDouble(int entry, double value, int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
-    return;
+  if (m_writePolicyEntries.MaybeContains(entry)) {
+    uint8_t data[8];
+    wpi::support::endian::write64le(data, wpi::DoubleToBits(value));
+    if (!CheckWritePolicy(entry, &timestamp, data, value)) {
+      return;
+    }
   }
-  uint8_t* buf = StartRecord(entry, timestamp, 8, 8);
-  if constexpr (wpi::support::endian::system_endianness() ==
-                wpi::support::little) {
-    std::memcpy(buf, &value, 8);
-  } else {
-    wpi::support::endian::write64le(buf, wpi::DoubleToBits(value));
+  if (m_blockEntries.MaybeContains(entry) &&
+      AppendBlockSample(entry, timestamp, wpi::DoubleToBits(value))) {
+    return;
   }
+  AppendThreadRecord(entry, timestamp, 8, [&](uint8_t* buf) {
+    if constexpr (wpi::support::endian::system_endianness() ==
+                  wpi::support::little) {
+      std::memcpy(buf, &value, 8);
+    } else {
+      wpi::support::endian::write64le(buf, wpi::DoubleToBits(value));
+    }
+  });
 }
 
 void DataLog::AppendString(int entry, std::string_view value,
@@ -625,11 +1846,23 @@ void DataLog::AppendString(int entry, std::string_view value,
 
 void DataLog::AppendBooleanArray(int entry, std::span<const bool> arr,
                                  int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (m_writePolicyEntries.MaybeContains(entry) &&
+      !CheckWritePolicy(entry, &timestamp)) {
+    return;
+  }
+  if (FitsInBlock(arr.size())) {
+    AppendThreadRecord(entry, timestamp, arr.size(), [&](uint8_t* buf) {
+      for (auto val : arr) {
+        *buf++ = val ? 1 : 0;
+      }
+    });
+    return;
+  }
+  auto lock = LockLargeRecord(entry, arr.size());
+  if (!lock) {
     return;
   }
   StartRecord(entry, timestamp, arr.size(), 0);
@@ -649,11 +1882,23 @@ void DataLog::AppendBooleanArray(int entry, std::span<const bool> arr,
 
 void DataLog::AppendBooleanArray(int entry, std::span<const int> arr,
                                  int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
     return;
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (m_writePolicyEntries.MaybeContains(entry) &&
+      !CheckWritePolicy(entry, &timestamp)) {
+    return;
+  }
+  if (FitsInBlock(arr.size())) {
+    AppendThreadRecord(entry, timestamp, arr.size(), [&](uint8_t* buf) {
+      for (auto val : arr) {
+        *buf++ = val & 1;
+      }
+    });
+    return;
+  }
+  auto lock = LockLargeRecord(entry, arr.size());
+  if (!lock) {
     return;
   }
   StartRecord(entry, timestamp, arr.size(), 0);
@@ -684,11 +1929,15 @@ void DataLog::AppendIntegerArray(int entry, std::span<const int64_t> arr,
               {reinterpret_cast<const uint8_t*>(arr.data()), arr.size() * 8},
               timestamp);
   } else {
-    if (entry <= 0) {
+    if (entry <= 0 || m_paused) {
       return;
     }
-    std::scoped_lock lock{m_mutex};
-    if (m_paused) {
+    if (m_writePolicyEntries.MaybeContains(entry) &&
+        !CheckWritePolicy(entry, &timestamp)) {
+      return;
+    }
+    auto lock = LockLargeRecord(entry, arr.size() * 8);
+    if (!lock) {
       return;
     }
     StartRecord(entry, timestamp, arr.size() * 8, 0);
@@ -717,11 +1966,15 @@ void DataLog::AppendFloatArray(int entry, std::span<const float> arr,
               {reinterpret_cast<const uint8_t*>(arr.data()), arr.size() * 4},
               timestamp);
   } else {
-    if (entry <= 0) {
+    if (entry <= 0 || m_paused) {
       return;
     }
-    std::scoped_lock lock{m_mutex};
-    if (m_paused) {
+    if (m_writePolicyEntries.MaybeContains(entry) &&
+        !CheckWritePolicy(entry, &timestamp)) {
+      return;
+    }
+    auto lock = LockLargeRecord(entry, arr.size() * 4);
+    if (!lock) {
       return;
     }
     StartRecord(entry, timestamp, arr.size() * 4, 0);
@@ -750,11 +2003,15 @@ void DataLog::AppendDoubleArray(int entry, std::span<const double> arr,
               {reinterpret_cast<const uint8_t*>(arr.data()), arr.size() * 8},
               timestamp);
   } else {
-    if (entry <= 0) {
+    if (entry <= 0 || m_paused) {
       return;
     }
-    std::scoped_lock lock{m_mutex};
-    if (m_paused) {
+    if (m_writePolicyEntries.MaybeContains(entry) &&
+        !CheckWritePolicy(entry, &timestamp)) {
+      return;
+    }
+    auto lock = LockLargeRecord(entry, arr.size() * 8);
+    if (!lock) {
       return;
     }
     StartRecord(entry, timestamp, arr.size() * 8, 0);
@@ -777,7 +2034,11 @@ void DataLog::AppendDoubleArray(int entry, std::span<const double> arr,
 
 void DataLog::AppendStringArray(int entry, std::span<const std::string> arr,
                                 int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
+    return;
+  }
+  if (m_writePolicyEntries.MaybeContains(entry) &&
+      !CheckWritePolicy(entry, &timestamp)) {
     return;
   }
   // storage: 4-byte array length, each string prefixed by 4-byte length
@@ -786,8 +2047,20 @@ void DataLog::AppendStringArray(int entry, std::span<const std::string> arr,
   for (auto&& str : arr) {
     size += 4 + str.size();
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (FitsInBlock(size)) {
+    AppendThreadRecord(entry, timestamp, size, [&](uint8_t* buf) {
+      wpi::support::endian::write32le(buf, arr.size());
+      buf += 4;
+      for (auto&& str : arr) {
+        wpi::support::endian::write32le(buf, str.size());
+        std::memcpy(buf + 4, str.data(), str.size());
+        buf += 4 + str.size();
+      }
+    });
+    return;
+  }
+  auto lock = LockLargeRecord(entry, size);
+  if (!lock) {
     return;
   }
   uint8_t* buf = StartRecord(entry, timestamp, size, 4);
@@ -800,7 +2073,11 @@ void DataLog::AppendStringArray(int entry, std::span<const std::string> arr,
 void DataLog::AppendStringArray(int entry,
                                 std::span<const std::string_view> arr,
                                 int64_t timestamp) {
-  if (entry <= 0) {
+  if (entry <= 0 || m_paused) {
+    return;
+  }
+  if (m_writePolicyEntries.MaybeContains(entry) &&
+      !CheckWritePolicy(entry, &timestamp)) {
     return;
   }
   // storage: 4-byte array length, each string prefixed by 4-byte length
@@ -809,8 +2086,20 @@ void DataLog::AppendStringArray(int entry,
   for (auto&& str : arr) {
     size += 4 + str.size();
   }
-  std::scoped_lock lock{m_mutex};
-  if (m_paused) {
+  if (FitsInBlock(size)) {
+    AppendThreadRecord(entry, timestamp, size, [&](uint8_t* buf) {
+      wpi::support::endian::write32le(buf, arr.size());
+      buf += 4;
+      for (auto sv : arr) {
+        wpi::support::endian::write32le(buf, sv.size());
+        std::memcpy(buf + 4, sv.data(), sv.size());
+        buf += 4 + sv.size();
+      }
+    });
+    return;
+  }
+  auto lock = LockLargeRecord(entry, size);
+  if (!lock) {
     return;
   }
   uint8_t* buf = StartRecord(entry, timestamp, size, 4);
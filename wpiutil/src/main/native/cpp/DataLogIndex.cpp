@@ -0,0 +1,224 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
+#include "DataLogInternal.h"
+#include "wpi/Endian.h"
+#include "wpi/leb128.h"
+#include "wpi/raw_istream.h"
+#include "wpi/raw_ostream.h"
+
+using namespace wpi::log;
+using impl::DataLogReaderAccess;
+
+// Saved index format (all integers are unsigned LEB128 unless noted):
+// 8-byte "WPILOGIX" magic
+// 2-byte little endian version (0x0100)
+// log size, time resolution, min timestamp, max timestamp
+// number of time index buckets, then for each bucket:
+//   bucket delta (from previous bucket), offset delta (from previous offset)
+// number of entries, then for each entry:
+//   entry ID, number of offsets, then offset deltas (from previous offset)
+static constexpr std::string_view kMagic = "WPILOGIX";
+static constexpr uint16_t kVersion = 0x0100;
+
+DataLogIndex::DataLogIndex(const DataLogReader& reader, int64_t timeResolution)
+    : m_timeResolution{timeResolution > 0 ? timeResolution
+                                          : kDefaultTimeResolution} {
+  if (!reader) {
+    return;
+  }
+
+  wpi::DenseMap<int64_t, size_t> buckets;
+  bool first = true;
+  DataLogRecord record;
+  impl::DecodedBlock block;
+  size_t pos = DataLogReaderAccess::GetFirstRecordPos(reader);
+  for (size_t recordPos = pos;
+       DataLogReaderAccess::GetRecord(reader, &pos, &record);
+       recordPos = pos) {
+    // block records are indexed under the entry of their samples, and cover
+    // the timestamps from the first to the last sample
+    int entry = record.GetEntry();
+    int64_t timestamp = record.GetTimestamp();
+    int64_t lastTimestamp = timestamp;
+    if (record.IsBlock() && impl::DecodeBlock(record, &block) &&
+        !block.timestamps.empty()) {
+      entry = block.entry;
+      lastTimestamp = block.timestamps.back();
+    }
+    m_offsets[entry].push_back(recordPos);
+
+    if (first) {
+      m_minTimestamp = timestamp;
+      m_maxTimestamp = lastTimestamp;
+      first = false;
+    } else {
+      m_minTimestamp = (std::min)(m_minTimestamp, timestamp);
+      m_maxTimestamp = (std::max)(m_maxTimestamp, lastTimestamp);
+    }
+
+    // offsets are increasing, so only the first record in a bucket matters;
+    // a block is also added to its last bucket so seeking to any time it
+    // covers starts at or before it
+    buckets.try_emplace(timestamp / m_timeResolution, recordPos);
+    buckets.try_emplace(lastTimestamp / m_timeResolution, recordPos);
+  }
+
+  m_timeIndex.assign(buckets.begin(), buckets.end());
+  std::sort(m_timeIndex.begin(), m_timeIndex.end());
+  // make offsets the minimum of this and all later buckets
+  for (size_t i = m_timeIndex.size(); i > 1; --i) {
+    m_timeIndex[i - 2].second =
+        (std::min)(m_timeIndex[i - 2].second, m_timeIndex[i - 1].second);
+  }
+
+  m_logSize = DataLogReaderAccess::GetBuffer(reader).size();
+}
+
+std::span<const size_t> DataLogIndex::GetRecordOffsets(int entry) const {
+  auto it = m_offsets.find(entry);
+  if (it == m_offsets.end()) {
+    return {};
+  }
+  return it->second;
+}
+
+DataLogIterator DataLogIndex::SeekTime(const DataLogReader& reader,
+                                       int64_t timestamp) const {
+  int64_t bucket = timestamp / m_timeResolution;
+  auto it = std::lower_bound(
+      m_timeIndex.begin(), m_timeIndex.end(), bucket,
+      [](const auto& elem, int64_t val) { return elem.first < val; });
+  if (it == m_timeIndex.end()) {
+    return reader.end();
+  }
+  return DataLogIterator{&reader, it->second};
+}
+
+void DataLogIndex::Save(wpi::raw_ostream& os) const {
+  os << kMagic;
+  uint8_t version[2];
+  wpi::support::endian::write16le(version, kVersion);
+  os << std::span<const uint8_t>{version};
+
+  wpi::WriteUleb128(os, m_logSize);
+  wpi::WriteUleb128(os, m_timeResolution);
+  wpi::WriteUleb128(os, m_minTimestamp);
+  wpi::WriteUleb128(os, m_maxTimestamp);
+
+  wpi::WriteUleb128(os, m_timeIndex.size());
+  int64_t prevBucket = 0;
+  size_t prevOffset = 0;
+  for (auto&& [bucket, offset] : m_timeIndex) {
+    wpi::WriteUleb128(os, bucket - prevBucket);
+    wpi::WriteUleb128(os, offset - prevOffset);
+    prevBucket = bucket;
+    prevOffset = offset;
+  }
+
+  wpi::WriteUleb128(os, m_offsets.size());
+  for (auto&& [entry, offsets] : m_offsets) {
+    wpi::WriteUleb128(os, entry);
+    wpi::WriteUleb128(os, offsets.size());
+    prevOffset = 0;
+    for (auto offset : offsets) {
+      wpi::WriteUleb128(os, offset - prevOffset);
+      prevOffset = offset;
+    }
+  }
+}
+
+bool DataLogIndex::Load(std::span<const uint8_t> data,
+                        const DataLogReader& reader) {
+  *this = DataLogIndex{};
+  if (!reader || data.size() < (kMagic.size() + 2) ||
+      std::string_view{reinterpret_cast<const char*>(data.data()),
+                       kMagic.size()} != kMagic ||
+      wpi::support::endian::read16le(&data[kMagic.size()]) != kVersion) {
+    return false;
+  }
+
+  wpi::raw_mem_istream is{data.subspan(kMagic.size() + 2)};
+  uint64_t logSize, timeResolution, minTimestamp, maxTimestamp, count;
+  if (!wpi::ReadUleb128(is, &logSize) ||
+      !wpi::ReadUleb128(is, &timeResolution) ||
+      !wpi::ReadUleb128(is, &minTimestamp) ||
+      !wpi::ReadUleb128(is, &maxTimestamp) || !wpi::ReadUleb128(is, &count)) {
+    return false;
+  }
+  if (logSize != DataLogReaderAccess::GetBuffer(reader).size() ||
+      timeResolution == 0) {
+    return false;
+  }
+
+  DataLogIndex index;
+  index.m_timeResolution = timeResolution;
+  index.m_minTimestamp = minTimestamp;
+  index.m_maxTimestamp = maxTimestamp;
+
+  // sanity check counts against the remaining data (each value is 1+ bytes)
+  if (count > (is.in_avail() / 2)) {
+    return false;
+  }
+  index.m_timeIndex.reserve(count);
+  int64_t bucket = 0;
+  uint64_t offset = 0;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t bucketDelta, offsetDelta;
+    if (!wpi::ReadUleb128(is, &bucketDelta) ||
+        !wpi::ReadUleb128(is, &offsetDelta)) {
+      return false;
+    }
+    bucket += bucketDelta;
+    offset += offsetDelta;
+    if (offset >= logSize) {
+      return false;
+    }
+    index.m_timeIndex.emplace_back(bucket, offset);
+  }
+
+  if (!wpi::ReadUleb128(is, &count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t entry, numOffsets;
+    if (!wpi::ReadUleb128(is, &entry) || !wpi::ReadUleb128(is, &numOffsets) ||
+        numOffsets > is.in_avail()) {
+      return false;
+    }
+    // entry IDs are non-negative ints (the maximum is reserved by DenseMap),
+    // and each appears only once
+    if (entry >= static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+      return false;
+    }
+    auto [it, inserted] = index.m_offsets.try_emplace(static_cast<int>(entry));
+    if (!inserted) {
+      return false;
+    }
+    auto& offsets = it->second;
+    offsets.reserve(numOffsets);
+    offset = 0;
+    for (uint64_t j = 0; j < numOffsets; ++j) {
+      uint64_t offsetDelta;
+      if (!wpi::ReadUleb128(is, &offsetDelta)) {
+        return false;
+      }
+      offset += offsetDelta;
+      if (offset >= logSize) {
+        return false;
+      }
+      offsets.push_back(offset);
+    }
+  }
+
+  index.m_logSize = logSize;
+  *this = std::move(index);
+  return true;
+}
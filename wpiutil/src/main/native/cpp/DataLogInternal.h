@@ -0,0 +1,84 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <cstring>
+#include <span>
+
+#include "wpi/DataLog.h"
+#include "wpi/DataLogReader.h"
+#include "wpi/Endian.h"
+
+// Record encoding shared by the data log writers (DataLog and DataLogMerger),
+// and access to DataLogReader internals for the other readers.
+
+namespace wpi::log::impl {
+
+inline constexpr size_t kRecordMaxHeaderSize = 17;
+
+// Sync records are written at most once per this many bytes
+inline constexpr uint64_t kSyncInterval = 1024 * 1024;
+
+inline constexpr size_t kSyncRecordMaxSize =
+    kRecordMaxHeaderSize + kSyncPayloadSize;
+
+template <typename T>
+inline unsigned int WriteVarInt(uint8_t* buf, T val) {
+  unsigned int len = 0;
+  do {
+    *buf++ = static_cast<unsigned int>(val) & 0xff;
+    ++len;
+    val >>= 8;
+  } while (val != 0);
+  return len;
+}
+
+// min size: 4, max size: 17
+inline unsigned int WriteRecordHeader(uint8_t* buf, uint32_t entry,
+                                      uint64_t timestamp,
+                                      uint32_t payloadSize) {
+  uint8_t* origbuf = buf++;
+
+  unsigned int entryLen = WriteVarInt(buf, entry);
+  buf += entryLen;
+  unsigned int payloadLen = WriteVarInt(buf, payloadSize);
+  buf += payloadLen;
+  unsigned int timestampLen = WriteVarInt(buf, timestamp);
+  buf += timestampLen;
+  *origbuf =
+      ((timestampLen - 1) << 4) | ((payloadLen - 1) << 2) | (entryLen - 1);
+  return buf - origbuf;
+}
+
+// buf must be at least kSyncRecordMaxSize; returns the record size
+inline size_t WriteSyncRecord(uint8_t* buf, uint64_t timestamp,
+                              uint64_t offset) {
+  auto headerLen = WriteRecordHeader(buf, 0, timestamp, kSyncPayloadSize);
+  uint8_t* payload = buf + headerLen;
+  payload[0] = kControlSync;
+  std::memcpy(payload + 1, kSyncMagic.data(), kSyncMagic.size());
+  wpi::support::endian::write64le(payload + 1 + kSyncMagic.size(), offset);
+  return headerLen + kSyncPayloadSize;
+}
+
+class DataLogReaderAccess {
+ public:
+  static std::span<const uint8_t> GetBuffer(const DataLogReader& reader) {
+    return reader.m_buf->GetBuffer();
+  }
+
+  static size_t GetFirstRecordPos(const DataLogReader& reader) {
+    return reader.GetFirstRecordPos();
+  }
+
+  static bool GetRecord(const DataLogReader& reader, size_t* pos,
+                        DataLogRecord* out) {
+    return reader.GetRecord(pos, out);
+  }
+};
+
+}  // namespace wpi::log::impl
@@ -0,0 +1,307 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogMerger.h"
+
+#include <functional>
+#include <queue>
+#include <utility>
+
+#include "DataLogInternal.h"
+#include "wpi/DataLog.h"
+#include "wpi/Endian.h"
+#include "wpi/raw_ostream.h"
+
+using namespace wpi::log;
+using impl::DataLogReaderAccess;
+using impl::kRecordMaxHeaderSize;
+// unlike DataLog, a zero timestamp is kept as-is
+using impl::WriteRecordHeader;
+
+struct DataLogMerger::Input {
+  explicit Input(const DataLogReader& reader)
+      : reader{reader}, pos{DataLogReaderAccess::GetFirstRecordPos(reader)} {}
+
+  // reads the next record; returns false at the end of the log
+  bool Next() {
+    recordPos = pos;
+    if (!DataLogReaderAccess::GetRecord(reader, &pos, &record)) {
+      return false;
+    }
+    auto buf = DataLogReaderAccess::GetBuffer(reader);
+    raw = buf.subspan(recordPos, pos - recordPos);
+    return true;
+  }
+
+  const DataLogReader& reader;
+  size_t pos;
+  size_t recordPos = 0;
+  DataLogRecord record;
+  std::span<const uint8_t> raw;
+  // input entry ID to output entry ID (0 if not included)
+  wpi::DenseMap<int, int> ids;
+  impl::DecodedBlock block;
+};
+
+void DataLogMerger::AddInput(const DataLogReader& reader) {
+  m_inputs.emplace_back(&reader);
+}
+
+void DataLogMerger::IncludeEntry(std::string_view name) {
+  m_names.emplace(name);
+}
+
+void DataLogMerger::IncludePrefix(std::string_view prefix) {
+  m_prefixes.emplace_back(prefix);
+}
+
+void DataLogMerger::SetTimeRange(int64_t start, int64_t end) {
+  m_startTime = start;
+  m_endTime = end;
+}
+
+bool DataLogMerger::IsIncluded(std::string_view name) const {
+  if (m_names.empty() && m_prefixes.empty()) {
+    return true;
+  }
+  if (m_names.find(name) != m_names.end()) {
+    return true;
+  }
+  for (auto&& prefix : m_prefixes) {
+    if (name.starts_with(prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int DataLogMerger::AllocateEntry(int preferred) {
+  // keep the input entry ID if possible so records can be copied unchanged
+  auto isFree = [&](int id) {
+    auto it = m_outputEntries.find(id);
+    return it == m_outputEntries.end() || it->second.refs == 0;
+  };
+  if (preferred > 0 && isFree(preferred)) {
+    return preferred;
+  }
+  while (!isFree(m_nextEntry)) {
+    ++m_nextEntry;
+  }
+  return m_nextEntry++;
+}
+
+bool DataLogMerger::Merge(raw_ostream& os) {
+  std::vector<Input> inputs;
+  inputs.reserve(m_inputs.size());
+  for (auto&& reader : m_inputs) {
+    if (!reader->IsValid()) {
+      return false;
+    }
+    inputs.emplace_back(*reader);
+  }
+
+  m_os = &os;
+  m_outputEntries.clear();
+  m_outputNames.clear();
+  m_nextEntry = 1;
+  m_copied = 0;
+  m_rewritten = 0;
+
+  // header
+  uint8_t header[12] = {'W', 'P', 'I', 'L', 'O', 'G'};
+  wpi::support::endian::write16le(&header[6], 0x0100);
+  wpi::support::endian::write32le(&header[8], m_extraHeader.size());
+  os.write(header, sizeof(header));
+  os << m_extraHeader;
+  m_offset = sizeof(header) + m_extraHeader.size();
+  m_lastSync = m_offset;
+
+  // k-way merge: min-heap on (timestamp, input index); ties go to the earlier
+  // input so the merge is deterministic
+  using HeapItem = std::pair<int64_t, size_t>;
+  std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>>
+      heap;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (inputs[i].Next()) {
+      heap.emplace(inputs[i].record.GetTimestamp(), i);
+    }
+  }
+  while (!heap.empty()) {
+    size_t i = heap.top().second;
+    heap.pop();
+    auto& in = inputs[i];
+    ProcessRecord(in);
+    if (in.Next()) {
+      heap.emplace(in.record.GetTimestamp(), i);
+    }
+  }
+
+  m_os = nullptr;
+  return true;
+}
+
+void DataLogMerger::ProcessRecord(Input& in) {
+  const DataLogRecord& record = in.record;
+  if (!record.IsControl()) {
+    auto it = in.ids.find(record.GetEntry());
+    if (it == in.ids.end() || it->second == 0 ||
+        !IsInTimeRange(record.GetTimestamp())) {
+      return;
+    }
+    WriteRecord(in.raw, record, it->second);
+    return;
+  }
+
+  if (record.IsStart()) {
+    StartRecordData data;
+    if (!record.GetStartData(&data) || in.ids.count(data.entry) != 0) {
+      return;
+    }
+    if (!IsIncluded(data.name)) {
+      in.ids[data.entry] = 0;
+      return;
+    }
+    // share an active output entry with the same name and type
+    if (auto it = m_outputNames.find(data.name); it != m_outputNames.end()) {
+      auto& entry = m_outputEntries[it->second];
+      if (entry.type == data.type) {
+        ++entry.refs;
+        in.ids[data.entry] = it->second;
+        return;
+      }
+    }
+    int id = AllocateEntry(data.entry);
+    in.ids[data.entry] = id;
+    m_outputEntries[id] = {std::string{data.name}, std::string{data.type}, 1};
+    // if the name is already in use with a different type, records for this
+    // entry still go to their own output entry, but aren't shared
+    m_outputNames.try_emplace(std::string{data.name}, id);
+    WriteRecord(in.raw, record, id);
+  } else if (record.IsFinish()) {
+    int entry;
+    if (!record.GetFinishEntry(&entry)) {
+      return;
+    }
+    auto it = in.ids.find(entry);
+    if (it == in.ids.end()) {
+      return;
+    }
+    int id = it->second;
+    in.ids.erase(it);
+    if (id == 0) {
+      return;
+    }
+    auto& outEntry = m_outputEntries[id];
+    if (--outEntry.refs > 0) {
+      return;
+    }
+    if (auto nameIt = m_outputNames.find(outEntry.name);
+        nameIt != m_outputNames.end() && nameIt->second == id) {
+      m_outputNames.erase(nameIt);
+    }
+    WriteRecord(in.raw, record, id);
+  } else if (record.IsSetMetadata()) {
+    MetadataRecordData data;
+    if (!record.GetSetMetadataData(&data)) {
+      return;
+    }
+    auto it = in.ids.find(data.entry);
+    if (it != in.ids.end() && it->second != 0) {
+      WriteRecord(in.raw, record, it->second);
+    }
+  } else if (record.IsBlock()) {
+    auto it = in.ids.find(
+        static_cast<int>(wpi::support::endian::read32le(&record.GetRaw()[1])));
+    if (it == in.ids.end() || it->second == 0) {
+      return;
+    }
+    int id = it->second;
+    if (m_startTime == INT64_MIN && m_endTime == INT64_MAX) {
+      WriteRecord(in.raw, record, id);
+      return;
+    }
+    if (!impl::DecodeBlock(record, &in.block)) {
+      return;
+    }
+    size_t count = 0;
+    for (auto timestamp : in.block.timestamps) {
+      if (IsInTimeRange(timestamp)) {
+        ++count;
+      }
+    }
+    if (count == in.block.timestamps.size()) {
+      WriteRecord(in.raw, record, id);
+    } else if (count != 0) {
+      // split into individual records for the samples in range
+      for (size_t i = 0; i < in.block.timestamps.size(); ++i) {
+        int64_t timestamp = in.block.timestamps[i];
+        if (!IsInTimeRange(timestamp)) {
+          continue;
+        }
+        BeginRecord(timestamp);
+        uint8_t buf[kRecordMaxHeaderSize];
+        auto headerLen = WriteRecordHeader(buf, id, timestamp, 8);
+        Write({buf, headerLen});
+        Write(std::span{in.block.values}.subspan(i * 8, 8));
+        ++m_rewritten;
+      }
+    }
+  } else if (record.IsSync() || record.IsSummary() || record.IsSummaryEnd()) {
+    // these describe the input log, not the merged log
+  } else if (record.GetSize() > 0 &&
+             record.GetRaw()[0] > impl::kControlSummaryEnd) {
+    // unknown control record type; it can't refer to an entry we know how to
+    // remap, so copy it unchanged
+    WriteRecord(in.raw, record, 0);
+  }
+}
+
+void DataLogMerger::WriteRecord(std::span<const uint8_t> raw,
+                                const DataLogRecord& record, int entry) {
+  BeginRecord(record.GetTimestamp());
+  auto payload = record.GetRaw();
+  if (record.IsControl()) {
+    // control records refer to the entry in the payload
+    if (entry == 0 || static_cast<int>(wpi::support::endian::read32le(
+                          &payload[1])) == entry) {
+      Write(raw);
+      ++m_copied;
+      return;
+    }
+    uint8_t buf[kRecordMaxHeaderSize + 5];
+    auto headerLen =
+        WriteRecordHeader(buf, 0, record.GetTimestamp(), payload.size());
+    buf[headerLen] = payload[0];
+    wpi::support::endian::write32le(&buf[headerLen + 1], entry);
+    Write({buf, headerLen + 5});
+    Write(payload.subspan(5));
+  } else {
+    if (record.GetEntry() == entry) {
+      Write(raw);
+      ++m_copied;
+      return;
+    }
+    uint8_t buf[kRecordMaxHeaderSize];
+    auto headerLen =
+        WriteRecordHeader(buf, entry, record.GetTimestamp(), payload.size());
+    Write({buf, headerLen});
+    Write(payload);
+  }
+  ++m_rewritten;
+}
+
+void DataLogMerger::BeginRecord(int64_t timestamp) {
+  if ((m_offset - m_lastSync) < impl::kSyncInterval) {
+    return;
+  }
+  uint8_t sync[impl::kSyncRecordMaxSize];
+  size_t len = impl::WriteSyncRecord(sync, timestamp, m_offset);
+  m_lastSync = m_offset;
+  Write({sync, len});
+}
+
+void DataLogMerger::Write(std::span<const uint8_t> data) {
+  m_os->write(data.data(), data.size());
+  m_offset += data.size();
+}
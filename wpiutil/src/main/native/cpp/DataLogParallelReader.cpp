@@ -0,0 +1,317 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogParallelReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <string_view>
+#include <thread>
+
+#include "DataLogInternal.h"
+#include "wpi/DataLog.h"
+#include "wpi/Endian.h"
+
+using namespace wpi::log;
+using impl::DataLogReaderAccess;
+
+// how far to search for a plausible record start in logs without sync records
+static constexpr size_t kResyncSearchLimit = 64 * 1024;
+// A candidate start position is accepted if it is followed by a run of at
+// least this many plausible records covering at least this many bytes.  Rather
+// than the candidate itself, the end of the run is used as the chunk start:
+// a misaligned parse (e.g. inside a large array) can look plausible for a
+// while, but once it reaches ordinary records it either fails or falls into
+// alignment, so the end of a long run is very likely a real record start.
+static constexpr int kResyncRecords = 16;
+static constexpr size_t kResyncMinBytes = 64 * 1024;
+// maximum timestamp difference between consecutive plausible records
+static constexpr int64_t kResyncMaxTimeSpan = 60000000;
+
+// control records must decode exactly (with no leftover data)
+static bool IsPlausibleControlRecord(const DataLogRecord& record) {
+  StartRecordData start;
+  MetadataRecordData metadata;
+  int entry;
+  if (record.GetStartData(&start)) {
+    return start.entry > 0 && !start.type.empty() &&
+           (17 + start.name.size() + start.type.size() +
+            start.metadata.size()) == record.GetSize();
+  } else if (record.GetFinishEntry(&entry)) {
+    return entry > 0;
+  } else if (record.GetSetMetadataData(&metadata)) {
+    return metadata.entry > 0 &&
+           (9 + metadata.metadata.size()) == record.GetSize();
+  } else if (record.IsSummary()) {
+    SummaryRecordData summary;
+    return record.GetSummaryData(&summary) && summary.entry > 0 &&
+           (66 + summary.name.size() + summary.type.size() +
+            summary.metadata.size()) == record.GetSize();
+  } else if (record.IsBlock()) {
+    impl::DecodedBlock block;
+    return impl::DecodeBlock(record, &block);
+  } else {
+    return record.IsSync() || record.IsSummaryEnd();
+  }
+}
+
+static void ParallelFor(size_t n, unsigned int numThreads,
+                        wpi::function_ref<void(size_t)> func) {
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i; (i = next++) < n;) {
+      func(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  size_t numExtra = (std::min<size_t>)(numThreads, n);
+  for (size_t i = 1; i < numExtra; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto&& thr : threads) {
+    thr.join();
+  }
+}
+
+DataLogParallelReader::DataLogParallelReader(const DataLogReader& reader,
+                                             unsigned int numThreads,
+                                             size_t chunkSize)
+    : m_reader{reader},
+      m_numThreads{numThreads != 0
+                       ? numThreads
+                       : (std::max)(std::thread::hardware_concurrency(), 1u)} {
+  if (!reader) {
+    return;
+  }
+  size_t first = DataLogReaderAccess::GetFirstRecordPos(reader);
+  if (first == SIZE_MAX) {
+    return;
+  }
+  size_t size = DataLogReaderAccess::GetBuffer(reader).size();
+  if (chunkSize == 0) {
+    chunkSize = std::clamp<size_t>((size - first) / (m_numThreads * 4),
+                                   kMinChunkSize, kMaxChunkSize);
+  }
+
+  // find a record start near each chunk target; this only scans a small part
+  // of each chunk, but it's still worth doing in parallel for large logs
+  std::vector<size_t> starts;
+  for (size_t target = first + chunkSize; target < size; target += chunkSize) {
+    starts.push_back(target);
+  }
+  ParallelFor(starts.size(), m_numThreads, [&](size_t i) {
+    starts[i] = FindChunkStart(starts[i], starts[i] + chunkSize);
+  });
+
+  m_offsets.push_back(first);
+  for (auto start : starts) {
+    if (start != SIZE_MAX && start > m_offsets.back()) {
+      m_offsets.push_back(start);
+    }
+  }
+}
+
+size_t DataLogParallelReader::FindChunkStart(size_t pos, size_t limit) const {
+  auto buf = DataLogReaderAccess::GetBuffer(m_reader);
+  limit = (std::min)(limit, buf.size());
+
+  // look for a sync record: the magic is preceded by the control record type
+  // and followed by the file offset of the record
+  std::string_view str{reinterpret_cast<const char*>(buf.data()),
+                       (std::min)(buf.size(), limit + impl::kSyncMagic.size())};
+  for (size_t i = str.find(impl::kSyncMagic, pos); i != std::string_view::npos;
+       i = str.find(impl::kSyncMagic, i + 1)) {
+    size_t payloadPos = i - 1;
+    if (i == 0 || (payloadPos + impl::kSyncPayloadSize) > buf.size() ||
+        buf[payloadPos] != impl::kControlSync) {
+      continue;
+    }
+    size_t offset =
+        wpi::support::endian::read64le(&buf[i + impl::kSyncMagic.size()]);
+    if (offset < pos || offset >= payloadPos) {
+      continue;
+    }
+    DataLogRecord record;
+    size_t recordPos = offset;
+    if (DataLogReaderAccess::GetRecord(m_reader, &recordPos, &record) &&
+        record.IsSync() && record.GetRaw().data() == &buf[payloadPos]) {
+      return offset;
+    }
+  }
+
+  // no sync records (e.g. an older log); look for a plausible record start
+  size_t end = (std::min)(limit, pos + kResyncSearchLimit);
+  for (; pos < end; ++pos) {
+    size_t resyncPos = Resync(pos);
+    if (resyncPos != SIZE_MAX) {
+      return resyncPos;
+    }
+  }
+  return SIZE_MAX;
+}
+
+size_t DataLogParallelReader::Resync(size_t pos) const {
+  auto buf = DataLogReaderAccess::GetBuffer(m_reader);
+  size_t start = pos;
+  int64_t prevTimestamp = 0;
+  for (int i = 0; i < kResyncRecords || (pos - start) < kResyncMinBytes; ++i) {
+    if (pos >= buf.size()) {
+      return SIZE_MAX;
+    }
+    // spare bit must be zero
+    if ((buf[pos] & 0x80) != 0) {
+      return SIZE_MAX;
+    }
+    // the writer always uses minimal length fields, so if a field is longer
+    // than one byte, its most significant byte must be nonzero
+    unsigned int entryLen = (buf[pos] & 0x3) + 1;
+    unsigned int sizeLen = ((buf[pos] >> 2) & 0x3) + 1;
+    unsigned int timestampLen = ((buf[pos] >> 4) & 0x7) + 1;
+    size_t headerLen = 1 + entryLen + sizeLen + timestampLen;
+    if ((buf.size() - pos) < headerLen ||
+        (entryLen > 1 && buf[pos + entryLen] == 0) ||
+        (sizeLen > 1 && buf[pos + entryLen + sizeLen] == 0) ||
+        (timestampLen > 1 && buf[pos + headerLen - 1] == 0)) {
+      return SIZE_MAX;
+    }
+
+    DataLogRecord record;
+    if (!DataLogReaderAccess::GetRecord(m_reader, &pos, &record) ||
+        record.GetEntry() < 0 || record.GetTimestamp() == 0) {
+      return SIZE_MAX;
+    }
+    if (record.IsControl() && !IsPlausibleControlRecord(record)) {
+      return SIZE_MAX;
+    }
+    if (i != 0 &&
+        (record.GetTimestamp() < (prevTimestamp - kResyncMaxTimeSpan) ||
+         record.GetTimestamp() > (prevTimestamp + kResyncMaxTimeSpan))) {
+      return SIZE_MAX;
+    }
+    prevTimestamp = record.GetTimestamp();
+  }
+  return pos;
+}
+
+void DataLogParallelReader::DecodeChunk(size_t index, size_t start,
+                                        Chunk* chunk) const {
+  size_t limit =
+      (index + 1) < m_offsets.size() ? m_offsets[index + 1] : SIZE_MAX;
+  chunk->start = start;
+  chunk->failed = false;
+  chunk->records.clear();
+  chunk->blocks.clear();
+  size_t pos = start;
+  DataLogRecord record;
+  while (pos < limit) {
+    if (!DataLogReaderAccess::GetRecord(m_reader, &pos, &record)) {
+      // end of log (or corrupt record); nothing after this can be decoded
+      chunk->failed = true;
+      break;
+    }
+    if (record.IsBlock()) {
+      auto block = std::make_unique<impl::DecodedBlock>();
+      if (impl::DecodeBlock(record, block.get())) {
+        for (size_t i = 0; i < block->timestamps.size(); ++i) {
+          chunk->records.push_back(block->GetRecord(i));
+        }
+        chunk->blocks.emplace_back(std::move(block));
+        continue;
+      }
+    }
+    chunk->records.push_back(record);
+  }
+  chunk->end = pos;
+}
+
+void DataLogParallelReader::Decode(
+    function_ref<void(std::span<Chunk> chunks, size_t index)> func) {
+  if (m_offsets.empty()) {
+    return;
+  }
+
+  // decode a window of chunks at a time to bound memory use
+  size_t window = m_numThreads * 2;
+  std::vector<Chunk> chunks((std::min)(window, m_offsets.size()));
+  size_t pos = m_offsets.front();
+  bool done = false;
+  for (size_t first = 0; first < m_offsets.size() && !done; first += window) {
+    std::span<Chunk> span{chunks.data(),
+                          (std::min)(window, m_offsets.size() - first)};
+    ParallelFor(span.size(), m_numThreads, [&](size_t i) {
+      DecodeChunk(first + i, m_offsets[first + i], &span[i]);
+    });
+
+    // verify each chunk started where the previous one ended; if not, the
+    // chunk start was wrong (e.g. a bad heuristic guess), so decode it again
+    for (size_t i = 0; i < span.size(); ++i) {
+      if (done) {
+        span = span.subspan(0, i);
+        break;
+      }
+      if (span[i].start != pos) {
+        DecodeChunk(first + i, pos, &span[i]);
+      }
+      pos = span[i].end;
+      done = span[i].failed;
+    }
+
+    func(span, first);
+  }
+}
+
+void DataLogParallelReader::ForEachChunk(
+    function_ref<void(size_t chunk, std::span<const DataLogRecord> records)>
+        func) {
+  Decode([&](std::span<Chunk> chunks, size_t index) {
+    ParallelFor(chunks.size(), m_numThreads,
+                [&](size_t i) { func(index + i, chunks[i].records); });
+  });
+}
+
+void DataLogParallelReader::ForEach(
+    function_ref<void(const DataLogRecord& record)> func) {
+  Decode([&](std::span<Chunk> chunks, size_t) {
+    for (auto&& chunk : chunks) {
+      for (auto&& record : chunk.records) {
+        func(record);
+      }
+    }
+  });
+}
+
+wpi::DenseMap<int, std::vector<DataLogRecord>>
+DataLogParallelReader::ReadByEntry() {
+  wpi::DenseMap<int, std::vector<DataLogRecord>> rv;
+  std::vector<wpi::DenseMap<int, std::vector<DataLogRecord>>> grouped;
+  m_blocks.clear();
+  Decode([&](std::span<Chunk> chunks, size_t) {
+    grouped.clear();
+    grouped.resize(chunks.size());
+    ParallelFor(chunks.size(), m_numThreads, [&](size_t i) {
+      for (auto&& record : chunks[i].records) {
+        grouped[i][record.GetEntry()].push_back(record);
+      }
+    });
+    for (auto&& group : grouped) {
+      for (auto&& [entry, records] : group) {
+        auto& out = rv[entry];
+        if (out.empty()) {
+          out = std::move(records);
+        } else {
+          out.insert(out.end(), records.begin(), records.end());
+        }
+      }
+    }
+    // keep the decoded blocks alive for the returned records
+    for (auto&& chunk : chunks) {
+      std::move(chunk.blocks.begin(), chunk.blocks.end(),
+                std::back_inserter(m_blocks));
+      chunk.blocks.clear();
+    }
+  });
+  return rv;
+}
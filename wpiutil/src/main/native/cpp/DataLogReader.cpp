@@ -40,6 +40,105 @@ bool DataLogRecord::IsSetMetadata() const {
          m_data[0] == impl::kControlSetMetadata;
 }
 
+bool DataLogRecord::IsSync() const {
+  return m_entry == 0 && m_data.size() == impl::kSyncPayloadSize &&
+         m_data[0] == impl::kControlSync;
+}
+
+bool DataLogRecord::IsBlock() const {
+  return m_entry == 0 && m_data.size() >= 8 &&
+         m_data[0] == impl::kControlBlock;
+}
+
+bool DataLogRecord::IsSummary() const {
+  return m_entry == 0 && m_data.size() >= 66 &&
+         m_data[0] == impl::kControlSummary;
+}
+
+bool DataLogRecord::IsSummaryEnd() const {
+  return m_entry == 0 && m_data.size() == impl::kSummaryEndPayloadSize &&
+         m_data[0] == impl::kControlSummaryEnd;
+}
+
+static bool ReadUleb128(std::span<const uint8_t>* buf, uint64_t* val) {
+  *val = 0;
+  for (size_t i = 0; i < buf->size() && i < 10; ++i) {
+    uint8_t byte = (*buf)[i];
+    *val |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *buf = buf->subspan(i + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint64_t UnZigZag(uint64_t val) {
+  return (val >> 1) ^ (~(val & 1) + 1);
+}
+
+bool wpi::log::impl::DecodeBlock(const DataLogRecord& record,
+                                 DecodedBlock* out) {
+  if (!record.IsBlock()) {
+    return false;
+  }
+  auto buf = record.GetRaw();
+  out->entry = wpi::support::endian::read32le(&buf[1]);
+  uint8_t encoding = buf[5];
+  buf = buf.subspan(6);
+  uint64_t count;
+  // every sample is at least 2 bytes
+  if (out->entry <= 0 ||
+      (encoding != kBlockInt64 && encoding != kBlockDouble) ||
+      !ReadUleb128(&buf, &count) || count == 0 || count > (buf.size() / 2)) {
+    return false;
+  }
+
+  out->timestamps.resize(count);
+  out->values.resize(count * 8);
+  uint64_t timestamp = record.GetTimestamp();
+  uint64_t delta = 0;
+  uint64_t bits = 0;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t val;
+    if (!ReadUleb128(&buf, &val)) {
+      return false;
+    }
+    delta += UnZigZag(val);
+    timestamp += delta;
+    out->timestamps[i] = timestamp;
+
+    if (encoding == kBlockInt64) {
+      if (!ReadUleb128(&buf, &val)) {
+        return false;
+      }
+      bits += UnZigZag(val);
+    } else {
+      if (buf.empty()) {
+        return false;
+      }
+      uint8_t header = buf[0];
+      buf = buf.subspan(1);
+      if (header != 0x80) {
+        unsigned int lead = header >> 4;
+        unsigned int trail = header & 0xf;
+        if ((lead + trail) >= 8 || buf.size() < (8 - lead - trail)) {
+          return false;
+        }
+        uint64_t x = 0;
+        for (unsigned int j = 0; j < (8 - lead - trail); ++j) {
+          x |= static_cast<uint64_t>(buf[j]) << (8 * j);
+        }
+        buf = buf.subspan(8 - lead - trail);
+        bits ^= x << (8 * trail);
+      }
+    }
+    wpi::support::endian::write64le(&out->values[i * 8], bits);
+  }
+  // any left over?  treat as corrupt
+  return buf.empty();
+}
+
 bool DataLogRecord::GetStartData(StartRecordData* out) const {
   if (!IsStart()) {
     return false;
@@ -75,6 +174,31 @@ bool DataLogRecord::GetSetMetadataData(MetadataRecordData* out) const {
   return ReadString(&buf, &out->metadata);
 }
 
+bool DataLogRecord::GetSummaryData(SummaryRecordData* out) const {
+  if (!IsSummary()) {
+    return false;
+  }
+  out->entry = wpi::support::endian::read32le(&m_data[1]);
+  out->count = wpi::support::endian::read64le(&m_data[5]);
+  out->firstTimestamp = wpi::support::endian::read64le(&m_data[13]);
+  out->lastTimestamp = wpi::support::endian::read64le(&m_data[21]);
+  out->hasValues = (m_data[29] & impl::kSummaryHasValues) != 0;
+  out->min = wpi::BitsToDouble(wpi::support::endian::read64le(&m_data[30]));
+  out->max = wpi::BitsToDouble(wpi::support::endian::read64le(&m_data[38]));
+  out->sum = wpi::BitsToDouble(wpi::support::endian::read64le(&m_data[46]));
+  auto buf = m_data.subspan(54);
+  if (!ReadString(&buf, &out->name)) {
+    return false;
+  }
+  if (!ReadString(&buf, &out->type)) {
+    return false;
+  }
+  if (!ReadString(&buf, &out->metadata)) {
+    return false;
+  }
+  return true;
+}
+
 bool DataLogRecord::GetBoolean(bool* value) const {
   if (m_data.size() != 1) {
     return false;
@@ -190,6 +314,47 @@ bool DataLogRecord::GetStringArray(std::vector<std::string_view>* arr) const {
 DataLogReader::DataLogReader(std::unique_ptr<MemoryBuffer> buffer)
     : m_buf{std::move(buffer)} {}
 
+bool DataLogReader::GetSummary(std::vector<SummaryRecordData>* out) const {
+  out->clear();
+  if (!m_buf) {
+    return false;
+  }
+  // the summary end record is the last record; its payload ends with the
+  // magic string and the offset of the first summary record
+  auto buf = m_buf->GetBuffer();
+  size_t firstPos = GetFirstRecordPos();
+  if (firstPos == SIZE_MAX ||
+      buf.size() < (firstPos + 3 + impl::kSummaryEndPayloadSize)) {
+    return false;
+  }
+  size_t endPayloadPos = buf.size() - impl::kSummaryEndPayloadSize;
+  if (buf[endPayloadPos] != impl::kControlSummaryEnd ||
+      std::string_view{
+          reinterpret_cast<const char*>(&buf[endPayloadPos + 1]),
+          impl::kSummaryMagic.size()} != impl::kSummaryMagic) {
+    return false;
+  }
+  size_t pos = wpi::support::endian::read64le(
+      &buf[endPayloadPos + 1 + impl::kSummaryMagic.size()]);
+  if (pos < firstPos || pos >= endPayloadPos) {
+    return false;
+  }
+
+  DataLogRecord record;
+  while (GetRecord(&pos, &record)) {
+    SummaryRecordData data;
+    if (record.GetSummaryData(&data)) {
+      out->push_back(data);
+    } else if (record.IsSummaryEnd() && pos == buf.size()) {
+      return true;
+    } else {
+      break;
+    }
+  }
+  out->clear();
+  return false;
+}
+
 bool DataLogReader::IsValid() const {
   if (!m_buf) {
     return false;
@@ -226,19 +391,23 @@ std::string_view DataLogReader::GetExtraHeader() const {
   return rv;
 }
 
-DataLogReader::iterator DataLogReader::begin() const {
+size_t DataLogReader::GetFirstRecordPos() const {
   if (!m_buf) {
-    return end();
+    return SIZE_MAX;
   }
   auto buf = m_buf->GetBuffer();
   if (buf.size() < 12) {
-    return end();
+    return SIZE_MAX;
   }
   uint32_t size = wpi::support::endian::read32le(&buf[8]);
   if (buf.size() < (12 + size)) {
-    return end();
+    return SIZE_MAX;
   }
-  return DataLogIterator{this, 12 + size};
+  return 12 + size;
+}
+
+DataLogReader::iterator DataLogReader::begin() const {
+  return DataLogIterator{this, GetFirstRecordPos()};
 }
 
 static uint64_t ReadVarInt(std::span<const uint8_t> buf) {
@@ -251,34 +420,42 @@ static uint64_t ReadVarInt(std::span<const uint8_t> buf) {
   return val;
 }
 
-bool DataLogReader::GetRecord(size_t* pos, DataLogRecord* out) const {
-  if (!m_buf) {
-    return false;
-  }
-  auto buf = m_buf->GetBuffer();
-  if (*pos >= buf.size()) {
-    return false;
-  }
-  buf = buf.subspan(*pos);
+size_t wpi::log::impl::DecodeRecord(std::span<const uint8_t> buf,
+                                    DataLogRecord* out) {
   if (buf.size() < 4) {  // minimum header length
-    return false;
+    return 0;
   }
   unsigned int entryLen = (buf[0] & 0x3) + 1;
   unsigned int sizeLen = ((buf[0] >> 2) & 0x3) + 1;
   unsigned int timestampLen = ((buf[0] >> 4) & 0x7) + 1;
   unsigned int headerLen = 1 + entryLen + sizeLen + timestampLen;
   if (buf.size() < headerLen) {
-    return false;
+    return 0;
   }
   int entry = ReadVarInt(buf.subspan(1, entryLen));
   uint32_t size = ReadVarInt(buf.subspan(1 + entryLen, sizeLen));
   if (size > (buf.size() - headerLen)) {
-    return false;
+    return 0;
   }
   int64_t timestamp =
       ReadVarInt(buf.subspan(1 + entryLen + sizeLen, timestampLen));
   *out = DataLogRecord{entry, timestamp, buf.subspan(headerLen, size)};
-  *pos += headerLen + size;
+  return headerLen + size;
+}
+
+bool DataLogReader::GetRecord(size_t* pos, DataLogRecord* out) const {
+  if (!m_buf) {
+    return false;
+  }
+  auto buf = m_buf->GetBuffer();
+  if (*pos >= buf.size()) {
+    return false;
+  }
+  size_t len = impl::DecodeRecord(buf.subspan(*pos), out);
+  if (len == 0) {
+    return false;
+  }
+  *pos += len;
   return true;
 }
 
@@ -305,3 +482,54 @@ bool DataLogReader::GetNextRecord(size_t* pos) const {
   *pos += headerLen + size;
   return true;
 }
+
+DataLogIterator& DataLogIterator::operator++() {
+  DataLogRecord record;
+  size_t pos = m_pos;
+  if (m_reader->GetRecord(&pos, &record) && record.IsBlock()) {
+    if (auto block = GetBlock(record);
+        block && (m_sample + 1) < block->timestamps.size()) {
+      ++m_sample;
+      m_valid = false;
+      return *this;
+    }
+  }
+  m_sample = 0;
+  if (!m_reader->GetNextRecord(&m_pos)) {
+    m_pos = SIZE_MAX;
+  }
+  m_valid = false;
+  return *this;
+}
+
+DataLogIterator::reference DataLogIterator::operator*() const {
+  if (!m_valid) {
+    size_t pos = m_pos;
+    if (m_reader->GetRecord(&pos, &m_value)) {
+      if (m_value.IsBlock()) {
+        if (auto block = GetBlock(m_value);
+            block && m_sample < block->timestamps.size()) {
+          m_value = block->GetRecord(m_sample);
+        }
+      }
+      m_valid = true;
+    }
+  }
+  return m_value;
+}
+
+const impl::DecodedBlock* DataLogIterator::GetBlock(
+    const DataLogRecord& record) const {
+  if (m_blockPos != m_pos) {
+    // reuse the previous block's storage unless a copy of this iterator (and
+    // thus possibly a record) still refers to it
+    if (!m_block || m_block.use_count() > 1) {
+      m_block = std::make_shared<impl::DecodedBlock>();
+    }
+    if (!impl::DecodeBlock(record, m_block.get())) {
+      m_block.reset();
+    }
+    m_blockPos = m_pos;
+  }
+  return m_block.get();
+}
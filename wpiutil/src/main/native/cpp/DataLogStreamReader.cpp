@@ -0,0 +1,175 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogStreamReader.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "fmt/format.h"
+#include "wpi/Endian.h"
+#include "wpi/raw_istream.h"
+
+using namespace wpi::log;
+
+static constexpr size_t kReadSize = 64 * 1024;
+// how often to check for new data if file notifications are not available
+static constexpr double kPollPeriod = 0.02;
+
+DataLogStreamReader::DataLogStreamReader(std::unique_ptr<raw_istream> is)
+    : m_is{std::move(is)} {}
+
+DataLogStreamReader::DataLogStreamReader(std::string_view filename,
+                                         std::error_code& ec)
+    : m_is{std::make_unique<raw_fd_istream>(filename, ec, kReadSize)} {
+  if (ec) {
+    m_is.reset();
+    m_invalid = true;
+    return;
+  }
+  WatchFile(std::string{filename});
+}
+
+DataLogStreamReader::DataLogStreamReader(int fd, bool shouldClose)
+    : m_is{std::make_unique<raw_fd_istream>(fd, shouldClose, kReadSize)} {
+  WatchFile(fmt::format("/proc/self/fd/{}", fd));
+}
+
+DataLogStreamReader::~DataLogStreamReader() {
+#ifdef __linux__
+  if (m_notifyFd >= 0) {
+    ::close(m_notifyFd);
+  }
+#endif
+}
+
+void DataLogStreamReader::WatchFile(const std::string& path) {
+#ifdef __linux__
+  m_notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_notifyFd < 0) {
+    return;
+  }
+  if (::inotify_add_watch(m_notifyFd, path.c_str(),
+                          IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+    ::close(m_notifyFd);
+    m_notifyFd = -1;
+  }
+#endif
+}
+
+bool DataLogStreamReader::ReadHeader() {
+  std::span<const uint8_t> buf{m_buf};
+  if (buf.size() < 12) {
+    return false;
+  }
+  if (std::string_view{reinterpret_cast<const char*>(buf.data()), 6} !=
+          "WPILOG" ||
+      wpi::support::endian::read16le(&buf[6]) < 0x0100) {
+    m_invalid = true;
+    return false;
+  }
+  uint32_t extraLen = wpi::support::endian::read32le(&buf[8]);
+  if (buf.size() < (12 + extraLen)) {
+    return false;
+  }
+  m_version = wpi::support::endian::read16le(&buf[6]);
+  m_extraHeader.assign(reinterpret_cast<const char*>(&buf[12]), extraLen);
+  m_pos = 12 + extraLen;
+  m_hasHeader = true;
+  return true;
+}
+
+size_t DataLogStreamReader::Poll(
+    function_ref<void(const DataLogRecord& record)> func) {
+  if (!m_is || m_invalid) {
+    return 0;
+  }
+  size_t count = 0;
+  for (;;) {
+    // discard consumed data, keeping any partial record
+    if (m_pos != 0) {
+      m_buf.erase(m_buf.begin(), m_buf.begin() + m_pos);
+      m_pos = 0;
+    }
+
+    size_t oldSize = m_buf.size();
+    m_buf.resize(oldSize + kReadSize);
+    m_is->read(m_buf.data() + oldSize, kReadSize);
+    size_t readCount = m_is->read_count();
+    m_buf.resize(oldSize + readCount);
+    // end of file just means the writer hasn't written more yet
+    if (m_is->has_error()) {
+      m_is->clear_error();
+    }
+
+    if (m_hasHeader || ReadHeader()) {
+      std::span<const uint8_t> buf{m_buf};
+      DataLogRecord record;
+      for (size_t len; (len = impl::DecodeRecord(buf.subspan(m_pos), &record));
+           m_pos += len) {
+        if (record.IsBlock() && impl::DecodeBlock(record, &m_block)) {
+          for (size_t i = 0; i < m_block.timestamps.size(); ++i) {
+            func(m_block.GetRecord(i));
+            ++count;
+          }
+          continue;
+        }
+        func(record);
+        ++count;
+      }
+    } else if (m_invalid) {
+      return count;
+    }
+
+    if (readCount < kReadSize) {
+      return count;
+    }
+  }
+}
+
+void DataLogStreamReader::Wait(double timeout) {
+  if (timeout <= 0) {
+    return;
+  }
+#ifdef __linux__
+  if (m_notifyFd >= 0) {
+    pollfd pfd{m_notifyFd, POLLIN, 0};
+    if (::poll(&pfd, 1, static_cast<int>(std::ceil(timeout * 1000))) > 0) {
+      // drain events; any later change generates a new event
+      char buf[4096];
+      while (::read(m_notifyFd, buf, sizeof(buf)) > 0) {
+      }
+    }
+    return;
+  }
+#endif
+  std::this_thread::sleep_for(
+      std::chrono::duration<double>((std::min)(timeout, kPollPeriod)));
+}
+
+size_t DataLogStreamReader::Follow(
+    function_ref<void(const DataLogRecord& record)> func, double timeout) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double>(timeout));
+  for (;;) {
+    size_t count = Poll(func);
+    if (count != 0) {
+      return count;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return 0;
+    }
+    Wait(std::chrono::duration<double>(deadline - now).count());
+  }
+}
@@ -118,6 +118,31 @@ void MappedFileRegion::Unmap() {
   m_mapping = nullptr;
 }
 
+void MappedFileRegion::Advise(Advice advice) {
+  if (!m_mapping) {
+    return;
+  }
+#ifndef _WIN32
+  int flag = MADV_NORMAL;
+  switch (advice) {
+    case kNormal:
+      break;
+    case kSequential:
+      flag = MADV_SEQUENTIAL;
+      break;
+    case kRandom:
+      flag = MADV_RANDOM;
+      break;
+    case kDontNeed:
+      flag = MADV_DONTNEED;
+      break;
+  }
+  ::madvise(m_mapping, m_size, flag);
+#else
+  (void)advice;
+#endif
+}
+
 size_t MappedFileRegion::GetAlignment() {
 #ifdef _WIN32
   SYSTEM_INFO SysInfo;
@@ -6,6 +6,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <functional>
 #include <initializer_list>
 #include <memory>
@@ -31,9 +32,37 @@ namespace impl {
 enum ControlRecordType {
   kControlStart = 0,
   kControlFinish,
-  kControlSetMetadata
+  kControlSetMetadata,
+  kControlSync,
+  kControlBlock,
+  kControlSummary,
+  kControlSummaryEnd
 };
 
+/** Value encodings used in block records. */
+enum BlockEncoding {
+  /** int64 values; zigzag LEB128 delta from the previous value. */
+  kBlockInt64 = 0,
+  /** double values; XOR with the previous value, zero bytes omitted. */
+  kBlockDouble
+};
+
+/** Magic string that follows the control record type in sync records. */
+inline constexpr std::string_view kSyncMagic = "WPILSYNC";
+
+/** Payload size of sync records (type, magic, and 8-byte offset). */
+inline constexpr uint32_t kSyncPayloadSize = 1 + kSyncMagic.size() + 8;
+
+/** Magic string that follows the control record type in summary end records. */
+inline constexpr std::string_view kSummaryMagic = "WPILSUMM";
+
+/** Payload size of summary end records (type, magic, and 8-byte offset). */
+inline constexpr uint32_t kSummaryEndPayloadSize =
+    1 + kSummaryMagic.size() + 8;
+
+/** Flag in summary records indicating min, max, and sum are valid. */
+inline constexpr uint8_t kSummaryHasValues = 0x01;
+
 }  // namespace impl
 
 /**
@@ -56,15 +85,76 @@ enum ControlRecordType {
  * good idea to call Finish() from destructors for this reason.
  *
  * DataLog calls are thread safe.  DataLog uses a typical multiple-supplier,
- * single-consumer setup.  Writes to the log are atomic, but there is no
- * guaranteed order in the log when multiple threads are writing to it;
- * whichever thread grabs the write mutex first will get written first.
- * For this reason (as well as the fact that timestamps can be set to
- * arbitrary values), records in the log are not guaranteed to be sorted by
- * timestamp.
+ * single-consumer setup.  To avoid contention between appending threads, each
+ * thread appends data records to its own buffer; these per-thread buffers are
+ * handed to the writer thread in batches (when full or at each flush).  Writes
+ * to the log are atomic, and records appended by a single thread appear in the
+ * log in the order they were appended, but there is no guaranteed order
+ * between records appended concurrently by different threads.  Control
+ * records (Start, Finish, SetMetadata) are ordered after all data records
+ * appended before the call was made, on any thread.  For this reason (as well
+ * as the fact that timestamps can be set to arbitrary values), records in the
+ * log are not guaranteed to be sorted by timestamp.
+ *
+ * The writer thread periodically inserts sync control records between
+ * records; readers can use these to split the log into chunks that can be
+ * decoded independently (see DataLogParallelReader).
+ *
+ * The writer thread also keeps statistics for each entry (number of records,
+ * timestamp range, and for numeric and boolean entries, the minimum, maximum,
+ * and sum of the values).  When the log is closed (or rotated), these are
+ * written as summary control records at the end of the file, so readers can
+ * get them without reading the entire log (see DataLogReader::GetSummary()).
  */
 class DataLog final {
  public:
+  /**
+   * What to do with new data records when the buffer limit set by
+   * SetBufferLimit() has been reached.
+   */
+  enum class OverflowPolicy {
+    /** Block the appending thread until the writer thread frees space. */
+    kBlock,
+    /** Drop new data records. */
+    kDropNewest,
+    /**
+     * Drop new data records based on the entry priority (see SetPriority()).
+     * Records for entries with negative priority are dropped once half of the
+     * limit is in use, records for entries with zero (default) priority are
+     * dropped once three quarters of the limit is in use, and records for
+     * entries with positive priority are dropped once the limit is reached.
+     */
+    kDropLowPriority
+  };
+
+  /**
+   * Per-entry write policy, applied when values are appended (before they
+   * are buffered).  See SetWritePolicy().
+   */
+  struct WritePolicy {
+    /**
+     * Minimum time between written values, in seconds; 0 for no limit.
+     * Values appended sooner than this after the last written value are
+     * suppressed.
+     */
+    double minPeriod = 0;
+
+    /**
+     * Deadband for boolean, int64, float, and double entries.  Values that
+     * differ from the last written value by no more than this are
+     * suppressed; 0 suppresses only repeated values.  Negative to disable.
+     */
+    double deadband = -1;
+
+    /**
+     * For boolean, int64, float, and double entries, write the latest value
+     * in each minPeriod interval rather than the first.  The latest value is
+     * held until the interval ends, so it is written with a delay of up to
+     * minPeriod (plus the flush period).
+     */
+    bool latest = false;
+  };
+
   /**
    * Construct a new Data Log.  The log will be initially created with a
    * temporary filename.
@@ -132,12 +222,32 @@ class DataLog final {
   DataLog& operator=(const DataLog&&) = delete;
 
   /**
-   * Change log filename.
+   * Change log filename.  If log rotation is enabled, this also changes the
+   * base name used for later files.
    *
    * @param filename filename
    */
   void SetFilename(std::string_view filename);
 
+  /**
+   * Enables automatic log rotation.  When the current file reaches the
+   * maximum size or age, the writer thread closes it and continues in a new
+   * file named after the original one (e.g. "foo_1.wpilog", "foo_2.wpilog",
+   * etc, for "foo.wpilog").  Each new file starts with start records
+   * (including current metadata) for all active entries, so each file can be
+   * read on its own.
+   *
+   * The next file is opened (and, if possible, preallocated) ahead of time by
+   * the writer thread, so appends never wait for the switch.  Rotation
+   * happens at flush boundaries, so files may be slightly larger or older
+   * than the limits.  This has no effect for logs written to a callback
+   * function.
+   *
+   * @param maxBytes maximum file size in bytes; 0 for no size limit
+   * @param maxTime maximum file age in seconds; 0 for no time limit
+   */
+  void SetRotation(uint64_t maxBytes, double maxTime = 0);
+
   /**
    * Explicitly flushes the log data to disk.
    */
@@ -155,6 +265,82 @@ class DataLog final {
    */
   void Resume();
 
+  /**
+   * Limits the amount of memory used to buffer data records that have not yet
+   * been written (e.g. because the storage device is slow).  By default there
+   * is no limit.  Control records (e.g. entry starts) are never dropped.
+   * Whenever records have been dropped, the total number of dropped records
+   * and bytes are logged to the "DataLog/droppedRecords" and
+   * "DataLog/droppedBytes" entries.
+   *
+   * @param maxBytes maximum number of buffered bytes; 0 for no limit
+   * @param policy what to do when the limit is reached
+   */
+  void SetBufferLimit(size_t maxBytes,
+                      OverflowPolicy policy = OverflowPolicy::kDropNewest);
+
+  /**
+   * Sets the priority of an entry.  This is used by the kDropLowPriority
+   * overflow policy to determine which records to drop first.
+   *
+   * @param entry Entry index
+   * @param priority Priority; negative is low, 0 is default, positive is high
+   */
+  void SetPriority(int entry, int priority);
+
+  /**
+   * Gets the total number of data records dropped due to the buffer limit.
+   *
+   * @return Number of dropped records
+   */
+  uint64_t GetDroppedRecords() const;
+
+  /**
+   * Gets the total number of data bytes dropped due to the buffer limit.
+   *
+   * @return Number of dropped payload bytes
+   */
+  uint64_t GetDroppedBytes() const;
+
+  /**
+   * Sets the write policy of an entry.  Write policies reduce the amount of
+   * data logged for entries that are appended much more often than needed
+   * (e.g. sensor values read at 1 kHz), by rate limiting, deadband, or
+   * decimation.  Suppressed values are counted (see GetSuppressedCount()).
+   * Appends to entries with a write policy take the log mutex.
+   *
+   * @param entry Entry index
+   * @param policy Write policy; a default-constructed policy removes any
+   *               existing policy
+   */
+  void SetWritePolicy(int entry, const WritePolicy& policy);
+
+  /**
+   * Gets the number of values suppressed by the write policy of an entry.
+   *
+   * @param entry Entry index
+   * @return Number of suppressed values
+   */
+  uint64_t GetSuppressedCount(int entry) const;
+
+  /**
+   * Enables or disables block encoding for an int64 or double entry.  Rather
+   * than writing a full record for each value, values for block encoded
+   * entries are buffered and periodically written as a single block record,
+   * with delta-of-delta encoded timestamps and delta (int64) or XOR (double)
+   * encoded values.  This typically makes high rate numeric entries several
+   * times smaller.  DataLogReader expands block records into ordinary
+   * records, but readers that don't support block records (e.g. older
+   * versions) will ignore them.
+   *
+   * Appends to block encoded entries take the log mutex, so they are slower
+   * than appends to other entries when multiple threads are appending.
+   *
+   * @param entry Entry index
+   * @param enable True to enable block encoding, false to disable it
+   */
+  void SetBlockEncoding(int entry, bool enable = true);
+
   /**
    * Start an entry.  Duplicate names are allowed (with the same type), and
    * result in the same index being returned (Start/Finish are reference
@@ -231,11 +417,103 @@ class DataLog final {
                          int64_t timestamp);
 
  private:
+  class Buffer;
+  class ThreadBuffer;
+  class BlockEncoder;
+
+  // Set of entries that need special handling when appending.  Entries below
+  // kBits are tracked in a bitmap so that appends to other entries can check
+  // without taking the mutex.  Modified only with m_mutex held.
+  class EntrySet {
+   public:
+    // may return true for entries not in the set
+    bool MaybeContains(int entry) const {
+      if (m_count.load(std::memory_order_relaxed) == 0) {
+        return false;
+      }
+      if (entry < kBits) {
+        return (m_bits[entry / 64].load(std::memory_order_relaxed) >>
+                (entry % 64)) &
+               1;
+      }
+      return true;
+    }
+    void Insert(int entry) {
+      ++m_count;
+      if (entry < kBits) {
+        m_bits[entry / 64] |= uint64_t{1} << (entry % 64);
+      }
+    }
+    void Erase(int entry) {
+      --m_count;
+      if (entry < kBits) {
+        m_bits[entry / 64] &= ~(uint64_t{1} << (entry % 64));
+      }
+    }
+
+   private:
+    static constexpr int kBits = 4096;
+    std::atomic<int> m_count{0};
+    std::atomic<uint64_t> m_bits[kBits / 64] = {};
+  };
+
+  struct WritePolicyState {
+    int64_t minPeriod;  // microseconds
+    double deadband;
+    bool latest;
+    // last written value
+    bool hasLast = false;
+    int64_t lastTimestamp = 0;
+    double lastValue = 0;
+    // held value (latest policy)
+    bool held = false;
+    int64_t windowEnd = 0;
+    int64_t heldTimestamp = 0;
+    double heldValue = 0;
+    uint8_t heldData[8];
+    uint8_t heldSize = 0;
+    uint64_t suppressed = 0;
+  };
+
   void WriterThreadMain(std::string_view dir);
   void WriterThreadMain(
       std::function<void(std::span<const uint8_t> data)> write);
 
+  // appends a record of at most kBlockSize total bytes to the calling
+  // thread's buffer; fill is called with a pointer to the payload
+  template <typename F>
+  void AppendThreadRecord(int entry, int64_t timestamp, size_t payloadSize,
+                          F&& fill);
+  ThreadBuffer& GetThreadBuffer();
+
+  // returns an unlocked lock if the record should be dropped
+  std::unique_lock<wpi::mutex> LockLargeRecord(int entry, size_t payloadSize);
+
+  // returns false if the entry is not (or is no longer) block encoded
+  bool AppendBlockSample(int entry, int64_t timestamp, uint64_t bits);
+
+  // returns false if the value should not be written; scalar is the payload
+  // of scalar (boolean or numeric) values (empty otherwise), and value its
+  // numeric value.  Fills in the timestamp if 0.
+  bool CheckWritePolicy(int entry, int64_t* timestamp,
+                        std::span<const uint8_t> scalar = {},
+                        double value = 0);
   // must be called with m_mutex held
+  void WriteHeld(int entry, WritePolicyState& state);
+  // writes held values whose interval has ended (or all if all is true)
+  void WriteHeldValues(bool all);
+
+  // must be called with m_mutex held
+  bool CheckBufferLimit(std::unique_lock<wpi::mutex>& lock, int entry,
+                        size_t count, size_t payloadSize);
+  void LogDropped(std::unique_lock<wpi::mutex>& lock);
+  void ReleaseBuffers(std::vector<Buffer>& bufs);
+  void SealThreadBuffers();
+  void WriteBlock(int entry, BlockEncoder& encoder);
+  void WriteBlocks();
+  // start records for all active entries, for the start of a rotated file
+  std::vector<uint8_t> MakeActiveStartRecords() const;
+  Buffer AllocBuffer();
   uint8_t* StartRecord(uint32_t entry, uint64_t timestamp, uint32_t payloadSize,
                        size_t reserveSize);
   uint8_t* Reserve(size_t size);
@@ -247,19 +525,41 @@ class DataLog final {
   wpi::condition_variable m_cond;
   bool m_active{true};
   bool m_doFlush{false};
-  bool m_paused{false};
+  std::atomic_bool m_paused{false};
   double m_period;
   std::string m_extraHeader;
   std::string m_newFilename;
-  class Buffer;
+  uint64_t m_rotateBytes{0};
+  double m_rotateTime{0};
   std::vector<Buffer> m_free;
   std::vector<Buffer> m_outgoing;
+  // shared with the owning thread, which marks its buffers when it exits
+  std::vector<std::shared_ptr<ThreadBuffer>> m_threadBuffers;
+  uint64_t m_instance;
+  wpi::condition_variable m_bufferCond;
+  size_t m_maxBuffers{0};
+  OverflowPolicy m_overflowPolicy{OverflowPolicy::kDropNewest};
+  std::atomic<size_t> m_buffersInUse{0};
+  // appends check priority (slow path) when this many buffers are in use
+  std::atomic<size_t> m_priorityThreshold{SIZE_MAX};
+  wpi::DenseMap<int, int> m_entryPriorities;
+  uint64_t m_droppedRecords{0};
+  uint64_t m_droppedBytes{0};
+  uint64_t m_loggedDroppedRecords{0};
+  int m_droppedRecordsEntry{0};
+  int m_droppedBytesEntry{0};
+  wpi::DenseMap<int, std::unique_ptr<BlockEncoder>> m_blockEncoders;
+  EntrySet m_blockEntries;
+  wpi::DenseMap<int, WritePolicyState> m_writePolicies;
+  EntrySet m_writePolicyEntries;
   struct EntryInfo {
     std::string type;
     int id{0};
   };
   wpi::StringMap<EntryInfo> m_entries;
   wpi::DenseMap<int, unsigned int> m_entryCounts;
+  // current metadata of active entries (needed for log rotation)
+  wpi::DenseMap<int, std::string> m_entryMetadata;
   int m_lastId = 0;
   std::thread m_thread;
 };
@@ -303,6 +603,42 @@ class DataLogEntry {
     m_log->SetMetadata(m_entry, metadata, timestamp);
   }
 
+  /**
+   * Sets the priority of the entry (used when the log buffer limit is
+   * reached).  See DataLog::SetPriority().
+   *
+   * @param priority Priority; negative is low, 0 is default, positive is high
+   */
+  void SetPriority(int priority) { m_log->SetPriority(m_entry, priority); }
+
+  /**
+   * Enables or disables block encoding of the entry.  See
+   * DataLog::SetBlockEncoding().
+   *
+   * @param enable True to enable block encoding, false to disable it
+   */
+  void SetBlockEncoding(bool enable = true) {
+    m_log->SetBlockEncoding(m_entry, enable);
+  }
+
+  /**
+   * Sets the write policy of the entry.  See DataLog::SetWritePolicy().
+   *
+   * @param policy Write policy
+   */
+  void SetWritePolicy(const DataLog::WritePolicy& policy) {
+    m_log->SetWritePolicy(m_entry, policy);
+  }
+
+  /**
+   * Gets the number of values suppressed by the write policy of the entry.
+   *
+   * @return Number of suppressed values
+   */
+  uint64_t GetSuppressedCount() const {
+    return m_log->GetSuppressedCount(m_entry);
+  }
+
   /**
    * Finishes the entry.
    *
@@ -0,0 +1,121 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "wpi/DataLogReader.h"
+#include "wpi/DenseMap.h"
+
+namespace wpi {
+class raw_ostream;
+}  // namespace wpi
+
+namespace wpi::log {
+
+/**
+ * Random access index for a data log.  Maps each entry ID to the offsets of
+ * its records, and coarse timestamps to file offsets, so that a single entry
+ * or a time window can be read without scanning the entire log.
+ *
+ * The index is built with a single pass over the log.  It can be saved to a
+ * sidecar file with Save() and loaded again later with Load() to avoid
+ * rebuilding it.
+ */
+class DataLogIndex {
+ public:
+  /** Default time resolution of the time index, in microseconds. */
+  static constexpr int64_t kDefaultTimeResolution = 100000;
+
+  DataLogIndex() = default;
+
+  /**
+   * Builds an index by scanning a data log.
+   *
+   * @param reader data log reader
+   * @param timeResolution time resolution of the time index, in microseconds
+   */
+  explicit DataLogIndex(const DataLogReader& reader,
+                        int64_t timeResolution = kDefaultTimeResolution);
+
+  /** Returns true if the index is valid (e.g. was built or loaded). */
+  explicit operator bool() const { return IsValid(); }
+
+  /** Returns true if the index is valid (e.g. was built or loaded). */
+  bool IsValid() const { return m_logSize != 0; }
+
+  /**
+   * Gets the offsets of all records for an entry ID, in file order.  Entry ID
+   * 0 returns the offsets of all control records, except for block records,
+   * which are included in the offsets of the entry they contain samples of
+   * (use impl::DecodeBlock() to expand them).  Use
+   * DataLogReader::GetRecordAt() to read the records.
+   *
+   * @param entry entry ID
+   * @return Record offsets
+   */
+  std::span<const size_t> GetRecordOffsets(int entry) const;
+
+  /**
+   * Gets an iterator positioned such that all records with timestamps at or
+   * after the given timestamp are at or after the iterator position.  Due to
+   * the coarse resolution of the index (and because records in a log are not
+   * guaranteed to be sorted by timestamp), records with earlier timestamps may
+   * still follow; callers should skip those.
+   *
+   * @param reader data log reader the index was built from
+   * @param timestamp timestamp, in integer microseconds
+   * @return Iterator
+   */
+  DataLogIterator SeekTime(const DataLogReader& reader,
+                           int64_t timestamp) const;
+
+  /**
+   * Gets the minimum record timestamp in the log.
+   *
+   * @return Timestamp, in integer microseconds
+   */
+  int64_t GetMinTimestamp() const { return m_minTimestamp; }
+
+  /**
+   * Gets the maximum record timestamp in the log.
+   *
+   * @return Timestamp, in integer microseconds
+   */
+  int64_t GetMaxTimestamp() const { return m_maxTimestamp; }
+
+  /**
+   * Saves the index (e.g. to a sidecar file).
+   *
+   * @param os output stream
+   */
+  void Save(wpi::raw_ostream& os) const;
+
+  /**
+   * Loads a saved index.  Fails if the data is corrupt or if the index was
+   * built from a different log (as determined by the log size).
+   *
+   * @param data saved index data
+   * @param reader data log reader for the log the index was built from
+   * @return True on success, false on error
+   */
+  bool Load(std::span<const uint8_t> data, const DataLogReader& reader);
+
+ private:
+  size_t m_logSize = 0;
+  int64_t m_timeResolution = kDefaultTimeResolution;
+  int64_t m_minTimestamp = 0;
+  int64_t m_maxTimestamp = 0;
+  wpi::DenseMap<int, std::vector<size_t>> m_offsets;
+  // sorted by time bucket; offset is the minimum offset of any record in
+  // that bucket or any later bucket
+  std::vector<std::pair<int64_t, size_t>> m_timeIndex;
+};
+
+}  // namespace wpi::log
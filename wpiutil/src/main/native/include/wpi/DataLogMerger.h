@@ -0,0 +1,148 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "wpi/DataLogReader.h"
+#include "wpi/DenseMap.h"
+
+namespace wpi {
+class raw_ostream;
+}  // namespace wpi
+
+namespace wpi::log {
+
+/**
+ * Merges multiple data logs into a single data log, optionally keeping only
+ * some of the entries and/or a window of time.
+ *
+ * Records from the input logs are interleaved in timestamp order (each input
+ * log's records stay in file order).  Entry IDs are remapped as necessary
+ * so they don't conflict; entries with the same name and type in multiple
+ * input logs are merged into a single output entry.  Records are copied
+ * without decoding: records whose entry ID doesn't change are copied byte for
+ * byte, and records whose entry ID changes only get a new record header (and,
+ * for control records, a patched entry ID).
+ *
+ * Sync records are written for the output log as DataLog does.  Sync and
+ * summary records in the input logs are not copied, as they only apply to
+ * the input log.
+ */
+class DataLogMerger {
+ public:
+  DataLogMerger() = default;
+
+  /**
+   * Adds an input log.  The reader must remain valid until Merge() returns.
+   *
+   * @param reader data log reader
+   */
+  void AddInput(const DataLogReader& reader);
+
+  /**
+   * Includes the entry with the given name.  If no names or prefixes are
+   * included, all entries are included.
+   *
+   * @param name entry name
+   */
+  void IncludeEntry(std::string_view name);
+
+  /**
+   * Includes all entries with names that start with the given prefix.  If no
+   * names or prefixes are included, all entries are included.
+   *
+   * @param prefix entry name prefix
+   */
+  void IncludePrefix(std::string_view prefix);
+
+  /**
+   * Only keeps data records with timestamps in the given range.  Control
+   * records (e.g. entry starts) of included entries are always kept.
+   *
+   * @param start start time (inclusive), in microseconds
+   * @param end end time (exclusive), in microseconds
+   */
+  void SetTimeRange(int64_t start, int64_t end);
+
+  /**
+   * Sets the extra header data of the output log.
+   *
+   * @param extraHeader extra header data
+   */
+  void SetExtraHeader(std::string_view extraHeader) {
+    m_extraHeader = extraHeader;
+  }
+
+  /**
+   * Merges the input logs.  Write errors are reported by the output stream.
+   *
+   * @param os output stream for the merged log
+   * @return False if an input log is invalid
+   */
+  bool Merge(raw_ostream& os);
+
+  /**
+   * Gets the number of records copied byte for byte by the last Merge().
+   *
+   * @return Number of records
+   */
+  uint64_t GetCopiedRecords() const { return m_copied; }
+
+  /**
+   * Gets the number of records written with a new entry ID (or, for block
+   * records partially outside the time range, split into individual records)
+   * by the last Merge().
+   *
+   * @return Number of records
+   */
+  uint64_t GetRewrittenRecords() const { return m_rewritten; }
+
+ private:
+  struct Input;
+
+  struct OutputEntry {
+    std::string name;
+    std::string type;
+    int refs = 0;
+  };
+
+  bool IsIncluded(std::string_view name) const;
+  bool IsInTimeRange(int64_t timestamp) const {
+    return timestamp >= m_startTime && timestamp < m_endTime;
+  }
+  int AllocateEntry(int preferred);
+  void ProcessRecord(Input& in);
+  void WriteRecord(std::span<const uint8_t> raw, const DataLogRecord& record,
+                   int entry);
+  void BeginRecord(int64_t timestamp);
+  void Write(std::span<const uint8_t> data);
+
+  std::vector<const DataLogReader*> m_inputs;
+  std::set<std::string, std::less<>> m_names;
+  std::vector<std::string> m_prefixes;
+  int64_t m_startTime = INT64_MIN;
+  int64_t m_endTime = INT64_MAX;
+  std::string m_extraHeader;
+
+  // merge state
+  raw_ostream* m_os = nullptr;
+  uint64_t m_offset = 0;
+  uint64_t m_lastSync = 0;
+  wpi::DenseMap<int, OutputEntry> m_outputEntries;
+  std::map<std::string, int, std::less<>> m_outputNames;
+  int m_nextEntry = 1;
+  uint64_t m_copied = 0;
+  uint64_t m_rewritten = 0;
+};
+
+}  // namespace wpi::log
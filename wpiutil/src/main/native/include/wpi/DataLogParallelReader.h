@@ -0,0 +1,114 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "wpi/DataLogReader.h"
+#include "wpi/DenseMap.h"
+#include "wpi/function_ref.h"
+
+namespace wpi::log {
+
+/**
+ * Decodes a data log using multiple threads.  The log is split into chunks
+ * that are decoded concurrently.  Chunk boundaries are placed at the sync
+ * control records periodically written by DataLog; for logs without sync
+ * records (e.g. written by older versions), boundaries are found
+ * heuristically by looking for a run of plausible records.
+ *
+ * Chunk boundaries are verified against the end of the preceding chunk after
+ * decoding, and any chunk with a mismatched start is decoded again from the
+ * correct position, so the results are always identical to decoding the log
+ * sequentially with DataLogReader.
+ *
+ * Records refer to the data log buffer, so the DataLogReader must outlive any
+ * records provided by this class.  Records expanded from block records refer
+ * to decoded copies of the blocks, which are only kept for the duration of
+ * the callback (or, for ReadByEntry(), until the next call or until this
+ * object is destroyed).
+ */
+class DataLogParallelReader {
+ public:
+  /** Minimum automatically selected chunk size, in bytes. */
+  static constexpr size_t kMinChunkSize = 1024 * 1024;
+
+  /** Maximum automatically selected chunk size, in bytes. */
+  static constexpr size_t kMaxChunkSize = 64 * 1024 * 1024;
+
+  /**
+   * Constructs a parallel reader.  This determines the chunk boundaries.
+   *
+   * @param reader data log reader
+   * @param numThreads number of decoding threads; 0 to use the number of
+   *                   hardware threads
+   * @param chunkSize target chunk size in bytes; 0 to select automatically
+   */
+  explicit DataLogParallelReader(const DataLogReader& reader,
+                                 unsigned int numThreads = 0,
+                                 size_t chunkSize = 0);
+
+  /**
+   * Gets the file offsets of the start of each chunk.
+   *
+   * @return Chunk offsets
+   */
+  std::span<const size_t> GetChunkOffsets() const { return m_offsets; }
+
+  /**
+   * Decodes the log, calling a function for each chunk of records.  The
+   * function is called concurrently from multiple threads; each call gets a
+   * chunk index (chunks are in file order) and the records in that chunk (in
+   * file order).
+   *
+   * @param func function to call for each chunk
+   */
+  void ForEachChunk(
+      function_ref<void(size_t chunk, std::span<const DataLogRecord> records)>
+          func);
+
+  /**
+   * Decodes the log, calling a function for each record in file order.  The
+   * function is called from the calling thread.
+   *
+   * @param func function to call for each record
+   */
+  void ForEach(function_ref<void(const DataLogRecord& record)> func);
+
+  /**
+   * Decodes the entire log, grouping records by entry ID.  Control records are
+   * grouped under entry ID 0.
+   *
+   * @return Map from entry ID to records (in file order)
+   */
+  wpi::DenseMap<int, std::vector<DataLogRecord>> ReadByEntry();
+
+ private:
+  struct Chunk {
+    size_t start = 0;
+    size_t end = 0;
+    bool failed = false;
+    std::vector<DataLogRecord> records;
+    // decoded block records (referred to by records)
+    std::vector<std::unique_ptr<impl::DecodedBlock>> blocks;
+  };
+
+  size_t FindChunkStart(size_t pos, size_t limit) const;
+  size_t Resync(size_t pos) const;
+  void DecodeChunk(size_t index, size_t start, Chunk* chunk) const;
+  void Decode(function_ref<void(std::span<Chunk> chunks, size_t index)> func);
+
+  const DataLogReader& m_reader;
+  unsigned int m_numThreads;
+  std::vector<size_t> m_offsets;
+  // decoded block records referred to by the result of ReadByEntry()
+  std::vector<std::unique_ptr<impl::DecodedBlock>> m_blocks;
+};
+
+}  // namespace wpi::log
@@ -47,6 +47,49 @@ struct MetadataRecordData {
   std::string_view metadata;
 };
 
+/**
+ * Data contained in a summary control record, written by DataLog at the end
+ * of the log.  This can be read by calling DataLogRecord::GetSummaryData() or
+ * DataLogReader::GetSummary().
+ */
+struct SummaryRecordData {
+  /** Entry ID. */
+  int entry;
+
+  /** Entry name. */
+  std::string_view name;
+
+  /** Type of the stored data for this entry, as a string, e.g. "double". */
+  std::string_view type;
+
+  /** Metadata (as of the end of the log). */
+  std::string_view metadata;
+
+  /** Number of data records. */
+  uint64_t count;
+
+  /** Earliest data record timestamp, in integer microseconds. */
+  int64_t firstTimestamp;
+
+  /** Latest data record timestamp, in integer microseconds. */
+  int64_t lastTimestamp;
+
+  /**
+   * True if min, max, and sum are valid.  These are only kept for boolean,
+   * int64, float, and double entries.
+   */
+  bool hasValues;
+
+  /** Minimum value. */
+  double min;
+
+  /** Maximum value. */
+  double max;
+
+  /** Sum of values. */
+  double sum;
+};
+
 /**
  * A record in the data log. May represent either a control record (entry == 0)
  * or a data record. Used only for reading (e.g. with DataLogReader).
@@ -115,6 +158,43 @@ class DataLogRecord {
    */
   bool IsSetMetadata() const;
 
+  /**
+   * Returns true if the record is a sync control record. Sync records mark
+   * points where decoding can start (see DataLogParallelReader) and carry no
+   * other data; they can be ignored by most readers.
+   *
+   * @return True if sync control record, false otherwise.
+   */
+  bool IsSync() const;
+
+  /**
+   * Returns true if the record is a block control record, containing multiple
+   * samples of a single entry (see DataLog::SetBlockEncoding()).  Iterating
+   * over DataLogReader expands blocks into individual records, so these are
+   * only seen when reading records by file offset (e.g. via DataLogIndex).
+   * Use impl::DecodeBlock() to decode the contents.
+   *
+   * @return True if block control record, false otherwise.
+   */
+  bool IsBlock() const;
+
+  /**
+   * Returns true if the record is a summary control record. Use
+   * GetSummaryData() to decode the contents.
+   *
+   * @return True if summary control record, false otherwise.
+   */
+  bool IsSummary() const;
+
+  /**
+   * Returns true if the record is a summary end control record.  This is the
+   * last record in a log with summary records, and points to the first
+   * summary record; it carries no other data.
+   *
+   * @return True if summary end control record, false otherwise.
+   */
+  bool IsSummaryEnd() const;
+
   /**
    * Decodes a start control record.
    *
@@ -139,6 +219,14 @@ class DataLogRecord {
    */
   bool GetSetMetadataData(MetadataRecordData* out) const;
 
+  /**
+   * Decodes a summary control record.
+   *
+   * @param[out] out summary record decoded data (if successful)
+   * @return True on success, false on error
+   */
+  bool GetSummaryData(SummaryRecordData* out) const;
+
   /**
    * Decodes a data record as a boolean. Note if the data type (as indicated in
    * the corresponding start control record for this entry) is not "boolean",
@@ -245,8 +333,55 @@ class DataLogRecord {
   int m_entry{-1};
 };
 
+namespace impl {
+/**
+ * Decodes a single record from the start of a buffer.
+ *
+ * @param buf buffer
+ * @param[out] out record (if successful); refers to the buffer contents
+ * @return Number of bytes used by the record, or 0 if the buffer does not
+ *         start with a complete record
+ */
+size_t DecodeRecord(std::span<const uint8_t> buf, DataLogRecord* out);
+
+/** Decoded contents of a block control record. */
+struct DecodedBlock {
+  /** Entry ID. */
+  int entry = 0;
+
+  /** Sample timestamps. */
+  std::vector<int64_t> timestamps;
+
+  /** Sample values; each is 8 bytes, in the normal record encoding. */
+  std::vector<uint8_t> values;
+
+  /**
+   * Gets the record for a sample.  The record refers to the values vector.
+   *
+   * @param i sample index
+   * @return Record
+   */
+  DataLogRecord GetRecord(size_t i) const {
+    return {entry, timestamps[i], std::span{values}.subspan(i * 8, 8)};
+  }
+};
+
+/**
+ * Decodes a block control record.
+ *
+ * @param record block control record
+ * @param[out] out decoded block (if successful)
+ * @return True on success, false on error
+ */
+bool DecodeBlock(const DataLogRecord& record, DecodedBlock* out);
+}  // namespace impl
+
 class DataLogReader;
 
+namespace impl {
+class DataLogReaderAccess;
+}  // namespace impl
+
 /** DataLogReader iterator. */
 class DataLogIterator {
  public:
@@ -259,13 +394,16 @@ class DataLogIterator {
       : m_reader{reader}, m_pos{pos} {}
 
   bool operator==(const DataLogIterator& oth) const {
-    return m_reader == oth.m_reader && m_pos == oth.m_pos;
+    return m_reader == oth.m_reader && m_pos == oth.m_pos &&
+           m_sample == oth.m_sample;
   }
   bool operator!=(const DataLogIterator& oth) const {
     return !this->operator==(oth);
   }
 
-  bool operator<(const DataLogIterator& oth) const { return m_pos < oth.m_pos; }
+  bool operator<(const DataLogIterator& oth) const {
+    return m_pos < oth.m_pos || (m_pos == oth.m_pos && m_sample < oth.m_sample);
+  }
   bool operator>(const DataLogIterator& oth) const {
     return !this->operator<(oth) && !this->operator==(oth);
   }
@@ -284,20 +422,33 @@ class DataLogIterator {
     return tmp;
   }
 
+  /**
+   * Gets the current record.  Records expanded from a block record refer to
+   * the iterator's decoded copy of the block, so they are only valid while
+   * the iterator (or a copy of it) is positioned within that block.
+   */
   reference operator*() const;
 
   pointer operator->() const { return &this->operator*(); }
 
  private:
+  const impl::DecodedBlock* GetBlock(const DataLogRecord& record) const;
+
   const DataLogReader* m_reader;
   size_t m_pos;
+  size_t m_sample = 0;  // sample index within a block record
   mutable bool m_valid = false;
   mutable DataLogRecord m_value;
+  // decoded block record at m_blockPos (nullptr if it failed to decode);
+  // shared with copies of the iterator
+  mutable std::shared_ptr<impl::DecodedBlock> m_block;
+  mutable size_t m_blockPos = SIZE_MAX;
 };
 
 /** Data log reader (reads logs written by the DataLog class). */
 class DataLogReader {
   friend class DataLogIterator;
+  friend class impl::DataLogReaderAccess;
 
  public:
   using iterator = DataLogIterator;
@@ -341,29 +492,36 @@ class DataLogReader {
   /** Returns end iterator. */
   iterator end() const { return DataLogIterator{this, SIZE_MAX}; }
 
+  /**
+   * Gets the record at a particular file offset (e.g. as provided by
+   * DataLogIndex).  Block records are not expanded.
+   *
+   * @param pos file offset
+   * @param[out] out record (if successful)
+   * @return True on success, false on error
+   */
+  bool GetRecordAt(size_t pos, DataLogRecord* out) const {
+    return GetRecord(&pos, out);
+  }
+
+  /**
+   * Gets the per-entry summary written at the end of the log by DataLog.
+   * This reads only the end of the log, so it is much faster than reading
+   * the entire log.  Logs that were not closed cleanly (or written by older
+   * versions of DataLog) do not have a summary.
+   *
+   * @param[out] out summaries, ordered by entry ID (if successful)
+   * @return True if the log has a summary, false otherwise
+   */
+  bool GetSummary(std::vector<SummaryRecordData>* out) const;
+
  private:
   std::unique_ptr<MemoryBuffer> m_buf;
 
+  size_t GetFirstRecordPos() const;
+
   bool GetRecord(size_t* pos, DataLogRecord* out) const;
   bool GetNextRecord(size_t* pos) const;
 };
 
-inline DataLogIterator& DataLogIterator::operator++() {
-  if (!m_reader->GetNextRecord(&m_pos)) {
-    m_pos = SIZE_MAX;
-  }
-  m_valid = false;
-  return *this;
-}
-
-inline DataLogIterator::reference DataLogIterator::operator*() const {
-  if (!m_valid) {
-    size_t pos = m_pos;
-    if (m_reader->GetRecord(&pos, &m_value)) {
-      m_valid = true;
-    }
-  }
-  return m_value;
-}
-
 }  // namespace wpi::log
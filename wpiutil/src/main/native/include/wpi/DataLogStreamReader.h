@@ -0,0 +1,142 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "wpi/DataLogReader.h"
+#include "wpi/function_ref.h"
+
+namespace wpi {
+class raw_istream;
+}  // namespace wpi
+
+namespace wpi::log {
+
+/**
+ * Streaming data log reader.  Unlike DataLogReader, this does not need the
+ * complete log up front; data is read from a stream incrementally, and a
+ * partial record at the end of the currently available data is kept until
+ * the rest of it arrives.  This makes it possible to follow a log file that
+ * is still being written by DataLog.
+ *
+ * When constructed from a filename or file descriptor, Wait() uses file
+ * change notifications (inotify on Linux) to wake up as soon as the writer
+ * appends to the file; otherwise it periodically polls.
+ */
+class DataLogStreamReader {
+ public:
+  /**
+   * Constructs from an input stream.  Reads return whatever data is
+   * available; a stream error (e.g. end of file) is treated as "no more data
+   * right now" and cleared before the next read.
+   *
+   * @param is input stream
+   */
+  explicit DataLogStreamReader(std::unique_ptr<raw_istream> is);
+
+  /**
+   * Opens a log file for reading.
+   *
+   * @param filename filename
+   * @param ec error code (set on open error)
+   */
+  DataLogStreamReader(std::string_view filename, std::error_code& ec);
+
+  /**
+   * Constructs from a file descriptor.
+   *
+   * @param fd file descriptor
+   * @param shouldClose if true, the file descriptor is closed on destruction
+   */
+  DataLogStreamReader(int fd, bool shouldClose);
+
+  ~DataLogStreamReader();
+
+  DataLogStreamReader(const DataLogStreamReader&) = delete;
+  DataLogStreamReader& operator=(const DataLogStreamReader&) = delete;
+
+  /**
+   * Returns false if the data log is known to be invalid (e.g. has an invalid
+   * header).  Returns true if the header has not been read yet.
+   */
+  explicit operator bool() const { return !m_invalid; }
+
+  /**
+   * Returns true once the header has been read.
+   *
+   * @return True if header has been read
+   */
+  bool HasHeader() const { return m_hasHeader; }
+
+  /**
+   * Gets the data log version. Returns 0 if the header has not been read or
+   * the data log is invalid.
+   *
+   * @return Version number; most significant byte is major, least significant
+   *         is minor (so version 1.0 will be 0x0100)
+   */
+  uint16_t GetVersion() const { return m_version; }
+
+  /**
+   * Gets the extra header data.
+   *
+   * @return Extra header data
+   */
+  std::string_view GetExtraHeader() const { return m_extraHeader; }
+
+  /**
+   * Reads all currently available data and calls a function for each
+   * complete record.  Does not block waiting for more data.  Block records
+   * are expanded into individual records.  The record (and the data it refers
+   * to) is only valid during the call.
+   *
+   * @param func function to call for each record
+   * @return Number of records read
+   */
+  size_t Poll(function_ref<void(const DataLogRecord& record)> func);
+
+  /**
+   * Waits for more data to be appended (or for the timeout to expire).  This
+   * may return early even if no data has been appended.
+   *
+   * @param timeout maximum time to wait, in seconds
+   */
+  void Wait(double timeout);
+
+  /**
+   * Reads records as they are appended until the timeout expires.  This is
+   * equivalent to calling Poll() and Wait() until at least one record has
+   * been read or the timeout has expired.
+   *
+   * @param func function to call for each record
+   * @param timeout maximum time to wait, in seconds
+   * @return Number of records read
+   */
+  size_t Follow(function_ref<void(const DataLogRecord& record)> func,
+                double timeout);
+
+ private:
+  bool ReadHeader();
+  void WatchFile(const std::string& path);
+
+  std::unique_ptr<raw_istream> m_is;
+  std::vector<uint8_t> m_buf;
+  size_t m_pos = 0;
+  bool m_hasHeader = false;
+  bool m_invalid = false;
+  uint16_t m_version = 0;
+  std::string m_extraHeader;
+  impl::DecodedBlock m_block;
+  int m_notifyFd = -1;
+};
+
+}  // namespace wpi::log
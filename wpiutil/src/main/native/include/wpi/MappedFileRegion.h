@@ -28,6 +28,14 @@ class MappedFileRegion {
     kPriv        ///< May modify via data, but changes are lost on destruction.
   };
 
+  /// Expected access pattern, for Advise().
+  enum Advice {
+    kNormal,      ///< No special treatment.
+    kSequential,  ///< Read sequentially; pages may be freed after access.
+    kRandom,      ///< Read in random order; read-ahead is not useful.
+    kDontNeed     ///< Not needed soon; resident pages may be released.
+  };
+
   MappedFileRegion() = default;
   MappedFileRegion(fs::file_t f, uint64_t length, uint64_t offset,
                    MapMode mapMode, std::error_code& ec);
@@ -66,6 +74,15 @@ class MappedFileRegion {
   void Flush();
   void Unmap();
 
+  /**
+   * Advises the operating system how the mapping will be accessed, so it can
+   * read ahead or release pages accordingly.  This is only a hint, and has no
+   * effect on Windows.
+   *
+   * @param advice expected access pattern
+   */
+  void Advise(Advice advice);
+
   uint64_t size() const {
     return m_size;
   }
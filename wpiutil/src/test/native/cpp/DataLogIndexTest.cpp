@@ -0,0 +1,204 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogIndex.h"  // NOLINT(build/include_order)
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wpi/DataLog.h"
+#include "wpi/MemoryBuffer.h"
+#include "wpi/SmallVector.h"
+#include "wpi/leb128.h"
+#include "wpi/raw_ostream.h"
+
+namespace {
+class DataLogIndexTest : public ::testing::Test {
+ protected:
+  DataLogIndexTest() {
+    {
+      wpi::log::DataLog log{[this](auto out) {
+        data.insert(data.end(), out.begin(), out.end());
+      }};
+      entry1 = log.Start("a", "int64", "", 1);
+      entry2 = log.Start("b", "double", "", 1);
+      for (int i = 0; i < 1000; ++i) {
+        log.AppendInteger(entry1, i, 1000 * i + 10);
+        log.AppendDouble(entry2, i * 0.5, 1000 * i + 20);
+      }
+    }
+    reader = std::make_unique<wpi::log::DataLogReader>(
+        wpi::MemoryBuffer::GetMemBuffer(data));
+  }
+
+  std::vector<uint8_t> data;
+  std::unique_ptr<wpi::log::DataLogReader> reader;
+  int entry1;
+  int entry2;
+};
+}  // namespace
+
+TEST_F(DataLogIndexTest, EntryOffsets) {
+  wpi::log::DataLogIndex index{*reader};
+  ASSERT_TRUE(index);
+  // 2 start records, 2 summary records, and a summary end record
+  EXPECT_EQ(index.GetRecordOffsets(0).size(), 5u);
+  EXPECT_TRUE(index.GetRecordOffsets(100).empty());
+
+  auto offsets = index.GetRecordOffsets(entry1);
+  ASSERT_EQ(offsets.size(), 1000u);
+  for (int i = 0; i < 1000; ++i) {
+    wpi::log::DataLogRecord record;
+    ASSERT_TRUE(reader->GetRecordAt(offsets[i], &record));
+    int64_t val;
+    ASSERT_TRUE(record.GetInteger(&val));
+    EXPECT_EQ(record.GetEntry(), entry1);
+    EXPECT_EQ(val, i);
+  }
+  EXPECT_EQ(index.GetMinTimestamp(), 1);
+  EXPECT_EQ(index.GetMaxTimestamp(), 999020);
+}
+
+TEST_F(DataLogIndexTest, SeekTime) {
+  wpi::log::DataLogIndex index{*reader, 10000};
+  auto it = index.SeekTime(*reader, 500000);
+  ASSERT_NE(it, reader->end());
+  // everything before the seek position must be earlier
+  for (auto prev = reader->begin(); prev != it; ++prev) {
+    EXPECT_LT(prev->GetTimestamp(), 500000);
+  }
+  int64_t first = INT64_MAX;
+  int count = 0;
+  for (; it != reader->end(); ++it) {
+    if (it->GetEntry() != 0 && it->GetTimestamp() >= 500000) {
+      first = std::min(first, it->GetTimestamp());
+      ++count;
+    }
+  }
+  EXPECT_EQ(first, 500010);
+  EXPECT_EQ(count, 1000);
+
+  EXPECT_EQ(index.SeekTime(*reader, 2000000), reader->end());
+}
+
+TEST_F(DataLogIndexTest, SaveLoad) {
+  wpi::log::DataLogIndex index{*reader};
+  wpi::SmallVector<uint8_t, 128> saved;
+  wpi::raw_usvector_ostream os{saved};
+  index.Save(os);
+
+  wpi::log::DataLogIndex loaded;
+  ASSERT_TRUE(loaded.Load(saved, *reader));
+  EXPECT_EQ(loaded.GetMinTimestamp(), index.GetMinTimestamp());
+  EXPECT_EQ(loaded.GetMaxTimestamp(), index.GetMaxTimestamp());
+  for (int entry : {0, entry1, entry2}) {
+    auto expected = index.GetRecordOffsets(entry);
+    auto actual = loaded.GetRecordOffsets(entry);
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), actual.begin(),
+                           actual.end()));
+  }
+  EXPECT_EQ(loaded.SeekTime(*reader, 500000), index.SeekTime(*reader, 500000));
+
+  // truncated
+  EXPECT_FALSE(loaded.Load(std::span{saved}.subspan(0, saved.size() - 1),
+                           *reader));
+  EXPECT_FALSE(loaded);
+}
+
+TEST_F(DataLogIndexTest, LoadBadEntry) {
+  // an index with no time buckets and the given entries (with no offsets)
+  auto makeIndex = [&](std::initializer_list<uint64_t> entries) {
+    wpi::SmallVector<uint8_t, 64> saved;
+    wpi::raw_usvector_ostream os{saved};
+    const uint8_t version[] = {0x00, 0x01};
+    os << "WPILOGIX" << std::span<const uint8_t>{version};
+    for (uint64_t val : {uint64_t{data.size()}, uint64_t{1}, uint64_t{0},
+                         uint64_t{0}, uint64_t{0}, uint64_t{entries.size()}}) {
+      wpi::WriteUleb128(os, val);
+    }
+    for (uint64_t entry : entries) {
+      wpi::WriteUleb128(os, entry);
+      wpi::WriteUleb128(os, 0);
+    }
+    return saved;
+  };
+
+  wpi::log::DataLogIndex loaded;
+  EXPECT_TRUE(loaded.Load(makeIndex({0, 1}), *reader));
+  // IDs that don't fit in an int or are reserved by the map
+  EXPECT_FALSE(loaded.Load(makeIndex({0x7fffffff}), *reader));
+  EXPECT_FALSE(loaded.Load(makeIndex({0x80000000}), *reader));
+  EXPECT_FALSE(loaded.Load(makeIndex({0x100000001}), *reader));
+  // duplicate IDs
+  EXPECT_FALSE(loaded.Load(makeIndex({1, 1}), *reader));
+  EXPECT_FALSE(loaded);
+}
+
+TEST(DataLogIndexBlockTest, BlockRecords) {
+  std::vector<uint8_t> data;
+  int entry1, entry2;
+  {
+    wpi::log::DataLog log{[&](auto out) {
+      data.insert(data.end(), out.begin(), out.end());
+    }};
+    entry1 = log.Start("a", "int64", "", 1);
+    entry2 = log.Start("b", "double", "", 1);
+    log.SetBlockEncoding(entry1);
+    for (int i = 0; i < 5000; ++i) {
+      log.AppendInteger(entry1, i, 1000 * i + 10);
+      if (i < 4000) {
+        log.AppendDouble(entry2, i * 0.5, 1000 * i + 20);
+      }
+    }
+  }
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  wpi::log::DataLogIndex index{reader, 10000};
+  ASSERT_TRUE(index);
+
+  // block records are indexed under their entry rather than as control
+  // records
+  for (auto offset : index.GetRecordOffsets(0)) {
+    wpi::log::DataLogRecord record;
+    ASSERT_TRUE(reader.GetRecordAt(offset, &record));
+    EXPECT_FALSE(record.IsBlock());
+  }
+  auto offsets = index.GetRecordOffsets(entry1);
+  ASSERT_GT(offsets.size(), 1u);
+  int64_t expected = 0;
+  for (auto offset : offsets) {
+    wpi::log::DataLogRecord record;
+    ASSERT_TRUE(reader.GetRecordAt(offset, &record));
+    ASSERT_TRUE(record.IsBlock());
+    wpi::log::impl::DecodedBlock block;
+    ASSERT_TRUE(wpi::log::impl::DecodeBlock(record, &block));
+    EXPECT_EQ(block.entry, entry1);
+    for (size_t i = 0; i < block.timestamps.size(); ++i) {
+      int64_t val;
+      ASSERT_TRUE(block.GetRecord(i).GetInteger(&val));
+      EXPECT_EQ(val, expected++);
+    }
+  }
+  EXPECT_EQ(expected, 5000);
+  EXPECT_EQ(index.GetRecordOffsets(entry2).size(), 4000u);
+
+  // the last block sample is later than any other record
+  EXPECT_EQ(index.GetMinTimestamp(), 1);
+  EXPECT_EQ(index.GetMaxTimestamp(), 4999010);
+
+  // seeking into the time covered by a block starts at or before the block
+  auto it = index.SeekTime(reader, 4500000);
+  ASSERT_NE(it, reader.end());
+  int count = 0;
+  for (; it != reader.end(); ++it) {
+    if (it->GetEntry() == entry1 && it->GetTimestamp() >= 4500000) {
+      ++count;
+    }
+  }
+  EXPECT_EQ(count, 500);
+}
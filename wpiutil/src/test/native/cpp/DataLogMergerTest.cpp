@@ -0,0 +1,170 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogMerger.h"  // NOLINT(build/include_order)
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wpi/DataLog.h"
+#include "wpi/DenseMap.h"
+#include "wpi/MemoryBuffer.h"
+#include "wpi/raw_ostream.h"
+
+namespace {
+struct Sample {
+  std::string name;
+  int64_t timestamp;
+  int64_t value;
+};
+
+// decodes a merged log into data samples (with block records expanded)
+std::vector<Sample> ReadSamples(const wpi::log::DataLogReader& reader,
+                                int* numStarts = nullptr) {
+  std::vector<Sample> rv;
+  wpi::DenseMap<int, std::string> names;
+  if (numStarts) {
+    *numStarts = 0;
+  }
+  for (auto&& record : reader) {
+    if (record.IsStart()) {
+      wpi::log::StartRecordData data;
+      EXPECT_TRUE(record.GetStartData(&data));
+      names[data.entry] = data.name;
+      if (numStarts) {
+        ++*numStarts;
+      }
+    } else if (!record.IsControl()) {
+      int64_t value;
+      EXPECT_TRUE(record.GetInteger(&value));
+      rv.emplace_back(names[record.GetEntry()], record.GetTimestamp(), value);
+    }
+  }
+  return rv;
+}
+
+std::vector<uint8_t> MakeLog(std::string_view name,
+                             std::initializer_list<int64_t> timestamps,
+                             bool blockEncoding = false) {
+  std::vector<uint8_t> data;
+  {
+    wpi::log::DataLog log{
+        [&](auto out) { data.insert(data.end(), out.begin(), out.end()); }};
+    int entry = log.Start(name, "int64", "", 1);
+    if (blockEncoding) {
+      log.SetBlockEncoding(entry);
+    }
+    for (auto timestamp : timestamps) {
+      log.AppendInteger(entry, timestamp * 10, timestamp);
+    }
+  }
+  return data;
+}
+}  // namespace
+
+TEST(DataLogMergerTest, SingleInputCopied) {
+  auto data = MakeLog("a", {10, 20, 30});
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  wpi::log::DataLogMerger merger;
+  merger.AddInput(reader);
+
+  std::vector<uint8_t> out;
+  wpi::raw_uvector_ostream os{out};
+  ASSERT_TRUE(merger.Merge(os));
+  EXPECT_EQ(merger.GetRewrittenRecords(), 0u);
+  // start, 3 data records
+  EXPECT_EQ(merger.GetCopiedRecords(), 4u);
+
+  wpi::log::DataLogReader merged{wpi::MemoryBuffer::GetMemBuffer(out)};
+  ASSERT_TRUE(merged);
+  auto samples = ReadSamples(merged);
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_EQ(samples[0].timestamp, 10);
+  EXPECT_EQ(samples[2].value, 300);
+}
+
+TEST(DataLogMergerTest, Interleave) {
+  auto data1 = MakeLog("a", {10, 30, 50});
+  auto data2 = MakeLog("b", {20, 40});
+  wpi::log::DataLogReader reader1{wpi::MemoryBuffer::GetMemBuffer(data1)};
+  wpi::log::DataLogReader reader2{wpi::MemoryBuffer::GetMemBuffer(data2)};
+  wpi::log::DataLogMerger merger;
+  merger.AddInput(reader1);
+  merger.AddInput(reader2);
+
+  std::vector<uint8_t> out;
+  wpi::raw_uvector_ostream os{out};
+  ASSERT_TRUE(merger.Merge(os));
+  // both logs use entry ID 1, so the second log's records are remapped
+  EXPECT_EQ(merger.GetCopiedRecords(), 4u);
+  EXPECT_EQ(merger.GetRewrittenRecords(), 3u);
+
+  wpi::log::DataLogReader merged{wpi::MemoryBuffer::GetMemBuffer(out)};
+  auto samples = ReadSamples(merged);
+  ASSERT_EQ(samples.size(), 5u);
+  const char* names[] = {"a", "b", "a", "b", "a"};
+  for (size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_EQ(samples[i].name, names[i]);
+    EXPECT_EQ(samples[i].timestamp, static_cast<int64_t>((i + 1) * 10));
+    EXPECT_EQ(samples[i].value, samples[i].timestamp * 10);
+  }
+}
+
+TEST(DataLogMergerTest, SharedEntry) {
+  auto data1 = MakeLog("a", {10, 30});
+  auto data2 = MakeLog("a", {20});
+  wpi::log::DataLogReader reader1{wpi::MemoryBuffer::GetMemBuffer(data1)};
+  wpi::log::DataLogReader reader2{wpi::MemoryBuffer::GetMemBuffer(data2)};
+  wpi::log::DataLogMerger merger;
+  merger.AddInput(reader1);
+  merger.AddInput(reader2);
+
+  std::vector<uint8_t> out;
+  wpi::raw_uvector_ostream os{out};
+  ASSERT_TRUE(merger.Merge(os));
+
+  wpi::log::DataLogReader merged{wpi::MemoryBuffer::GetMemBuffer(out)};
+  int numStarts;
+  auto samples = ReadSamples(merged, &numStarts);
+  EXPECT_EQ(numStarts, 1);
+  ASSERT_EQ(samples.size(), 3u);
+  for (auto&& sample : samples) {
+    EXPECT_EQ(sample.name, "a");
+  }
+}
+
+TEST(DataLogMergerTest, FilterAndTimeRange) {
+  auto data1 = MakeLog("/keep/a", {10, 20, 30, 40});
+  auto data2 = MakeLog("/drop/b", {15, 25});
+  auto data3 = MakeLog("/keep/c", {10, 20, 30, 40}, true);
+  wpi::log::DataLogReader reader1{wpi::MemoryBuffer::GetMemBuffer(data1)};
+  wpi::log::DataLogReader reader2{wpi::MemoryBuffer::GetMemBuffer(data2)};
+  wpi::log::DataLogReader reader3{wpi::MemoryBuffer::GetMemBuffer(data3)};
+  wpi::log::DataLogMerger merger;
+  merger.AddInput(reader1);
+  merger.AddInput(reader2);
+  merger.AddInput(reader3);
+  merger.IncludePrefix("/keep/");
+  merger.SetTimeRange(20, 40);
+
+  std::vector<uint8_t> out;
+  wpi::raw_uvector_ostream os{out};
+  ASSERT_TRUE(merger.Merge(os));
+
+  wpi::log::DataLogReader merged{wpi::MemoryBuffer::GetMemBuffer(out)};
+  int numStarts;
+  auto samples = ReadSamples(merged, &numStarts);
+  EXPECT_EQ(numStarts, 2);
+  std::vector<std::pair<std::string, int64_t>> expected{
+      {"/keep/a", 20}, {"/keep/a", 30}, {"/keep/c", 20}, {"/keep/c", 30}};
+  std::vector<std::pair<std::string, int64_t>> actual;
+  for (auto&& sample : samples) {
+    actual.emplace_back(sample.name, sample.timestamp);
+  }
+  std::sort(actual.begin(), actual.end());
+  EXPECT_EQ(actual, expected);
+}
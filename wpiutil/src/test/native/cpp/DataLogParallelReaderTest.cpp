@@ -0,0 +1,173 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogParallelReader.h"  // NOLINT(build/include_order)
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "wpi/DataLog.h"
+#include "wpi/Endian.h"
+#include "wpi/MemoryBuffer.h"
+
+namespace {
+class DataLogParallelReaderTest : public ::testing::Test {
+ protected:
+  static constexpr int kNumRecords = 100000;
+
+  DataLogParallelReaderTest() {
+    wpi::log::DataLog log{[this](auto out) {
+      data.insert(data.end(), out.begin(), out.end());
+    }};
+    int intEntry = log.Start("int", "int64", "", 1);
+    int arrEntry = log.Start("arr", "double[]", "", 1);
+    std::vector<double> large(3000, 1.0);
+    for (int i = 0; i < kNumRecords; ++i) {
+      log.AppendInteger(intEntry, i, 1000 + i);
+      if ((i % 1000) == 0) {
+        // larger than a block, so it spans buffers
+        log.AppendDoubleArray(arrEntry, large, 1000 + i);
+      }
+      if ((i % 10000) == 0) {
+        // make sure records get split across several flushes
+        log.Flush();
+      }
+    }
+  }
+
+  // sequentially decoded records
+  static std::vector<wpi::log::DataLogRecord> ReadAll(
+      const wpi::log::DataLogReader& reader) {
+    std::vector<wpi::log::DataLogRecord> rv;
+    for (auto&& record : reader) {
+      rv.push_back(record);
+    }
+    return rv;
+  }
+
+  static void ExpectEqual(const std::vector<wpi::log::DataLogRecord>& expected,
+                          const std::vector<wpi::log::DataLogRecord>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i].GetEntry(), actual[i].GetEntry());
+      EXPECT_EQ(expected[i].GetTimestamp(), actual[i].GetTimestamp());
+      ASSERT_EQ(expected[i].GetRaw().data(), actual[i].GetRaw().data());
+      ASSERT_EQ(expected[i].GetSize(), actual[i].GetSize());
+    }
+  }
+
+  // chunk starts should be found correctly (even though an incorrect start
+  // would only slow down decoding)
+  static void ExpectRecordStarts(
+      const std::vector<wpi::log::DataLogRecord>& records,
+      const wpi::log::DataLogReader& reader, std::span<const size_t> offsets) {
+    for (auto offset : offsets) {
+      wpi::log::DataLogRecord record;
+      ASSERT_TRUE(reader.GetRecordAt(offset, &record));
+      EXPECT_TRUE(std::any_of(records.begin(), records.end(), [&](auto& r) {
+        return r.GetRaw().data() == record.GetRaw().data();
+      })) << "offset " << offset;
+    }
+  }
+
+  std::vector<uint8_t> data;
+};
+}  // namespace
+
+TEST_F(DataLogParallelReaderTest, SyncRecords) {
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  auto expected = ReadAll(reader);
+  int numSync = 0;
+  for (auto&& record : expected) {
+    if (record.IsSync()) {
+      ++numSync;
+    }
+  }
+  EXPECT_GT(numSync, 1);
+
+  wpi::log::DataLogParallelReader preader{reader, 4, 64 * 1024};
+  EXPECT_GT(preader.GetChunkOffsets().size(), 4u);
+  ExpectRecordStarts(expected, reader, preader.GetChunkOffsets());
+
+  std::vector<wpi::log::DataLogRecord> actual;
+  preader.ForEach([&](auto& record) { actual.push_back(record); });
+  ExpectEqual(expected, actual);
+}
+
+TEST_F(DataLogParallelReaderTest, NoSyncRecords) {
+  // strip out sync records to simulate an older log
+  std::vector<uint8_t> stripped;
+  {
+    wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+    size_t pos = 0;
+    for (auto&& record : reader) {
+      if (record.IsSync()) {
+        // sync records contain their own offset
+        size_t end = wpi::support::endian::read64le(
+            &record.GetRaw()[1 + wpi::log::impl::kSyncMagic.size()]);
+        stripped.insert(stripped.end(), data.begin() + pos,
+                        data.begin() + end);
+        pos = record.GetRaw().data() + record.GetSize() - data.data();
+      }
+    }
+    stripped.insert(stripped.end(), data.begin() + pos, data.end());
+  }
+
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(stripped)};
+  auto expected = ReadAll(reader);
+  for (auto&& record : expected) {
+    ASSERT_FALSE(record.IsSync());
+  }
+
+  wpi::log::DataLogParallelReader preader{reader, 4, 64 * 1024};
+  EXPECT_GT(preader.GetChunkOffsets().size(), 4u);
+  ExpectRecordStarts(expected, reader, preader.GetChunkOffsets());
+
+  std::vector<wpi::log::DataLogRecord> actual;
+  preader.ForEach([&](auto& record) { actual.push_back(record); });
+  ExpectEqual(expected, actual);
+}
+
+TEST_F(DataLogParallelReaderTest, ForEachChunk) {
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  auto expected = ReadAll(reader);
+
+  wpi::log::DataLogParallelReader preader{reader, 4, 64 * 1024};
+  std::vector<std::vector<wpi::log::DataLogRecord>> chunks(
+      preader.GetChunkOffsets().size());
+  std::atomic<size_t> count{0};
+  preader.ForEachChunk([&](size_t chunk, auto records) {
+    chunks[chunk].assign(records.begin(), records.end());
+    count += records.size();
+  });
+  EXPECT_EQ(count, expected.size());
+
+  std::vector<wpi::log::DataLogRecord> actual;
+  for (auto&& chunk : chunks) {
+    actual.insert(actual.end(), chunk.begin(), chunk.end());
+  }
+  ExpectEqual(expected, actual);
+}
+
+TEST_F(DataLogParallelReaderTest, ReadByEntry) {
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  auto expected = ReadAll(reader);
+
+  wpi::log::DataLogParallelReader preader{reader, 4, 64 * 1024};
+  auto byEntry = preader.ReadByEntry();
+  EXPECT_EQ(byEntry.size(), 3u);
+  for (auto&& [entry, records] : byEntry) {
+    std::vector<wpi::log::DataLogRecord> entryExpected;
+    for (auto&& record : expected) {
+      if (record.GetEntry() == entry) {
+        entryExpected.push_back(record);
+      }
+    }
+    ExpectEqual(entryExpected, records);
+  }
+  EXPECT_EQ(byEntry[1].size(), static_cast<size_t>(kNumRecords));
+}
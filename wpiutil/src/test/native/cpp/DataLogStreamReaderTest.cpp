@@ -0,0 +1,165 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLogStreamReader.h"  // NOLINT(build/include_order)
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "wpi/DataLog.h"
+#include "wpi/MemoryBuffer.h"
+#include "wpi/fs.h"
+#include "wpi/raw_istream.h"
+
+namespace {
+// stream where only part of the data is available at a time
+class PartialStream : public wpi::raw_istream {
+ public:
+  explicit PartialStream(std::span<const uint8_t> data) : m_data{data} {}
+
+  void SetAvailable(size_t avail) {
+    m_avail = (std::min)(avail, m_data.size());
+  }
+
+  void close() override {}
+  size_t in_avail() const override { return m_avail - m_pos; }
+
+ private:
+  void read_impl(void* data, size_t len) override {
+    if (len > (m_avail - m_pos)) {
+      error_detected();
+      len = m_avail - m_pos;
+    }
+    std::memcpy(data, m_data.data() + m_pos, len);
+    m_pos += len;
+    set_read_count(len);
+  }
+
+  std::span<const uint8_t> m_data;
+  size_t m_avail = 0;
+  size_t m_pos = 0;
+};
+
+struct SavedRecord {
+  int entry;
+  int64_t timestamp;
+  std::vector<uint8_t> data;
+
+  bool operator==(const SavedRecord&) const = default;
+};
+}  // namespace
+
+TEST(DataLogStreamReaderTest, PartialRecords) {
+  std::vector<uint8_t> data;
+  {
+    wpi::log::DataLog log{[&](auto out) {
+                            data.insert(data.end(), out.begin(), out.end());
+                          },
+                          0.25, "extra"};
+    int entry = log.Start("test", "int64", "", 1);
+    int strEntry = log.Start("str", "string", "", 1);
+    for (int i = 0; i < 1000; ++i) {
+      log.AppendInteger(entry, i, 1000 + i);
+      log.AppendString(strEntry, std::string(i % 50, 'x'), 1000 + i);
+    }
+  }
+
+  std::vector<SavedRecord> expected;
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  for (auto&& record : reader) {
+    expected.push_back({record.GetEntry(), record.GetTimestamp(),
+                        {record.GetRaw().begin(), record.GetRaw().end()}});
+  }
+
+  auto stream = std::make_unique<PartialStream>(data);
+  auto& partial = *stream;
+  wpi::log::DataLogStreamReader sreader{std::move(stream)};
+  std::vector<SavedRecord> actual;
+  auto save = [&](const wpi::log::DataLogRecord& record) {
+    actual.push_back({record.GetEntry(), record.GetTimestamp(),
+                      {record.GetRaw().begin(), record.GetRaw().end()}});
+  };
+
+  // make data available a few bytes at a time
+  EXPECT_EQ(sreader.Poll(save), 0u);
+  EXPECT_FALSE(sreader.HasHeader());
+  for (size_t avail = 0; avail < data.size(); avail += 7) {
+    partial.SetAvailable(avail);
+    sreader.Poll(save);
+  }
+  partial.SetAvailable(data.size());
+  sreader.Poll(save);
+
+  ASSERT_TRUE(sreader);
+  EXPECT_EQ(sreader.GetVersion(), 0x0100);
+  EXPECT_EQ(sreader.GetExtraHeader(), "extra");
+  EXPECT_EQ(actual.size(), expected.size());
+  EXPECT_TRUE(actual == expected);
+}
+
+TEST(DataLogStreamReaderTest, InvalidHeader) {
+  static const uint8_t data[] = {'W', 'P', 'I', 'X', 'O', 'G', 0, 1,
+                                 0,   0,   0,   0,   1,   1,   1, 1};
+  auto stream = std::make_unique<PartialStream>(data);
+  stream->SetAvailable(sizeof(data));
+  wpi::log::DataLogStreamReader sreader{std::move(stream)};
+  EXPECT_EQ(sreader.Poll([](auto&) {}), 0u);
+  EXPECT_FALSE(sreader);
+}
+
+TEST(DataLogStreamReaderTest, FollowFile) {
+  static constexpr int kNumRecords = 100;
+
+  auto dir = fs::temp_directory_path();
+  std::string filename =
+      fmt::format("DataLogStreamReaderTest_{}.wpilog",
+                  std::chrono::steady_clock::now().time_since_epoch().count());
+  auto path = dir / filename;
+
+  auto log =
+      std::make_unique<wpi::log::DataLog>(dir.string(), filename, 0.01);
+  int entry = log->Start("test", "int64", "", 1);
+  log->Flush();
+  // wait for the file to be created
+  for (int i = 0; i < 100 && !fs::exists(path); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::error_code ec;
+  wpi::log::DataLogStreamReader sreader{path.string(), ec};
+  ASSERT_FALSE(ec);
+
+  std::thread writer{[&] {
+    for (int i = 1; i <= kNumRecords; ++i) {
+      log->AppendInteger(entry, i, i);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }};
+
+  int64_t last = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (last < kNumRecords && std::chrono::steady_clock::now() < deadline) {
+    sreader.Follow(
+        [&](auto& record) {
+          int64_t val;
+          if (record.GetEntry() == entry && record.GetInteger(&val)) {
+            EXPECT_EQ(val, last + 1);
+            last = val;
+          }
+        },
+        0.1);
+  }
+  writer.join();
+  log.reset();
+  fs::remove(path, ec);
+
+  EXPECT_EQ(last, kNumRecords);
+}
@@ -0,0 +1,542 @@
+// Copyright (c) FIRST and other WPILib contributors.
+// Open Source Software; you can modify and/or share it under the terms of
+// the WPILib BSD license file in the root directory of this project.
+
+#include "wpi/DataLog.h"  // NOLINT(build/include_order)
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "wpi/DataLogReader.h"
+#include "wpi/DenseMap.h"
+#include "wpi/MemoryBuffer.h"
+#include "wpi/fs.h"
+
+namespace {
+struct TestLog {
+  std::vector<uint8_t> data;
+  std::unique_ptr<wpi::log::DataLog> log;
+
+  TestLog()
+      : log{std::make_unique<wpi::log::DataLog>(
+            [this](auto out) {
+              data.insert(data.end(), out.begin(), out.end());
+            },
+            0.005)} {}
+
+  wpi::log::DataLogReader Finish() {
+    log.reset();
+    return wpi::log::DataLogReader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  }
+};
+}  // namespace
+
+TEST(DataLogTest, SimpleInt) {
+  TestLog t;
+  int entry = t.log->Start("test", "int64", "", 1);
+  t.log->AppendInteger(entry, 1, 2);
+  auto reader = t.Finish();
+  ASSERT_TRUE(reader);
+
+  int count = 0;
+  for (auto&& record : reader) {
+    if (record.IsSummary() || record.IsSummaryEnd()) {
+      continue;
+    }
+    if (count == 0) {
+      ASSERT_TRUE(record.IsStart());
+      wpi::log::StartRecordData start;
+      ASSERT_TRUE(record.GetStartData(&start));
+      EXPECT_EQ(start.entry, entry);
+      EXPECT_EQ(start.name, "test");
+      EXPECT_EQ(start.type, "int64");
+      EXPECT_EQ(record.GetTimestamp(), 1);
+    } else {
+      int64_t val;
+      ASSERT_TRUE(record.GetInteger(&val));
+      EXPECT_EQ(record.GetEntry(), entry);
+      EXPECT_EQ(record.GetTimestamp(), 2);
+      EXPECT_EQ(val, 1);
+    }
+    ++count;
+  }
+  EXPECT_EQ(count, 2);
+}
+
+TEST(DataLogTest, LargeRecord) {
+  TestLog t;
+  int entry = t.log->Start("test", "double[]", "", 1);
+  std::vector<double> small{1.0, 2.0};
+  std::vector<double> large(5000, 3.0);
+  t.log->AppendDoubleArray(entry, small, 2);
+  t.log->AppendDoubleArray(entry, large, 3);
+  t.log->AppendDoubleArray(entry, small, 4);
+  auto reader = t.Finish();
+
+  std::vector<int64_t> timestamps;
+  for (auto&& record : reader) {
+    if (record.IsControl()) {
+      continue;
+    }
+    std::vector<double> arr;
+    ASSERT_TRUE(record.GetDoubleArray(&arr));
+    EXPECT_EQ(arr.size(), record.GetTimestamp() == 3 ? 5000u : 2u);
+    timestamps.push_back(record.GetTimestamp());
+  }
+  EXPECT_EQ(timestamps, (std::vector<int64_t>{2, 3, 4}));
+}
+
+TEST(DataLogTest, MultiThreadOrdering) {
+  static constexpr int kNumThreads = 4;
+  static constexpr int kNumRecords = 20000;
+
+  TestLog t;
+  std::vector<int> entries;
+  for (int i = 0; i < kNumThreads; ++i) {
+    entries.push_back(
+        t.log->Start("thread" + std::to_string(i), "int64", "", 1));
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, entry = entries[i]] {
+      for (int j = 1; j <= kNumRecords; ++j) {
+        t.log->AppendInteger(entry, j, j);
+      }
+    });
+  }
+  for (auto&& thr : threads) {
+    thr.join();
+  }
+  for (auto entry : entries) {
+    t.log->Finish(entry, kNumRecords + 1);
+  }
+  auto reader = t.Finish();
+
+  wpi::DenseMap<int, int64_t> last;
+  wpi::DenseMap<int, bool> finished;
+  for (auto&& record : reader) {
+    if (record.IsFinish()) {
+      int entry;
+      ASSERT_TRUE(record.GetFinishEntry(&entry));
+      EXPECT_EQ(last[entry], kNumRecords);
+      finished[entry] = true;
+    } else if (!record.IsControl()) {
+      int64_t val;
+      ASSERT_TRUE(record.GetInteger(&val));
+      EXPECT_FALSE(finished[record.GetEntry()]);
+      EXPECT_EQ(val, last[record.GetEntry()] + 1);
+      last[record.GetEntry()] = val;
+    }
+  }
+  for (auto entry : entries) {
+    EXPECT_TRUE(finished[entry]);
+  }
+}
+
+TEST(DataLogTest, MultiThreadSameEntryOrdering) {
+  static constexpr int kNumThreads = 4;
+  static constexpr int kNumRecords = 20000;
+
+  TestLog t;
+  int entry = t.log->Start("test", "int64", "", 1);
+  // appends are serialized in timestamp order, but land in different
+  // per-thread buffers
+  std::mutex mutex;
+  int64_t next = 2;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < kNumRecords; ++j) {
+        std::scoped_lock lock{mutex};
+        t.log->AppendInteger(entry, next, next);
+        ++next;
+      }
+    });
+  }
+  for (auto&& thr : threads) {
+    thr.join();
+  }
+  auto reader = t.Finish();
+
+  int64_t last = 1;
+  for (auto&& record : reader) {
+    if (record.IsControl()) {
+      continue;
+    }
+    int64_t val;
+    ASSERT_TRUE(record.GetInteger(&val));
+    ASSERT_EQ(record.GetTimestamp(), last + 1);
+    last = val;
+  }
+  EXPECT_EQ(last, kNumThreads * kNumRecords + 1);
+}
+
+TEST(DataLogTest, ShortLivedThreads) {
+  static constexpr int kNumThreads = 200;
+
+  TestLog t;
+  int entry = t.log->Start("test", "int64", "", 1);
+  for (int i = 1; i <= kNumThreads; ++i) {
+    // the buffer of each exited thread is discarded once it has been written
+    std::thread{[&] { t.log->AppendInteger(entry, i, i); }}.join();
+    if (i % 50 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+  }
+  auto reader = t.Finish();
+
+  int64_t last = 0;
+  for (auto&& record : reader) {
+    if (record.IsControl()) {
+      continue;
+    }
+    int64_t val;
+    ASSERT_TRUE(record.GetInteger(&val));
+    EXPECT_EQ(val, last + 1);
+    last = val;
+  }
+  EXPECT_EQ(last, kNumThreads);
+}
+
+TEST(DataLogTest, BufferLimitDrop) {
+  static constexpr int kNumRecords = 20000;
+
+  std::vector<uint8_t> data;
+  auto log = std::make_unique<wpi::log::DataLog>(
+      [&](auto out) {
+        // simulate slow storage
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        data.insert(data.end(), out.begin(), out.end());
+      },
+      10);
+  log->SetBufferLimit(64 * 1024);
+  int entry = log->Start("test", "int64", "", 1);
+  for (int i = 1; i <= kNumRecords; ++i) {
+    log->AppendInteger(entry, i, i);
+  }
+  uint64_t dropped = log->GetDroppedRecords();
+  EXPECT_GT(dropped, 0u);
+  EXPECT_EQ(log->GetDroppedBytes(), dropped * 8);
+  log.reset();
+
+  wpi::log::DataLogReader reader{wpi::MemoryBuffer::GetMemBuffer(data)};
+  int droppedEntry = 0;
+  int64_t loggedDropped = 0;
+  uint64_t count = 0;
+  for (auto&& record : reader) {
+    wpi::log::StartRecordData start;
+    if (record.GetStartData(&start) &&
+        start.name == "DataLog/droppedRecords") {
+      droppedEntry = start.entry;
+    } else if (record.GetEntry() == entry) {
+      ++count;
+    } else if (droppedEntry != 0 && record.GetEntry() == droppedEntry) {
+      ASSERT_TRUE(record.GetInteger(&loggedDropped));
+    }
+  }
+  EXPECT_EQ(count + dropped, static_cast<uint64_t>(kNumRecords));
+  EXPECT_EQ(loggedDropped, static_cast<int64_t>(dropped));
+}
+
+TEST(DataLogTest, BufferLimitBlock) {
+  static constexpr int kNumRecords = 20000;
+
+  TestLog t;
+  t.log->SetBufferLimit(64 * 1024, wpi::log::DataLog::OverflowPolicy::kBlock);
+  int entry = t.log->Start("test", "int64", "", 1);
+  for (int i = 1; i <= kNumRecords; ++i) {
+    t.log->AppendInteger(entry, i, i);
+  }
+  EXPECT_EQ(t.log->GetDroppedRecords(), 0u);
+  auto reader = t.Finish();
+
+  int count = 0;
+  for (auto&& record : reader) {
+    if (record.GetEntry() == entry) {
+      ++count;
+    }
+  }
+  EXPECT_EQ(count, kNumRecords);
+}
+
+TEST(DataLogTest, BlockEncoding) {
+  static constexpr int kNumRecords = 5000;
+
+  auto append = [](TestLog& t, bool block) {
+    int intEntry = t.log->Start("int", "int64", "", 1);
+    int doubleEntry = t.log->Start("double", "double", "", 1);
+    t.log->SetBlockEncoding(intEntry, block);
+    t.log->SetBlockEncoding(doubleEntry, block);
+    for (int i = 0; i < kNumRecords; ++i) {
+      // 20 ms period with some jitter
+      int64_t timestamp = 1000000 + i * 20000 + (i % 3);
+      t.log->AppendInteger(intEntry, (i * 7) - 1000, timestamp);
+      t.log->AppendDouble(doubleEntry, (i % 100) * 0.5, timestamp);
+    }
+    return std::pair{intEntry, doubleEntry};
+  };
+
+  TestLog plain;
+  append(plain, false);
+  plain.Finish();
+
+  TestLog t;
+  auto [intEntry, doubleEntry] = append(t, true);
+  auto reader = t.Finish();
+  EXPECT_LT(t.data.size() * 3, plain.data.size());
+
+  int intCount = 0;
+  int doubleCount = 0;
+  for (auto&& record : reader) {
+    EXPECT_FALSE(record.IsBlock());
+    if (record.GetEntry() == intEntry) {
+      EXPECT_EQ(record.GetTimestamp(),
+                1000000 + intCount * 20000 + (intCount % 3));
+      int64_t val;
+      ASSERT_TRUE(record.GetInteger(&val));
+      EXPECT_EQ(val, (intCount * 7) - 1000);
+      ++intCount;
+    } else if (record.GetEntry() == doubleEntry) {
+      EXPECT_EQ(record.GetTimestamp(),
+                1000000 + doubleCount * 20000 + (doubleCount % 3));
+      double val;
+      ASSERT_TRUE(record.GetDouble(&val));
+      EXPECT_EQ(val, (doubleCount % 100) * 0.5);
+      ++doubleCount;
+    }
+  }
+  EXPECT_EQ(intCount, kNumRecords);
+  EXPECT_EQ(doubleCount, kNumRecords);
+}
+
+TEST(DataLogTest, Rotation) {
+  static constexpr int kNumRecords = 20000;
+
+  auto dir = fs::temp_directory_path() /
+             fmt::format("DataLogTest_Rotation_{}",
+                         std::chrono::steady_clock::now()
+                             .time_since_epoch()
+                             .count());
+  fs::create_directory(dir);
+  {
+    wpi::log::DataLog log{dir.string(), "test.wpilog", 0.001};
+    log.SetRotation(64 * 1024);
+    int entry = log.Start("test", "int64", "meta", 1);
+    log.SetMetadata(entry, "newmeta", 1);
+    for (int i = 1; i <= kNumRecords; ++i) {
+      log.AppendInteger(entry, i, i);
+      if ((i % 1000) == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+    }
+  }
+
+  std::vector<fs::path> files;
+  for (auto&& file : fs::directory_iterator{dir}) {
+    files.emplace_back(file.path());
+  }
+  EXPECT_GT(files.size(), 2u);
+
+  int64_t count = 0;
+  int64_t sum = 0;
+  for (auto&& file : files) {
+    std::error_code ec;
+    wpi::log::DataLogReader reader{
+        wpi::MemoryBuffer::GetFile(file.string(), ec)};
+    ASSERT_FALSE(ec) << file.string();
+    ASSERT_TRUE(reader);
+    // every file starts with the entry's start record
+    int entry = 0;
+    for (auto&& record : reader) {
+      wpi::log::StartRecordData start;
+      if (record.GetStartData(&start)) {
+        entry = start.entry;
+        EXPECT_EQ(start.name, "test");
+        if (file.filename() != "test.wpilog") {
+          EXPECT_EQ(start.metadata, "newmeta");
+        }
+      } else if (!record.IsControl()) {
+        ASSERT_NE(entry, 0) << file.string();
+        int64_t val;
+        ASSERT_TRUE(record.GetInteger(&val));
+        ++count;
+        sum += val;
+      }
+    }
+  }
+  EXPECT_EQ(count, kNumRecords);
+  EXPECT_EQ(sum, static_cast<int64_t>(kNumRecords) * (kNumRecords + 1) / 2);
+
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+}
+
+TEST(DataLogTest, RotationIdle) {
+  auto dir = fs::temp_directory_path() /
+             fmt::format("DataLogTest_RotationIdle_{}",
+                         std::chrono::steady_clock::now()
+                             .time_since_epoch()
+                             .count());
+  fs::create_directory(dir);
+  {
+    wpi::log::DataLog log{dir.string(), "test.wpilog", 0.005};
+    log.SetRotation(0, 0.05);
+    int entry = log.Start("test", "int64", "", 1);
+    log.AppendInteger(entry, 1, 2);
+    // nothing is appended while the file ages
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  }
+
+  int numFiles = 0;
+  for (auto&& file : fs::directory_iterator{dir}) {
+    std::error_code ec;
+    wpi::log::DataLogReader reader{
+        wpi::MemoryBuffer::GetFile(file.path().string(), ec)};
+    ASSERT_FALSE(ec) << file.path().string();
+    ASSERT_TRUE(reader);
+    bool started = false;
+    for (auto&& record : reader) {
+      wpi::log::StartRecordData start;
+      if (record.GetStartData(&start)) {
+        EXPECT_EQ(start.name, "test");
+        started = true;
+      }
+    }
+    EXPECT_TRUE(started) << file.path().string();
+    ++numFiles;
+  }
+  EXPECT_GT(numFiles, 2);
+
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+}
+
+TEST(DataLogTest, WritePolicy) {
+  static constexpr int kNumRecords = 1000;
+  // far in the future, so held values are only written at interval ends
+  static constexpr int64_t kBaseTime = int64_t{1} << 60;
+
+  TestLog t;
+  int rateEntry = t.log->Start("rate", "int64", "", 1);
+  int deadbandEntry = t.log->Start("deadband", "double", "", 1);
+  int latestEntry = t.log->Start("latest", "int64", "", 1);
+  t.log->SetWritePolicy(rateEntry, {.minPeriod = 0.01});
+  t.log->SetWritePolicy(deadbandEntry, {.deadband = 0.5});
+  t.log->SetWritePolicy(latestEntry, {.minPeriod = 0.01, .latest = true});
+  for (int i = 1; i <= kNumRecords; ++i) {
+    int64_t timestamp = kBaseTime + i * 1000;
+    t.log->AppendInteger(rateEntry, i, timestamp);
+    t.log->AppendDouble(deadbandEntry, (i / 100) + (i % 2) * 0.25, timestamp);
+    t.log->AppendInteger(latestEntry, i, timestamp);
+  }
+  EXPECT_EQ(t.log->GetSuppressedCount(rateEntry), 900u);
+  EXPECT_EQ(t.log->GetSuppressedCount(deadbandEntry), 989u);
+  auto reader = t.Finish();
+
+  std::vector<int64_t> rateValues;
+  std::vector<double> deadbandValues;
+  std::vector<int64_t> latestValues;
+  for (auto&& record : reader) {
+    int64_t ival;
+    double dval;
+    if (record.GetEntry() == rateEntry && record.GetInteger(&ival)) {
+      rateValues.push_back(ival);
+    } else if (record.GetEntry() == deadbandEntry && record.GetDouble(&dval)) {
+      deadbandValues.push_back(dval);
+    } else if (record.GetEntry() == latestEntry && record.GetInteger(&ival)) {
+      EXPECT_EQ(record.GetTimestamp(), kBaseTime + ival * 1000);
+      latestValues.push_back(ival);
+    }
+  }
+
+  // first value in each 10 ms
+  ASSERT_EQ(rateValues.size(), 100u);
+  for (size_t i = 0; i < rateValues.size(); ++i) {
+    EXPECT_EQ(rateValues[i], static_cast<int64_t>(i * 10 + 1));
+  }
+  // only changes of more than 0.5
+  ASSERT_EQ(deadbandValues.size(), 11u);
+  for (size_t i = 0; i < deadbandValues.size(); ++i) {
+    EXPECT_EQ(deadbandValues[i], i == 0 ? 0.25 : static_cast<double>(i));
+  }
+  // last value in each 10 ms
+  ASSERT_EQ(latestValues.size(), 100u);
+  for (size_t i = 0; i < latestValues.size(); ++i) {
+    EXPECT_EQ(latestValues[i], static_cast<int64_t>(i * 10 + 10));
+  }
+}
+
+TEST(DataLogTest, Summary) {
+  TestLog t;
+  int intEntry = t.log->Start("int", "int64", "meta", 1);
+  int doubleEntry = t.log->Start("double", "double", "", 1);
+  int boolEntry = t.log->Start("bool", "boolean", "", 1);
+  int strEntry = t.log->Start("str", "string", "", 1);
+  t.log->SetBlockEncoding(doubleEntry);
+  for (int i = 1; i <= 100; ++i) {
+    t.log->AppendInteger(intEntry, i - 50, 1000 + i);
+    t.log->AppendDouble(doubleEntry, i * 0.5, 2000 + i);
+    t.log->AppendBoolean(boolEntry, (i % 4) == 0, 3000 + i);
+    t.log->AppendString(strEntry, "hello", 4000 + i);
+  }
+  t.log->SetMetadata(intEntry, "newmeta", 5000);
+  t.log->Finish(boolEntry, 5000);
+  auto reader = t.Finish();
+
+  std::vector<wpi::log::SummaryRecordData> summary;
+  ASSERT_TRUE(reader.GetSummary(&summary));
+  ASSERT_EQ(summary.size(), 4u);
+
+  EXPECT_EQ(summary[0].entry, intEntry);
+  EXPECT_EQ(summary[0].name, "int");
+  EXPECT_EQ(summary[0].type, "int64");
+  EXPECT_EQ(summary[0].metadata, "newmeta");
+  EXPECT_EQ(summary[0].count, 100u);
+  EXPECT_EQ(summary[0].firstTimestamp, 1001);
+  EXPECT_EQ(summary[0].lastTimestamp, 1100);
+  ASSERT_TRUE(summary[0].hasValues);
+  EXPECT_EQ(summary[0].min, -49);
+  EXPECT_EQ(summary[0].max, 50);
+  EXPECT_EQ(summary[0].sum, 50);
+
+  EXPECT_EQ(summary[1].entry, doubleEntry);
+  EXPECT_EQ(summary[1].count, 100u);
+  EXPECT_EQ(summary[1].firstTimestamp, 2001);
+  EXPECT_EQ(summary[1].lastTimestamp, 2100);
+  ASSERT_TRUE(summary[1].hasValues);
+  EXPECT_EQ(summary[1].min, 0.5);
+  EXPECT_EQ(summary[1].max, 50);
+  EXPECT_EQ(summary[1].sum, 2525);
+
+  EXPECT_EQ(summary[2].entry, boolEntry);
+  EXPECT_EQ(summary[2].count, 100u);
+  ASSERT_TRUE(summary[2].hasValues);
+  EXPECT_EQ(summary[2].sum, 25);
+
+  EXPECT_EQ(summary[3].entry, strEntry);
+  EXPECT_EQ(summary[3].count, 100u);
+  EXPECT_EQ(summary[3].firstTimestamp, 4001);
+  EXPECT_EQ(summary[3].lastTimestamp, 4100);
+  EXPECT_FALSE(summary[3].hasValues);
+
+  // no summary if the log was not closed
+  std::vector<uint8_t> partial;
+  {
+    wpi::log::DataLog log{[&](auto out) {
+      if (!out.empty()) {
+        partial.insert(partial.end(), out.begin(), out.end());
+      }
+    }};
+    log.Start("test", "int64", "", 1);
+  }
+  partial.resize(partial.size() - 1);
+  wpi::log::DataLogReader partialReader{
+      wpi::MemoryBuffer::GetMemBuffer(partial)};
+  EXPECT_FALSE(partialReader.GetSummary(&summary));
+}